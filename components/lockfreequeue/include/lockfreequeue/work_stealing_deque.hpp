@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+#include "array_mpmc_queue.hpp"
+
+namespace lf {
+
+// Bounded Chase-Lev work-stealing deque (the C11 version of Le, Pop, Cohen and Nardelli,
+// PPoPP 2013). The owner thread pushes and pops at the bottom (LIFO); any other thread
+// steals from the top (FIFO). Values are read by thieves before they win the race for them,
+// so they must be trivially copyable words: pointers, indices, tagged pointers.
+template<typename _Tp>
+class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable_v<_Tp> && sizeof(_Tp) <= sizeof(std::uint64_t),
+                  "WorkStealingDeque holds word-sized trivially copyable values");
+
+public:
+    explicit WorkStealingDeque(std::size_t capacity)
+        : _M_C_capacity(align_pow_2(capacity)),
+          _M_C_mask(_M_C_capacity - 1),
+          _M_data(std::make_unique<std::atomic<_Tp>[]>(_M_C_capacity)),
+          _M_top(0),
+          _M_bottom(0) {}
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // Owner only. False when full.
+    bool push(_Tp value) {
+        std::int64_t b = _M_bottom.load(std::memory_order_relaxed);
+        std::int64_t t = _M_top.load(std::memory_order_acquire);
+        if (b - t >= static_cast<std::int64_t>(_M_C_capacity)) return false;
+        _M_data[b & _M_C_mask].store(value, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_release);
+        _M_bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Owner only: the most recently pushed value.
+    bool pop(_Tp& out) {
+        std::int64_t b = _M_bottom.load(std::memory_order_relaxed) - 1;
+        _M_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = _M_top.load(std::memory_order_relaxed);
+        if (t > b) {
+            _M_bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        out = _M_data[b & _M_C_mask].load(std::memory_order_relaxed);
+        if (t == b) {
+            // Last one: race the thieves for it.
+            bool won = _M_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                      std::memory_order_relaxed);
+            _M_bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // Any thread: the oldest value, if accept(value) agrees. False when empty, refused, or
+    // lost to another thief or the owner (the caller may retry).
+    template<typename _Accept>
+    bool steal_if(_Tp& out, _Accept&& accept) {
+        std::int64_t t = _M_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = _M_bottom.load(std::memory_order_acquire);
+        if (t >= b) return false;
+        _Tp value = _M_data[t & _M_C_mask].load(std::memory_order_acquire);
+        if (!accept(value)) return false;
+        if (!_M_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                            std::memory_order_relaxed)) {
+            return false;
+        }
+        out = value;
+        return true;
+    }
+
+    bool steal(_Tp& out) { return steal_if(out, [](const _Tp&) { return true; }); }
+
+    inline std::size_t capacity() const { return _M_C_capacity; }
+    // Approximate when read by a thief.
+    inline std::size_t size() const {
+        std::int64_t b = _M_bottom.load(std::memory_order_acquire);
+        std::int64_t t = _M_top.load(std::memory_order_acquire);
+        return b > t ? static_cast<std::size_t>(b - t) : 0;
+    }
+    inline bool empty() const { return size() == 0; }
+
+private:
+    static std::size_t align_pow_2(std::size_t num) {
+        std::size_t ret = 1;
+        while (ret < num) {
+            ret <<= 1;
+        }
+        return ret;
+    }
+
+    const std::size_t _M_C_capacity;
+    const std::size_t _M_C_mask;
+    std::unique_ptr<std::atomic<_Tp>[]> _M_data;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::int64_t> _M_top;
+    alignas(CACHE_LINE_SIZE) std::atomic<std::int64_t> _M_bottom;
+};
+
+} // namespace lf
@@ -5,10 +5,10 @@
 #include <errno.h>
 #include <iostream>
 
-#include <source_location> 
-
 #define DEBUG 0
 
+#include "utils/log.h"     // after DEBUG: DEBUG==1 compiles every level in
+
 #if defined __CPPPLUSPLUS
     extern "C" {
 #endif
@@ -34,24 +34,8 @@
 }
 #endif
 
-inline void log_cpp20(const std::string& message, 
-               const std::source_location& location = std::source_location::current()) {
-#if DEBUG==1
-    std::cout << "[" << location.file_name() 
-              << ":" << location.line() 
-              << ":" << location.column() << "] "
-              << location.function_name() << "() - " 
-              << message << std::endl;
-#endif
-}
-
-inline void error_cpp20(const std::string& message, 
-               const std::source_location& location = std::source_location::current()) {
-#if DEBUG==1
-    std::cout << "[" << location.file_name() 
-              << ":" << location.line() 
-              << ":" << location.column() << "] "
-              << location.function_name() << "(ERROR) - " 
-              << message << std::endl;
-#endif
-}
\ No newline at end of file
+// Older call sites build their message with string concatenation. As macros the expression is
+// only evaluated when the level is enabled, and debug messages compile away below
+// FILE_SERVER_LOG_LEVEL. New code should use the LOG_* macros with `{}` arguments directly.
+#define log_cpp20(...) LOG_DEBUG("{}", (__VA_ARGS__))
+#define error_cpp20(...) LOG_ERROR("{}", (__VA_ARGS__))
@@ -6,6 +6,7 @@
 #include <atomic>
 #include "cache/lru_cache.h"
 #include "db/file_repository.h"
+#include "metrics/trace.h"
 
 
 class FileMetaCache {
@@ -29,12 +30,23 @@ public:
             return v;
         }
         ++misses_id_;
+        metrics::trace::Span span("FileMetaCache miss (id)", "cache");
         auto meta = db::FileRepository::getInstance().getById(id);
         if (meta)
             insertUnlocked(*meta);
         return meta;
     }
 
+    // Cache only: a miss is left for getById() (on the DB executor) to count and load.
+    std::optional<FileMetadata> cachedById(size_t id) {
+        ensureInit();
+        if (auto v = id_cache_->get(id)) {
+            ++hits_id_;
+            return v;
+        }
+        return std::nullopt;
+    }
+
     std::optional<FileMetadata> getByHash(const std::string& hash) {
         ensureInit();
         if (auto v = hash_cache_->get(hash)) {
@@ -42,6 +54,7 @@ public:
             return v;
         }
         ++misses_hash_;
+        metrics::trace::Span span("FileMetaCache miss (hash)", "cache");
         auto meta = db::FileRepository::getInstance().getByHash(hash);
         if (meta)
             insertUnlocked(*meta);
@@ -3,6 +3,10 @@
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <termios.h>
+#include <poll.h>
+
+#include <chrono>
+#include <vector>
 
 #include "common/debug.h"
 #include "list_handler.h"
@@ -50,6 +54,53 @@ public:
     }
 };
 
+// Prints the server's metrics; only answered for clients on the server's host.
+class StatsClientHandler : public Handler {
+public:
+    StatsClientHandler(int fd, json&& cmd): Handler(fd, std::move(cmd)) {}
+    void handle() override {
+        request_ = {
+            {"command", "stats"},
+            {"params", json::object()}
+        };
+        send(MessageType::REQUEST, request_);
+    }
+};
+
+class StatClientHandler : public Handler {
+public:
+    StatClientHandler(int fd, json&& cmd): Handler(fd, std::move(cmd)) {}
+    void handle() override {
+        if (command_["params"].empty()) {
+            std::cerr << "Usage: stat <name>" << std::endl;
+            return;
+        }
+        request_ = {
+            {"command", "stat"},
+            {"params", { {"file_name", command_["params"][0]} }}
+        };
+        send(MessageType::REQUEST, request_);
+    }
+    void receive() override {
+        if (!readFrame()) return;
+        bool decoded = decodeBody(frame_header_, frame_body_.data(), frame_body_.size(), response_);
+        resetFrame();
+        if (!decoded) {
+            error_cpp20("stat: response decode error");
+        } else if (response_.value("status", "") == "stat") {
+            std::cout << response_.value("fileName", "");
+            if (response_.value("isDirectory", false)) {
+                std::cout << "  directory" << std::endl;
+            } else {
+                std::cout << "  " << response_.value<uint64_t>("fileSize", 0) << " bytes  "
+                          << response_.value("fileHash", "") << std::endl;
+            }
+        } else if (response_.contains("errorMessage")) {
+            std::cout << response_["errorMessage"].get<std::string>() << std::endl;
+        }
+    }
+};
+
 static Client* g_client_instance = nullptr;
 
 Client* Client::instance() { return g_client_instance; }
@@ -85,74 +136,108 @@ bool Client::connect(const std::string& ip, uint16_t port) {
 
     poller_.add_fd(fd_, EPOLLIN | EPOLLET);
     log_cpp20("Connected to server " + ip + ":" + std::to_string(port) + " on fd " + std::to_string(fd_));
+    if (requested_version_ >= protocol::kProtocolV2) {
+        negotiateProtocol();
+    }
     if (!fetchPublicKeyBlocking()) {
         error_cpp20("Public key fetch failed; register will not encrypt correctly.");
     }
     return true;
 }
 
-bool Client::fetchPublicKeyBlocking(int timeout_ms) {
-    auto& rsa = RSAKeyManager::getInstance();
-    if (rsa.hasPublicKey()) return true; // already have it
+bool Client::negotiateProtocol(int timeout_ms) {
+    json hello = {
+        {"command", "hello"},
+        {"params", {
+            {"version", protocol::kProtocolV2},
+            {"capabilities", requested_capabilities_},
+            {"maxFrame", protocol::kMaxBodyV2}
+        }}
+    };
+    json reply;
+    if (!requestBlocking(hello, reply, timeout_ms)) return false;
+    if (reply.value("status", "") != "hello") {
+        // A server without protocol v2 answers with an error; keep talking v1.
+        log_cpp20("Server does not support protocol negotiation, staying on v1");
+        return false;
+    }
+    protocol::WireFormat format;
+    format.version = reply.value("version", 1);
+    format.capabilities = reply.value("capabilities", 0u);
+    format.max_body = format.v2() ? reply.value("maxFrame", protocol::kMaxBodyV1) : protocol::kMaxBodyV1;
+    wire_ = format;
+    log_cpp20("Protocol v" + std::to_string(wire_.version) + " capabilities=" + std::to_string(wire_.capabilities)
+              + " maxFrame=" + std::to_string(wire_.max_body));
+    return true;
+}
+
+// Read exactly n bytes within the deadline (the socket is shared with the poller, so no blocking recv).
+static bool recvExact(int fd, uint8_t* buf, size_t n, std::chrono::steady_clock::time_point deadline) {
+    size_t got = 0;
+    while (got < n) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0) return false;
+        pollfd p{fd, POLLIN, 0};
+        if (::poll(&p, 1, static_cast<int>(left)) <= 0) continue;
+        ssize_t r = ::recv(fd, buf + got, n - got, MSG_DONTWAIT);
+        if (r == 0) return false;
+        if (r < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+            return false;
+        }
+        got += static_cast<size_t>(r);
+    }
+    return true;
+}
 
-    // Build and send request manually (without adding to handlers_)
-    json pubReq = { {"command", "pubkey"} };
-    std::string msg_str = pubReq.dump();
-    Message msg{};
-    msg.header.type = static_cast<uint8_t>(MessageType::REQUEST);
-    msg.header.length = msg_str.size();
-    memcpy(msg.body, msg_str.data(), msg_str.size());
-    if (::send(fd_, reinterpret_cast<const char*>(&msg), sizeof(msg.header) + msg.header.length, 0) < 0) {
-        error_cpp20("Failed to send pubkey request: " + std::string(strerror(errno)));
+bool Client::requestBlocking(const json& request, json& response, int timeout_ms) {
+    std::string body;
+    uint8_t flags = Handler::encodeRequest(request, body);
+    if (!Handler::sendFrame(fd_, MessageType::REQUEST, body.data(), body.size(), flags)) {
+        error_cpp20("Failed to send " + request.value("command", std::string("request")) + ": " + std::string(strerror(errno)));
         return false;
     }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    uint8_t header_bytes[protocol::kMaxHeaderSize];
+    if (!recvExact(fd_, header_bytes, wire_.header_size(), deadline)) return false;
+    protocol::FrameHeader header = protocol::decode_header(header_bytes, wire_);
+    if (header.length > wire_.max_body) {
+        error_cpp20("Response too large: " + std::to_string(header.length));
+        return false;
+    }
+    std::vector<uint8_t> payload(header.length);
+    if (!recvExact(fd_, payload.data(), payload.size(), deadline)) return false;
+    if (!protocol::verify_body(header, payload.data())) {
+        error_cpp20("Response checksum mismatch");
+        return false;
+    }
+    if (!Handler::decodeBody(header, payload.data(), payload.size(), response)) {
+        error_cpp20("Response decode error");
+        return false;
+    }
+    return true;
+}
 
-    // Switch socket temporarily to blocking recv with small timeouts until done or timeout_ms reached.
-    int elapsed = 0;
-    const int step = 200; // ms
-    while (elapsed < timeout_ms && !rsa.hasPublicKey()) {
-        // Use poll() system call for simplicity
-        struct epoll_event evs[4];
-        auto events = poller_.poll(step);
-        if (events.has_value()) {
-            for (auto & ev : events.value()) {
-                if (ev.data.fd == fd_) {
-                    // Minimal inline receive (blocking style): read header fully, then body.
-                    MessageHeader hdr{};
-                    ssize_t n = recv(fd_, &hdr, sizeof(hdr), MSG_DONTWAIT);
-                    if (n <= 0) continue;
-                    if (hdr.length > sizeof(msg.body)) {
-                        error_cpp20("Pubkey response too large");
-                        return false;
-                    }
-                    size_t got = 0;
-                    std::string body;
-                    body.resize(hdr.length);
-                    while (got < hdr.length) {
-                        ssize_t b = recv(fd_, body.data() + got, hdr.length - got, MSG_DONTWAIT);
-                        if (b <= 0) break; got += b;
-                    }
-                    if (got != hdr.length) continue; // incomplete
-                    try {
-                        auto outer = json::parse(body);
-                        if (outer.contains("responseMessage")) {
-                            auto innerStr = outer["responseMessage"].get<std::string>();
-                            auto inner = json::parse(innerStr);
-                            if (inner.contains("pubkey")) {
-                                if (rsa.loadPublicKeyPEM(inner["pubkey"].get<std::string>())) {
-                                    log_cpp20("Server public key loaded successfully (blocking phase)");
-                                    return true;
-                                }
-                            }
-                        }
-                    } catch (const std::exception& e) {
-                        error_cpp20(std::string("Pubkey parse error: ") + e.what());
-                        return false;
-                    }
+bool Client::fetchPublicKeyBlocking(int timeout_ms) {
+    auto& rsa = RSAKeyManager::getInstance();
+    if (rsa.hasPublicKey()) return true; // already have it
+
+    json outer;
+    if (!requestBlocking({ {"command", "pubkey"} }, outer, timeout_ms)) return false;
+    try {
+        if (outer.contains("responseMessage")) {
+            auto innerStr = outer["responseMessage"].get<std::string>();
+            auto inner = json::parse(innerStr);
+            if (inner.contains("pubkey")) {
+                if (rsa.loadPublicKeyPEM(inner["pubkey"].get<std::string>())) {
+                    log_cpp20("Server public key loaded successfully (blocking phase)");
+                    return true;
                 }
             }
         }
-        elapsed += step;
+    } catch (const std::exception& e) {
+        error_cpp20(std::string("Pubkey parse error: ") + e.what());
+        return false;
     }
     return rsa.hasPublicKey();
 }
@@ -233,6 +318,14 @@ void Client::run() {
                         log_cpp20("Creating RMDIRClientHandler");
                         handler = std::make_shared<RMDIRClientHandler>(fd_, std::move(command));
                         handlers_[fd_] = handler;
+                    } else if (cmd_str == "stat") {
+                        log_cpp20("Creating StatClientHandler");
+                        handler = std::make_shared<StatClientHandler>(fd_, std::move(command));
+                        handlers_[fd_] = handler;
+                    } else if (cmd_str == "stats") {
+                        log_cpp20("Creating StatsClientHandler");
+                        handler = std::make_shared<StatsClientHandler>(fd_, std::move(command));
+                        handlers_[fd_] = handler;
                     } else if (cmd_str == "register") {
                         log_cpp20("Creating RegisterClientHandler");
                         handler = std::make_shared<RegisterClientHandler>(fd_, std::move(command));
@@ -6,6 +6,7 @@
 #include "command_parser.h"
 #include "net/epoll_poller.h"
 #include "handler.h"
+#include "protocol/wire_format.h"
 
 using namespace net;
 class Client
@@ -21,6 +22,16 @@ public:
     void stop();
     // Ensure got the server public key (blocking). Returns true on success.
     bool fetchPublicKeyBlocking(int timeout_ms = 3000);
+    // Protocol v2 handshake right after connect (blocking); false keeps protocol v1.
+    bool negotiateProtocol(int timeout_ms = 3000);
+
+    // What connect() asks the server for; set before connect(). Version 1 skips the handshake.
+    void setRequestedProtocol(uint8_t version, uint32_t capabilities) {
+        requested_version_ = version;
+        requested_capabilities_ = capabilities;
+    }
+    // Framing agreed with the server, used by every handler.
+    const protocol::WireFormat& wire() const { return wire_; }
 
     void setToken(const std::string& t) { auth_token_ = t; }
     const std::string& token() const { return auth_token_; }
@@ -29,6 +40,9 @@ public:
     void setPath(const std::string& p) { current_path_ = p; }
     const std::string& path() const { return current_path_; }
 private:
+    // Send a request and wait for its reply frame; used before the poll loop runs.
+    bool requestBlocking(const json& request, json& response, int timeout_ms);
+
     int fd_{-1};
     bool stop_{false};
     CommandParser parser_{};
@@ -36,6 +50,9 @@ private:
     std::string auth_token_{}; // JWT token stored after login
     std::string current_username_{}; // set after login
     std::string current_path_{"/"}; // updated via pwd/cd responses
+    uint8_t requested_version_{protocol::kProtocolV2};
+    uint32_t requested_capabilities_{protocol::kCapLargeFrames | protocol::kCapPipelining | protocol::kCapBinaryControl};
+    protocol::WireFormat wire_{};
 
     std::unordered_map<int, std::shared_ptr<Handler>> handlers_;
 };
\ No newline at end of file
@@ -11,7 +11,7 @@ public:
     }
     void receive() override {
         Handler::receive();
-        // Server currently uses responseBuilder.build(data.dump()) -> field name is responseMessage containing JSON string
+        // PubkeyResponse in JSON form: responseMessage holds the fields as a JSON string
         if (response_.contains("responseMessage")) {
             std::string inner = response_["responseMessage"].get<std::string>();
             try {
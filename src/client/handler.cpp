@@ -6,85 +6,145 @@
 
 #include "types/message.h"
 #include "common/debug.h"
+#include "protocol/codec.h"
 #include "client.h"
 
 
 
 void Handler::send(const MessageType type, const json& json_msg) {
-    std::string msg_str = json_msg.dump();
-    Message msg;
-    msg.header.type = static_cast<uint8_t>(type);
-    msg.header.length = msg_str.size();
-    memcpy(msg.body, msg_str.c_str(), msg.header.length);
-    if (::send(fd_, reinterpret_cast<const char*>(&msg), sizeof(msg.header) + msg.header.length, 0) < 0) {
+    std::string msg_str;
+    uint8_t flags = 0;
+    if (type == MessageType::REQUEST) {
+        flags = encodeRequest(json_msg, msg_str);
+    } else {
+        msg_str = json_msg.dump();
+    }
+    if (!sendFrame(fd_, type, msg_str.data(), msg_str.size(), flags)) {
         error_cpp20("Failed to send message: " + std::string(strerror(errno)));
     } else {
-        log_cpp20("Sent message: " + msg_str);
+        log_cpp20("Sent message: " + json_msg.dump() + ((flags & protocol::kFrameBinary) ? " (binary)" : ""));
     }
 }
 
-void Handler::receive() {
+uint8_t Handler::encodeRequest(const json& json_msg, std::string& body) {
+    if (auto client = Client::instance(); client && client->wire().binary_control()) {
+        if (auto request = protocol::request_from_json(json_msg)) {
+            protocol::encode_request(*request, body);
+            return protocol::kFrameBinary;
+        }
+    }
+    body = json_msg.dump();
+    return 0;
+}
+
+bool Handler::decodeBody(const protocol::FrameHeader& header, const uint8_t* body, size_t size, json& out) {
+    if (header.flags & protocol::kFrameBinary) {
+        auto response = protocol::decode_response(body, size);
+        if (!response) return false;
+        out = protocol::response_to_json(*response);
+        return true;
+    }
+    out = json::parse(body, body + size, nullptr, false);
+    return !out.is_discarded();
+}
+
+bool Handler::sendFrame(int fd, MessageType type, const void* body, size_t size, uint8_t flags) {
+    protocol::WireFormat format = Client::instance() ? Client::instance()->wire() : protocol::WireFormat{};
+    if (size > format.max_body) {
+        errno = EMSGSIZE;
+        return false;
+    }
+    std::string wire = protocol::encode_frame(static_cast<uint8_t>(type), body, size, format, flags);
+    const char* p = wire.data();
+    size_t left = wire.size();
+    while (left > 0) {
+        ssize_t n = ::send(fd, p, left, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        left -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool Handler::readFrame() {
+    protocol::WireFormat format = Client::instance() ? Client::instance()->wire() : protocol::WireFormat{};
     if (state_ == ReceiveState::READ_HEADER) {
-        ssize_t n = ::recv(fd_, reinterpret_cast<char*>(&receive_msg_.header), sizeof(receive_msg_.header), MSG_DONTWAIT);
-        if (n == 0) {
-            error_cpp20("Connection closed by peer while receiving header");
-            return;
-        } else if (n < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
-                return; // try later
+        const size_t header_size = format.header_size();
+        while (total_received_ < header_size) {
+            ssize_t n = ::recv(fd_, header_bytes_ + total_received_, header_size - total_received_, MSG_DONTWAIT);
+            if (n == 0) {
+                error_cpp20("Connection closed by peer while receiving header");
+                return false;
+            } else if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                    return false; // try later
+                }
+                error_cpp20("Failed to receive message header: " + std::string(strerror(errno)));
+                return false;
             }
-            error_cpp20("Failed to receive message header: " + std::string(strerror(errno)));
-            return;
-        } else if (n < static_cast<ssize_t>(sizeof(receive_msg_.header))) {
-            error_cpp20("Partial header read; deferring until full header available");
-            return;
+            total_received_ += n;
         }
-        log_cpp20("Received message header: length=" + std::to_string(receive_msg_.header.length) + ", type=" + std::to_string(receive_msg_.header.type));
-        if (receive_msg_.header.length > sizeof(receive_msg_.body)) {
+        frame_header_ = protocol::decode_header(header_bytes_, format);
+        log_cpp20("Received message header: length=" + std::to_string(frame_header_.length) + ", type=" + std::to_string(frame_header_.type));
+        if (frame_header_.length > format.max_body) {
             error_cpp20("Message body length exceeds buffer size");
-            return;
+            resetFrame();
+            return false;
         }
+        frame_body_.resize(frame_header_.length);
         total_received_ = 0;
         state_ = ReceiveState::READ_BODY;
     }
 
     if (state_ == ReceiveState::READ_BODY) {
-        ssize_t body_length = receive_msg_.header.length;
+        size_t body_length = frame_header_.length;
         while (total_received_ < body_length) {
-            ssize_t n = ::recv(fd_, reinterpret_cast<char*>(receive_msg_.body) + total_received_, body_length - total_received_, MSG_DONTWAIT);
+            ssize_t n = ::recv(fd_, frame_body_.data() + total_received_, body_length - total_received_, MSG_DONTWAIT);
             if (n == 0) {
                 error_cpp20("Connection closed by peer while receiving body");
-                return;
+                return false;
             } else if (n < 0) {
                 if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
                     // Not all body data available yet; wait for next event
-                    return;
+                    return false;
                 }
                 error_cpp20("Receive body error: " + std::string(strerror(errno)));
-                return;
+                return false;
             }
             total_received_ += n;
         }
+        if (!protocol::verify_body(frame_header_, frame_body_.data())) {
+            error_cpp20("Frame checksum mismatch, dropping frame");
+            resetFrame();
+            return false;
+        }
         // Full body received
         state_ = ReceiveState::PROCESSING;
     }
+    return state_ == ReceiveState::PROCESSING;
+}
 
-    if (state_ != ReceiveState::PROCESSING) {
+void Handler::resetFrame() {
+    state_ = ReceiveState::READ_HEADER;
+    total_received_ = 0;
+    frame_body_.clear();
+}
+
+void Handler::receive() {
+    if (!readFrame()) {
         return; // Not ready yet
     }
 
-    std::string body_str(reinterpret_cast<char*>(receive_msg_.body), receive_msg_.header.length);
-    log_cpp20("Received message body (once): " + body_str);
-    try {
-        response_ = json::parse(body_str);
-    } catch (const std::exception& e) {
-        error_cpp20(std::string("JSON parse error: ") + e.what());
+    if (!decodeBody(frame_header_, frame_body_.data(), frame_body_.size(), response_)) {
+        error_cpp20("Response decode error, length=" + std::to_string(frame_body_.size()));
         // Reset state machine to avoid lockup
-        state_ = ReceiveState::READ_HEADER;
+        resetFrame();
         return;
     }
+    log_cpp20("Received message body (once): " + response_.dump());
 
-    if (receive_msg_.header.type == static_cast<uint8_t>(MessageType::RESPONSE)) {
+    if (frame_header_.type == static_cast<uint8_t>(MessageType::RESPONSE)) {
         log_cpp20("Received RESPONSE: " + response_.dump());
         if (response_.contains("responseMessage")) {
             std::string msgOut = response_["responseMessage"].get<std::string>();
@@ -96,19 +156,17 @@ void Handler::receive() {
                 }
             }
         }
-    } else if (receive_msg_.header.type == static_cast<uint8_t>(MessageType::ERROR)) {
+    } else if (frame_header_.type == static_cast<uint8_t>(MessageType::ERROR)) {
         log_cpp20("Received ERROR: " + response_.dump());
         if (response_.contains("errorMessage")) {
             std::cout << response_["errorMessage"].get<std::string>() << std::endl;
         }
     } else {
-        log_cpp20("Received UNKNOWN message type: " + std::to_string(receive_msg_.header.type));
+        log_cpp20("Received UNKNOWN message type: " + std::to_string(frame_header_.type));
     }
 
     // Reset for next message
-    state_ = ReceiveState::READ_HEADER;
-    total_received_ = 0;
-    memset(&receive_msg_, 0, sizeof(receive_msg_));
+    resetFrame();
 }
 
 
@@ -2,9 +2,11 @@
 
 #include <nlohmann/json.hpp>
 #include <string>
+#include <vector>
 
 #include "types/enums.h"
 #include "types/message.h"
+#include "protocol/wire_format.h"
 
 using nlohmann::json;
 
@@ -24,10 +26,26 @@ public:
     virtual void handle(){}
     virtual void send(const MessageType type, const json& json_msg);
     virtual void receive();
+
+    // Send one frame in the connection's agreed wire format (Client::wire()).
+    static bool sendFrame(int fd, MessageType type, const void* body, size_t size, uint8_t flags = 0);
+    // REQUEST body for json_msg: binary when the server agreed to kCapBinaryControl, JSON
+    // otherwise. Returns the frame flags to send it with.
+    static uint8_t encodeRequest(const json& json_msg, std::string& body);
+    // A RESPONSE/ERROR body as JSON, whichever encoding it came in; false if it does not decode.
+    static bool decodeBody(const protocol::FrameHeader& header, const uint8_t* body, size_t size, json& out);
 protected:
+    // Resumable read of one frame; true once frame_header_/frame_body_ hold a complete frame.
+    // Returns false while more data is needed or on errors (logged).
+    bool readFrame();
+    // Back to READ_HEADER after the frame was consumed.
+    void resetFrame();
+
     int fd_;
-    Message receive_msg_;
-    ssize_t total_received_{0};
+    protocol::FrameHeader frame_header_{};
+    std::vector<uint8_t> frame_body_;
+    uint8_t header_bytes_[protocol::kMaxHeaderSize]{};
+    size_t total_received_{0};      // of the header in READ_HEADER, of the body in READ_BODY
     ReceiveState state_{ReceiveState::READ_HEADER};
     json command_;
     json request_;
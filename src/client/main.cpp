@@ -1,6 +1,7 @@
 #include <csignal>
 #include <functional>
 #include <unistd.h>
+#include <cstring>
 
 #include "client.h"
 
@@ -12,8 +13,18 @@ void handle_signal(int signal) {
     }
 }
 
-int main() {
+int main(int argc, char** argv) {
     Client client;
+    // --v1: old framing, no handshake; --crc: ask for CRC-32C on every frame body;
+    // --json: keep control messages in JSON (readable in captures) instead of binary.
+    uint8_t version = protocol::kProtocolV2;
+    uint32_t capabilities = protocol::kCapLargeFrames | protocol::kCapPipelining | protocol::kCapBinaryControl;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--v1") == 0) version = protocol::kProtocolV1;
+        else if (std::strcmp(argv[i], "--crc") == 0) capabilities |= protocol::kCapCrc;
+        else if (std::strcmp(argv[i], "--json") == 0) capabilities &= ~protocol::kCapBinaryControl;
+    }
+    client.setRequestedProtocol(version, capabilities);
     g_signal_handler = [&client](int signal) {
         client.stop();
     };
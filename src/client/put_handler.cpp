@@ -13,6 +13,7 @@
 #include "common/debug.h"
 #include "types/message.h"
 #include "utils/hash_utils.h"
+#include "client.h"
 
 void PUTHandler::handle() {
     if (command_["params"].empty()) {
@@ -173,8 +174,11 @@ void PUTHandler::startFileUpload() {
         std::cout << "Resuming upload from offset " << bytes_sent_ << "..." << std::endl;
     }
 
-    // Send file data in chunks
-    const size_t CHUNK_SIZE = 32 * 1024; // 32KB chunks
+    // Send file data in chunks: 32KB, or the largest frame agreed with a protocol v2 server
+    size_t CHUNK_SIZE = 32 * 1024;
+    if (auto client = Client::instance(); client && client->wire().v2()) {
+        CHUNK_SIZE = client->wire().chunk_size();
+    }
     std::vector<char> buffer(CHUNK_SIZE);
 
     while (bytes_sent_ < file_size_ && upload_state_ == UploadState::UPLOADING) {
@@ -227,23 +231,10 @@ void PUTHandler::startFileUpload() {
 }
 
 bool PUTHandler::sendDataChunk(const char* data, size_t size) {
-    Message msg;
-    msg.header.type = static_cast<uint8_t>(MessageType::PUT_DATA);
-    msg.header.length = size;
-    
-    if (size > sizeof(msg.body)) {
-        std::cerr << "Error: Data chunk too large: " << size << std::endl;
-        return false;
-    }
-    
-    memcpy(msg.body, data, size);
-    
-    ssize_t sent = ::send(fd_, reinterpret_cast<const char*>(&msg), sizeof(msg.header) + size, 0);
-    if (sent < 0) {
+    if (!sendFrame(fd_, MessageType::PUT_DATA, data, size)) {
         error_cpp20("Failed to send data chunk: " + std::string(strerror(errno)));
         return false;
     }
-    
     return true;
 }
 
@@ -0,0 +1,126 @@
+#include "admission_controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace concurrency {
+
+namespace {
+
+AdmissionConfig normalized(AdmissionConfig config) {
+    config.min_limit = std::max<uint32_t>(config.min_limit, 1);
+    config.max_limit = std::max(config.max_limit, config.min_limit);
+    config.initial_limit = std::clamp(config.initial_limit, config.min_limit, config.max_limit);
+    config.backoff = std::clamp(config.backoff, 0.1, 1.0);
+    return config;
+}
+
+} // namespace
+
+AdmissionController::AdmissionController(AdmissionConfig config)
+    : config_(normalized(config)),
+      limit_(config_.initial_limit),
+      window_start_ns_(Clock::now().time_since_epoch().count()) {}
+
+bool AdmissionController::try_acquire() {
+    uint32_t current = in_flight_.load(std::memory_order_relaxed);
+    do {
+        if (current >= limit_.load(std::memory_order_relaxed)) {
+            stats_.shed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!in_flight_.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel));
+    stats_.admitted.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool AdmissionController::admit_transfer() {
+    if (in_flight_.load(std::memory_order_relaxed) >= limit_.load(std::memory_order_relaxed)) {
+        stats_.shed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    stats_.admitted.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void AdmissionController::release(std::chrono::nanoseconds latency) {
+    uint32_t before = in_flight_.fetch_sub(1, std::memory_order_acq_rel);
+    record(latency, before);
+}
+
+void AdmissionController::on_queue_full(bool held_slot) {
+    if (held_slot) in_flight_.fetch_sub(1, std::memory_order_acq_rel);
+    stats_.shed.fetch_add(1, std::memory_order_relaxed);
+    stats_.shed_queue_full.fetch_add(1, std::memory_order_relaxed);
+    // admitted and then refused: undo the admission in the counters
+    stats_.admitted.fetch_sub(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(window_mutex_);
+    decrease(Clock::now());
+}
+
+bool AdmissionController::admit_connection() {
+    bool room = config_.max_connections == 0 || connections_.load(std::memory_order_relaxed) < config_.max_connections;
+    if (room && stats_.queued.load(std::memory_order_relaxed) < limit_.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    stats_.shed_connections.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+uint32_t AdmissionController::retry_after_ms() const {
+    uint64_t recent_ms = recent_latency_us_.load(std::memory_order_relaxed) * 2 / 1000;
+    uint64_t floor_ms = static_cast<uint64_t>(config_.retry_after.count());
+    return static_cast<uint32_t>(std::min<uint64_t>(std::max(recent_ms, floor_ms), 5000));
+}
+
+void AdmissionController::record(std::chrono::nanoseconds latency, uint32_t in_flight) {
+    auto now = Clock::now();
+    window_sum_us_.fetch_add(static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0)) / 1000,
+                             std::memory_order_relaxed);
+    uint32_t samples = window_samples_.fetch_add(1, std::memory_order_relaxed) + 1;
+    uint32_t seen = window_peak_.load(std::memory_order_relaxed);
+    while (in_flight > seen && !window_peak_.compare_exchange_weak(seen, in_flight, std::memory_order_relaxed)) {}
+    auto window_ended = [&] {
+        return now.time_since_epoch().count() - window_start_ns_.load(std::memory_order_relaxed)
+            >= std::chrono::duration_cast<Clock::duration>(config_.window).count();
+    };
+    if (samples < config_.min_samples || !window_ended()) return;
+
+    std::unique_lock<std::mutex> lock(window_mutex_, std::try_to_lock);
+    if (!lock.owns_lock() || !window_ended()) return;   // somebody else is rolling it, or just did
+    window_start_ns_.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+    samples = window_samples_.exchange(0, std::memory_order_relaxed);
+    uint64_t sum_us = window_sum_us_.exchange(0, std::memory_order_relaxed);
+    uint32_t peak = window_peak_.exchange(0, std::memory_order_relaxed);
+    if (samples == 0) return;
+    double average = static_cast<double>(sum_us) / samples;
+    recent_latency_us_.store(static_cast<uint64_t>(average), std::memory_order_relaxed);
+
+    // The baseline follows new minimums at once and creeps up otherwise, so a workload that
+    // became slower for good does not keep the limit at its floor forever.
+    if (baseline_us_ == 0.0 || average < baseline_us_) baseline_us_ = average;
+    else baseline_us_ += (average - baseline_us_) * 0.01;
+
+    uint32_t limit = limit_.load(std::memory_order_relaxed);
+    if (average > baseline_us_ * config_.tolerance) {
+        decrease(now);
+    } else if (peak * 4 >= limit * 3 && limit < config_.max_limit) {
+        // only grow a limit that is actually being used
+        uint32_t step = std::max<uint32_t>(1, static_cast<uint32_t>(std::sqrt(static_cast<double>(limit))));
+        limit_.store(std::min(config_.max_limit, limit + step), std::memory_order_relaxed);
+        stats_.limit_increases.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void AdmissionController::decrease(Clock::time_point now) {
+    // One decrease per window: a burst of slow completions or queue-full drops is one signal.
+    if (last_decrease_ != Clock::time_point{} && now - last_decrease_ < config_.window) return;
+    uint32_t limit = limit_.load(std::memory_order_relaxed);
+    uint32_t lowered = std::max(config_.min_limit, static_cast<uint32_t>(limit * config_.backoff));
+    if (lowered == limit) return;
+    last_decrease_ = now;
+    limit_.store(lowered, std::memory_order_relaxed);
+    stats_.limit_decreases.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace concurrency
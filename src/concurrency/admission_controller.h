@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace concurrency {
+
+struct AdmissionConfig {
+    std::size_t max_connections{10000};     // open connections across all IO reactors, 0 = unlimited
+    uint32_t initial_limit{64};             // requests admitted to the thread pool at once
+    uint32_t min_limit{8};
+    uint32_t max_limit{1024};               // no point above the pool's queue capacity
+    double tolerance{2.0};                  // window latency above tolerance * baseline is congestion
+    double backoff{0.9};                    // multiplicative decrease on congestion
+    std::chrono::milliseconds window{100};  // at most one limit change per window
+    uint32_t min_samples{16};               // ... and only with this many latency samples
+    std::chrono::milliseconds retry_after{50};  // smallest retry hint given to shed clients
+};
+
+// Admission control for requests dispatched to the thread pool and for new connections.
+//
+// The request limit adapts AIMD-style to handler latency: every window the average latency of
+// completed requests is compared to a slowly rising baseline (the lowest window average seen).
+// Latency above tolerance * baseline means requests are queueing somewhere (pool, database,
+// disk) and the limit shrinks by `backoff`; latency at baseline with the limit actually reached
+// grows it by sqrt(limit). A full pool queue is a congestion signal on its own.
+//
+// try_acquire()/release() are called once per request from the reactor and worker threads
+// and only touch atomics; the window roll-over, by whichever completion ends the window, takes
+// a lock (try_lock: the others just add their sample to the next window).
+class AdmissionController {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        std::atomic<uint64_t> admitted{0};          // requests let through
+        std::atomic<uint64_t> shed{0};              // requests answered "busy" at dispatch
+        std::atomic<uint64_t> shed_queue_full{0};   // ... of which because the pool queue was full
+        std::atomic<uint64_t> shed_connections{0};  // connections refused at accept
+        std::atomic<uint64_t> queued{0};            // admitted requests waiting for a worker (gauge)
+        std::atomic<uint64_t> limit_decreases{0};
+        std::atomic<uint64_t> limit_increases{0};
+    };
+
+    explicit AdmissionController(AdmissionConfig config = {});
+
+    // Take a request slot; false when limit() requests are already in flight (counted as shed).
+    bool try_acquire();
+    // Admit a request that does not hold a slot (transfers), unless the limit is reached.
+    bool admit_transfer();
+    // The request holding a slot completed after `latency`.
+    void release(std::chrono::nanoseconds latency);
+    // An admitted request could not be queued: counted as shed instead, returns its slot if it
+    // held one, and backs the limit off.
+    void on_queue_full(bool held_slot);
+
+    // Pool queue accounting for admitted requests.
+    void on_queued() { stats_.queued.fetch_add(1, std::memory_order_relaxed); }
+    void on_started() { stats_.queued.fetch_sub(1, std::memory_order_relaxed); }
+
+    // Whether a new connection may be accepted: below max_connections, and the pool is not a
+    // whole limit's worth of admitted requests behind. Counts refusals.
+    bool admit_connection();
+    void connection_opened() { connections_.fetch_add(1, std::memory_order_relaxed); }
+    void connection_closed() { connections_.fetch_sub(1, std::memory_order_relaxed); }
+
+    // How long a shed client should wait before retrying: twice the recent handler latency,
+    // at least config.retry_after and at most 5s.
+    uint32_t retry_after_ms() const;
+
+    uint32_t limit() const { return limit_.load(std::memory_order_relaxed); }
+    uint32_t in_flight() const { return in_flight_.load(std::memory_order_relaxed); }
+    std::size_t connections() const { return connections_.load(std::memory_order_relaxed); }
+    const Stats& stats() const { return stats_; }
+    const AdmissionConfig& config() const { return config_; }
+
+private:
+    void record(std::chrono::nanoseconds latency, uint32_t in_flight);
+    void decrease(Clock::time_point now);
+
+    const AdmissionConfig config_;
+    std::atomic<uint32_t> limit_;
+    std::atomic<uint32_t> in_flight_{0};
+    std::atomic<std::size_t> connections_{0};
+    std::atomic<uint64_t> recent_latency_us_{0};   // last window average
+    Stats stats_{};
+
+    // The current window, added to by every completion. Sum and count are separate atomics, so
+    // a sample racing the roll-over may land its latency and its count in different windows.
+    std::atomic<uint64_t> window_sum_us_{0};
+    std::atomic<uint32_t> window_samples_{0};
+    std::atomic<uint32_t> window_peak_{0};      // highest in-flight count seen in the window
+    std::atomic<int64_t> window_start_ns_;      // Clock::time_since_epoch
+
+    // The roll-over's.
+    std::mutex window_mutex_;
+    Clock::time_point last_decrease_{};
+    double baseline_us_{0.0};
+};
+
+} // namespace concurrency
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "lf_thread_pool.h"
+#include "metrics/trace.h"
+
+namespace concurrency {
+
+// Coroutines for request handlers: a handler written as straight-line code suspends at each
+// blocking call instead of holding a pool worker through it.
+//
+//   Co<void> GETHandler::serve(Ptr self) {
+//       auto file = co_await run_on(db, [&] { return repo.getFileByPath(uid, path); }, "db");
+//       ...
+//   }
+//   void GETHandler::handle() { spawn(serve(self)); }
+//
+// Co<T> is lazy: it starts when awaited and hands control back to its awaiter when it
+// finishes (symmetric transfer, so chains of them do not grow the stack). spawn() starts a
+// Co<void> nobody awaits. Awaiters remember the trace of the code they suspend and restore it
+// where the coroutine resumes, so spans keep landing on the right request.
+
+template<typename T = void>
+class Co;
+
+namespace detail {
+
+struct CoPromiseBase {
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) const noexcept {
+            return h.promise().continuation;
+        }
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { error = std::current_exception(); }
+
+    std::coroutine_handle<> continuation{std::noop_coroutine()};
+    std::exception_ptr error;
+};
+
+template<typename T>
+struct CoPromise : CoPromiseBase {
+    Co<T> get_return_object() noexcept;
+    template<typename U = T>
+    void return_value(U&& value) { result.emplace(std::forward<U>(value)); }
+    T take() {
+        if (error) std::rethrow_exception(error);
+        return std::move(*result);
+    }
+
+    std::optional<T> result;
+};
+
+template<>
+struct CoPromise<void> : CoPromiseBase {
+    Co<void> get_return_object() noexcept;
+    void return_void() const noexcept {}
+    void take() const {
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+} // namespace detail
+
+template<typename T>
+class [[nodiscard]] Co {
+public:
+    using promise_type = detail::CoPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Co(Co&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Co& operator=(Co&& other) noexcept {
+        if (this != &other) {
+            reset();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    Co(const Co&) = delete;
+    Co& operator=(const Co&) = delete;
+    ~Co() { reset(); }
+
+    // Runs the coroutine until it finishes; gives back its co_return value or rethrows.
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            Handle handle;
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) const noexcept {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+            T await_resume() const { return handle.promise().take(); }
+        };
+        return Awaiter{handle_};
+    }
+
+private:
+    friend promise_type;
+    explicit Co(Handle handle) noexcept : handle_(handle) {}
+
+    void reset() noexcept {
+        if (handle_) std::exchange(handle_, {}).destroy();
+    }
+
+    Handle handle_;
+};
+
+template<typename T>
+Co<T> detail::CoPromise<T>::get_return_object() noexcept {
+    return Co<T>(Co<T>::Handle::from_promise(*this));
+}
+
+inline Co<void> detail::CoPromise<void>::get_return_object() noexcept {
+    return Co<void>(Co<void>::Handle::from_promise(*this));
+}
+
+namespace detail {
+
+// Starts at once and frees itself when done.
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+inline Detached detach(Co<void> co) { co_await std::move(co); }
+
+// Continues h on pool, or on the calling thread without a pool or when it refuses (queue
+// full, shut down); under the given trace either way.
+inline void resume_on(LFThreadPool* pool, std::coroutine_handle<> h, uint64_t trace) {
+    if (pool != nullptr && pool->submit([h, trace] {
+            metrics::trace::Scope scope(trace);
+            h.resume();
+        })) {
+        return;
+    }
+    metrics::trace::Scope scope(trace);
+    h.resume();
+}
+
+} // namespace detail
+
+// Runs co on the calling thread up to its first suspension; it goes on wherever it is resumed
+// from there. An exception escaping it ends the process, as one escaping a pool task does.
+inline void spawn(Co<void> co) { detail::detach(std::move(co)); }
+
+// co_await resume_on(pool): continues on one of pool's workers, e.g. to leave a reactor
+// thread. Stays on the calling thread when the pool refuses.
+class ResumeOn {
+public:
+    ResumeOn(LFThreadPool& pool, TaskClass cls) : pool_(pool), cls_(cls) {}
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> h) const {
+        const uint64_t trace = metrics::trace::current();
+        return pool_.submit([h, trace] {
+            metrics::trace::Scope scope(trace);
+            h.resume();
+        }, cls_);
+    }
+    void await_resume() const noexcept {}
+
+private:
+    LFThreadPool& pool_;
+    TaskClass cls_;
+};
+
+inline ResumeOn resume_on(LFThreadPool& pool, TaskClass cls = TaskClass::Flexible) { return {pool, cls}; }
+
+// co_await run_on(executor, fn, span): the blocking call fn() (a DB round trip, a file system
+// call) runs on one of executor's workers while the calling worker goes on with other
+// requests; gives back fn's result or rethrows its exception. The coroutine then continues on
+// the pool it was suspended from (LFThreadPool::current()), or on the executor thread if it
+// was not on a pool worker. Without an executor, or when it refuses, fn runs right here and
+// blocks as before. For a traced request the call is recorded as a span named span.
+template<typename Fn>
+class RunOn {
+public:
+    using Result = std::invoke_result_t<Fn&>;
+    static_assert(!std::is_reference_v<Result>, "run_on: return a value, not a reference");
+
+    RunOn(LFThreadPool* executor, Fn fn, const char* span)
+        : executor_(executor), fn_(std::move(fn)), span_(span) {}
+
+    bool await_ready() {
+        if (executor_ != nullptr) return false;
+        invoke();
+        return true;
+    }
+
+    bool await_suspend(std::coroutine_handle<> h) {
+        home_ = LFThreadPool::current();
+        trace_ = metrics::trace::current();
+        if (executor_->submit([this, h] { run(h); })) return true;
+        invoke();
+        return false;
+    }
+
+    Result await_resume() {
+        if (error_) std::rethrow_exception(error_);
+        if constexpr (!std::is_void_v<Result>) return std::move(*result_);
+    }
+
+private:
+    void run(std::coroutine_handle<> h) {
+        {
+            metrics::trace::Scope scope(trace_);
+            invoke();
+        }
+        // The coroutine owns *this: nothing of it is touched once it may have resumed.
+        detail::resume_on(home_, h, trace_);
+    }
+
+    void invoke() noexcept {
+        metrics::trace::Span span(span_, "blocking");
+        try {
+            if constexpr (std::is_void_v<Result>) fn_();
+            else result_.emplace(fn_());
+        } catch (...) {
+            error_ = std::current_exception();
+        }
+    }
+
+    LFThreadPool* executor_;
+    Fn fn_;
+    const char* span_;
+    std::conditional_t<std::is_void_v<Result>, bool, std::optional<Result>> result_{};
+    std::exception_ptr error_;
+    LFThreadPool* home_{nullptr};
+    uint64_t trace_{0};
+};
+
+template<typename Fn>
+RunOn<std::decay_t<Fn>> run_on(LFThreadPool* executor, Fn&& fn, const char* span = "blocking call") {
+    return {executor, std::forward<Fn>(fn), span};
+}
+
+} // namespace concurrency
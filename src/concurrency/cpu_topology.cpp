@@ -0,0 +1,359 @@
+#include "cpu_topology.h"
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <thread>
+#include <utility>
+
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace concurrency {
+
+namespace {
+
+std::optional<std::string> read_line(const std::filesystem::path& path) {
+    std::ifstream in(path);
+    if (!in) return std::nullopt;
+    std::string line;
+    std::getline(in, line);
+    while (!line.empty() && (line.back() == '\n' || line.back() == ' ')) line.pop_back();
+    return line;
+}
+
+std::optional<int> read_int(const std::filesystem::path& path) {
+    auto line = read_line(path);
+    if (!line) return std::nullopt;
+    int value = 0;
+    auto [end, ec] = std::from_chars(line->data(), line->data() + line->size(), value);
+    if (ec != std::errc{} || end != line->data() + line->size()) return std::nullopt;
+    return value;
+}
+
+std::vector<int> read_cpu_list(const std::filesystem::path& path) {
+    auto line = read_line(path);
+    if (!line) return {};
+    return parse_cpu_list(*line).value_or(std::vector<int>{});
+}
+
+// "node3" -> 3
+std::optional<int> numbered(const std::string& name, std::string_view prefix) {
+    if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0) return std::nullopt;
+    int value = 0;
+    auto [end, ec] = std::from_chars(name.data() + prefix.size(), name.data() + name.size(), value);
+    if (ec != std::errc{} || end != name.data() + name.size()) return std::nullopt;
+    return value;
+}
+
+bool contains(const std::vector<int>& cpus, int cpu) {
+    return std::find(cpus.begin(), cpus.end(), cpu) != cpus.end();
+}
+
+// Dedicated CPU lists keep their order and show unpinned slots as "-".
+std::string format_slots(const std::vector<int>& cpus) {
+    std::string out;
+    for (int cpu : cpus) {
+        if (!out.empty()) out += ',';
+        out += cpu >= 0 ? std::to_string(cpu) : std::string("-");
+    }
+    return out.empty() ? std::string("none") : out;
+}
+
+} // namespace
+
+std::optional<std::vector<int>> parse_cpu_list(std::string_view text) {
+    std::vector<int> cpus;
+    while (!text.empty()) {
+        auto comma = text.find(',');
+        std::string_view item = text.substr(0, comma);
+        text = comma == std::string_view::npos ? std::string_view{} : text.substr(comma + 1);
+        if (item.empty()) continue;
+        int lo = 0;
+        int hi = 0;
+        auto [end, ec] = std::from_chars(item.data(), item.data() + item.size(), lo);
+        if (ec != std::errc{} || lo < 0) return std::nullopt;
+        hi = lo;
+        if (end != item.data() + item.size()) {
+            if (*end != '-') return std::nullopt;
+            auto [end2, ec2] = std::from_chars(end + 1, item.data() + item.size(), hi);
+            if (ec2 != std::errc{} || end2 != item.data() + item.size() || hi < lo) return std::nullopt;
+        }
+        for (int cpu = lo; cpu <= hi; ++cpu) cpus.push_back(cpu);
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+std::string format_cpu_list(const std::vector<int>& cpus) {
+    std::vector<int> sorted(cpus);
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    std::string out;
+    for (std::size_t i = 0; i < sorted.size();) {
+        std::size_t j = i;
+        while (j + 1 < sorted.size() && sorted[j + 1] == sorted[j] + 1) ++j;
+        if (!out.empty()) out += ',';
+        out += std::to_string(sorted[i]);
+        if (j > i) out += '-' + std::to_string(sorted[j]);
+        i = j + 1;
+    }
+    return out.empty() ? std::string("none") : out;
+}
+
+CpuTopology CpuTopology::from_sysfs(const std::string& root, const std::vector<int>& allowed) {
+    namespace fs = std::filesystem;
+    const fs::path cpu_dir = fs::path(root) / "cpu";
+    CpuTopology topology;
+
+    std::vector<int> online = read_cpu_list(cpu_dir / "online");
+    if (online.empty()) {
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator(cpu_dir, ec)) {
+            if (auto cpu = numbered(entry.path().filename().string(), "cpu")) online.push_back(*cpu);
+        }
+        std::sort(online.begin(), online.end());
+    }
+    const std::vector<int> isolated = read_cpu_list(cpu_dir / "isolated");
+
+    std::map<int, int> node_of;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(fs::path(root) / "node", ec)) {
+        auto node = numbered(entry.path().filename().string(), "node");
+        if (!node) continue;
+        for (int cpu : read_cpu_list(entry.path() / "cpulist")) node_of[cpu] = *node;
+    }
+
+    // core_id repeats across sockets: number physical cores by (socket, core_id).
+    std::map<std::pair<int, int>, int> core_index;
+    for (int cpu : online) {
+        if (!allowed.empty() && !contains(allowed, cpu)) continue;
+        const fs::path topo = cpu_dir / ("cpu" + std::to_string(cpu)) / "topology";
+        CpuInfo info;
+        info.cpu = cpu;
+        info.socket = read_int(topo / "physical_package_id").value_or(0);
+        const int core_id = read_int(topo / "core_id").value_or(cpu);
+        auto [it, inserted] = core_index.try_emplace({info.socket, core_id}, static_cast<int>(core_index.size()));
+        info.core = it->second;
+        auto node = node_of.find(cpu);
+        info.node = node != node_of.end() ? node->second : 0;
+        info.isolated = contains(isolated, cpu);
+        topology.cpus_.push_back(info);
+    }
+    topology.from_sysfs_ = !topology.cpus_.empty();
+    return topology;
+}
+
+CpuTopology CpuTopology::discover() {
+    std::vector<int> allowed;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) allowed.push_back(cpu);
+        }
+    }
+    CpuTopology topology = from_sysfs("/sys/devices/system", allowed);
+    if (!topology.empty()) return topology;
+    if (allowed.empty()) {
+        for (unsigned cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu) allowed.push_back(cpu);
+    }
+    for (int cpu : allowed) topology.cpus_.push_back(CpuInfo{cpu, cpu, 0, 0, false});
+    return topology;
+}
+
+const CpuInfo* CpuTopology::find(int cpu) const {
+    for (const auto& info : cpus_) {
+        if (info.cpu == cpu) return &info;
+    }
+    return nullptr;
+}
+
+std::size_t CpuTopology::sockets() const {
+    std::set<int> sockets;
+    for (const auto& info : cpus_) sockets.insert(info.socket);
+    return sockets.size();
+}
+
+std::size_t CpuTopology::cores() const {
+    std::set<int> cores;
+    for (const auto& info : cpus_) cores.insert(info.core);
+    return cores.size();
+}
+
+std::vector<int> CpuTopology::nodes() const {
+    std::set<int> nodes;
+    for (const auto& info : cpus_) nodes.insert(info.node);
+    return {nodes.begin(), nodes.end()};
+}
+
+std::vector<int> CpuTopology::node_cpus(int node) const {
+    std::vector<int> cpus;
+    for (const auto& info : cpus_) {
+        if (info.node == node) cpus.push_back(info.cpu);
+    }
+    return cpus;
+}
+
+PlacementPlan plan_placement(const CpuTopology& topology, const PlacementRequest& request) {
+    PlacementPlan plan;
+
+    const std::vector<int> nodes = topology.nodes();
+    if (request.numa_node && std::find(nodes.begin(), nodes.end(), *request.numa_node) != nodes.end()) {
+        plan.numa_node = *request.numa_node;
+    } else if (!nodes.empty()) {
+        // The node with the most CPUs this process may use; the lowest on a tie.
+        std::size_t best = 0;
+        plan.numa_node = nodes.front();
+        for (int node : nodes) {
+            std::size_t n = topology.node_cpus(node).size();
+            if (n > best) {
+                best = n;
+                plan.numa_node = node;
+            }
+        }
+    }
+
+    std::vector<int> given(request.io_reactor_cpus);
+    given.insert(given.end(), request.pinned_worker_cpus.begin(), request.pinned_worker_cpus.end());
+    if (request.main_reactor_cpu) given.push_back(*request.main_reactor_cpu);
+
+    // The node's physical cores in order of preference, with the CPUs nobody asked for.
+    struct Core {
+        int id;
+        bool isolated;
+        bool housekeeping;      // holds CPU 0
+        std::vector<int> cpus;
+    };
+    std::vector<Core> cores;
+    for (const auto& info : topology.cpus()) {
+        if (info.node != plan.numa_node || contains(given, info.cpu)) continue;
+        auto it = std::find_if(cores.begin(), cores.end(), [&](const Core& c) { return c.id == info.core; });
+        if (it == cores.end()) {
+            cores.push_back(Core{info.core, info.isolated, false, {}});
+            it = cores.end() - 1;
+        }
+        it->cpus.push_back(info.cpu);
+        it->housekeeping = it->housekeeping || info.cpu == 0;
+    }
+    std::stable_sort(cores.begin(), cores.end(), [](const Core& a, const Core& b) {
+        if (a.isolated != b.isolated) return a.isolated;
+        return !a.housekeeping && b.housekeeping;
+    });
+    // One CPU per core first, then the SMT siblings round by round.
+    std::vector<std::pair<int, bool>> slots;    // (cpu, sibling of a slot before it)
+    for (std::size_t round = 0;; ++round) {
+        bool any = false;
+        for (const auto& core : cores) {
+            if (round < core.cpus.size()) {
+                slots.emplace_back(core.cpus[round], round > 0);
+                any = true;
+            }
+        }
+        if (!any) break;
+    }
+    std::size_t next = 0;
+    auto take = [&]() {
+        if (next == slots.size()) return -1;
+        plan.smt_shared = plan.smt_shared || slots[next].second;
+        return slots[next++].first;
+    };
+
+    plan.io_reactor_cpus = request.io_reactor_cpus;
+    if (plan.io_reactor_cpus.empty()) {
+        for (std::size_t i = 0; i < request.io_reactors; ++i) plan.io_reactor_cpus.push_back(take());
+    }
+    plan.pinned_worker_cpus = request.pinned_worker_cpus;
+    if (plan.pinned_worker_cpus.empty()) {
+        for (std::size_t i = 0; i < request.pinned_workers; ++i) plan.pinned_worker_cpus.push_back(take());
+    }
+
+    auto dedicated = [&](int cpu) {
+        return contains(plan.io_reactor_cpus, cpu) || contains(plan.pinned_worker_cpus, cpu);
+    };
+    std::set<int> dedicated_cores;
+    for (const auto& info : topology.cpus()) {
+        if (dedicated(info.cpu)) dedicated_cores.insert(info.core);
+    }
+    // The node's CPUs off the dedicated cores; their SMT siblings only when nothing else is
+    // left, then any node's.
+    for (const auto& info : topology.cpus()) {
+        if (info.node == plan.numa_node && !info.isolated && !dedicated_cores.count(info.core)) {
+            plan.shared_cpus.push_back(info.cpu);
+        }
+    }
+    if (plan.shared_cpus.empty()) {
+        for (const auto& info : topology.cpus()) {
+            if (info.node == plan.numa_node && !info.isolated && !dedicated(info.cpu)) plan.shared_cpus.push_back(info.cpu);
+        }
+    }
+    if (plan.shared_cpus.empty()) {
+        for (const auto& info : topology.cpus()) {
+            if (!info.isolated && !dedicated(info.cpu)) plan.shared_cpus.push_back(info.cpu);
+        }
+    }
+
+    // Accepting is light: the lowest shared CPU (CPU 0's core is fine for it), else ride along
+    // with the first IO reactor.
+    if (request.main_reactor_cpu) {
+        plan.main_reactor_cpu = *request.main_reactor_cpu;
+    } else if (!plan.shared_cpus.empty()) {
+        plan.main_reactor_cpu = plan.shared_cpus.front();
+    } else if (!plan.io_reactor_cpus.empty()) {
+        plan.main_reactor_cpu = plan.io_reactor_cpus.front();
+    }
+    return plan;
+}
+
+std::string PlacementPlan::describe(const CpuTopology& topology) const {
+    std::vector<int> isolated;
+    for (const auto& info : topology.cpus()) {
+        if (info.isolated) isolated.push_back(info.cpu);
+    }
+    std::string out = "node " + std::to_string(numa_node) + " of " + std::to_string(topology.nodes().size())
+        + " (" + std::to_string(topology.sockets()) + " sockets, " + std::to_string(topology.cores()) + " cores, "
+        + std::to_string(topology.cpus().size()) + " cpus, isolated " + format_cpu_list(isolated)
+        + (topology.from_sysfs() ? ")" : ", sysfs unavailable)");
+    out += ": main reactor " + format_slots({main_reactor_cpu});
+    out += ", IO reactors " + format_slots(io_reactor_cpus);
+    out += ", pinned workers " + format_slots(pinned_worker_cpus);
+    out += ", shared " + (shared_cpus.empty() ? std::string("any") : format_cpu_list(shared_cpus));
+    if (smt_shared) out += ", SMT siblings shared";
+    return out;
+}
+
+NumaScope::NumaScope(const CpuTopology& topology, int node) {
+    const std::vector<int> cpus = topology.node_cpus(node);
+    if (cpus.empty()) return;
+    if (sched_getaffinity(0, sizeof(previous_), &previous_) == 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus) CPU_SET(cpu, &set);
+        restore_affinity_ = sched_setaffinity(0, sizeof(set), &set) == 0;
+    }
+    constexpr unsigned long kMaxNodes = sizeof(previous_nodes_) * 8;
+    if (topology.nodes().size() > 1 && node >= 0 && static_cast<unsigned long>(node) < kMaxNodes
+        && ::syscall(SYS_get_mempolicy, &previous_mode_, previous_nodes_, kMaxNodes, nullptr, 0) == 0) {
+        unsigned long mask[sizeof(previous_nodes_) / sizeof(unsigned long)] = {};
+        mask[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+        restore_policy_ = ::syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask, kMaxNodes) == 0;
+    }
+}
+
+NumaScope::~NumaScope() {
+    if (restore_policy_) {
+        // Back to the policy in place before, not the default: the caller may have set its own.
+        const int mode = previous_mode_ & ~(MPOL_F_STATIC_NODES | MPOL_F_RELATIVE_NODES);
+        const bool nodes = mode != MPOL_DEFAULT && mode != MPOL_LOCAL;
+        ::syscall(SYS_set_mempolicy, previous_mode_, nodes ? previous_nodes_ : nullptr,
+                  nodes ? sizeof(previous_nodes_) * 8 : 0);
+    }
+    if (restore_affinity_) sched_setaffinity(0, sizeof(previous_), &previous_);
+}
+
+} // namespace concurrency
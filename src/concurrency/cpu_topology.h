@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <sched.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace concurrency {
+
+// The host's CPUs as sysfs describes them (/sys/devices/system): which physical core, socket
+// and NUMA node each logical CPU belongs to, and whether it is isolated (isolcpus=, left to
+// threads pinned there explicitly).
+struct CpuInfo {
+    int cpu{-1};
+    int core{-1};       // physical core, unique across sockets; SMT siblings share it
+    int socket{0};
+    int node{0};
+    bool isolated{false};
+};
+
+class CpuTopology {
+public:
+    // This host, limited to the CPUs the process may run on (sched_getaffinity, so a cgroup or
+    // taskset limit is honoured). Without a readable sysfs every CPU is its own core on node 0.
+    static CpuTopology discover();
+    // root is the directory holding cpu/ and node/; allowed empty means every online CPU.
+    static CpuTopology from_sysfs(const std::string& root, const std::vector<int>& allowed = {});
+
+    const std::vector<CpuInfo>& cpus() const { return cpus_; }   // sorted by cpu number
+    const CpuInfo* find(int cpu) const;
+    bool empty() const { return cpus_.empty(); }
+    std::size_t sockets() const;
+    std::size_t cores() const;
+    std::vector<int> nodes() const;
+    std::vector<int> node_cpus(int node) const;
+    bool from_sysfs() const { return from_sysfs_; }
+
+private:
+    std::vector<CpuInfo> cpus_;
+    bool from_sysfs_{false};
+};
+
+// "0-3,8,10-11" (the sysfs cpulist format) -> {0,1,2,3,8,10,11}; nullopt if malformed.
+std::optional<std::vector<int>> parse_cpu_list(std::string_view text);
+std::string format_cpu_list(const std::vector<int>& cpus);
+
+// What the server wants placed; a non-empty CPU list (from the command line) is used as is.
+struct PlacementRequest {
+    std::size_t io_reactors{4};
+    std::size_t pinned_workers{2};
+    std::optional<int> main_reactor_cpu{};
+    std::vector<int> io_reactor_cpus{};
+    std::vector<int> pinned_worker_cpus{};
+    std::optional<int> numa_node{};
+};
+
+// Where the server's threads go. Everything lives on one NUMA node: the reactors, the workers
+// and the queues between them share a memory controller and a last-level cache. Dedicated
+// threads (IO reactors, then pinned workers) get a physical core each, isolated cores first,
+// CPU 0's core (interrupts, housekeeping) last; SMT siblings only once the node's cores are
+// used up, and -1 (not pinned) when even those are. The accept-only main reactor and the
+// unpinned threads (flexible workers, DB and disk executors) float over the node's other
+// non-isolated CPUs, leaving the SMT siblings of dedicated cores alone unless nothing else
+// is left.
+struct PlacementPlan {
+    int numa_node{0};
+    int main_reactor_cpu{-1};
+    std::vector<int> io_reactor_cpus;
+    std::vector<int> pinned_worker_cpus;
+    std::vector<int> shared_cpus;       // empty: no restriction
+    bool smt_shared{false};             // some dedicated threads are SMT siblings of each other
+
+    std::string describe(const CpuTopology& topology) const;
+};
+
+PlacementPlan plan_placement(const CpuTopology& topology, const PlacementRequest& request);
+
+// For the scope, runs the calling thread on node's CPUs and prefers node's memory for its
+// allocations (set_mempolicy MPOL_PREFERRED), so the pools, queues and rings built meanwhile
+// are first touched on that node, and threads started meanwhile inherit the CPU mask until
+// they pin themselves. The previous mask and memory policy are restored at the end; failures
+// (no NUMA, no permission) leave things as they were.
+class NumaScope {
+public:
+    NumaScope(const CpuTopology& topology, int node);
+    ~NumaScope();
+    NumaScope(const NumaScope&) = delete;
+    NumaScope& operator=(const NumaScope&) = delete;
+
+private:
+    cpu_set_t previous_{};
+    int previous_mode_{0};                          // MPOL_DEFAULT
+    unsigned long previous_nodes_[1024 / (8 * sizeof(unsigned long))]{};
+    bool restore_affinity_{false};
+    bool restore_policy_{false};
+};
+
+} // namespace concurrency
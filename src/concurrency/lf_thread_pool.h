@@ -10,15 +10,50 @@
 #include <cstdint>
 #include <string>
 #include <chrono>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
 #include "lockfreequeue/array_mpmc_queue.hpp"
+#include "lockfreequeue/work_stealing_deque.hpp"
+#include "lockfreequeue/detail/backoff.hpp"
 #include "cpu_affinity.h"
 #include "task.h"
+#include "utils/inline_function.h"
 
 namespace concurrency {
 
+// The elastic flexible tier of an LFThreadPool. max_flexible above the constructor's
+// flexible_threads lets the tier grow up to it and shrink back; 0 (or no more than
+// flexible_threads) keeps it fixed, with no scaler thread.
+struct PoolScalingConfig {
+    std::size_t max_flexible{0};
+    std::chrono::milliseconds interval{100};        // one sample, at most one change, per interval
+    std::size_t grow_backlog{4};                    // queued tasks per flexible worker that mean busy
+    std::chrono::microseconds grow_wait{2000};      // probe queue wait that means busy
+    unsigned grow_after{2};                         // busy samples in a row before growing
+    unsigned shrink_after{50};                      // idle samples in a row before retiring one
+};
+
+// Idle workers spin on the queues for a while, then park on a futex word (std::atomic::wait)
+// until submit() wakes one of them. The spin budget adapts like lf::AdaptiveBlockingQueue's
+// spin/block hysteresis: a worker that finds work while spinning doubles its budget, one that
+// spins it out and parks halves it.
+//
+// Every worker also owns a Chase-Lev deque. A task submitted from one of the pool's own
+// workers goes to that worker's deque when the worker may run its TaskClass, and the worker
+// pops it back LIFO while it is still in cache; idle workers steal from a random victim's
+// deque, oldest first. Submits from other threads (the reactors) still go through the two
+// shared injection queues. Stealing keeps the affinity rules: pinned workers take anything,
+// flexible ones never take a PinnedOnly task.
+//
+// The flexible tier can be elastic (PoolScalingConfig): a scaler thread samples the flexible
+// backlog and the queue wait of a probe task every interval, starts workers after grow_after
+// busy samples in a row and retires one after shrink_after idle ones. Worker slots up to the
+// maximum are allocated up front, so the workers_ the stealers walk never changes; a retired
+// slot just has an empty deque and no thread until the scaler reuses it.
 class LFThreadPool {
 public:
-    using Task = std::function<void()>;
+    using Task = utils::InlineFunction<void()>;     // move-only, capture inline (40 bytes)
     using Ptr = std::shared_ptr<LFThreadPool>;
 
     struct Stats {
@@ -26,8 +61,29 @@ public:
         std::atomic<uint64_t> submitted_pinned{0};
         std::atomic<uint64_t> executed_flexible{0};
         std::atomic<uint64_t> executed_pinned{0};
+        std::atomic<uint64_t> rejected{0};   // submit() returned false: queue full
+        std::atomic<uint64_t> parks{0};      // a worker went to sleep on an empty queue
+        std::atomic<uint64_t> wakes{0};      // submit() woke a parked worker
+        std::atomic<uint64_t> local{0};      // submitted by a worker to its own deque
+        std::atomic<uint64_t> steals{0};     // taken from another worker's deque
+        std::atomic<uint64_t> scale_ups{0};         // flexible workers started by the scaler
+        std::atomic<uint64_t> scale_downs{0};       // flexible workers retired by the scaler
+        std::atomic<uint64_t> flexible_workers{0};  // running now (gauge)
+        std::atomic<uint64_t> sampled_backlog{0};   // the scaler's last sample: queued flexible tasks
+        std::atomic<uint64_t> sampled_wait_us{0};   // ... and the probe's queue wait
+    };
+
+    enum class Scheduling {
+        SharedQueues,       // every task through the injection queues, no deques
+        WorkStealing,
     };
 
+    static constexpr unsigned kMinSpin = 8;         // idle rounds before parking, adapted per worker
+    static constexpr unsigned kInitialSpin = 64;
+    static constexpr unsigned kMaxSpin = 256;
+    static constexpr std::size_t kLocalQueueCapacity = 1024;   // per worker; full -> injection queue
+    static constexpr std::size_t kNodeCache = 256;             // recycled task nodes per worker
+
     // simple constructor: all workers are flexible, single queue.
     explicit LFThreadPool(std::size_t threads,
                           std::size_t queue_capacity = 1024,
@@ -35,81 +91,164 @@ public:
         : pinned_queue_(queue_capacity), flex_queue_(queue_capacity), stop_(false) {
         // If core ids provided -> treat all as pinned workers.
         if (!core_ids.empty()) pinned_core_ids_ = core_ids;
-        for (std::size_t i = 0; i < threads; ++i) {
-            if (!pinned_core_ids_.empty()) {
-                pinned_workers_.emplace_back([this, i]{
-                    pinned_worker_loop(i);
-                });
-            }
-            else {
-                flexible_workers_.emplace_back([this]{
-                    flexible_worker_loop();
-                });
-            }
-        }
+        if (!pinned_core_ids_.empty()) start(threads, 0);
+        else start(0, threads);
     }
 
-    // Advanced hybrid constructor.
+    // Advanced hybrid constructor. Pinned worker i runs on pinned_core_ids[i] (-1: anywhere);
+    // flexible workers float over flexible_cpus (empty: anywhere), see plan_placement().
     LFThreadPool(std::size_t pinned_threads,
                  std::size_t flexible_threads,
                  std::size_t queue_capacity_pinned,
                  std::size_t queue_capacity_flexible,
-                 std::vector<int> pinned_core_ids = {})
+                 std::vector<int> pinned_core_ids = {},
+                 Scheduling scheduling = Scheduling::WorkStealing,
+                 std::vector<int> flexible_cpus = {},
+                 PoolScalingConfig scaling = {})
         : pinned_queue_(queue_capacity_pinned),
           flex_queue_(queue_capacity_flexible),
           stop_(false),
-          pinned_core_ids_(std::move(pinned_core_ids)) {
-        for (std::size_t i = 0; i < pinned_threads; ++i) {
-            pinned_workers_.emplace_back([this, i]{
-                pinned_worker_loop(i);
-            });
-        }
-        for (std::size_t i = 0; i < flexible_threads; ++i) {
-            flexible_workers_.emplace_back([this]{
-                flexible_worker_loop();
-            });
-        }
+          pinned_core_ids_(std::move(pinned_core_ids)),
+          flexible_cpus_(std::move(flexible_cpus)),
+          work_stealing_(scheduling == Scheduling::WorkStealing),
+          scaling_(scaling) {
+        start(pinned_threads, flexible_threads, scaling.max_flexible);
     }
 
     ~LFThreadPool() { shutdown(); }
 
     bool submit(Task t, TaskClass cls = TaskClass::Flexible) {
         if (stop_.load(std::memory_order_relaxed)) return false;
+        Worker* self = t_worker;
+        if (self != nullptr && self->pool == this && submit_local(*self, t, cls)) return true;
         lf::ArrayMPMCQueue<Task>* q = choose_queue(cls);
         auto& stat_counter = (q == &pinned_queue_) ? stats_.submitted_pinned : stats_.submitted_flexible;
         stat_counter.fetch_add(1, std::memory_order_relaxed);
-        for (int i = 0; i < 64; ++i) {
-            if (q->try_push(std::move(t))) return true;
+        for (int i = 0; i < 65; ++i) {
+            if (q->try_push(std::move(t))) {
+                wake_for(q);
+                return true;
+            }
         }
-        return q->try_push(std::move(t));
+        stats_.rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
     }
 
     bool submit_pinned(Task t) { return submit(std::move(t), TaskClass::PinnedOnly); }
     bool submit_flexible(Task t) { return submit(std::move(t), TaskClass::Flexible); }
 
+    // A strand running on this pool (see SeriesTask); the pool must outlive its drains.
+    SeriesTask<Task>::Ptr make_series(TaskClass cls = TaskClass::Flexible) {
+        return SeriesTask<Task>::create([this, cls](Task t) { return submit(std::move(t), cls); });
+    }
+
     void shutdown() {
         bool expected=false;
         if (!stop_.compare_exchange_strong(expected, true)) return;
+        { std::lock_guard<std::mutex> lock(scaler_mutex_); }
+        scaler_cv_.notify_all();
+        if (scaler_.joinable()) scaler_.join();
+        for (ParkingLot* lot : {&pinned_lot_, &flex_lot_}) {
+            lot->epoch.fetch_add(1, std::memory_order_release);
+            lot->epoch.notify_all();
+        }
         for (auto & th: pinned_workers_) if (th.joinable()) th.join();
         for (auto & th: flexible_workers_) if (th.joinable()) th.join();
-        // Drain remaining tasks
+        // Drain remaining tasks; the owners are gone, so popping their deques is safe here.
+        for (auto& worker : workers_) {
+            uintptr_t item;
+            while (worker->deque.pop(item)) {
+                Task* node = node_of(item);
+                (*node)();
+                delete node;
+            }
+        }
         Task task;
         while (pinned_queue_.try_pop(task)) task();
         while (flex_queue_.try_pop(task)) task();
     }
 
+    // The pool whose worker is calling, nullptr off the workers (reactors, other threads).
+    static LFThreadPool* current() { return t_worker != nullptr ? t_worker->pool : nullptr; }
+
+    // True once shutdown() has begun: a long-running task can check it to bail out early.
+    bool stopped() const { return stop_.load(std::memory_order_relaxed); }
     const Stats& stats() const { return stats_; }
     std::size_t pinned_worker_count() const { return pinned_workers_.size(); }
-    std::size_t flexible_worker_count() const { return flexible_workers_.size(); }
+    std::size_t flexible_worker_count() const { return stats_.flexible_workers.load(std::memory_order_relaxed); }
+    std::size_t max_flexible_worker_count() const { return flexible_workers_.size(); }
 
 private:
+    // The idle workers of one kind. epoch is the futex word: a waker bumps it, so a worker
+    // that read it before parking does not sleep through a wake that came in between. The
+    // counters are seq_cst: the wake/park handshake below depends on their total order.
+    struct alignas(64) ParkingLot {
+        std::atomic<uint32_t> epoch{0};
+        std::atomic<uint32_t> sleepers{0};     // parked, or about to
+        std::atomic<uint32_t> spinning{0};     // awake and looking for work: no need to wake anyone
+        std::atomic<uint32_t> waking{0};       // wakes not yet picked up by a returning worker
+    };
+
+    // A worker's deque holds heap nodes tagged with their TaskClass in the low bits, so a
+    // thief can check the class before it claims the node. Nodes are recycled through the
+    // cache of whichever worker ran them; only that worker touches its cache.
+    struct Worker {
+        Worker(LFThreadPool* pool, bool pinned, uint64_t seed)
+            : pool(pool), pinned(pinned), deque(kLocalQueueCapacity), rng(seed) {}
+        ~Worker() { for (Task* node : free_nodes) delete node; }
+
+        LFThreadPool* const pool;
+        const bool pinned;
+        lf::WorkStealingDeque<uintptr_t> deque;
+        std::vector<Task*> free_nodes;
+        uint64_t rng;
+        std::atomic<bool> retired{false};   // its thread left on a retirement, ready to join
+    };
+
+    static_assert(alignof(Task) >= 4, "TaskClass is kept in the low two bits of a Task*");
+
+    static uintptr_t tag(Task* node, TaskClass cls) {
+        return reinterpret_cast<uintptr_t>(node) | static_cast<uintptr_t>(cls);
+    }
+    static Task* node_of(uintptr_t item) { return reinterpret_cast<Task*>(item & ~uintptr_t{3}); }
+    static TaskClass class_of(uintptr_t item) { return static_cast<TaskClass>(item & 3); }
+
+    // Creates every Worker, the elastic tier's spare slots included, before any thread runs,
+    // so workers_ is read-only once they do.
+    void start(std::size_t pinned_threads, std::size_t flexible_threads, std::size_t max_flexible = 0) {
+        pinned_count_ = pinned_threads;
+        // Without pinned workers the last flexible one must stay: nobody else drains the queues.
+        min_flexible_ = pinned_threads == 0 ? std::max<std::size_t>(flexible_threads, 1) : flexible_threads;
+        const std::size_t slots = std::max(flexible_threads, max_flexible);
+        for (std::size_t i = 0; i < pinned_threads + slots; ++i) {
+            workers_.push_back(std::make_unique<Worker>(this, i < pinned_threads, (i + 1) * 0x9E3779B97F4A7C15ull));
+        }
+        for (std::size_t i = 0; i < pinned_threads; ++i) {
+            pinned_workers_.emplace_back([this, i]{
+                pinned_worker_loop(i);
+            });
+        }
+        flexible_workers_.resize(slots);
+        for (std::size_t i = 0; i < flexible_threads; ++i) start_flexible(i);
+        if (slots > min_flexible_) scaler_ = std::thread([this] { scaler_loop(); });
+    }
+
+    void start_flexible(std::size_t slot) {
+        const std::size_t index = pinned_count_ + slot;
+        workers_[index]->retired.store(false, std::memory_order_relaxed);
+        stats_.flexible_workers.fetch_add(1, std::memory_order_relaxed);
+        flexible_workers_[slot] = std::thread([this, index]{
+            flexible_worker_loop(index);
+        });
+    }
+
     lf::ArrayMPMCQueue<Task>* choose_queue(TaskClass cls) {
         switch (cls) {
             case TaskClass::PinnedOnly:
-                if (!pinned_workers_.empty()) return &pinned_queue_;
+                if (pinned_count_ > 0) return &pinned_queue_;
                 return &flex_queue_;
             case TaskClass::PreferPinned:
-                if (!pinned_workers_.empty() && pinned_queue_.size() <= flex_queue_.size()*2) return &pinned_queue_;
+                if (pinned_count_ > 0 && pinned_queue_.size() <= flex_queue_.size()*2) return &pinned_queue_;
                 return &flex_queue_;
             case TaskClass::Flexible:
             default:
@@ -122,27 +261,317 @@ private:
             int core = pinned_core_ids_[index % pinned_core_ids_.size()];
             set_current_thread_affinity(core);
         }
-        main_worker_loop(true /*pinned*/);
+        main_worker_loop(*workers_[index]);
     }
 
-    void flexible_worker_loop() { main_worker_loop(false /*pinned*/); }
+    void flexible_worker_loop(std::size_t index) {
+        if (!flexible_cpus_.empty()) set_current_thread_affinity(flexible_cpus_);
+        Worker& self = *workers_[index];
+        if (main_worker_loop(self)) {
+            stats_.flexible_workers.fetch_sub(1, std::memory_order_relaxed);
+            stats_.scale_downs.fetch_add(1, std::memory_order_relaxed);
+            self.retired.store(true, std::memory_order_release);
+        }
+    }
 
-    void main_worker_loop(bool pinned) {
+    // Returns true when the worker left on a retirement (see scale()), false on shutdown.
+    bool main_worker_loop(Worker& self) {
+        t_worker = &self;
+        const bool pinned = self.pinned;
         auto* primary = pinned ? &pinned_queue_ : &flex_queue_;
          // pinned worker can fallback; flexible normally not steal pinned unless backlog large
         auto* secondary = pinned ? &flex_queue_ : &pinned_queue_;
+        ParkingLot& lot = pinned ? pinned_lot_ : flex_lot_;
+        unsigned spin_budget = kInitialSpin;
+        unsigned idle_rounds = 0;
+        bool spinning = false;
+        lf::ExponentialBackoff backoff;
+        // Called with a task in hand, before running it: a task may block for long (the DB and
+        // disk executors' do), and the rest of a burst must not wait for it to wake a worker.
+        auto found = [&] {
+            if (idle_rounds > 0) spin_budget = std::min(spin_budget * 2, kMaxSpin);
+            idle_rounds = 0;
+            backoff.reset();
+            if (spinning) {
+                // Submitters skipped the wake-up while this worker was looking: pass it on
+                // if there is more to do.
+                spinning = false;
+                lot.spinning.fetch_sub(1);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (has_work(self)) wake_one(lot);
+            }
+        };
         while (!stop_.load(std::memory_order_relaxed)) {
             Task task;
-            if (primary->try_pop(task)) {
+            uintptr_t item;
+            if (work_stealing_ && self.deque.pop(item)) {
+                found();
+                run_local(self, item);
+            } else if (primary->try_pop(task)) {
+                found();
                 execute_task(task, pinned);
             } else if (pinned && secondary->try_pop(task)) {
+                found();
                 execute_task(task, false);
             } else if (!pinned && should_help_pinned() && secondary->try_pop(task)) {
+                found();
                 execute_task(task, true);
+            } else if (work_stealing_ && steal(self, item)) {
+                found();
+                run_local(self, item);
+            } else if (!spinning) {
+                spinning = true;
+                lot.spinning.fetch_add(1);
+            } else if (!pinned && claim_retirement()) {
+                // Idle with a retirement pending: leave instead of spinning on. Nothing is left
+                // behind, only this worker pushes to its deque and it just came up empty; a
+                // wake skipped because this worker was spinning is passed on like in found().
+                lot.spinning.fetch_sub(1);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (has_work(self)) wake_for_local(TaskClass::Flexible);
+                t_worker = nullptr;
+                return true;
+            } else if (++idle_rounds < spin_budget) {
+                backoff();
             } else {
-                std::this_thread::yield();
+                spin_budget = std::max(spin_budget / 2, kMinSpin);
+                park(lot, self);
+                idle_rounds = 0;
+                backoff.reset();
             }
         }
+        t_worker = nullptr;
+        return false;
+    }
+
+    bool claim_retirement() {
+        uint32_t pending = retirements_.load(std::memory_order_relaxed);
+        while (pending > 0) {
+            if (retirements_.compare_exchange_weak(pending, pending - 1)) return true;
+        }
+        return false;
+    }
+
+    void scaler_loop() {
+        std::unique_lock<std::mutex> lock(scaler_mutex_);
+        while (!scaler_cv_.wait_for(lock, scaling_.interval, [this] { return stop_.load(); })) scale();
+    }
+
+    // One scaler sample. Busy: more than grow_backlog queued flexible tasks per worker, or the
+    // probe waited grow_wait or longer in the injection queue (workers stuck in blocking calls
+    // show up there before the backlog grows). Idle: nothing queued, the probe went straight
+    // through, and a flexible worker is parked. Anything in between resets both streaks, and so
+    // does every change, so the tier neither flaps on a short burst nor shrinks in a lull.
+    void scale() {
+        for (std::size_t slot = 0; slot < flexible_workers_.size(); ++slot) {
+            std::thread& th = flexible_workers_[slot];
+            if (th.joinable() && workers_[pinned_count_ + slot]->retired.load(std::memory_order_acquire)) th.join();
+        }
+
+        std::size_t backlog = flex_queue_.size();
+        for (std::size_t i = pinned_count_; i < workers_.size(); ++i) backlog += workers_[i]->deque.size();
+        const int64_t now = steady_ns();
+        const int64_t sent = probe_sent_ns_.load(std::memory_order_acquire);
+        int64_t wait_ns;
+        if (sent != 0) {
+            wait_ns = now - sent;       // still queued: waited at least this long
+        } else {
+            wait_ns = probe_wait_ns_.load(std::memory_order_relaxed);
+            probe_sent_ns_.store(now, std::memory_order_relaxed);
+            bool queued = submit([this, now] {
+                probe_wait_ns_.store(steady_ns() - now, std::memory_order_relaxed);
+                probe_sent_ns_.store(0, std::memory_order_release);
+            });
+            if (!queued) {
+                probe_sent_ns_.store(0, std::memory_order_relaxed);
+                wait_ns = INT64_MAX;    // a full queue is as busy as it gets
+            }
+        }
+        stats_.sampled_backlog.store(backlog, std::memory_order_relaxed);
+        stats_.sampled_wait_us.store(wait_ns == INT64_MAX ? UINT64_MAX : static_cast<uint64_t>(wait_ns / 1000),
+                                     std::memory_order_relaxed);
+
+        const std::size_t running = stats_.flexible_workers.load(std::memory_order_relaxed);
+        const int64_t grow_wait_ns = std::chrono::nanoseconds(scaling_.grow_wait).count();
+        const bool busy = backlog > scaling_.grow_backlog * running || wait_ns >= grow_wait_ns;
+        const bool idle = backlog == 0 && wait_ns < grow_wait_ns / 4 && flex_lot_.sleepers.load() > 0;
+        busy_samples_ = busy ? busy_samples_ + 1 : 0;
+        idle_samples_ = idle ? idle_samples_ + 1 : 0;
+
+        if (busy_samples_ >= scaling_.grow_after && running < flexible_workers_.size()) {
+            // Enough workers for the backlog at grow_backlog each, at least one more.
+            const std::size_t wanted = backlog / std::max<std::size_t>(scaling_.grow_backlog, 1);
+            std::size_t add = std::clamp<std::size_t>(wanted > running ? wanted - running : 1, 1,
+                                                      flexible_workers_.size() - running);
+            for (std::size_t slot = 0; slot < flexible_workers_.size() && add > 0; ++slot) {
+                if (flexible_workers_[slot].joinable()) continue;   // running, or retiring
+                start_flexible(slot);
+                stats_.scale_ups.fetch_add(1, std::memory_order_relaxed);
+                --add;
+            }
+            retirements_.store(0);     // one still unclaimed is stale now
+            busy_samples_ = 0;
+        } else if (idle_samples_ >= scaling_.shrink_after && running > min_flexible_
+                   && retirements_.load(std::memory_order_relaxed) == 0) {
+            // Whichever flexible worker next comes up empty takes it; the one parked now is
+            // woken to look.
+            retirements_.fetch_add(1);
+            flex_lot_.epoch.fetch_add(1);
+            flex_lot_.epoch.notify_all();
+            idle_samples_ = 0;
+        }
+    }
+
+    static int64_t steady_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Flexible workers skip the pinned workers' deques here: those may hold only PinnedOnly
+    // tasks, and their owner is awake to run whatever is in them anyway.
+    bool has_work(const Worker& self) const {
+        if (self.pinned) {
+            if (!pinned_queue_.empty() || !flex_queue_.empty()) return true;
+        } else if (!flex_queue_.empty() || should_help_pinned()) {
+            return true;
+        }
+        if (!work_stealing_) return false;
+        for (const auto& worker : workers_) {
+            if ((self.pinned || !worker->pinned) && !worker->deque.empty()) return true;
+        }
+        return false;
+    }
+
+    // Pushes t onto the calling worker's own deque if that worker may run it; leaves t alone
+    // and returns false otherwise, or when the deque is full.
+    bool submit_local(Worker& self, Task& t, TaskClass cls) {
+        if (!work_stealing_) return false;
+        if (pinned_count_ == 0) cls = TaskClass::Flexible;
+        if (!self.pinned && cls != TaskClass::Flexible) return false;
+        Task* node;
+        if (!self.free_nodes.empty()) {
+            node = self.free_nodes.back();
+            self.free_nodes.pop_back();
+            *node = std::move(t);
+        } else {
+            node = new Task(std::move(t));
+        }
+        if (!self.deque.push(tag(node, cls))) {
+            t = std::move(*node);
+            release_node(self, node);
+            return false;
+        }
+        auto& stat_counter = cls == TaskClass::Flexible ? stats_.submitted_flexible : stats_.submitted_pinned;
+        stat_counter.fetch_add(1, std::memory_order_relaxed);
+        stats_.local.fetch_add(1, std::memory_order_relaxed);
+        wake_for_local(cls);
+        return true;
+    }
+
+    // One pass over the other workers' deques from a random victim.
+    bool steal(Worker& self, uintptr_t& item) {
+        const std::size_t n = workers_.size();
+        if (n < 2) return false;
+        self.rng ^= self.rng << 13;
+        self.rng ^= self.rng >> 7;
+        self.rng ^= self.rng << 17;
+        const std::size_t first = self.rng % n;
+        for (std::size_t i = 0; i < n; ++i) {
+            Worker& victim = *workers_[(first + i) % n];
+            if (&victim == &self || victim.deque.empty()) continue;
+            bool stolen = self.pinned
+                ? victim.deque.steal(item)
+                : victim.deque.steal_if(item, [](uintptr_t v) { return class_of(v) != TaskClass::PinnedOnly; });
+            if (stolen) {
+                stats_.steals.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run_local(Worker& self, uintptr_t item) {
+        Task* node = node_of(item);
+        execute_task(*node, class_of(item) != TaskClass::Flexible);
+        release_node(self, node);
+    }
+
+    void release_node(Worker& self, Task* node) {
+        *node = nullptr;    // drop the captures now, not when the node is reused
+        if (self.free_nodes.size() < kNodeCache) self.free_nodes.push_back(node);
+        else delete node;
+    }
+
+    // Called spinning; returns spinning again (a woken worker looks for work before it parks
+    // again).
+    void park(ParkingLot& lot, const Worker& self) {
+        uint32_t epoch = lot.epoch.load();
+        lot.sleepers.fetch_add(1);
+        lot.spinning.fetch_sub(1);
+        // Pairs with the fence in wake_for(): either this re-check sees the task just pushed,
+        // or the submitter sees this worker in sleepers, not spinning, and bumps epoch.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!has_work(self) && !stop_.load(std::memory_order_relaxed)) {
+            stats_.parks.fetch_add(1, std::memory_order_relaxed);
+            lot.epoch.wait(epoch);
+        }
+        lot.spinning.fetch_add(1);
+        lot.sleepers.fetch_sub(1);
+        // Take over a wake in flight, this one or one meant for another sleeper: it has
+        // somebody awake now. After the sleepers decrement, so a waker that counted this worker
+        // has its increment seen here.
+        uint32_t waking = lot.waking.load();
+        while (waking > 0 && !lot.waking.compare_exchange_weak(waking, waking - 1)) {}
+    }
+
+    // Makes sure a worker of the lot is awake or on its way, waking at most one; false when
+    // the lot has neither awake nor parked workers. A wake still in flight counts as awake,
+    // so a burst of submits costs one futex wake, and the woken worker passes it on when it
+    // finds work.
+    bool wake_one(ParkingLot& lot) {
+        for (;;) {
+            if (lot.spinning.load() > 0 || lot.waking.load() > 0) return true;
+            if (lot.sleepers.load() == 0) return false;
+            lot.waking.fetch_add(1);
+            if (lot.sleepers.load() > 0) break;
+            // Nobody is parked after all: withdraw the wake so it does not hide a worker that
+            // parks next, and look again.
+            lot.waking.fetch_sub(1);
+        }
+        lot.epoch.fetch_add(1);
+        lot.epoch.notify_one();
+        stats_.wakes.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Makes sure a worker that can run a task of q is awake, waking at most one: pinned
+    // workers also drain the flexible queue, flexible ones help with the pinned queue once it
+    // backs up.
+    void wake_for(const lf::ArrayMPMCQueue<Task>* q) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (q == &pinned_queue_) {
+            if (!wake_one(pinned_lot_) && should_help_pinned()) wake_one(flex_lot_);
+        } else if (!wake_one(flex_lot_)) {
+            wake_one(pinned_lot_);
+        }
+    }
+
+    // The same for a task pushed onto a worker's own deque: any worker allowed to run it can
+    // steal it.
+    void wake_for_local(TaskClass cls) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        switch (cls) {
+            case TaskClass::PinnedOnly:
+                wake_one(pinned_lot_);
+                break;
+            case TaskClass::PreferPinned:
+                if (!wake_one(pinned_lot_)) wake_one(flex_lot_);
+                break;
+            case TaskClass::Flexible:
+            default:
+                if (!wake_one(flex_lot_)) wake_one(pinned_lot_);
+                break;
+        }
     }
 
     inline bool should_help_pinned() const {
@@ -160,11 +589,31 @@ private:
 
     lf::ArrayMPMCQueue<Task> pinned_queue_;
     lf::ArrayMPMCQueue<Task> flex_queue_;
+    ParkingLot pinned_lot_;
+    ParkingLot flex_lot_;
     std::vector<std::thread> pinned_workers_;
     std::vector<std::thread> flexible_workers_;
     std::atomic<bool> stop_;
     std::vector<int> pinned_core_ids_;
+    std::vector<int> flexible_cpus_;
+    const bool work_stealing_ = true;
+    std::size_t pinned_count_ = 0;
+    std::size_t min_flexible_ = 0;
+    std::vector<std::unique_ptr<Worker>> workers_;
     Stats stats_{};
+
+    // The scaler's; retirements_ is claimed by the idle flexible workers.
+    const PoolScalingConfig scaling_{};
+    std::thread scaler_;
+    std::mutex scaler_mutex_;
+    std::condition_variable scaler_cv_;
+    unsigned busy_samples_ = 0;
+    unsigned idle_samples_ = 0;
+    std::atomic<uint32_t> retirements_{0};
+    std::atomic<int64_t> probe_sent_ns_{0};     // 0: no probe in the queue
+    std::atomic<int64_t> probe_wait_ns_{0};
+
+    static inline thread_local Worker* t_worker = nullptr;     // the calling thread's worker, any pool
 };
 
 } // namespace concurrency
@@ -7,8 +7,9 @@
 #include <cassert>
 
 // A per-connection ordered callback buffer.
-// Single producer per sequence insertion from IO thread for reservation, multiple producers from worker completion can be adapted
-// For simplicity here we assume all completions are enqueued via push(seq, fn) possibly from many threads; consumption is single-thread (IO reactor)
+// Sequence numbers are handed out by one thread (the IO reactor) and announced with expect_until();
+// completions push(seq, fn) from any thread. drain() runs the callbacks in sequence order and must
+// only run on one thread at a time (callers serialize it, see net::RequestPipeline).
 
 namespace concurrency {
 
@@ -25,19 +26,20 @@ public:
 
     // returns false if window full (caller should back off)
     bool push(uint64_t seq, Callback cb) {
-        if (seq < base_) {
+        uint64_t base = base_.load(std::memory_order_acquire);
+        if (seq < base) {
             return false; // already consumed
         }
-        if (seq >= base_ + window_) {
+        if (seq >= base + window_) {
             return false; // window overflow
         }
         auto & slot = slots_[seq & mask_];
-        // spin until free OR already set (should not happen under correct usage)
-        bool expected = false;
-        if (!slot.ready.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+        if (slot.ready.load(std::memory_order_acquire)) {
             return false; // collision (window too small)
         }
+        // Each sequence number is pushed once, so the slot is ours: publish the callback with the flag.
         slot.cb = std::move(cb);
+        slot.ready.store(true, std::memory_order_release);
         return true;
     }
 
@@ -47,31 +49,39 @@ public:
         size_t processed = 0;
         while (true) {
             if (limit && processed >= limit) break;
-            auto seq = base_;
-            if (seq >= next_expected_) break; // nothing to do
+            auto seq = base_.load(std::memory_order_relaxed);
+            if (seq >= next_expected_.load(std::memory_order_acquire)) break; // nothing to do
             auto & slot = slots_[seq & mask_];
             if (!slot.ready.load(std::memory_order_acquire)) break; // gap
             auto cb = std::move(slot.cb);
             slot.cb = nullptr;
             slot.ready.store(false, std::memory_order_release);
-            ++base_;
+            base_.store(seq + 1, std::memory_order_release);
             if (cb) consume(std::move(cb));
             ++processed;
         }
         return processed;
     }
 
-    void expect_until(uint64_t next_seq_exclusive) { next_expected_ = next_seq_exclusive; }
+    // Whether drain() would run at least one callback.
+    bool head_ready() const {
+        auto seq = base_.load(std::memory_order_acquire);
+        return seq < next_expected_.load(std::memory_order_acquire)
+            && slots_[seq & mask_].ready.load(std::memory_order_acquire);
+    }
+
+    void expect_until(uint64_t next_seq_exclusive) { next_expected_.store(next_seq_exclusive, std::memory_order_release); }
 
-    uint64_t base() const { return base_; }
+    uint64_t base() const { return base_.load(std::memory_order_acquire); }
+    uint64_t window() const { return window_; }
 
 private:
     struct Slot {
         std::atomic<bool> ready{false};
         Callback cb{};
     };
-    uint64_t base_{0};
-    uint64_t next_expected_{0};
+    std::atomic<uint64_t> base_{0};
+    std::atomic<uint64_t> next_expected_{0};
     const uint64_t window_;
     const uint64_t mask_;
     std::vector<Slot> slots_;
@@ -1,6 +1,11 @@
 #pragma once
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
-#include <vector>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
 
 namespace concurrency {
 
@@ -10,15 +15,116 @@ enum class TaskClass : uint8_t {
     PinnedOnly       // Must run on pinned worker (if none exist -> fallback to flexible)
 };
 
+// A strand on top of an executor (normally LFThreadPool::submit): tasks posted to one series
+// run one at a time, in the order they were posted, each seeing everything the previous one
+// wrote. Different series run in parallel.
+//
+// post() may be called from any thread. Whoever finds the series idle schedules a drain on
+// the executor; the drain runs up to `batch` tasks and then re-submits itself if more are
+// queued, so one busy series does not hold a worker forever. Nothing runs on the posting
+// thread: when the executor refuses the first drain (queue full) the series stalls, its tasks
+// wait, and post() returns false until retry() gets a drain accepted. A drain refused at a
+// batch boundary keeps going on its worker. Pending tasks sit in an intrusive MPSC list
+// (Vyukov), the drain being its single consumer.
 template<typename Task>
-class SeriesTask {
+class SeriesTask : public std::enable_shared_from_this<SeriesTask<Task>> {
+public:
+    using Ptr = std::shared_ptr<SeriesTask>;
+    using Executor = std::function<bool(Task)>;   // false: rejected, not run
 
+    static constexpr std::size_t kDefaultBatch = 32;
+
+    static Ptr create(Executor executor, std::size_t batch = kDefaultBatch) {
+        return Ptr(new SeriesTask(std::move(executor), batch));
+    }
+
+    SeriesTask(const SeriesTask&) = delete;
+    SeriesTask& operator=(const SeriesTask&) = delete;
+
+    ~SeriesTask() {
+        // Nothing is draining: a drain holds a reference to the series.
+        Node* node = tail_;
+        while (node != nullptr) {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+
+    // Queues the task. False while the series is stalled: the task waits for retry().
+    bool post(Task task) {
+        Node* node = new Node(std::move(task));
+        Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+        if (pending_.fetch_add(1, std::memory_order_acq_rel) == 0) schedule();
+        return !stalled();
+    }
+
+    // Offers the refused drain to the executor again; true once it is accepted or when the
+    // series is not stalled. Whoever saw post() fail calls it, one caller at a time.
+    bool retry() {
+        if (!stalled()) return true;
+        // Cleared first: once the drain is accepted it may finish, and a later post() may
+        // stall the series again before this returns.
+        stalled_.store(false, std::memory_order_release);
+        if (executor_([self = this->shared_from_this()] { self->drain(); })) return true;
+        stalled_.store(true, std::memory_order_release);
+        return false;
+    }
+
+    bool stalled() const { return stalled_.load(std::memory_order_acquire); }
+
+    // Posted and not finished yet, the running one included.
+    std::size_t pending() const { return pending_.load(std::memory_order_acquire); }
 
 private:
-    std::vector<Task> tasks_;
-};
+    struct Node {
+        Node() = default;
+        explicit Node(Task t) : task(std::move(t)) {}
+        Task task{};
+        std::atomic<Node*> next{nullptr};
+    };
 
+    SeriesTask(Executor executor, std::size_t batch)
+        : executor_(std::move(executor)), batch_(batch == 0 ? 1 : batch), tail_(new Node()), head_(tail_) {}
 
+    void schedule() {
+        if (!executor_([self = this->shared_from_this()] { self->drain(); })) {
+            stalled_.store(true, std::memory_order_release);
+        }
+    }
 
+    // The only consumer: pending_ went from 0 to non-zero for it, and it runs until pending_
+    // is back to 0 or it handed the rest to a new drain.
+    void drain() {
+        std::size_t ran = 0;
+        for (;;) {
+            Node* next = tail_->next.load(std::memory_order_acquire);
+            while (next == nullptr) {
+                // A post() between its exchange and its link: it is counted, so it is coming.
+                std::this_thread::yield();
+                next = tail_->next.load(std::memory_order_acquire);
+            }
+            delete tail_;
+            tail_ = next;       // the new stub; its task is ours
+            {
+                Task task = std::move(next->task);
+                task();
+            }
+            if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) return;
+            if (++ran == batch_) {
+                if (executor_([self = this->shared_from_this()] { self->drain(); })) return;
+                ran = 0;        // refused: keep going on this worker
+            }
+        }
+    }
+
+    Executor executor_;
+    const std::size_t batch_;
+    Node* tail_;                        // consumer side: the stub, its task already run
+    std::atomic<Node*> head_;           // last posted node
+    std::atomic<std::size_t> pending_{0};
+    std::atomic<bool> stalled_{false};  // tasks pending, no drain scheduled
+};
 
-}; // namespace concurrency
\ No newline at end of file
+}; // namespace concurrency
@@ -9,6 +9,7 @@
 #include "mysql_pool.h"
 #include "common/debug.h"
 #include "db_error.h"
+#include "metrics/trace.h"
 
 // struct FileMetadata {
 //     size_t id;                  // Unique identifier for the file
@@ -98,6 +99,7 @@ FileRepository& FileRepository::operator=(FileRepository&& other) {
 }
 
 bool FileRepository::insertFile(const FileMetadata& file) {
+    metrics::trace::Span span("FileRepository::insertFile", "db");
     MYSQL* conn = pool_->getConnection();
     if (!conn) return false;
 
@@ -114,6 +116,7 @@ bool FileRepository::insertFile(const FileMetadata& file) {
 }
 
 bool FileRepository::increaseFile(const size_t file_id) {
+    metrics::trace::Span span("FileRepository::increaseFile", "db");
     MYSQL* conn = pool_->getConnection();
     if (!conn) return false;
 
@@ -129,6 +132,7 @@ bool FileRepository::increaseFile(const size_t file_id) {
 
 
 bool FileRepository::reduceFile(const size_t file_id) {
+    metrics::trace::Span span("FileRepository::reduceFile", "db");
     MYSQL* conn = pool_->getConnection();
     if (!conn) return false;
 
@@ -144,6 +148,7 @@ bool FileRepository::reduceFile(const size_t file_id) {
 
 
 bool FileRepository::deleteFile(const size_t file_id) {
+    metrics::trace::Span span("FileRepository::deleteFile", "db");
     MYSQL* conn = pool_->getConnection();
     if (!conn) return false;
 
@@ -158,6 +163,7 @@ bool FileRepository::deleteFile(const size_t file_id) {
 }
 
 std::optional<FileMetadata> FileRepository::getByHash(const std::string& hashCode) {
+    metrics::trace::Span span("FileRepository::getByHash", "db");
     // Fast path via cache (read-through). To avoid recursive dependency, cache header included elsewhere.
     // didn't include cache header here directly to keep layering minimal; external callers may prefer using adapter.
     MYSQL* conn = pool_->getConnection();
@@ -195,6 +201,7 @@ std::optional<FileMetadata> FileRepository::getByHash(const std::string& hashCod
 }
 
 std::optional<FileMetadata> FileRepository::getById(size_t file_id) {
+    metrics::trace::Span span("FileRepository::getById", "db");
     MYSQL* conn = pool_->getConnection();
     if (!conn) {
         error_cpp20("MySQL query failed: " + std::string(mysql_error(conn)));
@@ -7,6 +7,8 @@ extern "C" {
 #include <mutex>
 
 #include "common/debug.h"
+#include "metrics/metrics.h"
+#include "metrics/trace.h"
 
 #if defined(__i386__) || defined(__x86_64__)
 #include <immintrin.h>
@@ -18,6 +20,30 @@ extern "C" {
 
 namespace db {
 
+namespace {
+
+// A repository call takes one connection, runs its query and gives it back, so the time a
+// connection is held is the time of the DB call.
+struct DBMetrics {
+    metrics::Histogram& wait;
+    metrics::Histogram& query;
+};
+
+DBMetrics& db_metrics() {
+    constexpr std::string_view kName = "fileserver_db_seconds";
+    constexpr std::string_view kHelp = "MySQL pool: waiting for a connection, and holding it for a call.";
+    auto& registry = metrics::Registry::global();
+    static DBMetrics m{registry.histogram(kName, kHelp, {{"phase", "wait"}}),
+                       registry.histogram(kName, kHelp, {{"phase", "query"}})};
+    return m;
+}
+
+// The connection this thread took last and when; a thread holds one at a time.
+thread_local MYSQL* t_held = nullptr;
+thread_local int64_t t_held_since = 0;
+
+} // namespace
+
 void MySQLPool::init(const MySQLConfig& config) {
     config_ = config;
     is_initialized_ = true;
@@ -58,7 +84,14 @@ void MySQLPool::destroy() {
 MYSQL* MySQLPool::getConnection() {
     MYSQL* conn = nullptr;
 
+    int64_t start = metrics::now_ns();
     while (!connections_.pop(conn)) {}
+    t_held = conn;
+    t_held_since = metrics::now_ns();
+    db_metrics().wait.record(static_cast<uint64_t>(t_held_since - start));
+    if (uint64_t trace_id = metrics::trace::current()) {
+        metrics::trace::record(trace_id, "MySQLPool wait", "db", start, t_held_since);
+    }
     return conn;
 }
 
@@ -66,6 +99,10 @@ void MySQLPool::releaseConnection(MYSQL* conn) {
     if (conn == nullptr) {
         return;
     }
+    if (conn == t_held) {
+        db_metrics().query.record(static_cast<uint64_t>(metrics::now_ns() - t_held_since));
+        t_held = nullptr;
+    }
     connections_.push(conn);
 }
 
@@ -1,6 +1,7 @@
 #include "mysql_pool.h"
 #include "user_file_repository.h"
 #include "common/debug.h"
+#include "metrics/trace.h"
 #include <optional>
 #include <sstream>
 
@@ -68,6 +69,7 @@ UserFileRepository::~UserFileRepository() {
 }
 
 bool UserFileRepository::insertUserFile(const UserFile& userFile) {
+    metrics::trace::Span span("UserFileRepository::insertUserFile", "db");
     MYSQL* conn = pool_->getConnection();
     if (!conn) return false;
 
@@ -83,6 +85,7 @@ bool UserFileRepository::insertUserFile(const UserFile& userFile) {
 }
 
 bool UserFileRepository::deleteUserFile(const size_t fileId) {
+    metrics::trace::Span span("UserFileRepository::deleteUserFile", "db");
     MYSQL* conn = pool_->getConnection();
     if (!conn) return false;
 
@@ -98,6 +101,7 @@ bool UserFileRepository::deleteUserFile(const size_t fileId) {
 }
 
 std::vector<UserFile> UserFileRepository::getFilesByParentID(int userId, int parentId) {
+    metrics::trace::Span span("UserFileRepository::getFilesByParentID", "db");
     std::vector<UserFile> files;
     MYSQL* conn = pool_->getConnection();
     if (!conn) return files;
@@ -132,6 +136,7 @@ std::vector<UserFile> UserFileRepository::getFilesByParentID(int userId, int par
 }
 
 std::optional<UserFile> UserFileRepository::getFileByParentAndName(int userId, int parentId, const std::string& name) {
+    metrics::trace::Span span("UserFileRepository::getFileByParentAndName", "db");
     MYSQL* conn = pool_->getConnection();
     if (!conn) return std::nullopt;
     std::string condition = "user_id = '" + std::to_string(userId) + "' AND parent_id = " + std::to_string(parentId) +
@@ -161,6 +166,7 @@ std::optional<UserFile> UserFileRepository::getFileByParentAndName(int userId, i
 }
 
 std::optional<UserFile> UserFileRepository::getFileByPath(int userId, const std::string& virtualPath) {
+    metrics::trace::Span span("UserFileRepository::getFileByPath", "db");
     // naive implementation: split by '/' and iteratively descend using parentId
     if (virtualPath.empty() || virtualPath == "/") return std::nullopt; // root directory not a file
     std::string path = virtualPath;
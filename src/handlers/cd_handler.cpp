@@ -23,22 +23,23 @@ void CDHandler::handle() {
     auto file_manager = &storage::FileManager::getInstance();
     if (!file_manager) {
         error_cpp20("FileManager is null in ConnectionContext");
-        jsonResponse = responseBuilder.buildErrorResponse(500, "Internal server error");
+        response = responseBuilder.buildErrorResponse(500, "Internal server error");
         sendResponse(MessageType::ERROR);
         return;
     }
     // try {
-        file_manager->cd(connection_context_->session_context->user_id,jsonRequest.value("params", "/"));
+        const auto* params = requestAs<protocol::CdRequest>();
+        file_manager->cd(connection_context_->session_context->user_id, params ? params->path : std::string("/"));
     // } catch (const storage::FileError& e) {
-    //     jsonResponse = responseBuilder.buildErrorResponse(400, e.what());
+    //     response = responseBuilder.buildErrorResponse(400, e.what());
     //     sendResponse(MessageType::ERROR);
-    //     connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
+    //     finish();
     //     return;
     // }
     auto ret = file_manager->pwd(connection_context_->session_context->user_id);
-    jsonResponse = responseBuilder.build(ret);
+    response = responseBuilder.build(ret);
     sendResponse(MessageType::RESPONSE);
-    connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
+    finish();
 }
 
 } // namespace handlers
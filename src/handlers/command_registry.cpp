@@ -0,0 +1,99 @@
+#include "command_registry.h"
+
+#include <array>
+
+#include "metrics/metrics.h"
+#include "net/block_pool.h"
+#include "handlers/list_handler.h"
+#include "handlers/cd_handler.h"
+#include "handlers/pwd_handler.h"
+#include "handlers/mkdir_handler.h"
+#include "handlers/put_handler.h"
+#include "handlers/rm_handler.h"
+#include "handlers/rmdir_handler.h"
+#include "handlers/register_handler.h"
+#include "handlers/pubkey_handler.h"
+#include "handlers/login_handler.h"
+#include "handlers/get_handler.h"
+#include "handlers/large_put_data_handler.h"
+#include "handlers/hello_handler.h"
+#include "handlers/stat_handler.h"
+#include "handlers/stats_handler.h"
+
+namespace handlers {
+
+namespace {
+
+using protocol::Command;
+
+template <typename H>
+RequestHandler::Ptr make(net::BlockPool* pool) {
+    return net::make_pooled<H>(pool);
+}
+
+// No default case: a Command without a route is a -Wswitch warning and a static_assert below.
+constexpr CommandRoute route_for(Command command) {
+    using R = CommandRoute;
+    switch (command) {
+        case Command::Ls:             return {make<ListHandler>, R::kPipelined};
+        case Command::Pwd:            return {make<PWDHandler>, R::kPipelined};
+        case Command::Cd:             return {make<CDHandler>, 0};
+        // Change the user's tree, so a pipelined ls after them must see the change and a
+        // dependent pair (mkdir a; rmdir a) must not swap: each runs alone, in request order.
+        case Command::Mkdir:          return {make<MKDIRHandler>, 0};
+        case Command::Rm:             return {make<RMHandler>, 0};
+        case Command::Rmdir:          return {make<RMDIRHandler>, 0};
+        case Command::Get:            return {make<GETHandler>, R::kTransfer};
+        // Switches the connection to upload mode before the next frame is read.
+        case Command::Put:            return {make<PUTHandler>, R::kTransfer | R::kInline};
+        case Command::PutDataChannel: return {make<LargePutDataHandler>, R::kTransfer};
+        case Command::Login:          return {make<LoginHandler>, 0};
+        case Command::Register:       return {make<RegisterHandler>, 0};
+        case Command::Pubkey:         return {make<PubKeyHandler>, R::kPipelined};
+        // Changes the framing between two frames, so it runs before the decoder reads the next
+        // header. Cheap, and not subject to admission.
+        case Command::Hello:          return {make<HelloHandler>, R::kInline | R::kUnadmitted};
+        case Command::Stat:           return {make<StatHandler>, R::kPipelined};
+        // Rendering takes a while, so it runs on the pool; answered even under overload.
+        case Command::Stats:          return {make<StatsHandler>, R::kUnadmitted};
+    }
+    return {nullptr, 0};
+}
+
+constexpr std::array<CommandRoute, protocol::kCommandCount + 1> make_routes() {
+    std::array<CommandRoute, protocol::kCommandCount + 1> routes{};
+    for (uint8_t v = 1; v <= protocol::kCommandCount; ++v) routes[v] = route_for(static_cast<Command>(v));
+    return routes;
+}
+
+constexpr auto kRoutes = make_routes();
+
+constexpr bool every_command_routed() {
+    for (uint8_t v = 1; v <= protocol::kCommandCount; ++v) {
+        if (!kRoutes[v].make) return false;
+    }
+    return true;
+}
+static_assert(every_command_routed(), "a protocol::Command has no handler in route_for()");
+
+} // namespace
+
+const CommandRoute& command_route(protocol::Command command) {
+    return kRoutes[static_cast<uint8_t>(command)];
+}
+
+metrics::Histogram& command_latency(protocol::Command command) {
+    static const auto histograms = [] {
+        std::array<metrics::Histogram*, protocol::kCommandCount + 1> h{};
+        for (uint8_t v = 1; v <= protocol::kCommandCount; ++v) {
+            h[v] = &metrics::Registry::global().histogram(
+                "fileserver_command_duration_seconds",
+                "Time from a request's arrival to its last response (transfers: the whole transfer).",
+                {{"command", std::string(protocol::command_name(static_cast<Command>(v)))}});
+        }
+        return h;
+    }();
+    return *histograms[static_cast<uint8_t>(command)];
+}
+
+} // namespace handlers
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+#include "protocol/commands.h"
+#include "handlers/request_handler.h"
+
+namespace net {
+class BlockPool;
+}
+
+namespace metrics {
+class Histogram;
+}
+
+namespace handlers {
+
+// How RequestHandler runs one command: the handler class and the dispatch rules. The table
+// behind command_route() is built at compile time and indexed by the Command value.
+struct CommandRoute {
+    enum Flag : uint8_t {
+        kPipelined  = 1 << 0,   // reads only: own handler, run concurrently, answered in request order
+        kTransfer   = 1 << 1,   // GET/PUT: shed under overload but holds no admission slot
+        kInline     = 1 << 2,   // runs on the reactor thread instead of the thread pool
+        kUnadmitted = 1 << 3,   // bypasses admission control (hello)
+    };
+
+    // A new handler for the command, from the reactor's pool when there is one.
+    RequestHandler::Ptr (*make)(net::BlockPool* pool);
+    uint8_t flags;
+
+    constexpr bool has(Flag flag) const { return (flags & flag) != 0; }
+};
+
+const CommandRoute& command_route(protocol::Command command);
+
+// Time from a request's arrival to its finish(), per command.
+metrics::Histogram& command_latency(protocol::Command command);
+
+} // namespace handlers
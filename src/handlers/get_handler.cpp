@@ -4,10 +4,14 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <cstring>
 #include "utils/hash_utils.h"
 #include "db/user_file_repository.h"
 #include "db/file_repository.h" // kept for other potential uses
 #include "cache/file_meta_cache.h"
+#include "metrics/trace.h"
+#include "storage/disk_metrics.h"
+#include "net/output_drained.h"
 
 // #ifdef ERROR
 // #undef ERROR
@@ -16,21 +20,26 @@
 namespace handlers {
 
 void GETHandler::handle() {
-    auto params = jsonRequest.value("params", nlohmann::json::object());
-    std::string file_name = params.value("file_name", "");
-    uint64_t offset = params.value("offset", 0ULL);
+    concurrency::spawn(serve(std::static_pointer_cast<GETHandler>(shared_from_this())));
+}
+
+// self only keeps the handler alive while the coroutine is suspended.
+concurrency::Co<void> GETHandler::serve([[maybe_unused]] std::shared_ptr<GETHandler> self) {
+    const auto* params = requestAs<protocol::GetRequest>();
+    std::string file_name = params ? params->file_name : std::string();
+    uint64_t offset = params ? params->offset : 0;
     if (file_name.empty()) {
-    jsonResponse = responseBuilder.buildErrorResponse(400, "missing file_name");
+    response = responseBuilder.buildErrorResponse(400, "missing file_name");
     sendResponse(static_cast<MessageType>(3));
-        connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
-        return;
+        finish();
+        co_return;
     }
     // Validate session/user
     if (!connection_context_->session_context) {
-    jsonResponse = responseBuilder.buildErrorResponse(401, "unauthorized");
+    response = responseBuilder.buildErrorResponse(401, "unauthorized");
     sendResponse(static_cast<MessageType>(3));
-        connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
-        return;
+        finish();
+        co_return;
     }
     int user_id = connection_context_->session_context->user_id;
 
@@ -39,72 +48,81 @@ void GETHandler::handle() {
         virtual_path = "/" + virtual_path;
     }
     auto& userFileRepo = db::UserFileRepository::getInstance();
-    auto user_file_opt = userFileRepo.getFileByPath(user_id, virtual_path);
+    auto user_file_opt = co_await dbCall([&] { return userFileRepo.getFileByPath(user_id, virtual_path); });
     if (!user_file_opt) {
-        jsonResponse = responseBuilder.buildErrorResponse(404, "virtual path not found");
+        response = responseBuilder.buildErrorResponse(404, "virtual path not found");
         sendResponse(static_cast<MessageType>(3));
-        connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
-        return;
+        finish();
+        co_return;
     }
     if (user_file_opt->fileType != FileType::FILE) {
-        jsonResponse = responseBuilder.buildErrorResponse(400, "not a regular file");
+        response = responseBuilder.buildErrorResponse(400, "not a regular file");
         sendResponse(static_cast<MessageType>(3));
-        connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
-        return;
+        finish();
+        co_return;
     }
     size_t file_id = user_file_opt->fileId;
-    auto meta_opt = FileMetaCache::instance().getById(file_id);
+    auto meta_opt = FileMetaCache::instance().cachedById(file_id);
+    if (!meta_opt) meta_opt = co_await dbCall([&] { return FileMetaCache::instance().getById(file_id); });
     if (!meta_opt) {
-        jsonResponse = responseBuilder.buildErrorResponse(404, "file metadata not found");
+        response = responseBuilder.buildErrorResponse(404, "file metadata not found");
         sendResponse(static_cast<MessageType>(3));
-        connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
-        return;
+        finish();
+        co_return;
     }
     uint64_t file_size = meta_opt->fileSize;
     if (offset > file_size) offset = file_size;
     std::string hash_code = meta_opt->hashCode;
 
     auto& got = storage::GlobalOpenTable::getInstance();
-    auto fd_opt = got.openFile(hash_code);
+    auto fd_opt = co_await diskCall([&] { return got.openFile(hash_code); });
     if (!fd_opt) {
-        jsonResponse = responseBuilder.buildErrorResponse(500, "open physical file failed");
+        response = responseBuilder.buildErrorResponse(500, "open physical file failed");
         sendResponse(static_cast<MessageType>(3));
-        connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
-        return;
+        finish();
+        co_return;
     }
     int fd = *fd_opt;
-    ::lseek(fd, offset, SEEK_SET);
     std::string file_hash = meta_opt->hashCode;
-    jsonResponse = responseBuilder.buildGetInitResponse(file_name, offset, file_size, file_hash);
+    response = responseBuilder.buildGetInitResponse(file_name, offset, file_size, file_hash);
     sendResponse(MessageType::RESPONSE);
 
-    const size_t CHUNK = 64*1024;
-    std::vector<char> buf(CHUNK);
+    // The body follows from here: a slow client neither pins a worker nor buffers the whole
+    // file, and the reactor only sends what is read.
+    const int64_t started_at = trace_id_ != 0 ? metrics::now_ns() : 0;
+    co_await streamBody(fd, offset);
+    got.closeFile(hash_code);
+    if (trace_id_ != 0) metrics::trace::record(trace_id_, "get stream", "handler", started_at, metrics::now_ns());
+    finish();
+}
+
+concurrency::Co<void> GETHandler::streamBody(int fd, uint64_t offset) {
+    auto ctx = connection_context_;
+    const size_t chunk = ctx->wire.chunk_size();
     while (true) {
-        ssize_t rn = ::read(fd, buf.data(), buf.size());
+        net::FrameRef frame = ctx->reactor_context->frame_pool->acquire(chunk, ctx->wire);
+        // pread: the descriptor is shared through GlobalOpenTable, so no file position is used.
+        // The read overlaps with sending the previous chunk.
+        ssize_t rn = co_await diskCall([&] {
+            storage::DiskTimer timer(storage::DiskOp::Read);
+            ssize_t n = ::pread(fd, frame->body(), chunk, static_cast<off_t>(offset));
+            return n < 0 ? -ssize_t{errno} : n;    // errno stays on the disk thread
+        });
         if (rn < 0) {
-            error_cpp20("read error during get: " + std::string(strerror(errno)));
-            break;
-        }
-        Message msg{};
-        msg.header.type = static_cast<uint8_t>(MessageType::GET_DATA);
-        if (rn == 0) {
-            msg.header.length = 0;
-            if (::send(connection_context_->connection_id, &msg, sizeof(msg.header), 0) < 0) {
-                error_cpp20("send EOF frame failed: " + std::string(strerror(errno)));
-            }
-            break;
-        }
-        if (rn > (ssize_t)sizeof(msg.body)) rn = sizeof(msg.body);
-        msg.header.length = rn;
-        memcpy(msg.body, buf.data(), rn);
-        if (::send(connection_context_->connection_id, &msg, sizeof(msg.header)+msg.header.length, 0) < 0) {
-            error_cpp20("send chunk failed: " + std::string(strerror(errno)));
-            break;
+            const std::string reason = strerror(static_cast<int>(-rn));
+            error_cpp20("read error during get: " + reason);
+            // Not the EOF frame: the client would keep a truncated file.
+            response = responseBuilder.buildErrorResponse(500, "read error: " + reason);
+            sendResponse(MessageType::ERROR);
+            co_return;
         }
+        if (!co_await net::output_drained(ctx)) co_return;   // connection gone
+        frame->header().type = static_cast<uint8_t>(MessageType::GET_DATA);
+        frame->header().length = static_cast<uint32_t>(rn);
+        queueResponse(*ctx, std::move(frame));
+        if (rn == 0) co_return;
+        offset += static_cast<uint64_t>(rn);
     }
-    got.closeFile(hash_code);
-    connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
 }
 
 } // namespace handlers
@@ -2,6 +2,7 @@
 
 #include "request_handler.h"
 #include "storage/file_manager.h"
+#include "metrics/metrics.h"
 #include <memory>
 
 namespace handlers {
@@ -11,9 +12,17 @@ public:
     GETHandler() = default;
     ~GETHandler() override = default;
 
+    // Starts serve(): the metadata lookups and the open suspend on the DB and disk executors
+    // instead of holding this worker.
     void handle() override;
 private:
-    void streamFile(const std::string& file_name, uint64_t start_offset);
+    // self keeps the handler alive while the coroutine is suspended.
+    concurrency::Co<void> serve(std::shared_ptr<GETHandler> self);
+    // GET_DATA frames from fd, read on the disk executor, each queued once the connection's
+    // output is down to the low watermark; the last frame has length 0, an ERROR frame ends a
+    // failed read. Chunks are the connection's WireFormat::chunk_size() (64KB on v1, up to 1MB
+    // on v2).
+    concurrency::Co<void> streamBody(int fd, uint64_t offset);
 };
 
 } // namespace handlers
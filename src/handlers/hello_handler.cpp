@@ -0,0 +1,26 @@
+#include "hello_handler.h"
+
+#include <algorithm>
+
+#include "common/debug.h"
+#include "net/frame_decoder.h"
+#include "protocol/wire_format.h"
+
+namespace handlers {
+void HelloHandler::handle() {
+    protocol::HelloRequest params;
+    if (const auto* hello = requestAs<protocol::HelloRequest>()) params = *hello;
+    auto format = protocol::negotiate(static_cast<uint8_t>(std::min<uint32_t>(params.version, 255)),
+                                      params.capabilities, params.max_frame);
+    // The answer still goes out in the old format, everything after it in the new one.
+    response = responseBuilder.buildHelloResponse(format.version, format.capabilities, format.max_body);
+    sendResponse(MessageType::RESPONSE);
+    connection_context_->wire = format;
+    connection_context_->decoder->set_format(format);
+    log_cpp20("[HelloHandler] fd=" + std::to_string(connection_context_->connection_id)
+              + " protocol v" + std::to_string(format.version)
+              + " capabilities=" + std::to_string(format.capabilities)
+              + " max_body=" + std::to_string(format.max_body));
+    finish();
+}
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include "request_handler.h"
+
+namespace handlers {
+// Protocol version and capability negotiation; runs on the reactor thread (see dispatch()).
+class HelloHandler : public RequestHandler {
+public:
+    void handle() override;
+};
+}
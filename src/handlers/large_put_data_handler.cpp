@@ -9,8 +9,13 @@
 #include <sys/types.h>
 #include <errno.h>
 #include <vector>
+#include <algorithm>
 #include <openssl/sha.h>
 #include "storage/file_manager.h"
+#include "net/frame_decoder.h"
+#include "net/socket_profile.h"
+#include "metrics/trace.h"
+#include "storage/disk_metrics.h"
 
 namespace {
 constexpr size_t SPLICE_CHUNK = 64 * 1024; // 64KB
@@ -19,6 +24,8 @@ constexpr size_t SPLICE_CHUNK = 64 * 1024; // 64KB
 namespace handlers {
 
 void LargePutDataHandler::recvRequest() {
+    // Runs on the reactor: the writes and the hash check belong to the channel request's trace.
+    metrics::trace::Scope scope(trace_id_);
     // For now just reuse base behavior (JSON message). After READY -> will be replaced by splice loop in next task.
     if (state_ == State::INIT) {
         RequestHandler::recvRequest();
@@ -30,21 +37,22 @@ void LargePutDataHandler::recvRequest() {
 }
 
 bool LargePutDataHandler::consumeToken() {
-    std::string token = jsonRequest["params"].value("token", "");
-    std::string file_hash = jsonRequest["params"].value("file_hash", "");
+    const auto* params = requestAs<protocol::PutDataChannelRequest>();
+    std::string token = params->token;
+    std::string file_hash = params->file_hash;
     if (token.empty()) {
-        jsonResponse = responseBuilder.buildErrorResponse(400, "missing token");
+        response = responseBuilder.buildErrorResponse(400, "missing token");
         sendResponse(MessageType::ERROR);
         state_ = State::ERROR; return false;
     }
     PendingLargeUpload tmp;
     if (!LargeUploadRegistry::instance().consume(token, tmp)) {
-        jsonResponse = responseBuilder.buildErrorResponse(403, "invalid or used token");
+        response = responseBuilder.buildErrorResponse(403, "invalid or used token");
         sendResponse(MessageType::ERROR); state_ = State::ERROR; return false;
     }
     // Optional file_hash check
     if (!file_hash.empty() && !tmp.file_hash.empty() && file_hash != tmp.file_hash) {
-        jsonResponse = responseBuilder.buildErrorResponse(400, "file_hash mismatch");
+        response = responseBuilder.buildErrorResponse(400, "file_hash mismatch");
         sendResponse(MessageType::ERROR); state_ = State::ERROR; return false;
     }
     plu_ = std::move(tmp);
@@ -67,22 +75,21 @@ bool LargePutDataHandler::prepareFile() {
 }
 
 void LargePutDataHandler::sendReady() {
-    // jsonResponse = responseBuilder.buildSuccessResponse("large_put_channel_ready");
-    jsonResponse = responseBuilder.build("large_put_channel_ready");
+    // response = responseBuilder.buildSuccessResponse("large_put_channel_ready");
+    response = responseBuilder.build("large_put_channel_ready");
     sendResponse(MessageType::RESPONSE);
 }
 
 void LargePutDataHandler::handle() {
     if (state_ == State::INIT) {
-        // Expect command == put_data_channel in jsonRequest
-        std::string cmd = jsonRequest.value("command", "");
-        if (cmd != "put_data_channel") {
-            jsonResponse = responseBuilder.buildErrorResponse(400, "invalid command for data channel");
+        // Expect command == put_data_channel
+        if (!requestAs<protocol::PutDataChannelRequest>()) {
+            response = responseBuilder.buildErrorResponse(400, "invalid command for data channel");
             sendResponse(MessageType::ERROR); state_ = State::ERROR; return;
         }
         if (!consumeToken()) return; // error already responded
         if (!prepareFile()) {
-            jsonResponse = responseBuilder.buildErrorResponse(500, "open/create file failed");
+            response = responseBuilder.buildErrorResponse(500, "open/create file failed");
             sendResponse(MessageType::ERROR); state_ = State::ERROR; return;
         }
         state_ = State::READY;
@@ -97,7 +104,7 @@ void LargePutDataHandler::tryStartReceiving() {
     if (pipe_in_ == -1 || pipe_out_ == -1) {
         int pfd[2];
         if (pipe(pfd) != 0) {
-            jsonResponse = responseBuilder.buildErrorResponse(500, "pipe failed");
+            response = responseBuilder.buildErrorResponse(500, "pipe failed");
             sendResponse(MessageType::ERROR); state_ = State::ERROR; return;
         }
         pipe_in_ = pfd[1];
@@ -106,22 +113,7 @@ void LargePutDataHandler::tryStartReceiving() {
         fcntl(pipe_in_, F_SETFL, O_NONBLOCK);
         fcntl(pipe_out_, F_SETFL, O_NONBLOCK);
     }
-    // Tune SO_RCVLOWAT (best-effort, only once)
-    static thread_local bool lowat_set = false;
-    if (!lowat_set) {
-        long page = ::sysconf(_SC_PAGESIZE);
-        if (page <= 0) page = 4096;
-        // choose k so that k*page ~= 64KB (or min(file_size, 128KB))
-        uint64_t target = std::min<uint64_t>(plu_.file_size, 128ull * 1024ull);
-        uint64_t k = target / page; if (k == 0) k = 1; if (k > 32) k = 32; // cap
-        int lowat = static_cast<int>(k * page);
-        if (setsockopt(connection_context_->connection_id, SOL_SOCKET, SO_RCVLOWAT, &lowat, sizeof(lowat)) != 0) {
-            log_cpp20("[LargePutDataHandler] SO_RCVLOWAT set failed: " + std::string(strerror(errno)));
-        } else {
-            log_cpp20("[LargePutDataHandler] SO_RCVLOWAT set to " + std::to_string(lowat));
-        }
-        lowat_set = true;
-    }
+    net::use_socket_profile(*connection_context_, net::SocketProfileKind::BulkUpload);
     state_ = State::RECEIVING;
     receiveLoop();
 }
@@ -129,12 +121,36 @@ void LargePutDataHandler::tryStartReceiving() {
 void LargePutDataHandler::receiveLoop() {
     if (state_ != State::RECEIVING) return;
     int sockfd = connection_context_->connection_id;
+    // Upload bytes that arrived together with the last JSON frame sit in the frame decoder.
+    auto& decoder = *connection_context_->decoder;
+    while (decoder.buffered() > 0 && received_ < plu_.file_size) {
+        auto raw = decoder.raw_bytes();
+        size_t take = std::min<uint64_t>(raw.size(), plu_.file_size - received_);
+        ssize_t w;
+        {
+            storage::DiskTimer timer(storage::DiskOp::Write);
+            w = ::write(file_fd_, raw.data(), take);
+        }
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            finalize(false, std::string("write error: ") + strerror(errno));
+            return;
+        }
+        decoder.consume_raw(w);    // already counted as received by the decoder
+        received_ += w;
+    }
+    if (decoder.poller_input() && received_ < plu_.file_size) {
+        // The poller receives for this socket: no splice, the rest comes through the decoder.
+        if (decoder.input_ended()) finalize(false, "peer closed before expected size");
+        return;
+    }
     while (received_ < plu_.file_size) {
         size_t to_read = std::min<uint64_t>(SPLICE_CHUNK, plu_.file_size - received_);
         ssize_t moved = splice(sockfd, nullptr, pipe_in_, nullptr, to_read, SPLICE_F_MOVE | SPLICE_F_MORE);
         if (moved < 0) {
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
                 // wait for next EPOLLIN
+                updateRcvLowat();
                 return; 
             }
             finalize(false, std::string("splice read error: ") + strerror(errno));
@@ -146,7 +162,11 @@ void LargePutDataHandler::receiveLoop() {
         }
         ssize_t written_total = 0;
         while (written_total < moved) {
-            ssize_t w = splice(pipe_out_, nullptr, file_fd_, nullptr, moved - written_total, SPLICE_F_MOVE | SPLICE_F_MORE);
+            ssize_t w;
+            {
+                storage::DiskTimer timer(storage::DiskOp::Write);
+                w = splice(pipe_out_, nullptr, file_fd_, nullptr, moved - written_total, SPLICE_F_MOVE | SPLICE_F_MORE);
+            }
             if (w < 0) {
                 if (errno == EAGAIN || errno == EWOULDBLOCK) {
                     // allow epoll to wake again
@@ -162,6 +182,7 @@ void LargePutDataHandler::receiveLoop() {
             written_total += w;
         }
         received_ += moved;
+        connection_context_->account_rx(moved);
         if (received_ >= plu_.file_size) break;
         // loop continues while data available (edge-trigger scenario) else return to epoll
     }
@@ -173,6 +194,7 @@ void LargePutDataHandler::receiveLoop() {
 
 bool LargePutDataHandler::computeAndVerifyHash() {
     // Map file and compute SHA1 (fallback: read in blocks if mmap undesired). Simple block read.
+    storage::DiskTimer timer(storage::DiskOp::Verify);
     ::lseek(file_fd_, 0, SEEK_SET);
     SHA_CTX ctx; SHA1_Init(&ctx);
     constexpr size_t BUF_SZ = 256 * 1024;
@@ -197,7 +219,7 @@ bool LargePutDataHandler::computeAndVerifyHash() {
 void LargePutDataHandler::finalize(bool success, const std::string& err) {
     if (state_ == State::COMPLETED || state_ == State::ERROR) return;
     if (success) {
-        jsonResponse = responseBuilder.buildLargePutComplete(plu_.file_name, plu_.file_size, plu_.file_hash, true);
+        response = responseBuilder.buildLargePutComplete(plu_.file_name, plu_.file_size, plu_.file_hash, true);
         sendResponse(MessageType::RESPONSE);
         state_ = State::COMPLETED;
     } else {
@@ -210,13 +232,24 @@ void LargePutDataHandler::finalize(bool success, const std::string& err) {
         } catch (...) {
             // ignore
         }
-        jsonResponse = responseBuilder.buildErrorResponse(500, err);
+        response = responseBuilder.buildErrorResponse(500, err);
         sendResponse(MessageType::ERROR);
         state_ = State::ERROR;
         // On error attempt to remove file (best-effort)
         // (We would need FileManager API for delete; omitted for now)
     }
     closeResources();
+    if (rcvlowat_ != 1 && net::set_socket_rcvlowat(connection_context_->connection_id, 1)) rcvlowat_ = 1;
+    net::leave_socket_profile(*connection_context_, net::SocketProfileKind::BulkUpload);
+}
+
+void LargePutDataHandler::updateRcvLowat() {
+    // Wake up per batch of body, but never ask for more than the client still has to send.
+    const auto& reactor = connection_context_->reactor_context;
+    uint64_t cap = reactor && reactor->socket_profiles ? reactor->socket_profiles->bulk_upload.rcvlowat : 1;
+    int lowat = static_cast<int>(std::max<uint64_t>(1, std::min<uint64_t>(cap, plu_.file_size - received_)));
+    if (lowat == rcvlowat_) return;
+    if (net::set_socket_rcvlowat(connection_context_->connection_id, lowat)) rcvlowat_ = lowat;
 }
 
 void LargePutDataHandler::closeResources() {
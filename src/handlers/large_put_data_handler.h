@@ -27,9 +27,11 @@ private:
     int pipe_out_{-1};
     uint64_t received_{0};
     bool hash_verified_{false};
+    int rcvlowat_{1};                    // SO_RCVLOWAT currently set on the socket
 
     void tryStartReceiving();
     void receiveLoop();
+    void updateRcvLowat();
     bool computeAndVerifyHash();
     void finalize(bool success, const std::string& err="");
     void closeResources();
@@ -6,41 +6,46 @@
 
 namespace handlers {
 void LoginHandler::handle() {
-    auto params = jsonRequest.value("params", nlohmann::json::object());
-    std::string username_enc = params.value("username", "");
-    std::string passhash_enc = params.value("passhash", "");
+    concurrency::spawn(serve(std::static_pointer_cast<LoginHandler>(shared_from_this())));
+}
+
+// self only keeps the handler alive while the coroutine is suspended.
+concurrency::Co<void> LoginHandler::serve([[maybe_unused]] std::shared_ptr<LoginHandler> self) {
+    const auto* params = requestAs<protocol::LoginRequest>();
+    std::string username_enc = params ? params->username : std::string();
+    std::string passhash_enc = params ? params->passhash : std::string();
     if (username_enc.empty() || passhash_enc.empty()) {
-        jsonResponse = responseBuilder.buildErrorResponse(400, "missing username or passhash");
+        response = responseBuilder.buildErrorResponse(400, "missing username or passhash");
         sendResponse(MessageType::ERROR);
-        connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
-        return;
+        finish();
+        co_return;
     }
     auto& rsa = RSAKeyManager::getInstance();
     std::string username = rsa.decrypt(username_enc);
     std::string client_hash = rsa.decrypt(passhash_enc);
     if (username.empty() || client_hash.empty()) {
-        jsonResponse = responseBuilder.buildErrorResponse(400, "decrypt failed");
+        response = responseBuilder.buildErrorResponse(400, "decrypt failed");
         sendResponse(MessageType::ERROR);
-        connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
-        return;
+        finish();
+        co_return;
     }
     std::string err;
-    auto user_opt = AuthManager().loginUser(username, client_hash, &err);
+    auto user_opt = co_await dbCall([&] { return AuthManager().loginUser(username, client_hash, &err); });
     if (!user_opt) {
-        jsonResponse = responseBuilder.buildErrorResponse(401, err.empty()?"login failed":err);
+        response = responseBuilder.buildErrorResponse(401, err.empty()?"login failed":err);
         sendResponse(MessageType::ERROR);
-        connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
-        return;
+        finish();
+        co_return;
     }
     auto session_ctx = SessionStore::instance().create_session(user_opt->id);
     SessionStore::instance().attach_connection(session_ctx->session_id, connection_context_->connection_id);
     // Generate JWT token (RS256) with user_id and session_id using existing RSA private key
     std::string priv_pem = rsa.getPrivateKeyPEM();
     if (priv_pem.empty()) {
-        jsonResponse = responseBuilder.buildErrorResponse(500, "private key unavailable");
+        response = responseBuilder.buildErrorResponse(500, "private key unavailable");
         sendResponse(MessageType::ERROR);
-        connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
-        return;
+        finish();
+        co_return;
     }
     
     auto token_obj = jwt::create()
@@ -56,16 +61,10 @@ void LoginHandler::handle() {
         .sign(jwt::algorithm::rs256(rsa.getPublicKeyPEM(), priv_pem, "", ""));
     std::string token = token_obj;
     session_ctx->session_token = token;
-    nlohmann::json data = {
-        {"token", token},
-        {"user_id", user_opt->id},
-        {"session_id", session_ctx->session_id},
-        {"username", user_opt->username}
-    };
-    jsonResponse = responseBuilder.build(data.dump());
+    response = responseBuilder.buildLoginResponse(token, user_opt->id, session_ctx->session_id, user_opt->username);
     sendResponse(MessageType::RESPONSE);
     connection_context_->session_context = session_ctx;
     storage::FileManager::getInstance().setUser(session_ctx->user_id);
-    connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
+    finish();
 }
 }
@@ -8,6 +8,9 @@
 namespace handlers {
 class LoginHandler : public RequestHandler {
 public:
+    // Starts serve(); the credential check suspends on the DB executor.
     void handle() override;
+private:
+    concurrency::Co<void> serve(std::shared_ptr<LoginHandler> self);
 };
 }
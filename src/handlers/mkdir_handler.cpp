@@ -23,32 +23,33 @@ void MKDIRHandler::handle() {
     auto file_manager = &storage::FileManager::getInstance();
     if (!file_manager) {
         error_cpp20("FileManager is null in ConnectionContext");
-        jsonResponse = responseBuilder.buildErrorResponse(500, "Internal server error");
+        response = responseBuilder.buildErrorResponse(500, "Internal server error");
         sendResponse(MessageType::ERROR);
         return;
     }
     std::string ret;
     // try {
-        if (!jsonRequest.contains("params") || jsonRequest["params"].is_null()) {
+        const auto* params = requestAs<protocol::MkdirRequest>();
+        if (!params || params->path.empty()) {
             error_cpp20("No directory name provided for mkdir");
-            jsonResponse = responseBuilder.buildErrorResponse(400, "No directory name provided");
+            response = responseBuilder.buildErrorResponse(400, "No directory name provided");
             sendResponse(MessageType::ERROR);
-            connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
+            finish();
             return;
 
         }
-        std::string path = jsonRequest["params"];
+        std::string path = params->path;
         file_manager->mkdir(connection_context_->session_context->user_id, path);
         ret = path + " created";
     // } catch (const storage::FileError& e) {
-    //     jsonResponse = responseBuilder.buildErrorResponse(400, e.what());
+    //     response = responseBuilder.buildErrorResponse(400, e.what());
     //     sendResponse(MessageType::ERROR);
-    //     connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
+    //     finish();
     //     return;
     // }
-    jsonResponse = responseBuilder.build(ret);
+    response = responseBuilder.build(ret);
     sendResponse(MessageType::RESPONSE);
-    connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
+    finish();
 }
 
 } // namespace handlers
@@ -6,13 +6,12 @@ void PubKeyHandler::handle() {
     auto& rsa = RSAKeyManager::getInstance();
     std::string pub = rsa.getPublicKeyPEM();
     if (pub.empty()) {
-        jsonResponse = responseBuilder.buildErrorResponse(500, "no pubkey");
+        response = responseBuilder.buildErrorResponse(500, "no pubkey");
         sendResponse(MessageType::ERROR);
     } else {
-        nlohmann::json data = { {"pubkey", pub} };
-        jsonResponse = responseBuilder.build(data.dump());
+        response = responseBuilder.buildPubkeyResponse(pub);
         sendResponse(MessageType::RESPONSE);
     }
-    connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
+    finish();
 }
 }
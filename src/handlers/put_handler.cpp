@@ -1,5 +1,6 @@
 #include "put_handler.h"
 
+#include <chrono>
 #include <vector>
 #include <string>
 
@@ -7,90 +8,87 @@
 #include "types/user_file.h"
 #include "storage/file_manager.h"
 #include "storage/storage_error.h"
-#include "utils/socket_transfer.h"
 #include "utils/hash_utils.h"
 #include "concurrency/lf_thread_pool.h"
 #include "types/pending_large_upload.h"
+#include "net/block_pool.h"
+#include "net/frame_decoder.h"
+#include "net/io_reactor.h"
+#include "net/socket_profile.h"
+#include "utils/log.h"
 
 namespace handlers {
 
 void PUTHandler::recvRequest() {
-    if (receiveCompleteMessage()) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        msg_queue_.push(temp_msg_);
-        log_cpp20("[PUTHandler] queued message length=" + std::to_string(temp_msg_.header.length) + " fd=" + std::to_string(connection_context_->connection_id));
-        
-        // Reset for next message
-        total_received_ = 0;
-        memset(&temp_msg_, 0, sizeof(temp_msg_));
-
-        int submit_fd = connection_context_->connection_id;
-        connection_context_->reactor_context->server_context->thread_pool->submit([self = shared_from_this(), submit_fd]() {
-            log_cpp20("[PUTHandler] thread_pool executing handle fd=" + std::to_string(submit_fd));
-            self->handle();
-        });
-    }
-}
-
-bool PUTHandler::receiveCompleteMessage() {
     int fd = connection_context_->connection_id;
     if (fd < 0) {
         error_cpp20("Invalid connection ID");
         connection_context_->close_callback();
-        return false;
+        return;
     }
-    
-    // First, receive the header if we haven't
-    if (total_received_ == 0) {
-        int nrecv = SocketTransfer::recvAll(fd, (char*)&temp_msg_.header, sizeof(temp_msg_.header));
-        if (nrecv == 0 || nrecv == -3) {
-            connection_context_->close_callback();
-            return false;
-        } else if (nrecv < 0) {
-            error_cpp20("Failed to receive message header");
-            connection_context_->close_callback();
-            return false;
-        }
-
-        MessageType mtype = static_cast<MessageType>(temp_msg_.header.type);
-        if (state_ == PUT_STATE::INIT) {
-            if (mtype != MessageType::REQUEST) {
-                error_cpp20("PUTHandler expected REQUEST header in INIT, got type=" + std::to_string(temp_msg_.header.type));
-                connection_context_->close_callback();
-                return false;
+    auto ctx = connection_context_;
+    bool bad_frame = false;
+    size_t nread = 0;
+    auto accept = [&]() {
+        if (bad_frame || connection_context_ == nullptr) return false;
+        if (ctx->strand && ctx->strand->stalled()) return false;   // waitForPool() resumes
+        if (!preparing_.load()) return true;
+        // Hold the input until prepareToReceive() is done; it asks the reactor to resume.
+        ctx->input_stalled.store(true);
+        return !preparing_.load() && ctx->input_stalled.exchange(false);
+    };
+    auto status = ctx->decoder->read_frames(fd, *ctx->reactor_context->frame_pool, accept,
+        [&](net::FrameRef frame) {
+            MessageType mtype = static_cast<MessageType>(frame->header().type);
+            if (state_ == PUT_STATE::INIT && mtype != MessageType::REQUEST) {
+                error_cpp20("PUTHandler expected REQUEST header in INIT, got type=" + std::to_string(frame->header().type));
+                bad_frame = true;
+                return;
             }
-        } else if (state_ == PUT_STATE::RECEIVING) {
-            if (mtype != MessageType::PUT_DATA) {
-                error_cpp20("PUTHandler expected PUT_DATA in RECEIVING, got type=" + std::to_string(temp_msg_.header.type));
-                connection_context_->close_callback();
-                return false;
+            if (state_ == PUT_STATE::RECEIVING && mtype != MessageType::PUT_DATA) {
+                error_cpp20("PUTHandler expected PUT_DATA in RECEIVING, got type=" + std::to_string(frame->header().type));
+                bad_frame = true;
+                return;
             }
-        }
-        
-        if (temp_msg_.header.length > sizeof(temp_msg_.body)) {
-            error_cpp20("Message body too large: " + std::to_string(temp_msg_.header.length));
-            connection_context_->close_callback();
-            return false;
-        }
+            LOG_TRACE("[PUTHandler] queued message length={} fd={}", frame->header().length, fd);
+            received_.push_back(std::move(frame));
+        }, nread);
+    ctx->account_rx(nread);
+
+    if (bad_frame || status == net::FrameDecoder::Status::Closed || status == net::FrameDecoder::Status::Error) {
+        received_.clear();
+        ctx->close_callback();
+        return;
     }
+    if (received_.empty()) return;
+    // One task per chunk on the connection's strand: chunks are written in arrival order and
+    // never two at once, always on the pool. When the pool is full the chunks wait on the
+    // strand and this socket is not read until the pool takes them.
+    if (!ctx->strand) ctx->strand = ctx->reactor_context->server_context->thread_pool->make_series();
+    auto self = std::static_pointer_cast<PUTHandler>(shared_from_this());
+    bool queued = true;
+    for (auto& frame : received_) {
+        queued = ctx->strand->post([self, frame = std::move(frame)]() {
+            self->processChunk(frame);
+        });
+    }
+    received_.clear();
+    if (!queued) waitForPool(ctx);
+}
 
-    // Then receive the body
-    ssize_t toRecv = temp_msg_.header.length;
-    while (total_received_ < toRecv) {
-        int n = SocketTransfer::recvNonBlocking(fd, (char*)temp_msg_.body + total_received_, toRecv - total_received_);
-        if (n == -1) {
-            // Would block, return false to try again later
-            return false;
-        } else if (n == -2) {
-            break;
-        } else if (n <= 0) {
-            connection_context_->close_callback();
-            return false;
+void PUTHandler::waitForPool(ConnectionContext::Ptr ctx) {
+    constexpr std::chrono::milliseconds kRetry{10};
+    ctx->input_stalled.store(true);
+    // Keeps going after a close too: the queued chunks hold the handler, and the strand must
+    // run them for the upload to roll back.
+    ctx->reactor_context->io_reactor->call_later(kRetry, [ctx]() {
+        if (!ctx->strand->retry()) {
+            waitForPool(ctx);
+            return;
         }
-        total_received_ += n;
-    }
-    
-    return total_received_ == toRecv;
+        ctx->input_stalled.store(false);
+        ctx->reactor_context->response_queue->submit_resume(ctx->connection_id, ctx->connection_generation);
+    });
 }
 
     
@@ -101,11 +99,12 @@ void PUTHandler::handle() {
         connection_context_->close_callback();
         return;
     }
-    log_cpp20("[PUTHandler] handle state=" + std::to_string(static_cast<int>(state_)) + " fd=" + std::to_string(fd));
+    LOG_TRACE("[PUTHandler] handle state={} fd={}", state_, fd);
     if (state_ == PUT_STATE::INIT) {
-        prepareToReceive();
+        preparing_.store(true);
+        concurrency::spawn(prepareToReceive(std::static_pointer_cast<PUTHandler>(shared_from_this())));
     } else if (state_ == PUT_STATE::RECEIVING) {
-        processMessages();
+        // chunks go to processChunk() through the connection's strand
     } else if (state_ == PUT_STATE::COMPLETED) {
         onSuccess("File upload already completed");
     } else {
@@ -115,152 +114,152 @@ void PUTHandler::handle() {
 }
 
 
-void PUTHandler::prepareToReceive() {
+// self only keeps the handler alive while the coroutine is suspended.
+concurrency::Co<void> PUTHandler::prepareToReceive([[maybe_unused]] std::shared_ptr<PUTHandler> self) {
     auto file_manager = &storage::FileManager::getInstance();
     if (!file_manager) {
         error_cpp20("FileManager is null in ConnectionContext");
         onFailed(500, "Internal server error");
-        return;
+        co_return;
+    }
+    const auto* params = requestAs<protocol::PutRequest>();
+    if (!params) {
+        onFailed(400, "Missing 'params' field");
+        co_return;
+    }
+    std::string file_name = params->file_name;
+    std::string file_hash = params->file_hash;
+    uint64_t file_size = params->file_size;
+    if (file_name.empty()) {
+        onFailed(400, "Missing file_name parameter");
+        co_return;
+    }
+    if (file_hash.empty()) {
+        onFailed(400, "Missing file_hash parameter");
+        co_return;
+    }
+    if (file_size == 0) {
+        onFailed(400, "Invalid file_size parameter");
+        co_return;
+    }
+    // Large file threshold 4MB
+    constexpr uint64_t LARGE_THRESHOLD = 4ull * 1024ull * 1024ull;
+    log_cpp20("[PUTHandler] evaluate large upload branch file_size=" + std::to_string(file_size) + " threshold=" + std::to_string(LARGE_THRESHOLD));
+    if (file_size > LARGE_THRESHOLD) {
+        log_cpp20("[PUTHandler] large file path selected, issuing token for '" + file_name + "'");
+        // Defer actual file creation to data channel after token validation.
+        auto token = LargeUploadRegistry::instance().create(connection_context_->session_context->user_id, file_name, file_hash, file_size);
+        log_cpp20("[PUTHandler] large upload token=" + token);
+        response = responseBuilder.buildLargePutInit(file_name, file_size, file_hash, token, "splice", 64*1024);
+        sendResponse(MessageType::RESPONSE);
+        // Roll back to base handler immediately (no in_put_upload flag set)
+        rollbackToBaseHandler();
+        co_return;
+    } else {
+        log_cpp20("[PUTHandler] small/normal file path selected (<= threshold)");
     }
-    // try {
-        if (jsonRequest.find("params") == jsonRequest.end()) {
-            onFailed(400, "Missing 'params' field");
-            return;
-        }
-        std::string file_name = jsonRequest["params"].value("file_name", "");
-        std::string file_hash = jsonRequest["params"].value("file_hash", "");
-        int file_size = jsonRequest["params"].value("file_size", 0);
-        if (file_name.empty()) {
-            onFailed(400, "Missing file_name parameter");
-            return;
-        }
-        if (file_hash.empty()) {
-            onFailed(400, "Missing file_hash parameter");
-            return;
-        }
-        if (file_size <= 0) {
-            onFailed(400, "Invalid file_size parameter");
-            return;
-        }
-        // Large file threshold 4MB
-        constexpr uint64_t LARGE_THRESHOLD = 4ull * 1024ull * 1024ull;
-        log_cpp20("[PUTHandler] evaluate large upload branch file_size=" + std::to_string(file_size) + " threshold=" + std::to_string(LARGE_THRESHOLD));
-        if (static_cast<uint64_t>(file_size) > LARGE_THRESHOLD) {
-            log_cpp20("[PUTHandler] large file path selected, issuing token for '" + file_name + "'");
-            // Defer actual file creation to data channel after token validation.
-            auto token = LargeUploadRegistry::instance().create(connection_context_->session_context->user_id, file_name, file_hash, file_size);
-            log_cpp20("[PUTHandler] large upload token=" + token);
-            jsonResponse = responseBuilder.buildLargePutInit(file_name, file_size, file_hash, token, "splice", 64*1024);
-            sendResponse(MessageType::RESPONSE);
-            // Roll back to base handler immediately (no in_put_upload flag set)
-            rollbackToBaseHandler();
-            return;
-        } else {
-            log_cpp20("[PUTHandler] small/normal file path selected (<= threshold)");
-        }
 
-        if (!file_manager->isFileExists(connection_context_->session_context->user_id, file_name)) {
-            file_manager->createFile(connection_context_->session_context->user_id, file_name, file_hash, file_size);
-        }
-        int fd = file_manager->openFile(connection_context_->session_context->user_id, file_name, file_hash);
-        if (fd < 0) {
-            onFailed(500, "Internal server error");
-            return;
-        }
-        file_handle_ = file_manager->getFileHandle(connection_context_->session_context->user_id, fd);
-        if (!file_handle_) {
-            onFailed(500, "Internal server error");
-            return;
+    // Off the reactor for the lookups below; it goes on reading other connections.
+    co_await concurrency::resume_on(*connection_context_->reactor_context->server_context->thread_pool);
+    const int user_id = connection_context_->session_context->user_id;
+    co_await dbCall([&] {
+        if (!file_manager->isFileExists(user_id, file_name)) {
+            file_manager->createFile(user_id, file_name, file_hash, file_size);
         }
+    });
+    int fd = co_await diskCall([&] { return file_manager->openFile(user_id, file_name, file_hash); });
+    if (fd < 0) {
+        onFailed(500, "Internal server error");
+        co_return;
+    }
+    file_handle_ = file_manager->getFileHandle(user_id, fd);
+    if (!file_handle_) {
+        onFailed(500, "Internal server error");
+        co_return;
+    }
 
-        uint64_t current_pos = file_handle_->getPosition();
-        if (current_pos >= static_cast<uint64_t>(file_size)) {
+    uint64_t current_pos = file_handle_->getPosition();
+    if (current_pos >= file_size) {
 
-            state_ = PUT_STATE::COMPLETED;
-            log_cpp20("[PUTHandler] file already complete file='" + file_name + "' size=" + std::to_string(current_pos) + " fd=" + std::to_string(connection_context_->connection_id));
-            jsonResponse = responseBuilder.buildPutResponse("completed", file_name, current_pos, file_hash);
-            sendResponse(MessageType::RESPONSE);
-            rollbackToBaseHandler();
-            return;
-        }
-        state_ = PUT_STATE::RECEIVING;
-        connection_context_->in_put_upload = true;
-        log_cpp20("[PUTHandler] prepared receiving file='" + file_name + "' position=" + std::to_string(current_pos) + " fd=" + std::to_string(connection_context_->connection_id));
-        jsonResponse = responseBuilder.buildPutResponse("receiving", file_name, current_pos, file_hash);
+        state_ = PUT_STATE::COMPLETED;
+        log_cpp20("[PUTHandler] file already complete file='" + file_name + "' size=" + std::to_string(current_pos) + " fd=" + std::to_string(connection_context_->connection_id));
+        response = responseBuilder.buildPutResponse("completed", file_name, current_pos, file_hash);
         sendResponse(MessageType::RESPONSE);
-    // } catch (const storage::FileError& e) {
-    //     onFailed(400, e.what());
-    //     return;
-    // } catch (const std::exception& e) {
-    //     onFailed(500, "Internal server error");
-    //     return;
-    // }
+        rollbackToBaseHandler();
+        co_return;
+    }
+    state_ = PUT_STATE::RECEIVING;
+    connection_context_->in_put_upload = true;
+    net::use_socket_profile(*connection_context_, net::SocketProfileKind::BulkUpload);
+    preparing_.store(false);
+    if (connection_context_->input_stalled.exchange(false)) {
+        connection_context_->reactor_context->response_queue->submit_resume(
+            connection_context_->connection_id, connection_context_->connection_generation);
+    }
+    log_cpp20("[PUTHandler] prepared receiving file='" + file_name + "' position=" + std::to_string(current_pos) + " fd=" + std::to_string(connection_context_->connection_id));
+    response = responseBuilder.buildPutResponse("receiving", file_name, current_pos, file_hash);
+    sendResponse(MessageType::RESPONSE);
 }
 
-void PUTHandler::processMessages() {
-    std::unique_lock<std::mutex> lock(mutex_);
-    while (!msg_queue_.empty()) {
-        Message msg = msg_queue_.front();
-        msg_queue_.pop();
-        lock.unlock();
-        if (state_ != PUT_STATE::RECEIVING) {
-            error_cpp20("Invalid state for receiving data");
-            onFailed(400, "Invalid state for receiving data");
-            return;
-        }
-        if (!file_handle_) {
-            error_cpp20("File handle is null");
-            onFailed(500, "Internal server error");
-            return;
-        }
+void PUTHandler::processChunk(const net::FrameRef& frame) {
+    if (state_ != PUT_STATE::RECEIVING) {
+        // Frames behind the last chunk: the upload is over and this handler handed the
+        // connection back.
+        LOG_DEBUG("[PUTHandler] dropping chunk length={} after upload ended state={}", frame->header().length, state_);
+        return;
+    }
+    if (!file_handle_) {
+        error_cpp20("File handle is null");
+        onFailed(500, "Internal server error");
+        return;
+    }
 
-        if (!incremental_sha1_) {
-            incremental_sha1_ = std::make_unique<utils::IncrementalSHA1>();
-        }
-        uint64_t pos_before = file_handle_->getPosition();
-        incremental_sha1_->update(msg.body, msg.header.length);
-        // 写入文件
-        int wn = file_handle_->writeBuffer(msg.body, msg.header.length);
-        if (wn < 0) {
+    if (!incremental_sha1_) {
+        incremental_sha1_ = std::make_unique<utils::IncrementalSHA1>();
+    }
+    uint64_t pos_before = file_handle_->getPosition();
+    incremental_sha1_->update(frame->body(), frame->header().length);
+    // 写入文件
+    int wn = file_handle_->writeBuffer(frame->body(), frame->header().length);
+    if (wn < 0) {
+        state_ = PUT_STATE::ERROR;
+        response = responseBuilder.buildErrorResponse(500, "Write file chunk failed");
+        sendResponse(MessageType::ERROR);
+        incremental_sha1_.reset();
+        rollbackToBaseHandler();
+        return;
+    }
+    uint64_t pos_after = file_handle_->getPosition();
+    LOG_TRACE("[PUTHandler] received chunk size={} pos_before={} pos_after={} fd={}", frame->header().length, pos_before, pos_after,
+              connection_context_->connection_id);
+    uint64_t current_position = pos_after;
+    const auto& params = *requestAs<protocol::PutRequest>();
+    if (current_position >= params.file_size) {
+
+        std::string expected_hash = params.file_hash;
+        std::string actual_hash = incremental_sha1_->final();
+        std::string file_name = params.file_name;
+        bool hash_ok = (!expected_hash.empty() && actual_hash == expected_hash);
+        if (hash_ok) {
+            state_ = PUT_STATE::COMPLETED;
+            log_cpp20("[PUTHandler] upload completed file='" + file_name + "' size=" + std::to_string(current_position) + " hash_ok=1 fd=" + std::to_string(connection_context_->connection_id));
+            response = responseBuilder.buildPutResponse("completed", 
+                file_name, 
+                current_position, 
+                expected_hash);
+            sendResponse(MessageType::RESPONSE);
+            incremental_sha1_.reset();
+            rollbackToBaseHandler();
+        } else {
+            error_cpp20("Hash verification failed: expected " + expected_hash + ", got " + actual_hash);
             state_ = PUT_STATE::ERROR;
-            jsonResponse = responseBuilder.buildErrorResponse(500, "Write file chunk failed");
+            log_cpp20("[PUTHandler] upload failed hash mismatch file='" + file_name + "' size=" + std::to_string(current_position) + " fd=" + std::to_string(connection_context_->connection_id));
+            response = responseBuilder.buildErrorResponse(400, "File hash verification failed, please retry upload.");
             sendResponse(MessageType::ERROR);
             incremental_sha1_.reset();
             rollbackToBaseHandler();
-            return;
         }
-        uint64_t pos_after = file_handle_->getPosition();
-        log_cpp20("[PUTHandler] received chunk size=" + std::to_string(msg.header.length) + " pos_before=" + std::to_string(pos_before) + " pos_after=" + std::to_string(pos_after) + " fd=" + std::to_string(connection_context_->connection_id));
-        ssize_t current_position = pos_after;
-        int expected_size = jsonRequest["params"].value("file_size", 0);
-        if (current_position >= expected_size) {
-
-            std::string expected_hash = jsonRequest["params"].value("file_hash", "");
-            std::string actual_hash = incremental_sha1_->final();
-            std::string file_name = jsonRequest["params"].value("file_name", "");
-            bool hash_ok = (!expected_hash.empty() && actual_hash == expected_hash);
-            if (hash_ok) {
-                state_ = PUT_STATE::COMPLETED;
-                log_cpp20("[PUTHandler] upload completed file='" + file_name + "' size=" + std::to_string(current_position) + " hash_ok=1 fd=" + std::to_string(connection_context_->connection_id));
-                jsonResponse = responseBuilder.buildPutResponse("completed", 
-                    file_name, 
-                    current_position, 
-                    expected_hash);
-                sendResponse(MessageType::RESPONSE);
-                incremental_sha1_.reset();
-                rollbackToBaseHandler();
-            } else {
-                error_cpp20("Hash verification failed: expected " + expected_hash + ", got " + actual_hash);
-                state_ = PUT_STATE::ERROR;
-                log_cpp20("[PUTHandler] upload failed hash mismatch file='" + file_name + "' size=" + std::to_string(current_position) + " fd=" + std::to_string(connection_context_->connection_id));
-                jsonResponse = responseBuilder.buildErrorResponse(400, "File hash verification failed, please retry upload.");
-                sendResponse(MessageType::ERROR);
-                incremental_sha1_.reset();
-                rollbackToBaseHandler();
-            }
-            return;
-        }
-        lock.lock();
+        return;
     }
 }
 
@@ -271,10 +270,10 @@ void PUTHandler::rollbackToBaseHandler() {
         error_cpp20("rollbackToBaseHandler: old_ctx null");
         return;
     }
-    log_cpp20("[PUTHandler] initiating rollback state=" + std::to_string(static_cast<int>(state_)) + " pending_msgs=" + std::to_string(msg_queue_.size()) + " fd=" + std::to_string(old_ctx->connection_id));
-    auto base = std::make_shared<RequestHandler>();
+    log_cpp20("[PUTHandler] initiating rollback state=" + std::to_string(static_cast<int>(state_)) + " pending_chunks=" + std::to_string(old_ctx->strand ? old_ctx->strand->pending() : 0) + " fd=" + std::to_string(old_ctx->connection_id));
+    auto base = net::make_pooled<RequestHandler>(objectPool());
     // move基类部分
-    dynamic_cast<RequestHandler&>(*base) = std::move(*this);
+    static_cast<RequestHandler&>(*base) = std::move(*this);
     // 由于当前对象已move，使用old_ctx执行回调
     if (old_ctx->change_handler_callback) {
         old_ctx->change_handler_callback(base);
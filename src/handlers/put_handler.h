@@ -2,9 +2,8 @@
 
 #include <string>
 #include <vector>
-#include <queue>
-#include <mutex>
 #include <memory>
+#include <atomic>
 
 #include "request_handler.h"
 #include "storage/file_manager.h"
@@ -28,18 +27,20 @@ private:
         ERROR
     };
 
-    void prepareToReceive();
-    void processMessages();
-    ssize_t receiveData(int fd, size_t size);
-    bool receiveCompleteMessage();
+    // Validates the request and opens the target; the lookups suspend on the DB and disk
+    // executors. self keeps the handler alive while suspended.
+    concurrency::Co<void> prepareToReceive(std::shared_ptr<PUTHandler> self);
+    void processChunk(const net::FrameRef& frame);
+    // The pool refused the strand's drain: input stays in the decoder, and the reactor offers
+    // the drain again every tick until the pool takes it, then resumes reading.
+    static void waitForPool(ConnectionContext::Ptr ctx);
     void rollbackToBaseHandler();
 
     PUT_STATE state_{PUT_STATE::INIT};
+    // Set while prepareToReceive() runs: recvRequest() leaves input in the decoder meanwhile.
+    std::atomic<bool> preparing_{false};
     storage::UserFileHandle::Ptr file_handle_{nullptr};
-    Message temp_msg_{};
-    std::mutex mutex_;
-    std::queue<Message> msg_queue_;
-    ssize_t total_received_{0};
+    std::vector<net::FrameRef> received_;   // frames of one recvRequest() call, reactor thread only
 
     std::unique_ptr<utils::IncrementalSHA1> incremental_sha1_;
 };
@@ -5,14 +5,14 @@
 namespace handlers {
 
 void RegisterHandler::handle() {
-    // Expected jsonRequest params: { username_enc, passhash_enc }
-    auto params = jsonRequest.value("params", nlohmann::json::object());
-    std::string username_enc = params.value("username", "");
-    std::string passhash_enc = params.value("passhash", "");
+    // Expected params: { username, passhash }, RSA-encrypted
+    const auto* params = requestAs<protocol::RegisterRequest>();
+    std::string username_enc = params ? params->username : std::string();
+    std::string passhash_enc = params ? params->passhash : std::string();
     if (username_enc.empty() || passhash_enc.empty()) {
-        jsonResponse = responseBuilder.buildErrorResponse(400, "missing username or passhash");
+        response = responseBuilder.buildErrorResponse(400, "missing username or passhash");
         sendResponse(MessageType::ERROR);
-        connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
+        finish();
         return;
     }
 
@@ -22,16 +22,16 @@ void RegisterHandler::handle() {
     std::string username = rsa.decrypt(username_enc);
     std::string client_hash = rsa.decrypt(passhash_enc);
     if (username.empty() || client_hash.empty()) {
-        jsonResponse = responseBuilder.buildErrorResponse(400, "decrypt failed");
+        response = responseBuilder.buildErrorResponse(400, "decrypt failed");
         sendResponse(MessageType::ERROR);
-        connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
+        finish();
         return;
     }
 
     if (userRepo.usernameExists(username)) {
-        jsonResponse = responseBuilder.buildErrorResponse(409, "username exists");
+        response = responseBuilder.buildErrorResponse(409, "username exists");
         sendResponse(MessageType::ERROR);
-        connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
+        finish();
         return;
     }
 
@@ -51,15 +51,15 @@ void RegisterHandler::handle() {
               " email=" + newUser.email);
 
     if (!userRepo.createUser(newUser)) {
-        jsonResponse = responseBuilder.buildErrorResponse(500, "create user failed");
+        response = responseBuilder.buildErrorResponse(500, "create user failed");
         sendResponse(MessageType::ERROR);
-        connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
+        finish();
         return;
     }
 
-    jsonResponse = responseBuilder.build("register success");
+    response = responseBuilder.build("register success");
     sendResponse(MessageType::RESPONSE);
-    connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
+    finish();
 }
 
 } // namespace handlers
@@ -1,54 +1,70 @@
 #include "request_handler.h"
+#include <chrono>
 #include <string>
+#include <utility>
 #include <vector>
 #include <sys/socket.h>
 #include <unistd.h>
+#include "protocol/codec.h"
 #include "protocol/request_parser.h"
 #include "protocol/response_builder.h"
+#include "protocol/wire_format.h"
 #include "types/message.h"
 #include "session/session.h"
 #include "net/connection.h"
+#include "net/frame_decoder.h"
 
 #include "nlohmann/json.hpp"
 #include "common/debug.h"
+#include "utils/log.h"
 #include "concurrency/lf_thread_pool.h"
-#include "handlers/list_handler.h"
-#include "handlers/cd_handler.h"
-#include "handlers/pwd_handler.h"
-#include "handlers/mkdir_handler.h"
-#include "handlers/put_handler.h"
-#include "handlers/rm_handler.h"
-#include "handlers/rmdir_handler.h"
-#include "handlers/register_handler.h"
-#include "handlers/pubkey_handler.h"
-#include "handlers/login_handler.h"
-#include "handlers/get_handler.h"
-#include "handlers/large_put_data_handler.h"
+#include "concurrency/admission_controller.h"
+#include "net/request_pipeline.h"
+#include "net/block_pool.h"
+#include "handlers/command_registry.h"
+#include "metrics/metrics.h"
+#include "metrics/trace.h"
 
 namespace handlers {
 
 RequestHandler::RequestHandler(RequestHandler&& other)
       : connection_context_(std::move(other.connection_context_)),
-        jsonRequest(std::move(other.jsonRequest)),
-        jsonResponse(std::move(other.jsonResponse)),
+        request(std::move(other.request)),
+        response(std::move(other.response)),
         requestParser(std::move(other.requestParser)),
-        responseBuilder(std::move(other.responseBuilder)) {}
+        responseBuilder(std::move(other.responseBuilder)),
+        request_id_(other.request_id_),
+        binary_(other.binary_),
+        trace_id_(std::exchange(other.trace_id_, 0)),
+        admitted_at_(std::exchange(other.admitted_at_, 0)),
+        received_at_(std::exchange(other.received_at_, 0)) {}
+
+RequestHandler::~RequestHandler() {
+    // A request that returned without finish() (error paths) still gives back its slot, and a
+    // pipelined one must not hold up the requests behind it.
+    releaseAdmission();
+    completePipelined();
+}
 
 RequestHandler& RequestHandler::operator=(RequestHandler&& other) {
     if (this != &other) {
         connection_context_ = std::move(other.connection_context_);
 
-        jsonRequest = std::move(other.jsonRequest);
-        jsonResponse = std::move(other.jsonResponse);
+        request = std::move(other.request);
+        response = std::move(other.response);
         requestParser = std::move(other.requestParser);
         responseBuilder = std::move(other.responseBuilder);
+        request_id_ = other.request_id_;
+        binary_ = other.binary_;
+        trace_id_ = std::exchange(other.trace_id_, 0);
+        admitted_at_ = std::exchange(other.admitted_at_, 0);
+        received_at_ = std::exchange(other.received_at_, 0);
     }
     return *this;
 }
 
 
 void RequestHandler::recvRequest() {
-    Message msg;
     int fd = connection_context_->connection_id;
     if (fd < 0) {
         error_cpp20("Invalid connection ID");
@@ -57,225 +73,369 @@ void RequestHandler::recvRequest() {
     }
     if (connection_context_->in_put_upload) {
         // 正在处于PUT数据阶段，基础handler不再读取，等待PUTHandler的recvRequest处理
-        log_cpp20("[RequestHandler] recvRequest ignored (in_put_upload=1) fd=" + std::to_string(fd));
+        LOG_DEBUG("[RequestHandler] recvRequest ignored (in_put_upload=1) fd={}", fd);
         return;
     }
-    log_cpp20("[RequestHandler] recvRequest begin fd=" + std::to_string(fd));
-    ssize_t nrecv = recv(fd, &msg.header, sizeof(msg.header), MSG_WAITALL);
-    if (nrecv == 0) {
-        log_cpp20("Connection closed by peer on fd " + std::to_string(fd));
-        connection_context_->close_callback();
-        return;
-    } else if (nrecv < 0) {
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            // No data available right now, try again later
-            log_cpp20("No data available to read on fd " + std::to_string(fd));
-            return;
+    DEBUG_PRINT("[RequestHandler] recvRequest begin fd=%d", fd);
+    auto& ctx = *connection_context_;
+    // Frames stay in the decoder while a non-pipelined request is being handled, while the
+    // pipeline is full, or while a parked request waits for the pipeline to drain; whoever
+    // unblocks the connection asks the reactor to resume (Connection::change_handler,
+    // RequestHandler::completePipelined).
+    auto waiting = [this, &ctx]() {
+        return ctx.request_in_flight.load()
+            || (ctx.pipeline && (ctx.pipeline->full() || (parked_ && ctx.pipeline->outstanding() > 0)));
+    };
+    auto accept = [this, &ctx, &waiting]() {
+        if (!connection_context_) return false;   // moved into another handler by the last frame
+        if (!waiting()) return !parked_;          // a parked request is dispatched first, below
+        ctx.input_stalled.store(true);
+        // Re-check: the request may have completed before the flag became visible.
+        return !waiting() && ctx.input_stalled.exchange(false) && !parked_;
+    };
+    net::FrameDecoder::Status status;
+    while (true) {
+        if (parked_ && !waiting()) {
+            dispatchParked();
+            if (!connection_context_) return;
         }
-        error_cpp20("Failed to receive data. Error: " + std::string(strerror(errno)));
-        connection_context_->close_callback();
+        size_t nread = 0;
+        status = ctx.decoder->read_frames(fd, *ctx.reactor_context->frame_pool, accept,
+            [this, fd](net::FrameRef frame) {
+                // 如果此时PUT已经结束（回到基础handler），残留的文件数据帧（PUT_DATA）直接丢弃
+                if (static_cast<MessageType>(frame->header().type) == MessageType::PUT_DATA) {
+                    LOG_DEBUG("[RequestHandler] discarded leftover PUT_DATA length={} fd={}", frame->header().length, fd);
+                    return;
+                }
+                // Defer parsing / dispatching to a dedicated method so recvRequest only does framing.
+                onFrame(frame);
+            }, nread);
+        ctx.account_rx(nread);
+        // Stopped for a parked request whose pipeline has drained meanwhile: dispatch it now.
+        if (status != net::FrameDecoder::Status::Stopped || !connection_context_ || !parked_ || waiting()) break;
+    }
+
+    if (status == net::FrameDecoder::Status::Closed) {
+        LOG_DEBUG("Connection closed by peer on fd {}", fd);
+        ctx.close_callback();
+    } else if (status == net::FrameDecoder::Status::Error) {
+        LOG_ERROR("Failed to receive data. Error: {}", strerror(errno));
+        ctx.close_callback();
+    }
+}
+
+// New: decouple frame reception from parsing & dispatch logic
+void RequestHandler::onFrame(const net::FrameRef &frame) {
+    int fd = connection_context_->connection_id;
+    if (static_cast<MessageType>(frame->header().type) != MessageType::REQUEST) {
+        LOG_ERROR("[RequestHandler] Unexpected non-REQUEST frame in base handler type={}", frame->header().type);
         return;
     }
-    // 如果是文件数据帧（PUT_DATA），直接返回让当前 active handler (应为 PUTHandler) 的 recvRequest 处理
-    if (static_cast<MessageType>(msg.header.type) == MessageType::PUT_DATA) {
-        // 如果此时PUT已经结束（回到基础handler），我们就需要把多余的数据体读掉丢弃；否则会不断触发事件
-        size_t to_discard = msg.header.length;
-        size_t discarded = 0;
-        while (discarded < to_discard) {
-            uint8_t buf[4096];
-            size_t chunk = std::min(sizeof(buf), to_discard - discarded);
-            ssize_t n = recv(fd, buf, chunk, 0);
-            if (n <= 0) {
-                error_cpp20("Failed to discard leftover PUT_DATA body or connection closed");
-                connection_context_->close_callback();
-                return;
-            }
-            discarded += n;
-        }
-        log_cpp20("[RequestHandler] discarded leftover PUT_DATA length=" + std::to_string(msg.header.length) + " fd=" + std::to_string(fd));
-        return; // 丢弃后不再继续处理
+    const bool binary = frame->header().flags & protocol::kFrameBinary;
+    const uint8_t request_id = frame->header().request_id;
+    if (!binary) {
+        LOG_TRACE("[RequestHandler] raw request body fd={}: {}", fd,
+                  std::string_view(reinterpret_cast<const char*>(frame->body()), frame->header().length));
     }
-    ssize_t toRecv = msg.header.length;
-    if (toRecv > sizeof(msg.body)) {
-        error_cpp20("Message body too large: " + std::to_string(toRecv));
-        connection_context_->close_callback();
+    auto ret = requestParser.parse(frame->body(), frame->header().length, binary);
+    if (ret == std::nullopt) {
+        LOG_ERROR("Failed to parse request fd={}: {}", fd, requestParser.error());
+        rejectMalformed(request_id, binary);
         return;
     }
+    const int64_t received_at = metrics::now_ns();
+    const uint64_t trace_id = metrics::trace::begin();
+    protocol::Command command = protocol::command_of(*ret);
+    LOG_DEBUG("[RequestHandler] parsed command='{}' fd={} id={} binary={}", protocol::command_name(command), fd,
+              request_id, binary);
+    if (connection_context_->session_context) {
+        // keeps the session clear of the reactors' session expiry
+        connection_context_->session_context->last_active_time.store(::time(nullptr), std::memory_order_relaxed);
+    }
 
-    ssize_t totalRecv = 0;
-    while (totalRecv < toRecv) {
-        ssize_t n = recv(fd, msg.body + totalRecv, toRecv - totalRecv, MSG_WAITALL);
-        if (n <= 0) {
-            error_cpp20("Failed to receive data or connection closed");
-            connection_context_->close_callback();
-            return;
-        }
-        totalRecv += n;
+    const CommandRoute& route = command_route(command);
+    if (route.has(CommandRoute::kPipelined)) {
+        dispatchPipelined(route.make(objectPool()), std::move(*ret), request_id, binary, received_at, trace_id);
+        return;
+    }
+    auto& pipeline = connection_context_->pipeline;
+    if (pipeline && pipeline->outstanding() > 0) {
+        // Commands that change connection or user state (cd, mkdir, login, put, ...) wait for
+        // the requests before them; input stops here until they are answered.
+        parked_ = ParkedRequest{std::move(*ret), request_id, binary, received_at, trace_id};
+        return;
+    }
+    request = std::move(*ret);
+    request_id_ = request_id;
+    binary_ = binary;
+    received_at_ = received_at;
+    trace_id_ = trace_id;
+    dispatch(command);
+}
+
+void RequestHandler::rejectMalformed(uint8_t request_id, bool binary) {
+    // Takes its turn in the pipeline like any request, so the answers after it keep their order.
+    auto handler = net::make_pooled<RequestHandler>(objectPool());
+    handler->connection_context_ = connection_context_;
+    handler->request_id_ = request_id;
+    handler->binary_ = binary;
+    if (auto& pipeline = connection_context_->pipeline) {
+        handler->pipeline_ = pipeline;
+        handler->pipeline_seq_ = pipeline->begin();
     }
+    handler->response = responseBuilder.buildErrorResponse(400, requestParser.error());
+    handler->sendResponse(MessageType::ERROR);
+    handler->completePipelined();
+}
 
-    // Defer parsing / dispatching to a dedicated method so recvRequest only does framing.
-    onFrame(msg);
+void RequestHandler::dispatchParked() {
+    ParkedRequest parked = std::move(*parked_);
+    parked_.reset();
+    request = std::move(parked.request);
+    request_id_ = parked.request_id;
+    binary_ = parked.binary;
+    received_at_ = parked.received_at;
+    trace_id_ = parked.trace_id;
+    dispatch(protocol::command_of(request));
 }
 
-// New: decouple frame reception from parsing & dispatch logic
-void RequestHandler::onFrame(const Message &msg) {
-    int fd = connection_context_->connection_id;
-    if (static_cast<MessageType>(msg.header.type) != MessageType::REQUEST) {
-        error_cpp20("[RequestHandler] Unexpected non-REQUEST frame in base handler type=" + std::to_string(msg.header.type));
+void RequestHandler::dispatch(protocol::Command command) {
+    const CommandRoute& route = command_route(command);
+    auto& admission = connection_context_->reactor_context->server_context->admission;
+    // Transfers are bounded by the connection limit and the stall timeout; they are shed under
+    // overload but do not hold a slot, so a long upload does not count as a slow request.
+    const bool transfer = route.has(CommandRoute::kTransfer);
+    const bool admitted = admission && !route.has(CommandRoute::kUnadmitted);
+    if (admitted && !(transfer ? admission->admit_transfer() : admission->try_acquire())) {
+        rejectBusy();
         return;
     }
-    std::string rawRequest(reinterpret_cast<const char*>(msg.body), msg.header.length);
-    log_cpp20("[RequestHandler] raw request body fd=" + std::to_string(fd) + ": " + rawRequest);
-    auto ret = requestParser.parse(rawRequest);
-    if (ret == std::nullopt) {
-        error_cpp20("Failed to parse request: " + rawRequest);
+
+    connection_context_->request_in_flight.store(true, std::memory_order_release);
+    if (admitted && !transfer) admitted_at_ = std::chrono::steady_clock::now().time_since_epoch().count();
+    traceReactorWait();
+    Ptr handler = route.make(objectPool());
+    handOver(handler);
+    if (route.has(CommandRoute::kInline)) {
+        // hello, and PUT taking over the connection's input before the next frame is read (its
+        // lookups then continue on the pool, see PUTHandler::prepareToReceive)
+        metrics::trace::Scope scope(handler->trace_id_);
+        metrics::trace::Span span(protocol::command_name(command), "handler");
+        handler->handle();
         return;
     }
-    jsonRequest = std::move(*ret);
-    std::string command = jsonRequest.value("command", "");
-    log_cpp20("[RequestHandler] parsed command='" + command + "' fd=" + std::to_string(fd));
-
-    if (command == "put") {
-        auto putHandler = std::make_shared<PUTHandler>();
-        dynamic_cast<RequestHandler&>(*putHandler) = std::move(*shared_from_this());
-        putHandler->connection_context_->change_handler_callback(putHandler);
-        log_cpp20("[RequestHandler] early switched to PUTHandler fd=" + std::to_string(putHandler->connection_context_->connection_id));
-        putHandler->handle();
+    // Dispatched asynchronously to keep the recv loop lightweight.
+    if (submitToPool(handler)) return;
+
+    // Pool queue full: answer now instead of leaving the client waiting for a reply that never comes.
+    if (admission) admission->on_queue_full(std::exchange(handler->admitted_at_, 0) != 0);
+    handler->rejectBusy();
+    handler->finish();
+}
+
+void RequestHandler::handOver(const Ptr& handler) {
+    static_cast<RequestHandler&>(*handler) = std::move(*this);
+    handler->connection_context_->change_handler_callback(handler);
+    LOG_DEBUG("[RequestHandler] switched to {} handler fd={}", protocol::command_name(protocol::command_of(handler->request)),
+              handler->connection_context_->connection_id);
+}
+
+void RequestHandler::dispatchPipelined(Ptr handler, protocol::Request request, uint8_t request_id, bool binary,
+                                       int64_t received_at, uint64_t trace_id) {
+    auto& pipeline = connection_context_->pipeline;
+    if (!pipeline) pipeline = net::make_pooled<net::RequestPipeline>(objectPool());
+    // The reading handler stays in place; the request runs on its own handler object.
+    handler->connection_context_ = connection_context_;
+    handler->request = std::move(request);
+    handler->request_id_ = request_id;
+    handler->binary_ = binary;
+    handler->received_at_ = received_at;
+    handler->trace_id_ = trace_id;
+    handler->traceReactorWait();
+    handler->pipeline_ = pipeline;
+    handler->pipeline_seq_ = pipeline->begin();
+
+    auto& admission = connection_context_->reactor_context->server_context->admission;
+    if (admission && !admission->try_acquire()) {
+        handler->rejectBusy();
+        handler->finish();
+        return;
+    }
+    if (admission) handler->admitted_at_ = std::chrono::steady_clock::now().time_since_epoch().count();
+    if (submitToPool(handler)) return;
+
+    if (admission) admission->on_queue_full(std::exchange(handler->admitted_at_, 0) != 0);
+    handler->rejectBusy();
+    handler->finish();
+}
+
+bool RequestHandler::submitToPool(Ptr handler) {
+    auto& server = *handler->connection_context_->reactor_context->server_context;
+    auto* admission = server.admission.get();
+    if (admission) admission->on_queued();
+    const int64_t queued_at = handler->trace_id_ != 0 ? metrics::now_ns() : 0;
+    bool queued = server.thread_pool->submit([handler, queued_at]() {
+        auto& server = *handler->connection_context_->reactor_context->server_context;
+        if (server.admission) server.admission->on_started();
+        LOG_TRACE("[RequestHandler] thread_pool executing handle for fd={}", handler->connection_context_->connection_id);
+        const uint64_t trace_id = handler->trace_id_;
+        if (trace_id != 0) metrics::trace::record(trace_id, "pool queue", "pool", queued_at, metrics::now_ns());
+        metrics::trace::Scope scope(trace_id);
+        metrics::trace::Span span(protocol::command_name(protocol::command_of(handler->request)), "handler");
+        handler->handle();
+    });
+    if (!queued && admission) admission->on_started();
+    return queued;
+}
+
+void RequestHandler::rejectBusy() {
+    auto& admission = connection_context_->reactor_context->server_context->admission;
+    uint32_t retry_after = admission ? admission->retry_after_ms() : 0;
+    LOG_DEBUG("[RequestHandler] shedding request fd={} retry_after_ms={}", connection_context_->connection_id, retry_after);
+    response = responseBuilder.buildBusyResponse(retry_after);
+    sendResponse(MessageType::ERROR);
+}
+
+void RequestHandler::finish() {
+    recordLatency();
+    releaseAdmission();
+    if (pipeline_) {
+        completePipelined();
         return;
     }
+    connection_context_->change_handler_callback(net::make_pooled<RequestHandler>(objectPool(), connection_context_));
+}
 
-    // Other commands dispatched asynchronously to keep recv loop lightweight
-    connection_context_->reactor_context->server_context->thread_pool->submit(
-        [self = shared_from_this()]() {
-            log_cpp20("[RequestHandler] thread_pool executing handle for fd=" + std::to_string(self->connection_context_->connection_id));
-            self->handle();
-        });
+void RequestHandler::releaseAdmission() {
+    int64_t admitted_at = std::exchange(admitted_at_, 0);
+    if (admitted_at == 0 || !connection_context_) return;
+    auto& admission = connection_context_->reactor_context->server_context->admission;
+    if (!admission) return;
+    auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+    admission->release(std::chrono::nanoseconds(now - admitted_at));
+}
+
+void RequestHandler::recordLatency() {
+    int64_t received_at = std::exchange(received_at_, 0);
+    if (received_at == 0) return;
+    const protocol::Command command = protocol::command_of(request);
+    const int64_t now = metrics::now_ns();
+    command_latency(command).record(static_cast<uint64_t>(now - received_at));
+    if (trace_id_ != 0) metrics::trace::record(trace_id_, protocol::command_name(command), "request", received_at, now);
+}
+
+void RequestHandler::traceReactorWait() const {
+    if (trace_id_ != 0 && received_at_ != 0) {
+        metrics::trace::record(trace_id_, "reactor wait", "reactor", received_at_, metrics::now_ns());
+    }
+}
+
+void RequestHandler::completePipelined() {
+    if (!pipeline_ || pipeline_completed_) return;
+    pipeline_completed_ = true;
+    auto ctx = connection_context_;
+    net::RequestPipeline::Deliver deliver;
+    if (held_response_) {
+        // The closure keeps the handler alive until delivery instead of moving the frames out.
+        // Not from the destructor (no shared_from_this there): the frames move then.
+        auto self = weak_from_this().lock();
+        if (self) {
+            deliver = [self]() {
+                queueResponse(*self->connection_context_, std::move(self->held_response_));
+                for (auto& frame : self->held_more_) queueResponse(*self->connection_context_, std::move(frame));
+                self->held_more_.clear();
+            };
+        } else {
+            deliver = [ctx, first = std::move(held_response_), more = std::move(held_more_)]() mutable {
+                queueResponse(*ctx, std::move(first));
+                for (auto& frame : more) queueResponse(*ctx, std::move(frame));
+            };
+        }
+    }
+    if (pipeline_->complete(pipeline_seq_, std::move(deliver)) > 0 && ctx->input_stalled.exchange(false)) {
+        // room in the pipeline again, or a parked request can go
+        ctx->reactor_context->response_queue->submit_resume(ctx->connection_id, ctx->connection_generation);
+    }
 }
 
 void RequestHandler::handle() {
-    Message msg;
+    // Requests reach their handler through dispatch(); this runs a request set on the base
+    // handler directly, on the calling thread.
     auto connection = connection_context_->connection;
     if (!connection) {
         error_cpp20("Connection no longer exists");
         return;
     }
-    auto response_queue_ = connection_context_->reactor_context->response_queue;
-    if (!response_queue_) {
+    if (!connection_context_->reactor_context->response_queue) {
         error_cpp20("Response queue is null");
         return;
     }
-    std::string command = jsonRequest.value("command", "");
-    log_cpp20("[RequestHandler] handle dispatch command='" + command + "' fd=" + std::to_string(connection_context_->connection_id));
-    if (command == "ls") {
-        auto handler = std::make_shared<ListHandler>();
-        dynamic_cast<RequestHandler&>(*handler) = std::move(*shared_from_this());
-        handler->connection_context_->change_handler_callback(handler);
-        log_cpp20("[RequestHandler] switched to ListHandler fd=" + std::to_string(handler->connection_context_->connection_id));
-        handler->handle();
-    } else if (command == "pwd") {
-        auto handler = std::make_shared<PWDHandler>();
-        dynamic_cast<RequestHandler&>(*handler) = std::move(*shared_from_this());
-        handler->connection_context_->change_handler_callback(handler);
-        log_cpp20("[RequestHandler] switched to PWDHandler fd=" + std::to_string(handler->connection_context_->connection_id));
-        handler->handle();
-    } else if (command == "cd") {
-        auto handler = std::make_shared<CDHandler>();
-        dynamic_cast<RequestHandler&>(*handler) = std::move(*shared_from_this());
-        handler->connection_context_->change_handler_callback(handler);
-        log_cpp20("[RequestHandler] switched to CDHandler fd=" + std::to_string(handler->connection_context_->connection_id));
-        handler->handle();
-    } else if (command == "mkdir") {
-        auto handler = std::make_shared<MKDIRHandler>();
-        dynamic_cast<RequestHandler&>(*handler) = std::move(*shared_from_this());
-        handler->connection_context_->change_handler_callback(handler);
-        log_cpp20("[RequestHandler] switched to MKDIRHandler fd=" + std::to_string(handler->connection_context_->connection_id));
-        handler->handle();
-    } else if (command == "put") {
-        auto handler = std::make_shared<PUTHandler>();
-        dynamic_cast<RequestHandler&>(*handler) = std::move(*shared_from_this());
-        handler->connection_context_->change_handler_callback(handler);
-        log_cpp20("[RequestHandler] switched to PUTHandler fd=" + std::to_string(handler->connection_context_->connection_id));
-        handler->handle();
-    } else if (command == "rm") {
-        auto handler = std::make_shared<RMHandler>();
-        dynamic_cast<RequestHandler&>(*handler) = std::move(*shared_from_this());
-        handler->connection_context_->change_handler_callback(handler);
-        log_cpp20("[RequestHandler] switched to RMHandler fd=" + std::to_string(handler->connection_context_->connection_id));
-        handler->handle();
-    } else if (command == "rmdir") {
-        auto handler = std::make_shared<RMDIRHandler>();
-        dynamic_cast<RequestHandler&>(*handler) = std::move(*shared_from_this());
-        handler->connection_context_->change_handler_callback(handler);
-        log_cpp20("[RequestHandler] switched to RMDIRHandler fd=" + std::to_string(handler->connection_context_->connection_id));
-        handler->handle();
-    } else if (command == "register") {
-        auto handler = std::make_shared<RegisterHandler>();
-        dynamic_cast<RequestHandler&>(*handler) = std::move(*shared_from_this());
-        handler->connection_context_->change_handler_callback(handler);
-        log_cpp20("[RequestHandler] switched to RegisterHandler fd=" + std::to_string(handler->connection_context_->connection_id));
-        handler->handle();
-    } else if (command == "pubkey") {
-        auto handler = std::make_shared<PubKeyHandler>();
-        dynamic_cast<RequestHandler&>(*handler) = std::move(*shared_from_this());
-        handler->connection_context_->change_handler_callback(handler);
-        log_cpp20("[RequestHandler] switched to PubKeyHandler fd=" + std::to_string(handler->connection_context_->connection_id));
-        handler->handle();
-    } else if (command == "login") {
-        auto handler = std::make_shared<LoginHandler>();
-        dynamic_cast<RequestHandler&>(*handler) = std::move(*shared_from_this());
-        handler->connection_context_->change_handler_callback(handler);
-        log_cpp20("[RequestHandler] switched to LoginHandler fd=" + std::to_string(handler->connection_context_->connection_id));
-        handler->handle();
-    } else if (command == "get") {
-        auto handler = std::make_shared<GETHandler>();
-        dynamic_cast<RequestHandler&>(*handler) = std::move(*shared_from_this());
-        handler->connection_context_->change_handler_callback(handler);
-        log_cpp20("[RequestHandler] switched to GETHandler fd=" + std::to_string(handler->connection_context_->connection_id));
-        handler->handle();
-    } else if (command == "put_data_channel") {
-        auto handler = std::make_shared<LargePutDataHandler>();
-        dynamic_cast<RequestHandler&>(*handler) = std::move(*shared_from_this());
-        handler->connection_context_->change_handler_callback(handler);
-        log_cpp20("[RequestHandler] switched to LargePutDataHandler fd=" + std::to_string(handler->connection_context_->connection_id));
-        handler->handle();
-    } else {
-        // TODO
-        jsonResponse = responseBuilder.buildErrorResponse(400, "Unknown command");
-        sendResponse(MessageType::ERROR);
-    }
+    Ptr handler = command_route(protocol::command_of(request)).make(objectPool());
+    handOver(handler);
+    handler->handle();
 }
 
 void RequestHandler::sendResponse(MessageType type) {
-    auto raw_response = jsonResponse.dump();
-    Message msg;
-    msg.header.length = raw_response.size();
-    log_cpp20("[RequestHandler] sendResponse fd=" + std::to_string(connection_context_->connection_id) + " type=" + std::to_string((int)type) + " body=" + raw_response);
-    // TODO
-    msg.header.type = static_cast<uint8_t>(type); // Assuming 1 is the type for response messages
-    if (msg.header.length > sizeof(msg.body)) {
-        RUNTIME_ERROR("Response too large to send: %u", msg.header.length);
+    std::string raw_response;
+    if (binary_) {
+        protocol::encode_response(response, raw_response);
+    } else {
+        raw_response = protocol::response_to_json(response).dump();
+    }
+    if (binary_) {
+        LOG_DEBUG("[RequestHandler] sendResponse fd={} type={} binary bytes={}", connection_context_->connection_id, type,
+                  raw_response.size());
+    } else {
+        LOG_TRACE("[RequestHandler] sendResponse fd={} type={} body={}", connection_context_->connection_id, type, raw_response);
+    }
+    net::FrameRef frame = connection_context_->reactor_context->frame_pool->acquire(raw_response.size(), connection_context_->wire);
+    if (!frame) {
+        RUNTIME_ERROR("Response too large to send: %zu", raw_response.size());
         return;
     }
-    std::memcpy(msg.body, raw_response.data(), msg.header.length);
+    frame->header().type = static_cast<uint8_t>(type);
+    frame->header().request_id = request_id_;
+    frame->header().flags = binary_ ? protocol::kFrameBinary : 0;
+    std::memcpy(frame->body(), raw_response.data(), raw_response.size());
+
+    if (pipeline_ && !pipeline_completed_) {
+        // held until finish(): pipelined responses leave in request order
+        holdResponse(std::move(frame));
+        return;
+    }
+    queueResponse(*connection_context_, std::move(frame));
+}
+
+void RequestHandler::holdResponse(net::FrameRef frame) {
+    if (!held_response_) {
+        held_response_ = std::move(frame);
+    } else {
+        held_more_.push_back(std::move(frame));
+    }
+}
 
-    connection_context_->reactor_context->response_queue->submit(
-        connection_context_->connection_id,
-        std::move(msg));
+net::BlockPool* RequestHandler::objectPool() const {
+    if (!connection_context_ || !connection_context_->reactor_context) return nullptr;
+    return connection_context_->reactor_context->object_pool.get();
+}
 
+void RequestHandler::queueResponse(ConnectionContext& ctx, net::FrameRef frame) {
+    ctx.responses_queued.fetch_add(1, std::memory_order_acq_rel);
+    ctx.reactor_context->response_queue->submit(ctx.connection_id, ctx.connection_generation, std::move(frame));
 }
 
 void RequestHandler::onSuccess(const std::string& message) {
-    jsonResponse = responseBuilder.build(message);
+    response = responseBuilder.build(message);
     sendResponse(MessageType::RESPONSE);
-    connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
-    log_cpp20("[RequestHandler] onSuccess reset to base handler fd=" + std::to_string(connection_context_->connection_id));
+    finish();
+    LOG_TRACE("[RequestHandler] onSuccess reset to base handler fd={}", connection_context_->connection_id);
 
 }
 void RequestHandler::onFailed(int error_code, const std::string& error_message) {
-    jsonResponse = responseBuilder.buildErrorResponse(error_code, error_message);
+    response = responseBuilder.buildErrorResponse(error_code, error_message);
     sendResponse(MessageType::ERROR);
-    connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
-    log_cpp20("[RequestHandler] onFailed reset to base handler fd=" + std::to_string(connection_context_->connection_id) + " error_code=" + std::to_string(error_code));
+    finish();
+    LOG_TRACE("[RequestHandler] onFailed reset to base handler fd={} error_code={}", connection_context_->connection_id, error_code);
 
 }
 
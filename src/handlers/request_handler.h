@@ -5,20 +5,25 @@
 #include <sys/socket.h>
 #include <unistd.h>
 #include <functional>
+#include <optional>
 
 
+#include "protocol/messages.h"
 #include "protocol/request_parser.h"
 #include "protocol/response_builder.h"
 #include "types/message.h"
 
 #include "nlohmann/json.hpp"
 #include "common/debug.h"
+#include "concurrency/coroutine.h"
 #include "net/response_queue.h"
+#include "net/frame_buffer.h"
 #include "types/context.h"
 #include "types/enums.h"
 
 namespace net {
 class Connection;
+class BlockPool;
 }
 
 namespace handlers {
@@ -39,7 +44,7 @@ public:
         : connection_context_(connection_context) {
         log_cpp20("[RequestHandler] constructed for fd=" + (connection_context ? std::to_string(connection_context->connection_id) : std::string("-1")));
     }
-    virtual ~RequestHandler() {}
+    virtual ~RequestHandler();
 
     RequestHandler(const RequestHandler&) = delete;
     RequestHandler& operator=(const RequestHandler&) = delete;
@@ -55,18 +60,89 @@ public:
     virtual void onSuccess(const std::string& message);
     virtual void onFailed(int error_code, const std::string& error_message);
 
+    // The request is done: back to the base handler, or for a pipelined request, release its
+    // responses in request order.
+    void finish();
+
 protected:
     ConnectionContext::Ptr connection_context_{nullptr};
 
-    json jsonRequest;
-    json jsonResponse;
+    protocol::Request request;
+    protocol::Response response;
     RequestParser requestParser;
     ResponseBuilder responseBuilder;
 
     // Handle a fully received REQUEST frame (decoupled from recvRequest framing logic)
-    void onFrame(const Message &msg);
+    void onFrame(const net::FrameRef &frame);
+    // Answer the current request with SERVER_BUSY and a retry hint; stays on this handler.
+    void rejectBusy();
+
+    // The reactor's pool for new handlers (net::make_pooled); nullptr without a reactor.
+    net::BlockPool* objectPool() const;
+    // Hands a frame to the connection's reactor, behind everything queued before it.
+    static void queueResponse(ConnectionContext& ctx, net::FrameRef frame);
+
+    // For coroutine handlers: co_await dbCall(fn) / diskCall(fn) runs the blocking fn on the
+    // server's DB or disk executor and resumes with its result (concurrency::run_on).
+    template <typename Fn>
+    auto dbCall(Fn&& fn) const {
+        return concurrency::run_on(connection_context_->reactor_context->server_context->db_executor.get(),
+                                   std::forward<Fn>(fn), "db");
+    }
+    template <typename Fn>
+    auto diskCall(Fn&& fn) const {
+        return concurrency::run_on(connection_context_->reactor_context->server_context->disk_executor.get(),
+                                   std::forward<Fn>(fn), "disk");
+    }
+
+    // The request as the handler's message type, nullptr if it is another command.
+    template <typename T>
+    const T* requestAs() const { return std::get_if<T>(&request); }
+
+    uint8_t request_id_{0};         // MessageHeader::request_id of the request, echoed in responses
+    bool binary_{false};            // the request came binary (kFrameBinary); responses follow it
+    uint64_t trace_id_{0};          // metrics::trace id of a sampled request, 0 = not traced
 
 private:
+    struct ParkedRequest {
+        protocol::Request request;
+        uint8_t request_id;
+        bool binary;
+        int64_t received_at;
+        uint64_t trace_id;
+    };
+
+    // Commands without connection state (CommandRoute::kPipelined) run on their own handler.
+    void dispatchPipelined(Ptr handler, protocol::Request request, uint8_t request_id, bool binary, int64_t received_at,
+                           uint64_t trace_id);
+    // Other commands: the request (already set) and the connection move to the command's
+    // handler, which replaces this one on the connection until finish().
+    void dispatch(protocol::Command command);
+    // Moves this handler's request and connection into handler and installs it.
+    void handOver(const Ptr& handler);
+    void dispatchParked();
+    // Answer a REQUEST that did not parse with 400, in its place among pipelined requests.
+    void rejectMalformed(uint8_t request_id, bool binary);
+    static bool submitToPool(Ptr handler);
+    void releaseAdmission();
+    void recordLatency();
+    // The time between parsing and dispatch, as a span of a traced request.
+    void traceReactorWait() const;
+    void completePipelined();
+    void holdResponse(net::FrameRef frame);
+
+    int64_t admitted_at_{0};        // steady_clock ns when the request took an admission slot, 0 = none
+    int64_t received_at_{0};        // steady_clock ns when the request was parsed, 0 = not timed
+
+    // Pipelined request: its sequence number and the responses held until finish().
+    std::shared_ptr<net::RequestPipeline> pipeline_{nullptr};
+    uint64_t pipeline_seq_{0};
+    net::FrameRef held_response_;                   // the usual single response, without a vector
+    std::vector<net::FrameRef> held_more_;
+    bool pipeline_completed_{false};
+
+    // Reading handler: a non-pipelined request waiting for the pipeline to drain.
+    std::optional<ParkedRequest> parked_;
 };
 
 
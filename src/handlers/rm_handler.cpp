@@ -11,30 +11,31 @@ void RMHandler::handle() {
         connection_context_->close_callback();
         return;
     }
-    if (jsonRequest.find("params") == jsonRequest.end()) {
-        jsonResponse = responseBuilder.buildErrorResponse(400, "Missing params");
+    const auto* params = requestAs<protocol::RmRequest>();
+    if (!params) {
+        response = responseBuilder.buildErrorResponse(400, "Missing params");
         sendResponse(MessageType::ERROR);
-        connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
+        finish();
         return;
     }
-    std::string file_name = jsonRequest["params"].value("file_name", "");
+    std::string file_name = params->file_name;
     if (file_name.empty()) {
-        jsonResponse = responseBuilder.buildErrorResponse(400, "Missing file_name");
+        response = responseBuilder.buildErrorResponse(400, "Missing file_name");
         sendResponse(MessageType::ERROR);
-        connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
+        finish();
         return;
     }
 
     auto* file_manager = &storage::FileManager::getInstance();
     if (!file_manager->deleteFile(connection_context_->session_context->user_id, file_name)) {
-        jsonResponse = responseBuilder.buildErrorResponse(404, "File not found or delete failed");
+        response = responseBuilder.buildErrorResponse(404, "File not found or delete failed");
         sendResponse(MessageType::ERROR);
-        connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
+        finish();
         return;
     }
-    jsonResponse = responseBuilder.build("Deleted: " + file_name);
+    response = responseBuilder.build("Deleted: " + file_name);
     sendResponse(MessageType::RESPONSE);
-    connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
+    finish();
 }
 
 } // namespace handlers
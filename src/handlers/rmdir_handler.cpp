@@ -4,28 +4,29 @@
 namespace handlers {
 
 void RMDIRHandler::handle() {
-    if (jsonRequest.find("params") == jsonRequest.end()) {
-        jsonResponse = responseBuilder.buildErrorResponse(400, "Missing params");
+    const auto* params = requestAs<protocol::RmdirRequest>();
+    if (!params) {
+        response = responseBuilder.buildErrorResponse(400, "Missing params");
         sendResponse(MessageType::ERROR);
-        connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
+        finish();
         return;
     }
-    std::string dir_name = jsonRequest["params"].value("dir_name", "");
+    std::string dir_name = params->dir_name;
     if (dir_name.empty()) {
-        jsonResponse = responseBuilder.buildErrorResponse(400, "Missing dir_name");
+        response = responseBuilder.buildErrorResponse(400, "Missing dir_name");
         sendResponse(MessageType::ERROR);
-        connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
+        finish();
         return;
     }
     auto* fm = &storage::FileManager::getInstance();
     if (!fm->removeDirectory(connection_context_->session_context->user_id, dir_name)) {
-        jsonResponse = responseBuilder.buildErrorResponse(400, "rmdir failed (not exists or not empty)");
+        response = responseBuilder.buildErrorResponse(400, "rmdir failed (not exists or not empty)");
         sendResponse(MessageType::ERROR);
     } else {
-        jsonResponse = responseBuilder.build("Removed dir: " + dir_name);
+        response = responseBuilder.build("Removed dir: " + dir_name);
         sendResponse(MessageType::RESPONSE);
     }
-    connection_context_->change_handler_callback(RequestHandler::Ptr(new RequestHandler(connection_context_)));
+    finish();
 }
 
 } // namespace handlers
@@ -0,0 +1,42 @@
+#include "stat_handler.h"
+
+#include "db/user_file_repository.h"
+#include "cache/file_meta_cache.h"
+
+namespace handlers {
+
+void StatHandler::handle() {
+    const auto* params = requestAs<protocol::StatRequest>();
+    if (!params || params->file_name.empty()) {
+        onFailed(400, "missing file_name");
+        return;
+    }
+    if (!connection_context_->session_context) {
+        onFailed(401, "unauthorized");
+        return;
+    }
+    // Resolved like GET: a bare name is looked up from the root.
+    std::string virtual_path = params->file_name;
+    if (virtual_path.find('/') == std::string::npos) {
+        virtual_path = "/" + virtual_path;
+    }
+    auto user_file = db::UserFileRepository::getInstance().getFileByPath(connection_context_->session_context->user_id, virtual_path);
+    if (!user_file) {
+        onFailed(404, "virtual path not found");
+        return;
+    }
+    if (user_file->fileType == FileType::DIRECTORY) {
+        response = responseBuilder.buildStatResponse(params->file_name, true, 0, "");
+    } else {
+        auto meta = FileMetaCache::instance().getById(user_file->fileId);
+        if (!meta) {
+            onFailed(404, "file metadata not found");
+            return;
+        }
+        response = responseBuilder.buildStatResponse(params->file_name, false, meta->fileSize, meta->hashCode);
+    }
+    sendResponse(MessageType::RESPONSE);
+    finish();
+}
+
+} // namespace handlers
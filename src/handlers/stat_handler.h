@@ -0,0 +1,16 @@
+#pragma once
+
+#include "request_handler.h"
+
+namespace handlers {
+
+// Metadata of one entry (size and hash for files) without opening it.
+class StatHandler : public RequestHandler {
+public:
+    StatHandler() = default;
+    ~StatHandler() override = default;
+
+    void handle() override;
+};
+
+} // namespace handlers
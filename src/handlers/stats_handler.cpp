@@ -0,0 +1,38 @@
+#include "stats_handler.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "metrics/metrics.h"
+
+namespace handlers {
+
+namespace {
+
+bool is_loopback_peer(int fd) {
+    sockaddr_storage addr{};
+    socklen_t len = sizeof(addr);
+    if (::getpeername(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) return false;
+    if (addr.ss_family == AF_INET) {
+        auto* in = reinterpret_cast<const sockaddr_in*>(&addr);
+        return (ntohl(in->sin_addr.s_addr) >> 24) == 127;
+    }
+    if (addr.ss_family == AF_INET6) {
+        auto* in6 = reinterpret_cast<const sockaddr_in6*>(&addr);
+        return IN6_IS_ADDR_LOOPBACK(&in6->sin6_addr);
+    }
+    return addr.ss_family == AF_UNIX;
+}
+
+} // namespace
+
+void StatsHandler::handle() {
+    if (!is_loopback_peer(connection_context_->connection_id)) {
+        onFailed(403, "stats is only available to local clients");
+        return;
+    }
+    onSuccess(metrics::Registry::global().render());
+}
+
+} // namespace handlers
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "request_handler.h"
+
+namespace handlers {
+
+// Admin command: the server's metrics (metrics::Registry) in the Prometheus text format, the
+// same text the metrics listener serves. Answered to loopback peers only.
+class StatsHandler : public RequestHandler {
+public:
+    StatsHandler() = default;
+    ~StatsHandler() override = default;
+
+    void handle() override;
+};
+
+} // namespace handlers
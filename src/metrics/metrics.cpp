@@ -0,0 +1,204 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+
+namespace metrics {
+
+namespace detail {
+
+std::size_t next_shard() {
+    static std::atomic<std::size_t> next{0};
+    return next.fetch_add(1, std::memory_order_relaxed) % kShards;
+}
+
+} // namespace detail
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (const auto& s : shards_) total += s.value.load(std::memory_order_relaxed);
+    return total;
+}
+
+Histogram::Histogram() : shards_(std::make_unique<Shard[]>(kShards)) {}
+
+Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot snap;
+    snap.buckets.assign(kBuckets, 0);
+    for (std::size_t s = 0; s < kShards; ++s) {
+        const Shard& shard = shards_[s];
+        snap.sum += shard.sum.load(std::memory_order_relaxed);
+        for (std::size_t b = 0; b < kBuckets; ++b) {
+            uint64_t n = shard.counts[b].load(std::memory_order_relaxed);
+            snap.buckets[b] += n;
+            snap.count += n;
+        }
+    }
+    return snap;
+}
+
+uint64_t Histogram::Snapshot::quantile(double q) const {
+    if (count == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(count)));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (std::size_t b = 0; b < buckets.size(); ++b) {
+        seen += buckets[b];
+        if (seen >= rank) return b + 1 < kBuckets ? bucket_floor(b + 1) - 1 : bucket_floor(b);
+    }
+    return bucket_floor(kBuckets - 1);
+}
+
+Registry& Registry::global() {
+    // Never destroyed: reactors and pool threads may still record during static destruction.
+    static Registry* registry = new Registry();
+    return *registry;
+}
+
+Registry::Family& Registry::family(std::string_view name, std::string_view help, Type type) {
+    for (auto& f : families_) {
+        if (f->name == name) return *f;
+    }
+    families_.push_back(std::make_unique<Family>(Family{std::string(name), std::string(help), type, {}}));
+    return *families_.back();
+}
+
+Counter& Registry::counter(std::string_view name, std::string_view help, Labels labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Family& f = family(name, help, Type::Counter);
+    for (auto& s : f.series) {
+        if (s.counter && s.labels == labels) return *s.counter;
+    }
+    f.series.push_back(Series{std::move(labels), std::make_unique<Counter>(), nullptr, nullptr, nullptr});
+    return *f.series.back().counter;
+}
+
+Histogram& Registry::histogram(std::string_view name, std::string_view help, Labels labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Family& f = family(name, help, Type::Summary);
+    for (auto& s : f.series) {
+        if (s.histogram && s.labels == labels) return *s.histogram;
+    }
+    f.series.push_back(Series{std::move(labels), nullptr, std::make_unique<Histogram>(), nullptr, nullptr});
+    return *f.series.back().histogram;
+}
+
+void Registry::callback(std::string_view name, std::string_view help, Type type, Labels labels, const void* owner,
+                        Read read) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    family(name, help, type).series.push_back(Series{std::move(labels), nullptr, nullptr, owner, std::move(read)});
+}
+
+void Registry::forget(const void* owner) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& f : families_) {
+        std::erase_if(f->series, [owner](const Series& s) { return s.read && s.owner == owner; });
+    }
+}
+
+namespace {
+
+std::string_view type_name(Registry::Type type) {
+    switch (type) {
+        case Registry::Type::Counter: return "counter";
+        case Registry::Type::Gauge:   return "gauge";
+        case Registry::Type::Summary: return "summary";
+    }
+    return "untyped";
+}
+
+void append_labels(std::string& out, const Labels& labels, std::string_view extra_name = {},
+                   std::string_view extra_value = {}) {
+    if (labels.empty() && extra_name.empty()) return;
+    out += '{';
+    bool first = true;
+    auto append = [&](std::string_view name, std::string_view value) {
+        if (!first) out += ',';
+        first = false;
+        out += name;
+        out += "=\"";
+        for (char c : value) {
+            if (c == '\\' || c == '"') out += '\\';
+            if (c == '\n') {
+                out += "\\n";
+                continue;
+            }
+            out += c;
+        }
+        out += '"';
+    };
+    for (const auto& [name, value] : labels) append(name, value);
+    if (!extra_name.empty()) append(extra_name, extra_value);
+    out += '}';
+}
+
+void append_value(std::string& out, double value) {
+    char buf[32];
+    auto r = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, r.ptr);
+    out += '\n';
+}
+
+void append_value(std::string& out, uint64_t value) {
+    char buf[24];
+    auto r = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, r.ptr);
+    out += '\n';
+}
+
+constexpr double kQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+constexpr std::string_view kQuantileNames[] = {"0.5", "0.9", "0.99", "0.999"};
+
+} // namespace
+
+std::string Registry::render() const {
+    std::string out;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& f : families_) {
+        if (f->series.empty()) continue;
+        out += "# HELP ";
+        out += f->name;
+        out += ' ';
+        out += f->help;
+        out += "\n# TYPE ";
+        out += f->name;
+        out += ' ';
+        out += type_name(f->type);
+        out += '\n';
+        for (const auto& s : f->series) {
+            if (s.counter) {
+                out += f->name;
+                append_labels(out, s.labels);
+                out += ' ';
+                append_value(out, s.counter->value());
+            } else if (s.histogram) {
+                Histogram::Snapshot snap = s.histogram->snapshot();
+                for (std::size_t i = 0; i < std::size(kQuantiles); ++i) {
+                    out += f->name;
+                    append_labels(out, s.labels, "quantile", kQuantileNames[i]);
+                    out += ' ';
+                    append_value(out, static_cast<double>(snap.quantile(kQuantiles[i])) / 1e9);
+                }
+                out += f->name;
+                out += "_sum";
+                append_labels(out, s.labels);
+                out += ' ';
+                append_value(out, static_cast<double>(snap.sum) / 1e9);
+                out += f->name;
+                out += "_count";
+                append_labels(out, s.labels);
+                out += ' ';
+                append_value(out, snap.count);
+            } else if (auto value = s.read()) {
+                out += f->name;
+                append_labels(out, s.labels);
+                out += ' ';
+                append_value(out, *value);
+            }
+        }
+    }
+    return out;
+}
+
+} // namespace metrics
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Server metrics: counters and latency histograms recorded on the hot path, plus callbacks
+// reading the Stats structs that components already keep. Everything is registered once in
+// Registry::global() (at startup, or when a reactor is created) and rendered in the
+// Prometheus text format by the `stats` command and the metrics listener.
+//
+// Recording takes no lock: each thread writes to its own shard (relaxed atomics, one cache
+// line per shard for counters) and readers sum the shards.
+
+namespace metrics {
+
+// Threads take shards round robin on their first record, so with one thread per core (IO
+// reactors, pool workers) every core writes its own cache lines.
+inline constexpr std::size_t kShards = 16;
+
+namespace detail {
+std::size_t next_shard();
+inline std::size_t shard() {
+    thread_local const std::size_t index = next_shard();
+    return index;
+}
+} // namespace detail
+
+inline int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class Counter {
+public:
+    void add(uint64_t n = 1) { shards_[detail::shard()].value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Shard, kShards> shards_{};
+};
+
+// Log-linear (HDR style) histogram of nanosecond durations: every power of two is split into
+// 16 linear buckets, so a recorded value is known to within 1/16 (6%) from 16ns up to about
+// 18 minutes (longer values land in the last bucket); values below 16 are exact.
+class Histogram {
+public:
+    static constexpr int kSubBits = 4;
+    static constexpr uint64_t kSubBuckets = uint64_t{1} << kSubBits;
+    static constexpr int kMaxExponent = 40;
+    static constexpr std::size_t kBuckets = (kMaxExponent - kSubBits + 1) * kSubBuckets;
+
+    static constexpr std::size_t bucket_of(uint64_t value) {
+        if (value < kSubBuckets) return static_cast<std::size_t>(value);
+        int exponent = 63 - __builtin_clzll(value);
+        if (exponent >= kMaxExponent) return kBuckets - 1;
+        uint64_t sub = (value >> (exponent - kSubBits)) & (kSubBuckets - 1);
+        return static_cast<std::size_t>((exponent - kSubBits + 1) * kSubBuckets + sub);
+    }
+    // Smallest value of a bucket; the bucket ends where the next one starts.
+    static constexpr uint64_t bucket_floor(std::size_t bucket) {
+        if (bucket < kSubBuckets) return bucket;
+        int exponent = static_cast<int>(bucket / kSubBuckets) + kSubBits - 1;
+        uint64_t sub = bucket % kSubBuckets;
+        return (kSubBuckets + sub) << (exponent - kSubBits);
+    }
+
+    Histogram();
+
+    void record(uint64_t ns) {
+        Shard& s = shards_[detail::shard()];
+        s.counts[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+        s.sum.fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    struct Snapshot {
+        std::vector<uint64_t> buckets;
+        uint64_t count{0};
+        uint64_t sum{0};                // ns
+
+        // Upper bound of the bucket holding the q-th value (0 < q <= 1); 0 when empty.
+        uint64_t quantile(double q) const;
+        uint64_t max() const { return quantile(1.0); }
+    };
+    Snapshot snapshot() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> sum{0};
+        std::array<std::atomic<uint64_t>, kBuckets> counts{};
+    };
+    std::unique_ptr<Shard[]> shards_;
+};
+
+// Records the lifetime of the scope into a histogram.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram& histogram) : histogram_(histogram), start_(now_ns()) {}
+    ~ScopedTimer() { histogram_.record(static_cast<uint64_t>(now_ns() - start_)); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Histogram& histogram_;
+    int64_t start_;
+};
+
+using Labels = std::vector<std::pair<std::string, std::string>>;
+
+class Registry {
+public:
+    enum class Type : uint8_t { Counter, Gauge, Summary };
+    // Read at render time; nullopt leaves the series out.
+    using Read = std::function<std::optional<double>()>;
+
+    static Registry& global();
+
+    Registry() = default;
+    Registry(const Registry&) = delete;
+    Registry& operator=(const Registry&) = delete;
+
+    // The series for name and labels, created on the first call; later calls return the same
+    // object, which lives as long as the registry. Histograms are rendered as summaries in
+    // seconds (quantiles, _sum and _count).
+    Counter& counter(std::string_view name, std::string_view help, Labels labels = {});
+    Histogram& histogram(std::string_view name, std::string_view help, Labels labels = {});
+
+    // A value kept elsewhere (a Stats field, a queue length), read when rendering. The
+    // callback must stay valid until forget(owner).
+    void callback(std::string_view name, std::string_view help, Type type, Labels labels, const void* owner, Read read);
+    // Drops the callbacks registered with owner; call it before the object they read goes away.
+    void forget(const void* owner);
+
+    // Prometheus text exposition format 0.0.4.
+    std::string render() const;
+
+private:
+    struct Series {
+        Labels labels;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Histogram> histogram;
+        const void* owner{nullptr};
+        Read read;
+    };
+    struct Family {
+        std::string name;
+        std::string help;
+        Type type;
+        std::vector<Series> series;
+    };
+
+    Family& family(std::string_view name, std::string_view help, Type type);
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Family>> families_;    // in registration order
+};
+
+} // namespace metrics
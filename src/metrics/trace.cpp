@@ -0,0 +1,156 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <charconv>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace metrics::trace {
+
+namespace detail {
+std::atomic<uint32_t> g_sample_every{0};
+}
+
+namespace {
+
+struct Event {
+    uint64_t id;
+    std::string_view name;
+    std::string_view category;
+    int64_t start_ns;
+    int64_t end_ns;
+};
+
+// One per thread that recorded a span, kept after the thread exits so its spans can still be
+// dumped. The mutex is only contended by a dump.
+struct Buffer {
+    std::mutex mutex;
+    std::vector<Event> events;      // ring of kBufferEvents once full
+    std::size_t next{0};
+    long tid{0};
+};
+
+struct Buffers {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<Buffer>> all;
+};
+
+Buffers& buffers() {
+    // Never destroyed: threads may record during static destruction.
+    static Buffers* b = new Buffers();
+    return *b;
+}
+
+Buffer& thread_buffer() {
+    thread_local std::shared_ptr<Buffer> buffer = [] {
+        auto b = std::make_shared<Buffer>();
+        b->tid = ::syscall(SYS_gettid);
+        b->events.reserve(kBufferEvents);
+        auto& all = buffers();
+        std::lock_guard<std::mutex> lock(all.mutex);
+        all.all.push_back(b);
+        return b;
+    }();
+    return *buffer;
+}
+
+void append_escaped(std::string& out, std::string_view s) {
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+}
+
+template <typename T>
+void append_number(std::string& out, T value) {
+    char buf[24];
+    auto r = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, r.ptr);
+}
+
+// Chrome wants microseconds; keep the nanoseconds as three decimals.
+void append_us(std::string& out, int64_t ns) {
+    append_number(out, ns / 1000);
+    int64_t frac = ns % 1000;
+    out += '.';
+    out += static_cast<char>('0' + frac / 100);
+    out += static_cast<char>('0' + frac / 10 % 10);
+    out += static_cast<char>('0' + frac % 10);
+}
+
+} // namespace
+
+void set_sample_every(uint32_t n) { detail::g_sample_every.store(n, std::memory_order_relaxed); }
+
+uint32_t sample_every() { return detail::g_sample_every.load(std::memory_order_relaxed); }
+
+uint64_t detail::sample() {
+    static std::atomic<uint64_t> next_id{1};
+    thread_local uint32_t countdown = 0;
+    uint32_t every = g_sample_every.load(std::memory_order_relaxed);
+    if (every == 0) return 0;
+    if (countdown == 0 || countdown > every) countdown = every;
+    if (--countdown != 0) return 0;
+    return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+void record(uint64_t id, std::string_view name, std::string_view category, int64_t start_ns, int64_t end_ns) {
+    Buffer& b = thread_buffer();
+    std::lock_guard<std::mutex> lock(b.mutex);
+    Event event{id, name, category, start_ns, end_ns};
+    if (b.events.size() < kBufferEvents) {
+        b.events.push_back(event);
+    } else {
+        b.events[b.next] = event;
+        b.next = (b.next + 1) % kBufferEvents;
+    }
+}
+
+std::string dump_json() {
+    std::vector<std::shared_ptr<Buffer>> all;
+    {
+        auto& bs = buffers();
+        std::lock_guard<std::mutex> lock(bs.mutex);
+        all = bs.all;
+    }
+    std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    for (const auto& b : all) {
+        std::lock_guard<std::mutex> lock(b->mutex);
+        for (std::size_t i = 0; i < b->events.size(); ++i) {
+            const Event& e = b->events[(b->next + i) % b->events.size()];
+            if (!first) out += ',';
+            first = false;
+            out += "\n{\"name\":\"";
+            append_escaped(out, e.name);
+            out += "\",\"cat\":\"";
+            append_escaped(out, e.category);
+            out += "\",\"ph\":\"X\",\"pid\":1,\"tid\":";
+            append_number(out, b->tid);
+            out += ",\"ts\":";
+            append_us(out, e.start_ns);
+            out += ",\"dur\":";
+            append_us(out, std::max<int64_t>(e.end_ns - e.start_ns, 0));
+            out += ",\"args\":{\"trace\":";
+            append_number(out, e.id);
+            out += "}}";
+        }
+    }
+    out += "\n]}\n";
+    return out;
+}
+
+void clear() {
+    auto& bs = buffers();
+    std::lock_guard<std::mutex> lock(bs.mutex);
+    for (const auto& b : bs.all) {
+        std::lock_guard<std::mutex> buffer_lock(b->mutex);
+        b->events.clear();
+        b->next = 0;
+    }
+}
+
+} // namespace metrics::trace
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "metrics.h"
+
+// Request tracing: one request in sample_every() gets a trace id when it is parsed, and the
+// stages it goes through (waiting in the reactor, in the pool queue, the handler, DB calls,
+// metadata cache misses, file system calls) are recorded as spans of that id. The spans go to
+// a buffer of the recording thread and are dumped on demand in the Chrome trace event format
+// (chrome://tracing, ui.perfetto.dev).
+//
+// With sampling off, begin() is a relaxed load and a Span is a thread-local read: the clock
+// is only read for sampled requests.
+
+namespace metrics::trace {
+
+// 1 traces every request, n one in n, 0 (the default) none.
+void set_sample_every(uint32_t n);
+uint32_t sample_every();
+
+namespace detail {
+extern std::atomic<uint32_t> g_sample_every;
+inline thread_local uint64_t t_current = 0;
+uint64_t sample();
+} // namespace detail
+
+// A trace id for a new request, 0 when the request is not sampled.
+inline uint64_t begin() {
+    if (detail::g_sample_every.load(std::memory_order_relaxed) == 0) return 0;
+    return detail::sample();
+}
+
+// The trace the calling thread is working for, 0 = none.
+inline uint64_t current() { return detail::t_current; }
+
+// A finished span of trace id; times are metrics::now_ns(). name and category must outlive
+// the dump (string literals, command names).
+void record(uint64_t id, std::string_view name, std::string_view category, int64_t start_ns, int64_t end_ns);
+
+// Makes id the calling thread's current trace for the scope, so nested Spans belong to it.
+class Scope {
+public:
+    explicit Scope(uint64_t id) : previous_(detail::t_current) { detail::t_current = id; }
+    ~Scope() { detail::t_current = previous_; }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    uint64_t previous_;
+};
+
+// Records the scope as a span of the current trace, if there is one.
+class Span {
+public:
+    Span(std::string_view name, std::string_view category) : id_(current()) {
+        if (id_ != 0) {
+            name_ = name;
+            category_ = category;
+            start_ = now_ns();
+        }
+    }
+    ~Span() {
+        if (id_ != 0) record(id_, name_, category_, start_, now_ns());
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    uint64_t id_;
+    std::string_view name_;
+    std::string_view category_;
+    int64_t start_{0};
+};
+
+// All buffered spans as {"traceEvents":[...]}. Each thread keeps its latest kBufferEvents.
+inline constexpr std::size_t kBufferEvents = 8192;
+std::string dump_json();
+void clear();
+
+} // namespace metrics::trace
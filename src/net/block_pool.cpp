@@ -0,0 +1,59 @@
+#include "block_pool.h"
+
+namespace net {
+
+BlockPool::Ptr BlockPool::create() {
+    // The handle only drops the owner's reference; blocks still in use keep the pool alive.
+    return Ptr(new BlockPool(), [](BlockPool* pool) { pool->unref(); });
+}
+
+BlockPool::BlockPool() {
+    for (std::size_t c = 0; c < kClassCount; ++c) {
+        free_[c] = std::make_unique<lf::ArrayMPMCQueue<void*>>(kClassCached[c]);
+    }
+}
+
+BlockPool::~BlockPool() {
+    for (auto& list : free_) {
+        void* block = nullptr;
+        while (list->try_pop(block)) ::operator delete(block);
+    }
+}
+
+int BlockPool::class_for(std::size_t size) {
+    for (std::size_t c = 0; c < kClassCount; ++c) {
+        if (size <= kClassSize[c]) return static_cast<int>(c);
+    }
+    return -1;
+}
+
+void* BlockPool::allocate(std::size_t size) {
+    int c = class_for(size);
+    void* block = nullptr;
+    if (c < 0) {
+        block = ::operator new(size);
+    } else if (free_[c]->try_pop(block)) {
+        stats_.reused.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        block = ::operator new(kClassSize[c]);
+    }
+    users_.fetch_add(1, std::memory_order_relaxed);
+    stats_.acquired.fetch_add(1, std::memory_order_relaxed);
+    stats_.outstanding.fetch_add(1, std::memory_order_relaxed);
+    return block;
+}
+
+void BlockPool::deallocate(void* block, std::size_t size) noexcept {
+    stats_.outstanding.fetch_sub(1, std::memory_order_relaxed);
+    int c = class_for(size);
+    if (c < 0 || !free_[c]->try_push(block)) ::operator delete(block);
+    unref();
+}
+
+void BlockPool::unref() noexcept {
+    if (users_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete this;
+    }
+}
+
+} // namespace net
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "lockfreequeue/array_mpmc_queue.hpp"
+
+namespace net {
+
+// Size-classed free lists of raw memory blocks for the objects an IO reactor creates per
+// connection and per request (Connection, ConnectionContext, request handlers), one pool per
+// reactor (ReactorContext::object_pool). Like FramePool, allocate() and deallocate() may be
+// called from any thread: handlers are created on the reactor and often released by a worker.
+// Blocks return to the pool they came from, which lives until its owner handle and every
+// outstanding block are gone. Requests larger than the biggest class go to the heap.
+class BlockPool {
+public:
+    using Ptr = std::shared_ptr<BlockPool>;
+
+    // Handlers are ~500 bytes (~650 for the upload handlers) including the shared_ptr control block.
+    static constexpr std::size_t kClassCount = 4;
+    static constexpr std::array<std::size_t, kClassCount> kClassSize{128, 256, 512, 1024};
+    static constexpr std::array<std::size_t, kClassCount> kClassCached{1024, 1024, 4096, 1024};
+
+    struct Stats {
+        std::atomic<uint64_t> acquired{0};
+        std::atomic<uint64_t> reused{0};          // served from a free list
+        std::atomic<uint64_t> outstanding{0};     // blocks currently handed out
+    };
+
+    static Ptr create();
+
+    void* allocate(std::size_t size);
+    // size must be the size passed to allocate().
+    void deallocate(void* block, std::size_t size) noexcept;
+
+    const Stats& stats() const { return stats_; }
+
+    BlockPool(const BlockPool&) = delete;
+    BlockPool& operator=(const BlockPool&) = delete;
+
+private:
+    BlockPool();
+    ~BlockPool();
+
+    static int class_for(std::size_t size);
+    void unref() noexcept;
+
+    std::array<std::unique_ptr<lf::ArrayMPMCQueue<void*>>, kClassCount> free_;
+    std::atomic<uint64_t> users_{1};   // owner handle + outstanding blocks
+    Stats stats_{};
+};
+
+// Allocator over a BlockPool, for std::allocate_shared.
+template <typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    explicit PoolAllocator(BlockPool* pool) noexcept : pool_(pool) {}
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) noexcept : pool_(other.pool()) {}
+
+    T* allocate(std::size_t n) {
+        static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "over-aligned types are not pooled");
+        return static_cast<T*>(pool_->allocate(n * sizeof(T)));
+    }
+    void deallocate(T* p, std::size_t n) noexcept { pool_->deallocate(p, n * sizeof(T)); }
+
+    BlockPool* pool() const noexcept { return pool_; }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>& other) const noexcept { return pool_ == other.pool(); }
+
+private:
+    BlockPool* pool_;
+};
+
+// std::make_shared with the object and its control block in one pooled block; plain
+// make_shared without a pool (tests, tools).
+template <typename T, typename... Args>
+std::shared_ptr<T> make_pooled(BlockPool* pool, Args&&... args) {
+    if (!pool) return std::make_shared<T>(std::forward<Args>(args)...);
+    return std::allocate_shared<T>(PoolAllocator<T>(pool), std::forward<Args>(args)...);
+}
+
+} // namespace net
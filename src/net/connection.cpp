@@ -2,19 +2,29 @@
 
 #include <sys/socket.h>
 #include <unistd.h>
+#include <cerrno>
 #include <stdexcept>
 #include <iostream>
+#include <cstring>
+#include <utility>
 
 #include "handlers/handlers.h"
 #include "handlers/request_handler.h"
+#include "net/block_pool.h"
+#include "net/frame_decoder.h"
+#include "net/response_queue.h"
+#include "net/socket_profile.h"
+#include "net/request_pipeline.h"
 #include "storage/file_manager.h"
 #include "session/session_store.h"
+#include "utils/log.h"
 
 namespace net {
 
 Connection::Connection(int socket_fd, ReactorContext::Ptr reactor_context)
     : socket_fd(socket_fd), is_connected(true),
-        connection_context_(std::make_shared<ConnectionContext>(reactor_context)) {
+        connection_context_(make_pooled<ConnectionContext>(reactor_context ? reactor_context->object_pool.get() : nullptr,
+                                                           reactor_context)) {
     if (socket_fd < 0) {
         error_cpp20("Invalid socket file descriptor");
     }
@@ -34,7 +44,9 @@ Connection::Connection(int socket_fd, ReactorContext::Ptr reactor_context)
 
     // storage::FileManager::getInstance().setUser(connection_context_->session_context->user_id);
 
-    handler = std::make_shared<handlers::RequestHandler>(connection_context_);
+    auto* pool = reactor_context ? reactor_context->object_pool.get() : nullptr;
+    connection_context_->decoder = make_pooled<FrameDecoder>(pool);
+    handler = make_pooled<handlers::RequestHandler>(pool, connection_context_);
 }
 
 Connection::~Connection() {
@@ -51,11 +63,179 @@ void Connection::on_readable() {
         close();
         return;
     }
-    handler->recvRequest();
+    input_staged_ = false;
+    auto current = handler;
+    current->recvRequest();
+    // A frame may have switched handlers on this thread (PUT); the new handler takes over
+    // whatever is still buffered. Bounded, since workers also switch handlers.
+    for (int i = 0; i < 4 && is_connected && handler && handler != current; ++i) {
+        current = handler;
+        current->recvRequest();
+    }
+}
+
+void Connection::on_writable() {
+    if (!is_connected) return;
+    flush_output();
+}
+
+void Connection::on_error(int err) {
+    LOG_DEBUG("[Connection] error/hangup on fd {} ({}), closing", socket_fd, err ? strerror(err) : "hangup");
+    close();
+}
+
+void Connection::use_completions(Poller* poller) {
+    poller_ = poller;
+    connection_context_->decoder->use_poller_input(poller);
+}
+
+bool Connection::stage_input(const Poller::Received& in) {
+    if (!is_connected) {
+        if (in.res > 0) poller_->release_buffer(in.buffer);
+        return false;
+    }
+    if (in.res > 0) connection_context_->account_rx(static_cast<size_t>(in.res));
+    connection_context_->decoder->push_input(in);
+    return !std::exchange(input_staged_, true);
+}
+
+void Connection::on_sent(int32_t res) {
+    send_in_flight_ = false;
+    if (!is_connected) return;
+    if (res < 0 && res != -EAGAIN && res != -EINTR) {
+        LOG_ERROR("[Connection] send failed on fd {}: {}", socket_fd, strerror(-res));
+        fail_output();
+        return;
+    }
+    if (res > 0) {
+        out_.consume(static_cast<size_t>(res));
+        connection_context_->account_tx(static_cast<size_t>(res));
+    }
+    flush_output();
+}
+
+void Connection::enqueue_output(FrameRef frame) {
+    if (stage_output(std::move(frame))) flush_staged();
+}
+
+bool Connection::stage_output(FrameRef frame) {
+    if (!is_connected) return false;
+    if (source_) {
+        deferred_.append(std::move(frame));
+        connection_context_->pending_out_bytes.store(pending_bytes(), std::memory_order_relaxed);
+        return false;
+    }
+    out_.append(std::move(frame));
+    // With EPOLLOUT armed the socket is known to be full, wait for the writable event.
+    if (want_write_ || flush_staged_) return false;
+    flush_staged_ = true;
+    return true;
+}
+
+void Connection::flush_staged() {
+    if (!flush_staged_) return;
+    flush_staged_ = false;
+    if (is_connected && !want_write_) flush_output();
+}
+
+void Connection::attach_source(OutboundSource source) {
+    if (!is_connected || !source) return;
+    if (source_) {
+        // Only one stream at a time; chain the next one behind the current.
+        struct Chain {
+            OutboundSource first;
+            OutboundSource next;
+            bool on_first = true;
+        };
+        source_ = [chain = std::make_unique<Chain>(Chain{std::move(source_), std::move(source)})](OutboundBuffer& out) {
+            if (chain->on_first && chain->first(out)) return true;
+            chain->on_first = false;
+            return chain->next(out);
+        };
+        return;
+    }
+    source_ = std::move(source);
+    use_socket_profile(*connection_context_, SocketProfileKind::BulkDownload);
+    if (!want_write_) flush_output();
+}
+
+void Connection::flush_output() {
+    flush_staged_ = false;
+    if (poller_) {
+        // One send in flight; on_sent() comes back here with its result.
+        if (!send_in_flight_) {
+            top_up_output();
+            start_send();
+        }
+        connection_context_->pending_out_bytes.store(pending_bytes(), std::memory_order_relaxed);
+        return;
+    }
+    while (true) {
+        top_up_output();
+        size_t written = 0;
+        auto result = out_.flush(socket_fd, written);
+        if (written) connection_context_->account_tx(written);
+
+        if (result == OutboundBuffer::FlushResult::Error) {
+            LOG_ERROR("[Connection] send failed on fd {}: {}", socket_fd, strerror(errno));
+            fail_output();
+            return;
+        }
+        if (result == OutboundBuffer::FlushResult::WouldBlock) {
+            set_write_interest(true);
+            break;
+        }
+        if (!source_) {
+            set_write_interest(false);
+            break;
+        }
+    }
+    connection_context_->pending_out_bytes.store(pending_bytes(), std::memory_order_relaxed);
+}
+
+void Connection::top_up_output() {
+    // Top up from the active source, then release output that was queued behind it.
+    while (source_ && out_.pending_bytes() < OutboundBuffer::kLowWatermark) {
+        if (!source_(out_)) {
+            source_ = nullptr;
+            out_.splice(deferred_);
+            leave_socket_profile(*connection_context_, SocketProfileKind::BulkDownload);
+        }
+    }
+}
+
+void Connection::start_send() {
+    if (out_.empty()) return;
+    iovec iov[OutboundBuffer::kMaxIov];
+    FrameRef frames[OutboundBuffer::kMaxIov];
+    const int n = out_.prepare(iov, frames, OutboundBuffer::kMaxIov);
+    const auto count = static_cast<size_t>(n);
+    if (!poller_->submit_send(socket_fd, {iov, count}, {frames, count})) {
+        LOG_ERROR("[Connection] could not submit a send on fd {}", socket_fd);
+        fail_output();
+        return;
+    }
+    send_in_flight_ = true;
 }
 
-void Connection::on_writable() {}
-void Connection::on_error(int err) {}
+void Connection::fail_output() {
+    out_.clear();
+    deferred_.clear();
+    source_ = nullptr;
+    connection_context_->pending_out_bytes.store(0, std::memory_order_relaxed);
+    close();
+}
+
+void Connection::set_write_interest(bool enable) {
+    if (want_write_ == enable) return;
+    auto* reactor = connection_context_->reactor_context->io_reactor;
+    if (!reactor) return;
+    uint32_t events = EPOLLIN | EPOLLET | (enable ? uint32_t{EPOLLOUT} : 0u);
+    if (reactor->mod_fd(socket_fd, events)) {
+        want_write_ = enable;
+        if (enable) reactor->note_write_stall();
+    }
+}
 
 void Connection::handle() {
     if (handler) {
@@ -68,17 +248,53 @@ void Connection::handle() {
 
 void Connection::change_handler(const std::shared_ptr<handlers::RequestHandler>& new_handler) {
     int fd = socket_fd;
-    log_cpp20("[Connection] change_handler fd=" + std::to_string(fd) + " -> new handler type=" + std::string(typeid(*new_handler).name()));
+    LOG_TRACE("[Connection] change_handler fd={} -> new handler type={}", fd, typeid(*new_handler).name());
     handler = new_handler;
+    if (typeid(*new_handler) == typeid(handlers::RequestHandler)) {
+        // back on the base handler: the previous request is complete
+        leave_socket_profile(*connection_context_, SocketProfileKind::BulkUpload);
+        connection_context_->request_in_flight.store(false);
+        if (connection_context_->input_stalled.exchange(false)) {
+            connection_context_->reactor_context->response_queue->submit_resume(
+                socket_fd, connection_context_->connection_generation);
+        }
+    }
+}
+
+int Connection::getSocketFD() const {
+    return socket_fd;
+}
+
+bool Connection::is_idle() const {
+    return is_connected
+        && out_.empty() && deferred_.empty() && !source_ && !send_in_flight_
+        && connection_context_->decoder->idle()
+        && connection_context_->responses_queued.load(std::memory_order_acquire) == 0
+        && handler
+        && typeid(*handler) == typeid(handlers::RequestHandler)
+        && !connection_context_->in_put_upload
+        && !connection_context_->request_in_flight.load(std::memory_order_acquire)
+        && (!connection_context_->pipeline || connection_context_->pipeline->outstanding() == 0);
+}
+
+bool Connection::transfer_pending() const {
+    return !out_.empty() || !deferred_.empty() || source_ || send_in_flight_
+        || !connection_context_->decoder->idle()
+        || connection_context_->in_put_upload
+        || (handler && typeid(*handler) != typeid(handlers::RequestHandler));
+}
+
+void Connection::rebind(ReactorContext::Ptr reactor_context, uint32_t generation) {
+    connection_context_->reactor_context = std::move(reactor_context);
+    connection_context_->connection_generation = generation;
 }
 
 
 void Connection::close() {
-    if (is_connected) {
-        // TODO handler ?
-        ::close(socket_fd);
-        is_connected = false;
-    }
+    // The close callback drops the reactor's reference; keep this alive to the end.
+    auto self = weak_from_this().lock();
+    const bool was_connected = is_connected;
+    is_connected = false;
     // detach from session store
     if (connection_context_ && connection_context_->session_context) {
         auto sid = connection_context_->session_context->session_id;
@@ -89,10 +305,20 @@ void Connection::close() {
             SessionStore::instance().remove_session(sid);
         }
     }
-    connection_context_->reactor_context->connection_close_callback(socket_fd);
+    // Out of the poller and the reactor's slab while the fd is still ours: once closed, the
+    // number may be reused by the next accept, and EPOLL_CTL_DEL on it would fail.
+    connection_context_->reactor_context->connection_close_callback(socket_fd, connection_context_->connection_generation);
+    // Staged receive buffers go back to the poller; off the reactor thread the decoder may be
+    // in use, and its destructor returns them instead.
+    if (poller_ && connection_context_->reactor_context->io_reactor
+        && connection_context_->reactor_context->io_reactor->in_loop_thread()) {
+        connection_context_->decoder->drop_input();
+    }
+    if (was_connected) ::close(socket_fd);
     connection_context_->connection = nullptr;
 }
 
+
 bool Connection::is_open() const {
     return is_connected;
 }
@@ -8,6 +8,7 @@
 #include <functional>
 
 #include "io_reactor.h"
+#include "outbound_buffer.h"
 #include "types/context.h"
 
 namespace net {
@@ -27,20 +28,77 @@ public:
     void on_writable();
     void on_error(int err);
 
+    // Completion backend (Poller::add_receiver): input arrives through stage_input() and output
+    // goes out as one poller send at a time, finished by on_sent(). Reactor thread only.
+    void use_completions(Poller* poller);
+    bool uses_completions() const { return poller_ != nullptr; }
+    // Stage one receive for the decoder. True for the first since the last on_readable(), when
+    // the caller owes the connection an on_readable() call.
+    bool stage_input(const Poller::Received& in);
+    void on_sent(int32_t res);
+
     void handle();
 
     void change_handler(const std::shared_ptr<handlers::RequestHandler>& new_handler);
 
     int getSocketFD() const;
+    void set_generation(uint32_t generation) { connection_context_->connection_generation = generation; }
+
+    // True between requests: base handler installed, no upload or dispatched request pending.
+    // Only idle connections are moved between IO reactors.
+    bool is_idle() const;
+    // Attach to another IO reactor after migration (called on the adopting reactor).
+    void rebind(ReactorContext::Ptr reactor_context, uint32_t generation);
+
+    // Outbound path, reactor thread only. Data is written right away as far as the socket
+    // accepts; the remainder waits in the outbound buffer and EPOLLOUT drives the rest.
+    void enqueue_output(FrameRef frame);
+    // Batched variant: queue without writing. Returns true when the connection needs a
+    // flush_staged() call, i.e. for the first staged frame since the last flush.
+    bool stage_output(FrameRef frame);
+    void flush_staged();
+    // Stream a body from source; output enqueued meanwhile is held back until the source ends.
+    void attach_source(OutboundSource source);
+    const ConnectionContext::Ptr& context() const { return connection_context_; }
+    size_t pending_bytes() const { return out_.pending_bytes() + deferred_.pending_bytes(); }
     void close();
     bool is_open() const;
 
+    // Timeout bookkeeping for the owning reactor. last_active is reactor thread only; the timer
+    // id is also read by release_connection, which may run on a worker thread.
+    void touch(TimerWheel::Clock::time_point now) { last_active_ = now; }
+    TimerWheel::Clock::time_point last_active() const { return last_active_; }
+    TimerWheel::TimerId timer() const { return timer_.load(std::memory_order_acquire); }
+    void set_timer(TimerWheel::TimerId id) { timer_.store(id, std::memory_order_release); }
+    // A transfer that must keep making progress: upload handler, partial frame, unsent output.
+    bool transfer_pending() const;
+
 private:
     int socket_fd;
     bool is_connected;
     struct sockaddr_in client_address;
     std::shared_ptr<handlers::RequestHandler> handler;
 
+    void flush_output();
+    void top_up_output();
+    // Completion backend: submit the head of out_ as the one send in flight.
+    void start_send();
+    // The output cannot be delivered: drop it and close.
+    void fail_output();
+    void set_write_interest(bool enable);
+
+    OutboundBuffer out_;
+    OutboundBuffer deferred_;       // output queued behind an active source
+    OutboundSource source_{};
+    bool want_write_{false};        // EPOLLOUT currently armed
+    bool flush_staged_{false};      // staged frames waiting for flush_staged()
+    Poller* poller_{nullptr};       // completion backend, see use_completions()
+    bool send_in_flight_{false};
+    bool input_staged_{false};      // stage_input() since the last on_readable()
+
+    TimerWheel::Clock::time_point last_active_{TimerWheel::Clock::now()};
+    std::atomic<TimerWheel::TimerId> timer_{0};
+
     ConnectionContext::Ptr connection_context_{nullptr};
 };
 
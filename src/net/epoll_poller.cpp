@@ -54,25 +54,20 @@ bool EpollPoller::remove_fd(int fd) {
     return true;
 }
 
-std::optional<std::vector<epoll_event>> EpollPoller::poll(int timeout = -1) {
-    std::vector<epoll_event> active_events;
-    struct epoll_event events[1024];
-    int num_events = epoll_wait(epoll_fd_, events, 1024, timeout);
+std::optional<std::span<const epoll_event>> EpollPoller::poll(int timeout = -1) {
+    int num_events = epoll_wait(epoll_fd_, events_, kMaxEvents, timeout);
 
     if (num_events < 0) {
         if (errno == EINTR) {
             log_cpp20("epoll_wait interrupted by signal: " + std::string(strerror(errno)));
+            num_events = 0;
         } else {
             error_cpp20("epoll_wait failed: " + std::string(strerror(errno)));
             return std::nullopt;
         } 
     }
 
-    for (int i = 0; i < num_events; ++i) {
-        active_events.push_back(events[i]);
-    }
-
-    return active_events;
+    return std::span<const epoll_event>(events_, static_cast<size_t>(num_events));
 }
 
 } // namespace net
\ No newline at end of file
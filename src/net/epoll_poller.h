@@ -7,22 +7,28 @@
 #include <iostream>
 #include <optional>
 
+#include "poller.h"
+
 namespace net {
 
-class EpollPoller {
+class EpollPoller : public Poller {
 public:
     EpollPoller();
-    ~EpollPoller();
+    ~EpollPoller() override;
 
-    bool add_fd(int fd, uint32_t events);
-    bool modify_fd(int fd, uint32_t events);
-    bool remove_fd(int fd);
+    bool add_fd(int fd, uint32_t events) override;
+    bool modify_fd(int fd, uint32_t events) override;
+    bool remove_fd(int fd) override;
     int epoll_fd() const { return epoll_fd_; }
-    std::optional<std::vector<epoll_event>> poll(int timeout);
+    std::optional<std::span<const epoll_event>> poll(int timeout) override;
+
+    const char* name() const override { return "epoll"; }
 
 private:
+    static constexpr int kMaxEvents = 1024;
+
     int epoll_fd_;
-    struct epoll_event events_[1024];
+    struct epoll_event events_[kMaxEvents];
 };
 
 } // namespace net
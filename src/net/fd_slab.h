@@ -0,0 +1,135 @@
+#pragma once
+
+#include <sys/resource.h>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace net {
+
+// fd-indexed table of shared objects, replacing unordered_map<int, shared_ptr<T>> on the reactor hot path.
+//
+// Slots live in fixed 4096-entry chunks that are allocated on first insert and never move, so a
+// lookup is two loads and no hashing, and an insert from another thread (MainReactor handing over
+// an accepted fd) never invalidates a concurrent lookup. Each slot carries a generation that is
+// bumped on insert and erase, letting callers detect that an fd number was closed and reused.
+template <typename T>
+class FdSlab {
+public:
+    using Ptr = std::shared_ptr<T>;
+
+    explicit FdSlab(std::size_t max_fds = default_max_fds())
+        : chunk_count_((max_fds + kChunkSize - 1) / kChunkSize),
+          chunks_(new std::atomic<Chunk*>[chunk_count_]) {
+        for (std::size_t i = 0; i < chunk_count_; ++i) {
+            chunks_[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~FdSlab() {
+        for (std::size_t i = 0; i < chunk_count_; ++i) {
+            delete chunks_[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    FdSlab(const FdSlab&) = delete;
+    FdSlab& operator=(const FdSlab&) = delete;
+
+    // Returns the new generation of the slot, 0 if fd is out of range.
+    uint32_t insert(int fd, Ptr item) {
+        Slot* s = slot_for_insert(fd);
+        if (!s) return 0;
+        if (!s->item) size_.fetch_add(1, std::memory_order_relaxed);
+        s->item = std::move(item);
+        return s->generation.fetch_add(1, std::memory_order_acq_rel) + 1;
+    }
+
+    bool erase(int fd) {
+        Slot* s = slot(fd);
+        if (!s || !s->item) return false;
+        s->generation.fetch_add(1, std::memory_order_acq_rel);
+        s->item.reset();
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Copy of the stored pointer (keeps the object alive across callbacks that may erase it).
+    Ptr get(int fd) const {
+        Slot* s = slot(fd);
+        return s ? s->item : nullptr;
+    }
+
+    uint32_t generation(int fd) const {
+        Slot* s = slot(fd);
+        return s ? s->generation.load(std::memory_order_acquire) : 0;
+    }
+
+    // Visit occupied slots in fd order until fn(fd, item) returns false. Owner thread only.
+    template <typename Fn>
+    void for_each(Fn&& fn) const {
+        for (std::size_t c = 0; c < chunk_count_; ++c) {
+            Chunk* chunk = chunks_[c].load(std::memory_order_acquire);
+            if (!chunk) continue;
+            for (std::size_t i = 0; i < kChunkSize; ++i) {
+                const Slot& s = chunk->slots[i];
+                if (s.item && !fn(static_cast<int>((c << kChunkShift) | i), s.item)) return;
+            }
+        }
+    }
+
+    std::size_t size() const { return size_.load(std::memory_order_relaxed); }
+    std::size_t capacity() const { return chunk_count_ * kChunkSize; }
+
+    static std::size_t default_max_fds() {
+        struct rlimit rl{};
+        if (::getrlimit(RLIMIT_NOFILE, &rl) != 0 || rl.rlim_cur == RLIM_INFINITY || rl.rlim_cur > kMaxFds) {
+            return kMaxFds;
+        }
+        return static_cast<std::size_t>(rl.rlim_cur);
+    }
+
+private:
+    static constexpr std::size_t kChunkShift = 12;
+    static constexpr std::size_t kChunkSize = std::size_t(1) << kChunkShift;
+    static constexpr std::size_t kMaxFds = std::size_t(1) << 22;
+
+    struct Slot {
+        Ptr item{};
+        std::atomic<uint32_t> generation{0};
+    };
+
+    struct Chunk {
+        Slot slots[kChunkSize];
+    };
+
+    Slot* slot(int fd) const {
+        if (fd < 0) return nullptr;
+        std::size_t idx = static_cast<std::size_t>(fd) >> kChunkShift;
+        if (idx >= chunk_count_) return nullptr;
+        Chunk* c = chunks_[idx].load(std::memory_order_acquire);
+        return c ? &c->slots[fd & (kChunkSize - 1)] : nullptr;
+    }
+
+    Slot* slot_for_insert(int fd) {
+        if (fd < 0) return nullptr;
+        std::size_t idx = static_cast<std::size_t>(fd) >> kChunkShift;
+        if (idx >= chunk_count_) return nullptr;
+        Chunk* c = chunks_[idx].load(std::memory_order_acquire);
+        if (!c) {
+            auto* fresh = new Chunk();
+            if (chunks_[idx].compare_exchange_strong(c, fresh, std::memory_order_acq_rel)) {
+                c = fresh;
+            } else {
+                delete fresh;
+            }
+        }
+        return &c->slots[fd & (kChunkSize - 1)];
+    }
+
+    const std::size_t chunk_count_;
+    std::unique_ptr<std::atomic<Chunk*>[]> chunks_;
+    std::atomic<std::size_t> size_{0};
+};
+
+} // namespace net
@@ -0,0 +1,74 @@
+#include "frame_buffer.h"
+
+#include <new>
+
+namespace net {
+
+FramePool::Ptr FramePool::create() {
+    // The handle only drops the owner's reference; frames still in flight keep the pool alive.
+    return Ptr(new FramePool(), [](FramePool* pool) { pool->unref(); });
+}
+
+FramePool::FramePool() {
+    for (std::size_t c = 0; c < kClassCount; ++c) {
+        free_[c] = std::make_unique<lf::ArrayMPMCQueue<FrameBuffer*>>(kClassCached[c]);
+    }
+}
+
+FramePool::~FramePool() {
+    for (auto& list : free_) {
+        FrameBuffer* frame = nullptr;
+        while (list->try_pop(frame)) {
+            frame->~FrameBuffer();
+            ::operator delete(frame);
+        }
+    }
+}
+
+int FramePool::class_for(std::size_t body_size) {
+    for (std::size_t c = 0; c < kClassCount; ++c) {
+        if (body_size <= kClassCapacity[c]) return static_cast<int>(c);
+    }
+    return -1;
+}
+
+FrameRef FramePool::acquire(std::size_t body_size, const protocol::WireFormat& format) {
+    int c = class_for(body_size);
+    if (c < 0 || body_size > format.max_body) return FrameRef{};
+
+    FrameBuffer* frame = nullptr;
+    if (free_[c]->try_pop(frame)) {
+        stats_.reused.fetch_add(1, std::memory_order_relaxed);
+        stats_.cached_bytes.fetch_sub(kClassCapacity[c], std::memory_order_relaxed);
+    } else {
+        void* mem = ::operator new(sizeof(FrameBuffer) + protocol::kMaxHeaderSize + kClassCapacity[c]);
+        frame = new (mem) FrameBuffer(this, static_cast<uint8_t>(c), kClassCapacity[c]);
+    }
+    users_.fetch_add(1, std::memory_order_relaxed);
+    stats_.acquired.fetch_add(1, std::memory_order_relaxed);
+    stats_.outstanding.fetch_add(1, std::memory_order_relaxed);
+
+    frame->header_ = protocol::FrameHeader{};
+    frame->header_.length = static_cast<uint32_t>(body_size);
+    frame->format_ = format;
+    return FrameRef(frame);
+}
+
+void FramePool::recycle(FrameBuffer* frame) {
+    stats_.outstanding.fetch_sub(1, std::memory_order_relaxed);
+    if (free_[frame->size_class_]->try_push(frame)) {
+        stats_.cached_bytes.fetch_add(frame->capacity_, std::memory_order_relaxed);
+    } else {
+        frame->~FrameBuffer();
+        ::operator delete(frame);
+    }
+    unref();
+}
+
+void FramePool::unref() {
+    if (users_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete this;
+    }
+}
+
+} // namespace net
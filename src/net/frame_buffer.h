@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "protocol/wire_format.h"
+#include "lockfreequeue/array_mpmc_queue.hpp"
+
+namespace net {
+
+class FramePool;
+
+// One wire frame (header followed by the body) in a pooled, refcounted allocation.
+// The body is not zero-initialized; only header.length bytes of it are meaningful. The header is
+// kept decoded and written in front of the body in the frame's wire format by seal(), so the
+// same frame can go out as v1 or v2 without moving the body.
+class FrameBuffer {
+public:
+    protocol::FrameHeader& header() { return header_; }
+    const protocol::FrameHeader& header() const { return header_; }
+    uint8_t* body() { return bytes_ + protocol::kMaxHeaderSize; }
+    const uint8_t* body() const { return bytes_ + protocol::kMaxHeaderSize; }
+    std::size_t body_capacity() const { return capacity_; }
+
+    // Framing the frame is sent with: the connection's at acquire().
+    const protocol::WireFormat& format() const { return format_; }
+    // Encode the header for format() in front of the body, with the body's CRC when the
+    // format carries one. Done by OutboundBuffer::append once the frame is complete.
+    void seal() { protocol::encode_header(header_, format_, body(), body() - format_.header_size()); }
+
+    // Sealed header plus header().length bytes of body, as written to the socket.
+    const uint8_t* wire_data() const { return body() - format_.header_size(); }
+    std::size_t wire_size() const { return format_.header_size() + header_.length; }
+
+private:
+    friend class FramePool;
+    friend class FrameRef;
+
+    FrameBuffer(FramePool* pool, uint8_t size_class, std::size_t capacity)
+        : pool_(pool), size_class_(size_class), capacity_(capacity) {}
+
+    FramePool* pool_;
+    std::atomic<uint32_t> refs_{0};
+    uint8_t size_class_;
+    std::size_t capacity_;
+    protocol::FrameHeader header_{};
+    protocol::WireFormat format_{};
+    alignas(8) uint8_t bytes_[];    // room for the largest header + capacity_ body bytes, allocated inline
+};
+
+// Shared handle to a FrameBuffer. Copying bumps the refcount, so a frame built on a worker
+// can be queued to the reactor and written from there without copying the payload.
+class FrameRef {
+public:
+    FrameRef() = default;
+    FrameRef(const FrameRef& other) : frame_(other.frame_) { retain(); }
+    FrameRef(FrameRef&& other) noexcept : frame_(other.frame_) { other.frame_ = nullptr; }
+    FrameRef& operator=(const FrameRef& other) {
+        if (this != &other) { release(); frame_ = other.frame_; retain(); }
+        return *this;
+    }
+    FrameRef& operator=(FrameRef&& other) noexcept {
+        if (this != &other) { release(); frame_ = other.frame_; other.frame_ = nullptr; }
+        return *this;
+    }
+    ~FrameRef() { release(); }
+
+    explicit operator bool() const { return frame_ != nullptr; }
+    FrameBuffer* operator->() const { return frame_; }
+    FrameBuffer& operator*() const { return *frame_; }
+    FrameBuffer* get() const { return frame_; }
+    void reset() { release(); frame_ = nullptr; }
+
+private:
+    friend class FramePool;
+    explicit FrameRef(FrameBuffer* frame) : frame_(frame) { retain(); }
+
+    void retain() { if (frame_) frame_->refs_.fetch_add(1, std::memory_order_relaxed); }
+    void release();
+
+    FrameBuffer* frame_{nullptr};
+};
+
+// Size-classed free lists of FrameBuffers, one pool per IO reactor (ReactorContext::frame_pool).
+// acquire() may be called from any thread (workers build responses into their connection's
+// reactor pool); frames return to the pool they came from when the last FrameRef goes away.
+// The pool itself is released once its owner handle and every outstanding frame are gone.
+class FramePool {
+public:
+    using Ptr = std::shared_ptr<FramePool>;
+
+    // The two large classes only serve protocol v2 connections that agreed on large frames.
+    static constexpr std::size_t kClassCount = 7;
+    static constexpr std::array<std::size_t, kClassCount> kClassCapacity{256, 1024, 4096, 16384, 65536, 262144, 1048576};
+    static constexpr std::array<std::size_t, kClassCount> kClassCached{2048, 1024, 256, 128, 32, 16, 8};
+
+    struct Stats {
+        std::atomic<uint64_t> acquired{0};
+        std::atomic<uint64_t> reused{0};          // served from a free list
+        std::atomic<uint64_t> cached_bytes{0};    // bytes parked in free lists
+        std::atomic<uint64_t> outstanding{0};     // frames currently handed out
+    };
+
+    static Ptr create();
+
+    // Frame whose body holds at least body_size bytes, sent with `format`; header.length is
+    // set to body_size. Returns an empty ref when body_size exceeds format.max_body.
+    FrameRef acquire(std::size_t body_size, const protocol::WireFormat& format = {});
+
+    const Stats& stats() const { return stats_; }
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+private:
+    friend class FrameRef;
+
+    FramePool();
+    ~FramePool();
+
+    static int class_for(std::size_t body_size);
+    void recycle(FrameBuffer* frame);
+    void unref();
+
+    std::array<std::unique_ptr<lf::ArrayMPMCQueue<FrameBuffer*>>, kClassCount> free_;
+    std::atomic<uint64_t> users_{1};   // owner handle + outstanding frames
+    Stats stats_{};
+};
+
+inline void FrameRef::release() {
+    if (frame_ && frame_->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        frame_->pool_->recycle(frame_);
+    }
+}
+
+} // namespace net
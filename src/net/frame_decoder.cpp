@@ -0,0 +1,146 @@
+#include "frame_decoder.h"
+
+#include <sys/socket.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace net {
+
+std::span<const uint8_t> FrameDecoder::raw_bytes() const {
+    if (in_buffer() > 0 || head_ == segments_.size()) return {buffer_.get() + rpos_, in_buffer()};
+    return {segments_[head_].data, segments_[head_].size};
+}
+
+void FrameDecoder::consume_raw(std::size_t n) {
+    std::size_t k = std::min(n, in_buffer());
+    rpos_ += k;
+    n -= k;
+    if (rpos_ == wpos_) rpos_ = wpos_ = 0;
+    while (n > 0 && head_ < segments_.size()) {
+        Segment& seg = segments_[head_];
+        k = std::min(n, seg.size);
+        seg.data += k;
+        seg.size -= k;
+        staged_ -= k;
+        n -= k;
+        if (seg.size == 0) pop_segment();
+    }
+}
+
+void FrameDecoder::push_input(const Poller::Received& in) {
+    if (in.res <= 0) {
+        input_end_ = in.res == 0 ? Fill::Closed : Fill::Error;
+        return;
+    }
+    segments_.push_back({in.data, static_cast<std::size_t>(in.res), in.buffer});
+    staged_ += static_cast<std::size_t>(in.res);
+}
+
+void FrameDecoder::drop_input() {
+    while (head_ < segments_.size()) {
+        staged_ -= segments_[head_].size;
+        pop_segment();
+    }
+}
+
+void FrameDecoder::pop_segment() {
+    poller_->release_buffer(segments_[head_].buffer);
+    if (++head_ == segments_.size()) {
+        segments_.clear();
+        head_ = 0;
+    }
+}
+
+FrameDecoder::Fill FrameDecoder::fill_staged(uint8_t* dst, std::size_t room, std::size_t& copied) {
+    if (head_ == segments_.size()) return input_end_;
+    copied = 0;
+    while (room > 0 && head_ < segments_.size()) {
+        Segment& seg = segments_[head_];
+        std::size_t n = std::min(room, seg.size);
+        std::memcpy(dst + copied, seg.data, n);
+        seg.data += n;
+        seg.size -= n;
+        staged_ -= n;
+        copied += n;
+        room -= n;
+        if (seg.size == 0) pop_segment();
+    }
+    return Fill::Progress;
+}
+
+FrameRef FrameDecoder::next(FramePool& pool) {
+    if (bad_) return {};
+    if (!partial_) {
+        const std::size_t header_size = format_.header_size();
+        if (in_buffer() < header_size) return {};
+        protocol::FrameHeader header = protocol::decode_header(buffer_.get() + rpos_, format_);
+        partial_ = pool.acquire(header.length, format_);
+        if (!partial_) {
+            // Larger than agreed: the stream cannot be resynchronized.
+            partial_.reset();
+            bad_ = true;
+            return {};
+        }
+        rpos_ += header_size;
+        partial_->header() = header;
+        got_ = 0;
+    }
+    std::size_t need = partial_->header().length - got_;
+    std::size_t n = std::min(need, in_buffer());
+    if (n) {
+        std::memcpy(partial_->body() + got_, buffer_.get() + rpos_, n);
+        got_ += n;
+        rpos_ += n;
+    }
+    if (rpos_ == wpos_) rpos_ = wpos_ = 0;
+    if (got_ < partial_->header().length) return {};
+    got_ = 0;
+    if (!protocol::verify_body(partial_->header(), partial_->body())) {
+        partial_.reset();
+        bad_ = true;
+        return {};
+    }
+    return std::move(partial_);
+}
+
+FrameDecoder::Fill FrameDecoder::fill(int fd, std::size_t& bytes_read) {
+    uint8_t* dst;
+    std::size_t room;
+    const bool direct = partial_ && in_buffer() == 0;
+    if (direct) {
+        // Body in progress: receive directly into the frame.
+        dst = partial_->body() + got_;
+        room = partial_->header().length - got_;
+    } else {
+        // Only a partial header can be left here, move it to the front.
+        if (rpos_ != 0) {
+            std::memmove(buffer_.get(), buffer_.get() + rpos_, in_buffer());
+            wpos_ -= rpos_;
+            rpos_ = 0;
+        }
+        dst = buffer_.get() + wpos_;
+        room = kBufferSize - wpos_;
+    }
+    if (poller_) {
+        // Already counted when it was staged.
+        std::size_t n = 0;
+        Fill result = fill_staged(dst, room, n);
+        if (direct) got_ += n; else wpos_ += n;
+        return result;
+    }
+    while (true) {
+        ssize_t n = ::recv(fd, dst, room, 0);
+        if (n > 0) {
+            bytes_read += static_cast<std::size_t>(n);
+            if (direct) got_ += n; else wpos_ += n;
+            return Fill::Progress;
+        }
+        if (n == 0) return Fill::Closed;
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return Fill::Drained;
+        return Fill::Error;
+    }
+}
+
+} // namespace net
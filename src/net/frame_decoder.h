@@ -0,0 +1,127 @@
+#pragma once
+
+#include <sys/types.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "frame_buffer.h"
+#include "poller.h"
+#include "protocol/wire_format.h"
+
+namespace net {
+
+// Resumable per-connection frame decoder, driven from the reactor thread.
+//
+// Reads whatever the socket has (never MSG_WAITALL) into a small connection-owned buffer and
+// cuts complete frames out of it; several pipelined frames from one read are all emitted, a
+// frame split over many reads is completed across calls. Once a header is known, the rest of a
+// large body is received straight into its pooled frame instead of through the buffer.
+// Headers are parsed in the connection's wire format: v1 until a hello switches it, from the
+// frame after the hello on. A frame above the agreed size or with a bad CRC is an Error.
+// On a completion backend the socket is not read here: the reactor stages the poller's receive
+// buffers with push_input() and the decoder copies out of them, returning each to the poller
+// once it is used up.
+class FrameDecoder {
+public:
+    enum class Status : uint8_t {
+        Drained,    // socket returned EAGAIN (or the staged input is used up), wait for more
+        Stopped,    // accept() declined more frames; buffered input is kept for later
+        Closed,     // peer closed (frames received before the FIN were delivered)
+        Error       // socket error, or a frame that breaks the agreed format
+    };
+
+    static constexpr std::size_t kBufferSize = 16 * 1024;
+
+    FrameDecoder() : buffer_(new uint8_t[kBufferSize]) {}
+    ~FrameDecoder() { drop_input(); }
+
+    // Deliver decoded frames to on_frame(FrameRef) while accept() allows, reading the socket as
+    // needed. bytes_read accumulates what came off the socket.
+    template <typename Accept, typename OnFrame>
+    Status read_frames(int fd, FramePool& pool, Accept&& accept, OnFrame&& on_frame, std::size_t& bytes_read) {
+        while (true) {
+            while (decodable()) {
+                if (!accept()) return Status::Stopped;
+                FrameRef frame = next(pool);
+                if (!frame) {
+                    if (bad_) return Status::Error;
+                    break;
+                }
+                on_frame(std::move(frame));
+            }
+            switch (fill(fd, bytes_read)) {
+                case Fill::Progress: continue;
+                case Fill::Drained:  return Status::Drained;
+                case Fill::Closed:   return Status::Closed;
+                case Fill::Error:    return Status::Error;
+            }
+        }
+    }
+
+    // Bytes received but not yet decoded (e.g. raw upload data that followed the last frame).
+    // Contiguous, so possibly only a part of buffered(): consume it and ask again.
+    std::span<const uint8_t> raw_bytes() const;
+    void consume_raw(std::size_t n);
+
+    // Completion input (Poller::add_receiver). Reactor thread only.
+    void use_poller_input(Poller* poller) { poller_ = poller; }
+    bool poller_input() const { return poller_ != nullptr; }
+    // Stage one receive completion; res <= 0 ends the input (0 = peer closed). The bytes are
+    // not counted again by read_frames(), the caller accounts them here.
+    void push_input(const Poller::Received& in);
+    // Return the staged buffers to the poller undecoded (the connection is closing).
+    void drop_input();
+    // The peer closed or the receive failed; what is staged can still be decoded.
+    bool input_ended() const { return input_end_ != Fill::Drained; }
+
+    // Header format for the frames after the current one (reactor thread, e.g. from on_frame).
+    void set_format(const protocol::WireFormat& format) { format_ = format; }
+    const protocol::WireFormat& format() const { return format_; }
+
+    std::size_t buffered() const { return in_buffer() + staged_; }
+    // Nothing buffered and no frame half received.
+    bool idle() const { return buffered() == 0 && !partial_; }
+
+private:
+    enum class Fill : uint8_t { Progress, Drained, Closed, Error };
+
+    struct Segment {
+        const uint8_t* data;
+        std::size_t size;
+        uint16_t buffer;
+    };
+
+    std::size_t in_buffer() const { return wpos_ - rpos_; }
+
+    // next() can make progress: a header is buffered, or the current frame has new bytes or is complete.
+    bool decodable() const {
+        return partial_ ? in_buffer() > 0 || got_ == partial_->header().length
+                        : in_buffer() >= format_.header_size();
+    }
+    FrameRef next(FramePool& pool);
+    Fill fill(int fd, std::size_t& bytes_read);
+    // fill() on a completion backend: copy from the staged segments.
+    Fill fill_staged(uint8_t* dst, std::size_t room, std::size_t& copied);
+    void pop_segment();
+
+    std::unique_ptr<uint8_t[]> buffer_;
+    std::size_t rpos_{0};
+    std::size_t wpos_{0};
+
+    FrameRef partial_{};        // frame whose body is still arriving
+    std::size_t got_{0};        // body bytes of partial_ received so far
+
+    protocol::WireFormat format_{};
+    bool bad_{false};           // oversized or corrupt frame seen, the stream is unusable
+
+    Poller* poller_{nullptr};           // set: input comes from push_input()
+    std::vector<Segment> segments_;     // staged receive buffers, consumed from head_
+    std::size_t head_{0};
+    std::size_t staged_{0};             // bytes left in segments_
+    Fill input_end_{Fill::Drained};     // Closed / Error once the input has ended
+};
+
+} // namespace net
@@ -7,50 +7,214 @@
 #include <cerrno>
 #include <vector>
 #include <chrono>
+#include <algorithm>
 #include <sys/eventfd.h>
+#include <sys/socket.h>
 
 #include "common/debug.h"
 #include "response_queue.h"
 #include "connection.h"
+#include "frame_buffer.h"
+#include "block_pool.h"
+#include "socket_profile.h"
+#include "concurrency/admission_controller.h"
+#include "protocol/codec.h"
+#include "protocol/response_builder.h"
+#include "types/enums.h"
+#include "types/message.h"
+#include "utils/alloc_counter.h"
+#include "types/pending_large_upload.h"
+#include "session/session_store.h"
+#include "metrics/metrics.h"
+#include "utils/log.h"
 
 namespace net {
 
+namespace {
+constexpr int kMaxPollTimeoutMs = 1000;
+
+// Delay of a connection's first timeout check: the shortest enabled limit that applies to a
+// fresh connection. Zero when every timeout is disabled.
+std::chrono::milliseconds first_check(const ConnectionTimeouts& t) {
+    for (auto limit : {t.idle, t.stall, t.session}) {
+        if (limit.count() > 0) return limit;
+    }
+    return std::chrono::milliseconds(0);
+}
+} // namespace
 
 IOReactor::IOReactor(int id, int core_id, ReactorContext::Ptr reactor_context)
-        : ReactorBase(core_id), id_(id), reactor_context_(reactor_context) {
+        : ReactorBase(core_id, poller_backend_of(reactor_context ? reactor_context->server_context : nullptr)),
+          id_(id), reactor_context_(reactor_context) {
+        if (reactor_context_->server_context) timeouts_ = reactor_context_->server_context->timeouts;
         ResponseQueue::Ptr response_queue = std::make_shared<ResponseQueue>(1024);
         if (!response_queue) {
             error_cpp20("Failed to create response queue");
         }
         reactor_context_->io_reactor = this;
         reactor_context_->response_queue = response_queue;
+        reactor_context_->frame_pool = FramePool::create();
+        reactor_context_->object_pool = BlockPool::create();
+        if (!reactor_context_->socket_profiles) {
+            auto& server = reactor_context_->server_context;
+            reactor_context_->socket_profiles = server && server->socket_profiles
+                ? server->socket_profiles : std::make_shared<const SocketProfiles>(SocketProfiles::defaults());
+        }
         reactor_context_->reactor_id = id_;
-        reactor_context_->connection_close_callback = [this](int fd) {
-            this->del_fd(fd);
+        reactor_context_->connection_close_callback = [this](int fd, uint32_t generation) {
+            this->release_connection(fd, generation);
         };
+        flush_batch_.reserve(response_queue->capacity());
         int event_fd = response_queue->getEventFd();
         if (!add_fd(event_fd, EPOLLIN)) {
             ::close(event_fd);
             error_cpp20("eventfd add to epoll failed: " + std::string(strerror(errno)));
         }
+        register_metrics();
     }
 
+IOReactor::~IOReactor() {
+    metrics::Registry::global().forget(this);
+    // The loop uses this class's members: stop it before they go, not in ~ReactorBase.
+    stop();
+}
+
+void IOReactor::register_metrics() {
+    auto& registry = metrics::Registry::global();
+    const metrics::Labels labels{{"reactor", std::to_string(id_)}};
+    busy_time_ = &registry.histogram("fileserver_reactor_busy_seconds",
+                                     "Time an IO reactor spends on the events of one wakeup.", labels);
+    using Type = metrics::Registry::Type;
+    auto add = [&](std::string_view name, std::string_view help, Type type, std::function<double()> read) {
+        registry.callback(name, help, type, labels, this, [read = std::move(read)] { return std::optional<double>(read()); });
+    };
+    auto& ctx = *reactor_context_;
+    add("fileserver_reactor_accepted_total", "Connections accepted by the reactor itself.", Type::Counter,
+        [this] { return static_cast<double>(accepted()); });
+    add("fileserver_reactor_rx_bytes_total", "Bytes read from the reactor's connections.", Type::Counter,
+        [&ctx] { return static_cast<double>(ctx.counters.rx_bytes.load(std::memory_order_relaxed)); });
+    add("fileserver_reactor_tx_bytes_total", "Bytes written to the reactor's connections.", Type::Counter,
+        [&ctx] { return static_cast<double>(ctx.counters.tx_bytes.load(std::memory_order_relaxed)); });
+    add("fileserver_reactor_loop_iterations_total", "Event loop wakeups.", Type::Counter,
+        [this] { return static_cast<double>(loop_stats_.iterations.load(std::memory_order_relaxed)); });
+    add("fileserver_reactor_write_stalls_total", "Times a connection waited for EPOLLOUT.", Type::Counter,
+        [this] { return static_cast<double>(write_stalls_.load(std::memory_order_relaxed)); });
+    add("fileserver_reactor_migrated_in_total", "Connections adopted from other reactors.", Type::Counter,
+        [this] { return static_cast<double>(migrated_in()); });
+    add("fileserver_reactor_migrated_out_total", "Connections handed to other reactors.", Type::Counter,
+        [this] { return static_cast<double>(migrated_out()); });
+    add("fileserver_reactor_reaped_idle_total", "Connections closed by the idle timeout.", Type::Counter,
+        [this] { return static_cast<double>(reaped_idle()); });
+    add("fileserver_reactor_reaped_stalled_total", "Connections closed by the stall timeout.", Type::Counter,
+        [this] { return static_cast<double>(reaped_stalled()); });
+    add("fileserver_reactor_connections", "Open connections.", Type::Gauge,
+        [this] { return static_cast<double>(connections_.size()); });
+    add("fileserver_reactor_response_queue_depth", "Responses waiting for the reactor.", Type::Gauge,
+        [&ctx] { return static_cast<double>(ctx.response_queue->depth()); });
+    add("fileserver_reactor_pending_out_bytes", "Unsent outbound bytes of all connections.", Type::Gauge,
+        [this] { return static_cast<double>(pending_out_bytes_.load(std::memory_order_relaxed)); });
+    add("fileserver_reactor_frames_outstanding", "Frames of the reactor's FramePool in use.", Type::Gauge,
+        [&ctx] { return static_cast<double>(ctx.frame_pool->stats().outstanding.load(std::memory_order_relaxed)); });
+    add("fileserver_reactor_objects_outstanding", "Blocks of the reactor's BlockPool in use.", Type::Gauge,
+        [&ctx] { return static_cast<double>(ctx.object_pool->stats().outstanding.load(std::memory_order_relaxed)); });
+}
+
 bool IOReactor::addConnection(int fd) {
-    auto conn = std::make_shared<Connection>(fd, reactor_context_);
+    auto conn = make_pooled<Connection>(reactor_context_->object_pool.get(), fd, reactor_context_);
     if (!conn) {
         error_cpp20("Failed to create connection for fd "+ std::to_string(fd));
         ::close(fd);
         return false;
     } else {
-        log_cpp20("IOReactor " + std::to_string(id_) + ": New connection created for fd " + std::to_string(fd));
+        LOG_DEBUG("IOReactor {}: New connection created for fd {}", id_, fd);
     }
-    connections_[fd] = conn;
+    // From here the Connection owns fd: on failure dropping it closes the socket, once.
+    uint32_t generation = connections_.insert(fd, conn);
+    if (generation == 0) {
+        error_cpp20("fd " + std::to_string(fd) + " exceeds connection slab capacity");
+        return false;
+    }
+    conn->set_generation(generation);
+    static const SocketProfile kAccepted = SocketProfile::kernel_defaults();
+    apply_socket_profile(fd, reactor_context_->socket_profiles->control, &kAccepted);
+
+    // A completion backend receives and sends for the connection; otherwise readiness drives it.
+    if (poller_->add_receiver(fd)) {
+        conn->use_completions(poller_.get());
+    } else if (!add_fd(fd, EPOLLIN | EPOLLET)) {
+        // Out of the slab first, so the closing Connection's release finds a stale generation.
+        connections_.erase(fd);
+        return false;
+    }
+    watch_connection(fd, generation);
+    if (auto* admission = admission_controller()) admission->connection_opened();
+    return true;
+}
 
-    return add_fd(fd, EPOLLIN | EPOLLET);
+concurrency::AdmissionController* IOReactor::admission_controller() const {
+    auto& server = reactor_context_->server_context;
+    return server ? server->admission.get() : nullptr;
+}
+
+void IOReactor::reject_connection(int fd, uint32_t retry_after_ms) {
+    // A new connection is still v1/JSON.
+    std::string body = protocol::response_to_json(protocol::ResponseBuilder().buildBusyResponse(retry_after_ms)).dump();
+    std::string wire(sizeof(MessageHeader) + body.size(), '\0');
+    MessageHeader header;
+    header.length = static_cast<uint16_t>(body.size());
+    header.type = static_cast<uint8_t>(MessageType::ERROR);
+    std::memcpy(wire.data(), &header, sizeof(header));
+    std::memcpy(wire.data() + sizeof(header), body.data(), body.size());
+    // A new socket's send buffer is empty, so this small frame goes out whole or not at all.
+    ::send(fd, wire.data(), wire.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+    ::close(fd);
+}
+
+bool IOReactor::listen_reuseport(uint16_t port, const std::string& ip) {
+    if (!listener_.listen_on(port, ip, true /*reuse_port*/)) {
+        error_cpp20("IOReactor " + std::to_string(id_) + ": SO_REUSEPORT listen failed");
+        return false;
+    }
+    listen_fd_ = listener_.get_fd();
+    // A private listener can be accepted on by the poller itself (multishot accept on io_uring).
+    if (poller_->add_acceptor(listen_fd_)) return true;
+    return add_fd(listen_fd_, EPOLLIN);
+}
+
+bool IOReactor::share_listener(int listen_fd) {
+    listen_fd_ = listen_fd;
+    // Level triggered so a wakeup cut short by the batch limit is reported again.
+    return add_fd(listen_fd_, EPOLLIN | EPOLLEXCLUSIVE);
+}
+
+void IOReactor::accept_batch() {
+    for (int i = 0; i < kAcceptBatch; ++i) {
+        int client_fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_ERROR("IOReactor {}: accept failed: {}", id_, strerror(errno));
+            }
+            return;
+        }
+        adopt_accepted(client_fd);
+    }
+}
+
+void IOReactor::adopt_accepted(int client_fd) {
+    accepted_.fetch_add(1, std::memory_order_relaxed);
+    auto* admission = admission_controller();
+    if (admission && !admission->admit_connection()) {
+        reject_connection(client_fd, admission->retry_after_ms());
+        return;
+    }
+    if (addConnection(client_fd) == false) {
+        error_cpp20("Failed to add connection to IO reactor, fd " + std::to_string(client_fd) + " closed");
+    }
 }
 
 bool IOReactor::add_fd(int fd, uint32_t events) {
-    if (epoll_poller_.add_fd(fd, events) == false) {
+    if (poller_->add_fd(fd, events) == false) {
         error_cpp20("Failed to add fd to epoll: " + std::string(strerror(errno)));
         return false;
     }
@@ -58,7 +222,7 @@ bool IOReactor::add_fd(int fd, uint32_t events) {
 }
 
 bool IOReactor::mod_fd(int fd, uint32_t events) {
-    if (epoll_poller_.modify_fd(fd, events) == false) {
+    if (poller_->modify_fd(fd, events) == false) {
         RUNTIME_ERROR("%s", strerror(errno));
         return false;
     }
@@ -66,18 +230,307 @@ bool IOReactor::mod_fd(int fd, uint32_t events) {
 }
 
 bool IOReactor::del_fd(int fd) {
-    if (epoll_poller_.remove_fd(fd) == false) {
-        RUNTIME_ERROR("%s", strerror(errno));
+    // The slot goes whatever the poller says: a kept slot would hold the Connection and count
+    // it as live until the fd number is reused.
+    bool removed = poller_->remove_fd(fd);
+    if (!removed) RUNTIME_ERROR("%s", strerror(errno));
+    connections_.erase(fd);
+    return removed;
+}
+
+bool IOReactor::release_connection(int fd, uint32_t generation) {
+    // A stale generation means this fd was already released (and possibly reused by a new connection);
+    // 0 was never handed out, the connection did not make it into the slab.
+    if (generation == 0 || connections_.generation(fd) != generation) {
         return false;
     }
-    connections_.erase(fd);
+    if (auto* admission = admission_controller()) admission->connection_closed();
+    if (auto conn = connections_.get(fd)) unwatch_connection(conn->timer());
+    return del_fd(fd);
+}
+
+ReactorLoad IOReactor::load() const {
+    ReactorLoad l;
+    l.reactor_id = id_;
+    l.connections = connections_.size();
+    l.rx_bytes_per_sec = rx_rate_.load(std::memory_order_relaxed);
+    l.tx_bytes_per_sec = tx_rate_.load(std::memory_order_relaxed);
+    l.queue_depth = reactor_context_->response_queue->depth();
+    l.idle_connections = idle_connections_.load(std::memory_order_relaxed);
+    l.pending_out_bytes = pending_out_bytes_.load(std::memory_order_relaxed);
+    l.max_conn_pending_bytes = max_conn_pending_bytes_.load(std::memory_order_relaxed);
+    l.write_stalls = write_stalls_.load(std::memory_order_relaxed);
+    l.timers = armed_timers_.load(std::memory_order_relaxed);
+    return l;
+}
+
+void IOReactor::sample_load() {
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed = now - last_sample_;
+    if (elapsed < std::chrono::seconds(1)) return;
+
+    uint64_t rx = reactor_context_->counters.rx_bytes.load(std::memory_order_relaxed);
+    uint64_t tx = reactor_context_->counters.tx_bytes.load(std::memory_order_relaxed);
+    if (last_sample_ != std::chrono::steady_clock::time_point{}) {
+        double sec = std::chrono::duration<double>(elapsed).count();
+        rx_rate_.store(static_cast<uint64_t>((rx - last_rx_bytes_) / sec), std::memory_order_relaxed);
+        tx_rate_.store(static_cast<uint64_t>((tx - last_tx_bytes_) / sec), std::memory_order_relaxed);
+    }
+    last_rx_bytes_ = rx;
+    last_tx_bytes_ = tx;
+    last_sample_ = now;
+
+    std::size_t idle = 0;
+    uint64_t pending = 0, max_pending = 0;
+    connections_.for_each([&](int, const FdSlab<Connection>::Ptr& conn) {
+        if (conn->is_idle()) ++idle;
+        uint64_t p = conn->pending_bytes();
+        pending += p;
+        max_pending = std::max(max_pending, p);
+        return true;
+    });
+    idle_connections_.store(idle, std::memory_order_relaxed);
+    pending_out_bytes_.store(pending, std::memory_order_relaxed);
+    max_conn_pending_bytes_.store(max_pending, std::memory_order_relaxed);
+    armed_timers_.store(timers_.size(), std::memory_order_relaxed);
+}
+
+void IOReactor::deliver_responses() {
+    reactor_context_->response_queue->drain([this](int fd, uint32_t generation, FrameRef& frame, OutboundSource& source) {
+        auto conn = connections_.get(fd);
+        if (!conn || connections_.generation(fd) != generation) {
+            DEBUG_PRINT("IOReactor %d: dropping response for closed fd %d", id_, fd);
+            return;
+        }
+        if (!frame && !source) {
+            conn->on_readable();    // resume input held back while a request was in flight
+            return;
+        }
+        conn->touch(loop_time_);
+        if (source) {
+            conn->attach_source(std::move(source));
+        } else if (conn->stage_output(std::move(frame))) {
+            flush_batch_.push_back(conn);
+        }
+        conn->context()->responses_queued.fetch_sub(1, std::memory_order_acq_rel);
+    });
+    // One vectored send per connection for everything drained above.
+    for (auto& conn : flush_batch_) {
+        conn->flush_staged();
+    }
+    flush_batch_.clear();
+}
+
+void IOReactor::request_migration(IOReactor* target, int count) {
+    if (!target || target == this || count <= 0) return;
+    migrate_target_.store(target, std::memory_order_relaxed);
+    migrate_budget_.store(count, std::memory_order_release);
+}
+
+void IOReactor::deliver_completions() {
+    for (const Poller::Received& in : poller_->received()) {
+        auto conn = connections_.get(in.fd);
+        if (!conn) {
+            if (in.res > 0) poller_->release_buffer(in.buffer);
+            continue;
+        }
+        conn->touch(loop_time_);
+        if (conn->stage_input(in)) input_batch_.push_back(std::move(conn));
+    }
+    // Once per connection, with everything this poll received staged.
+    for (auto& conn : input_batch_) {
+        if (conn->is_open()) conn->on_readable();
+    }
+    input_batch_.clear();
+    for (const Poller::Sent& out : poller_->sent()) {
+        auto conn = connections_.get(out.fd);
+        if (!conn) continue;
+        conn->touch(loop_time_);
+        conn->on_sent(out.res);
+    }
+}
+
+void IOReactor::run_pending_migration() {
+    if (migrate_budget_.load(std::memory_order_acquire) <= 0) return;
+    int budget = migrate_budget_.exchange(0, std::memory_order_acq_rel);
+    IOReactor* target = migrate_target_.load(std::memory_order_relaxed);
+    if (budget <= 0 || !target) return;
+
+    std::vector<std::shared_ptr<Connection>> moving;
+    moving.reserve(budget);
+    connections_.for_each([&](int, const FdSlab<Connection>::Ptr& conn) {
+        // A completion connection stays: input could land in its buffers while the receive is
+        // being cancelled, with nobody left to decode it.
+        if (conn->is_idle() && !conn->uses_completions()) moving.push_back(conn);
+        return static_cast<int>(moving.size()) < budget;
+    });
+
+    for (auto& conn : moving) {
+        int fd = conn->getSocketFD();
+        // Stop watching before the hand over; readiness is re-evaluated when the target registers the fd.
+        if (!poller_->remove_fd(fd)) continue;
+        connections_.erase(fd);
+        timers_.cancel(conn->timer());
+        conn->set_timer(0);
+        if (target->adopt_connection(conn)) {
+            migrated_out_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        // target refused: keep serving it here
+        uint32_t generation = connections_.insert(fd, conn);
+        conn->rebind(reactor_context_, generation);
+        if (!add_fd(fd, EPOLLIN | EPOLLET)) {
+            conn->close();
+            continue;
+        }
+        watch_connection(fd, generation);
+    }
+    if (!moving.empty()) {
+        log_cpp20("IOReactor " + std::to_string(id_) + ": migrated " + std::to_string(migrated_out_.load())
+                  + " connections to IOReactor " + std::to_string(target->id()) + " in total");
+    }
+}
+
+bool IOReactor::adopt_connection(std::shared_ptr<Connection> conn) {
+    int fd = conn->getSocketFD();
+    uint32_t generation = connections_.insert(fd, conn);
+    if (generation == 0) {
+        return false;
+    }
+    // Only idle (Control) connections migrate; move them onto this reactor's control options.
+    auto previous = conn->context()->reactor_context->socket_profiles;
+    if (previous && previous != reactor_context_->socket_profiles) {
+        apply_socket_profile(fd, reactor_context_->socket_profiles->control, &previous->control);
+    }
+    conn->rebind(reactor_context_, generation);
+    if (!add_fd(fd, EPOLLIN | EPOLLET)) {
+        connections_.erase(fd);
+        return false;
+    }
+    migrated_in_.fetch_add(1, std::memory_order_relaxed);
+    watch_connection(fd, generation);
     return true;
 }
 
+void IOReactor::watch_connection(int fd, uint32_t generation) {
+    if (first_check(timeouts_).count() == 0) return;
+    if (in_loop_thread()) {
+        auto conn = connections_.get(fd);
+        if (conn && connections_.generation(fd) == generation) {
+            arm_connection_timer(conn, fd, generation, first_check(timeouts_));
+        }
+        return;
+    }
+    std::lock_guard<std::mutex> lock(timer_requests_mutex_);
+    pending_watches_.emplace_back(fd, generation);
+    timer_requests_.store(true, std::memory_order_release);
+}
+
+void IOReactor::unwatch_connection(TimerWheel::TimerId timer) {
+    if (timer == 0) return;
+    if (in_loop_thread()) {
+        timers_.cancel(timer);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(timer_requests_mutex_);
+    pending_unwatches_.push_back(timer);
+    timer_requests_.store(true, std::memory_order_release);
+}
+
+void IOReactor::apply_timer_requests() {
+    if (!timer_requests_.load(std::memory_order_acquire)) return;
+    {
+        std::lock_guard<std::mutex> lock(timer_requests_mutex_);
+        applying_watches_.swap(pending_watches_);
+        applying_unwatches_.swap(pending_unwatches_);
+        timer_requests_.store(false, std::memory_order_relaxed);
+    }
+    for (auto timer : applying_unwatches_) {
+        timers_.cancel(timer);
+    }
+    for (auto [fd, generation] : applying_watches_) {
+        auto conn = connections_.get(fd);
+        if (conn && connections_.generation(fd) == generation && !timers_.armed(conn->timer())) {
+            arm_connection_timer(conn, fd, generation, first_check(timeouts_));
+        }
+    }
+    applying_watches_.clear();
+    applying_unwatches_.clear();
+}
+
+void IOReactor::arm_connection_timer(const std::shared_ptr<Connection>& conn, int fd, uint32_t generation,
+                                     std::chrono::milliseconds delay) {
+    conn->set_timer(timers_.arm(delay, [this, fd, generation] { check_connection(fd, generation); }));
+}
+
+void IOReactor::check_connection(int fd, uint32_t generation) {
+    using std::chrono::milliseconds;
+    auto conn = connections_.get(fd);
+    if (!conn || connections_.generation(fd) != generation) return;
+    conn->set_timer(0);
+
+    auto quiet = std::chrono::duration_cast<milliseconds>(loop_time_ - conn->last_active());
+    milliseconds limit{0};
+    if (conn->is_idle()) {
+        const auto& session = conn->context()->session_context;
+        if (session && timeouts_.session.count() > 0
+            && ::time(nullptr) - session->last_active_time.load(std::memory_order_relaxed) >= timeouts_.session.count()) {
+            LOG_DEBUG("IOReactor {}: session expired, closing fd {}", id_, fd);
+            expired_sessions_.fetch_add(1, std::memory_order_relaxed);
+            conn->close();
+            return;
+        }
+        limit = timeouts_.idle;
+        if (limit.count() > 0 && quiet >= limit) {
+            LOG_DEBUG("IOReactor {}: closing idle fd {}", id_, fd);
+            reaped_idle_.fetch_add(1, std::memory_order_relaxed);
+            conn->close();
+            return;
+        }
+    } else if (conn->transfer_pending()) {
+        limit = timeouts_.stall;
+        if (limit.count() > 0 && quiet >= limit) {
+            LOG_DEBUG("IOReactor {}: closing stalled transfer on fd {}", id_, fd);
+            reaped_stalled_.fetch_add(1, std::memory_order_relaxed);
+            conn->close();
+            return;
+        }
+    }
+    // Not due yet (or a worker still holds the request): look again when the limit would run out.
+    milliseconds next = limit.count() > 0 ? limit - quiet : first_check(timeouts_);
+    arm_connection_timer(conn, fd, generation, next);
+}
+
+void IOReactor::housekeeping() {
+    std::size_t tokens = LargeUploadRegistry::instance().cleanup();
+    std::size_t sessions = timeouts_.session.count() > 0 ? SessionStore::instance().expire_idle(timeouts_.session) : 0;
+    if (tokens || sessions) {
+        log_cpp20("IOReactor " + std::to_string(id_) + ": expired " + std::to_string(tokens) + " upload tokens, "
+                  + std::to_string(sessions) + " sessions");
+    }
+    timers_.arm(timeouts_.housekeeping, [this] { housekeeping(); });
+}
+
+void IOReactor::record_loop_iteration(uint64_t allocations) {
+    loop_stats_.iterations.fetch_add(1, std::memory_order_relaxed);
+    if (allocations != 0) {
+        loop_stats_.allocating_iterations.fetch_add(1, std::memory_order_relaxed);
+        loop_stats_.allocations.fetch_add(allocations, std::memory_order_relaxed);
+    }
+}
 
 void IOReactor::loop() {
+    const int response_event_fd = reactor_context_->response_queue->getEventFd();
+    // Global sweeps (upload tokens, orphaned sessions) run on the first reactor only.
+    if (id_ == 0 && timeouts_.housekeeping.count() > 0) {
+        timers_.arm(timeouts_.housekeeping, [this] { housekeeping(); });
+    }
     while (running_.load(std::memory_order_acquire)) {
-        auto events_opt = epoll_poller_.poll(1000);
+        // Allocations made inside connection callbacks belong to the handlers, not to the loop itself.
+        uint64_t allocs_begin = utils::thread_allocations();
+        uint64_t allocs_in_callbacks = 0;
+
+        auto events_opt = poller_->poll(timers_.next_timeout_ms(TimerWheel::Clock::now(), kMaxPollTimeoutMs));
         if (!events_opt) {
             if (errno == EINTR) {
                 RUNTIME_ERROR("epoll_wait interrupted by signal: %s", strerror(errno));
@@ -85,32 +538,67 @@ void IOReactor::loop() {
             }
             else break;
         }
-        auto events = *events_opt;
-        if (events.empty()) {
-            // log_cpp20("IOReactor " + std::to_string(id_) + ": epoll_wait timeout with no events");
-            continue;
+        std::span<const epoll_event> events = *events_opt;
+        loop_time_ = TimerWheel::Clock::now();
+        // Before the readiness events: the completions belong to the registrations as polled.
+        const bool completions = !poller_->received().empty() || !poller_->sent().empty();
+        if (completions) {
+            uint64_t allocs_before = utils::thread_allocations();
+            deliver_completions();
+            allocs_in_callbacks += utils::thread_allocations() - allocs_before;
         }
 
-        for (int i = 0; i < events.size(); ++i) {
-            if (events[i].data.fd == reactor_context_->response_queue->getEventFd()) {
-                reactor_context_->response_queue->on_readable();
+        for (const epoll_event& event : events) {
+            int fd = event.data.fd;
+            if (fd == response_event_fd) {
+                uint64_t allocs_before = utils::thread_allocations();
+                deliver_responses();
+                allocs_in_callbacks += utils::thread_allocations() - allocs_before;
+                continue;
+            }
+            if (fd == listen_fd_) {
+                uint64_t allocs_before = utils::thread_allocations();
+                accept_batch();
+                allocs_in_callbacks += utils::thread_allocations() - allocs_before;
                 continue;
             }
-            int fd = events[i].data.fd;
-            log_cpp20("IOReactor " + std::to_string(id_) + ": event on fd " + std::to_string(fd));
-            auto it = connections_.find(fd);
-            if (it == connections_.end()) continue;
-            uint32_t ev = events[i].events;
-            auto conn = it->second;
+            DEBUG_PRINT("IOReactor %d: event on fd %d", id_, fd);
+            auto conn = connections_.get(fd);
+            if (!conn) continue;
+            uint32_t generation = connections_.generation(fd);
+            uint32_t ev = event.events;
+            conn->touch(loop_time_);
+
+            uint64_t allocs_before = utils::thread_allocations();
             if (ev & (EPOLLERR|EPOLLHUP)) {
                 conn->on_error(0);
-                continue;
+            } else {
+                if (ev & EPOLLIN) conn->on_readable();
+                // on_readable may have closed the connection
+                if ((ev & EPOLLOUT) && connections_.generation(fd) == generation) conn->on_writable();
             }
-            if (ev & EPOLLIN) conn->on_readable();
-            if (ev & EPOLLOUT) conn->on_writable();
-            // TODO submit to thread pool
-            // pool_->submit([handler, fd, ev]{
+            allocs_in_callbacks += utils::thread_allocations() - allocs_before;
+        }
+        if (auto accepted = poller_->accepted(); !accepted.empty()) {
+            uint64_t allocs_before = utils::thread_allocations();
+            for (int client_fd : accepted) adopt_accepted(client_fd);
+            allocs_in_callbacks += utils::thread_allocations() - allocs_before;
         }
+        {
+            // Expired timers close connections and log, like any other callback.
+            uint64_t allocs_before = utils::thread_allocations();
+            apply_timer_requests();
+            timers_.advance(loop_time_);
+            allocs_in_callbacks += utils::thread_allocations() - allocs_before;
+        }
+        record_loop_iteration(utils::thread_allocations() - allocs_begin - allocs_in_callbacks);
+        if (!events.empty() || completions) {
+            busy_time_->record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(TimerWheel::Clock::now() - loop_time_).count()));
+        }
+
+        sample_load();
+        run_pending_migration();
     }
 }
 
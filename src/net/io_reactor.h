@@ -1,26 +1,49 @@
 #pragma once
 
 #include "reactor.h"
-#include <unordered_map>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 
 #include "types/context.h"
 #include "common/debug.h"
-#include "epoll_poller.h"
+#include "poller.h"
+#include "fd_slab.h"
+#include "listener.h"
+#include "reactor_load.h"
+#include "timer_wheel.h"
 
 // Forward declare
 namespace net {
     class Connection;
 }
 
+namespace metrics {
+    class Histogram;
+}
+
 namespace net {
 
 class IOReactor : public ReactorBase, public std::enable_shared_from_this<IOReactor> {
 public:
     using Ptr = std::shared_ptr<IOReactor>;
     explicit IOReactor(int id, int core_id = -1, ::ReactorContext::Ptr reactor_context = nullptr);
+    ~IOReactor() override;
 
+    // Takes ownership of fd: when it fails the socket is already closed.
     bool addConnection(int fd);
+    // Admission control refused a freshly accepted socket: best effort SERVER_BUSY frame with a
+    // retry hint, then close it.
+    static void reject_connection(int fd, uint32_t retry_after_ms);
+
+    // Multi-acceptor modes: accept directly on this reactor, either on a private
+    // SO_REUSEPORT listener or on a listener shared by all reactors with EPOLLEXCLUSIVE.
+    bool listen_reuseport(uint16_t port, const std::string& ip);
+    bool share_listener(int listen_fd);
+    uint64_t accepted() const { return accepted_.load(std::memory_order_relaxed); }
 
     bool add_fd(int fd, uint32_t events);
 
@@ -28,16 +51,113 @@ public:
 
     bool del_fd(int fd);
 
+    // Unregister a connection only if fd still maps to the given slab generation.
+    bool release_connection(int fd, uint32_t generation);
+
     int id() const { return id_; }
 
+    // Latest load sample (refreshed about once per second by the reactor thread).
+    ReactorLoad load() const;
+
+    // Ask this reactor to hand up to `count` idle connections over to `target`.
+    // Executed asynchronously on this reactor's thread at the next loop iteration.
+    void request_migration(IOReactor* target, int count);
+    // Take ownership of a connection released by another reactor. Callable from any thread.
+    bool adopt_connection(std::shared_ptr<Connection> conn);
+    // A connection armed EPOLLOUT because the socket could not take all its output.
+    void note_write_stall() { write_stalls_.fetch_add(1, std::memory_order_relaxed); }
+    // Run cb on this reactor's thread once delay has passed. Reactor thread only.
+    void call_later(std::chrono::milliseconds delay, TimerWheel::Callback cb) { timers_.arm(delay, std::move(cb)); }
+
+    uint64_t migrated_in() const { return migrated_in_.load(std::memory_order_relaxed); }
+    uint64_t migrated_out() const { return migrated_out_.load(std::memory_order_relaxed); }
+
+    // Connections closed by the timeout policy (ServerContext::timeouts).
+    uint64_t reaped_idle() const { return reaped_idle_.load(std::memory_order_relaxed); }
+    uint64_t reaped_stalled() const { return reaped_stalled_.load(std::memory_order_relaxed); }
+    uint64_t expired_sessions() const { return expired_sessions_.load(std::memory_order_relaxed); }
+
+    struct LoopStats {
+        std::atomic<uint64_t> iterations{0};
+        std::atomic<uint64_t> allocating_iterations{0};
+        std::atomic<uint64_t> allocations{0};   // heap allocations made by the loop itself (ENABLE_ALLOC_COUNTER)
+    };
+    const LoopStats& loop_stats() const { return loop_stats_; }
+
 protected:
     void loop() override;
 
 private:
+    void record_loop_iteration(uint64_t allocations);
+    void register_metrics();
+    void accept_batch();
+    // Admission check and registration of a socket accepted on this reactor's listener.
+    void adopt_accepted(int client_fd);
+    void sample_load();
+    void deliver_responses();
+    // Completion backend: stage what the poller received and finish its sends.
+    void deliver_completions();
+    void run_pending_migration();
+
+    // Connection timeouts. watch/unwatch may be called from any thread; off the loop thread
+    // the request is queued and applied at the next iteration.
+    void watch_connection(int fd, uint32_t generation);
+    void unwatch_connection(TimerWheel::TimerId timer);
+    void apply_timer_requests();
+    void arm_connection_timer(const std::shared_ptr<Connection>& conn, int fd, uint32_t generation,
+                              std::chrono::milliseconds delay);
+    void check_connection(int fd, uint32_t generation);
+    void housekeeping();
+    concurrency::AdmissionController* admission_controller() const;
+
+    static constexpr int kAcceptBatch = 64;
+
     int id_;
-    EpollPoller epoll_poller_{};
     
-    std::unordered_map<int, std::shared_ptr<Connection>> connections_;
+    FdSlab<Connection> connections_;
+    LoopStats loop_stats_{};
+    metrics::Histogram* busy_time_{nullptr};    // handling the events of one wakeup
+
+    Listener listener_;         // own SO_REUSEPORT listener
+    int listen_fd_{-1};         // fd accepted on by this reactor (own or shared), -1 if none
+    std::atomic<uint64_t> accepted_{0};
+
+    // load sampling
+    std::chrono::steady_clock::time_point last_sample_{};
+    uint64_t last_rx_bytes_{0};
+    uint64_t last_tx_bytes_{0};
+    std::atomic<uint64_t> rx_rate_{0};
+    std::atomic<uint64_t> tx_rate_{0};
+    std::atomic<std::size_t> idle_connections_{0};
+    std::atomic<uint64_t> pending_out_bytes_{0};
+    std::atomic<uint64_t> max_conn_pending_bytes_{0};
+    std::atomic<uint64_t> write_stalls_{0};
+
+    // timers; loop_time_ is sampled once per iteration after poll() returns
+    TimerWheel timers_;
+    TimerWheel::Clock::time_point loop_time_{TimerWheel::Clock::now()};
+    ConnectionTimeouts timeouts_{};
+    std::mutex timer_requests_mutex_;
+    std::vector<std::pair<int, uint32_t>> pending_watches_;     // (fd, generation)
+    std::vector<TimerWheel::TimerId> pending_unwatches_;
+    std::vector<std::pair<int, uint32_t>> applying_watches_;
+    std::vector<TimerWheel::TimerId> applying_unwatches_;
+    std::atomic<bool> timer_requests_{false};
+    std::atomic<std::size_t> armed_timers_{0};
+    std::atomic<uint64_t> reaped_idle_{0};
+    std::atomic<uint64_t> reaped_stalled_{0};
+    std::atomic<uint64_t> expired_sessions_{0};
+
+    // connections with staged responses, flushed once each after a ResponseQueue drain
+    std::vector<std::shared_ptr<Connection>> flush_batch_;
+    // connections with staged input, read once each after the receive completions
+    std::vector<std::shared_ptr<Connection>> input_batch_;
+
+    // pending migration order from MainReactor
+    std::atomic<IOReactor*> migrate_target_{nullptr};
+    std::atomic<int> migrate_budget_{0};
+    std::atomic<uint64_t> migrated_in_{0};
+    std::atomic<uint64_t> migrated_out_{0};
 
     ReactorContext::Ptr reactor_context_{nullptr};
 };
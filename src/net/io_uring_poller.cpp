@@ -0,0 +1,765 @@
+#include "io_uring_poller.h"
+
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <signal.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <iterator>
+#include <string>
+#include <utility>
+
+#include "common/debug.h"
+
+namespace net {
+
+namespace {
+
+constexpr uint64_t kTimeoutTag = ~0ull;
+constexpr uint64_t kWakeTag    = ~0ull - 1;
+constexpr uint64_t kCtlTag     = ~0ull - 2;
+constexpr uint64_t kAcceptTag  = ~0ull - 3;
+constexpr uint64_t kProbeTag   = ~0ull - 4;
+
+constexpr uint16_t kBufferGroup = 0;
+
+// Back-off before re-arming a listener whose accept failed (EMFILE and friends), so a full fd
+// table does not turn the loop into a busy spin.
+constexpr auto kAcceptRetry = std::chrono::milliseconds(50);
+
+// Flags that only make sense for epoll_ctl; io_uring poll masks carry plain POLL* bits.
+constexpr uint32_t kEpollOnlyFlags = EPOLLET | EPOLLONESHOT | EPOLLEXCLUSIVE | EPOLLWAKEUP;
+
+inline unsigned load_acquire(unsigned* p) {
+    return std::atomic_ref<unsigned>(*p).load(std::memory_order_acquire);
+}
+
+inline void store_release(unsigned* p, unsigned v) {
+    std::atomic_ref<unsigned>(*p).store(v, std::memory_order_release);
+}
+
+inline int fd_of(uint64_t user_data) { return static_cast<int>(user_data & 0xffffffffu); }
+inline uint32_t generation_of(uint64_t user_data) { return static_cast<uint32_t>(user_data >> 32) & ((1u << 30) - 1); }
+inline uint64_t kind_of(uint64_t user_data) { return user_data >> 62; }
+
+} // namespace
+
+IoUringPoller::IoUringPoller(unsigned entries) {
+    ready_.reserve(entries * 2);
+    if (!setup(entries)) {
+        teardown();
+        return;
+    }
+    wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd_ < 0) {
+        RUNTIME_ERROR("io_uring wake eventfd failed: %s", strerror(errno));
+        teardown();
+        return;
+    }
+    receive_ = setup_receive();
+    if (!receive_) log_cpp20("io_uring: no multishot recv with provided buffers, connections are read on readiness");
+}
+
+IoUringPoller::~IoUringPoller() {
+    teardown();
+}
+
+bool IoUringPoller::setup(unsigned entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0) {
+        RUNTIME_ERROR("io_uring_setup failed: %s", strerror(errno));
+        return false;
+    }
+    ring_fd_ = fd;
+    ext_arg_ = params.features & IORING_FEAT_EXT_ARG;
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+
+    sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+        sq_ring_ = nullptr;
+        RUNTIME_ERROR("io_uring SQ ring mmap failed: %s", strerror(errno));
+        return false;
+    }
+    if (single_mmap) {
+        cq_ring_ = sq_ring_;
+    } else {
+        cq_ring_ = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          ring_fd_, IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) {
+            cq_ring_ = nullptr;
+            RUNTIME_ERROR("io_uring CQ ring mmap failed: %s", strerror(errno));
+            return false;
+        }
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        RUNTIME_ERROR("io_uring SQE array mmap failed: %s", strerror(errno));
+        return false;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    auto* sq = static_cast<char*>(sq_ring_);
+    sq_head_  = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_  = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_  = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sq_entries_ = params.sq_entries;
+
+    auto* cq = static_cast<char*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_    = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+}
+
+bool IoUringPoller::setup_receive() {
+    void* buffers = ::mmap(nullptr, kRecvBuffers * kRecvBufferSize, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffers == MAP_FAILED) return false;
+    buffers_ = static_cast<uint8_t*>(buffers);
+    buffer_owner_.assign(kRecvBuffers, 0);
+    received_.reserve(kRecvBuffers);
+    // Handing a buffer back is a store into the ring, no SQE. The ring is 5.19+, older kernels
+    // have no multishot recv either.
+    if (!register_buf_ring()) return false;
+    buffers_out_ = kRecvBuffers;
+    for (unsigned i = 0; i < kRecvBuffers; ++i) recycle_buffer(static_cast<uint16_t>(i));
+    publish_buffers();
+    return probe_receive();
+}
+
+bool IoUringPoller::register_buf_ring() {
+    buf_ring_size_ = kRecvBuffers * sizeof(io_uring_buf);
+    void* ring = ::mmap(nullptr, buf_ring_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring == MAP_FAILED) return false;
+    // Written before the kernel pins it: an untouched private page would be pinned as the
+    // shared zero page, and our first write would move the ring to a copy the kernel never sees.
+    std::memset(ring, 0, buf_ring_size_);
+    io_uring_buf_reg reg;
+    std::memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(ring);
+    reg.ring_entries = kRecvBuffers;
+    reg.bgid = kBufferGroup;
+    // IORING_REGISTER_PBUF_RING is 5.19+; older kernels refuse it with EINVAL.
+    if (::syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        ::munmap(ring, buf_ring_size_);
+        return false;
+    }
+    buf_ring_ = static_cast<io_uring_buf_ring*>(ring);
+    buf_tail_ = 0;
+    return true;
+}
+
+bool IoUringPoller::probe_receive() {
+    // Multishot recv (6.0+) has no feature bit: try one on a socketpair before anything else
+    // is armed, so the only completions are its own.
+    int sv[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, sv) < 0) return false;
+    auto take = [this](io_uring_cqe& out) {
+        while (load_acquire(cq_tail_) == *cq_head_) {
+            if (enter(to_submit_, 1) < 0 && errno != EINTR) return false;
+        }
+        out = cqes_[*cq_head_ & *cq_mask_];
+        store_release(cq_head_, *cq_head_ + 1);
+        if (out.flags & IORING_CQE_F_BUFFER) {
+            ++buffers_out_;
+            recycle_buffer(static_cast<uint16_t>(out.flags >> IORING_CQE_BUFFER_SHIFT));
+            publish_buffers();
+        }
+        return true;
+    };
+    bool ok = false;
+    const char byte = 0;
+    io_uring_sqe* sqe = ::write(sv[1], &byte, 1) == 1 ? next_sqe() : nullptr;
+    if (sqe) {
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = sv[0];
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = kBufferGroup;
+        sqe->user_data = kProbeTag;
+        io_uring_cqe cqe{};
+        if (take(cqe)) {
+            const bool more = cqe.flags & IORING_CQE_F_MORE;
+            ok = cqe.res == 1 && (cqe.flags & IORING_CQE_F_BUFFER) && more;
+            // End of stream finishes a receive that is still armed.
+            ::close(sv[1]);
+            sv[1] = -1;
+            if (more) take(cqe);
+        }
+    }
+    if (sv[1] >= 0) ::close(sv[1]);
+    ::close(sv[0]);
+    return ok;
+}
+
+void IoUringPoller::teardown() {
+    if (sqes_) {
+        ::munmap(sqes_, sqes_size_);
+        sqes_ = nullptr;
+    }
+    if (cq_ring_ && cq_ring_ != sq_ring_) {
+        ::munmap(cq_ring_, cq_ring_size_);
+    }
+    cq_ring_ = nullptr;
+    if (sq_ring_) {
+        ::munmap(sq_ring_, sq_ring_size_);
+        sq_ring_ = nullptr;
+    }
+    if (ring_fd_ >= 0) {
+        ::close(ring_fd_);
+        ring_fd_ = -1;
+    }
+    if (buffers_) {
+        ::munmap(buffers_, kRecvBuffers * kRecvBufferSize);
+        buffers_ = nullptr;
+    }
+    if (buf_ring_) {
+        ::munmap(buf_ring_, buf_ring_size_);
+        buf_ring_ = nullptr;
+    }
+    receive_ = false;
+    if (wake_fd_ >= 0) {
+        ::close(wake_fd_);
+        wake_fd_ = -1;
+    }
+}
+
+bool IoUringPoller::add_fd(int fd, uint32_t events) {
+    return queue_ctl(CtlOp::Add, fd, events);
+}
+
+bool IoUringPoller::modify_fd(int fd, uint32_t events) {
+    return queue_ctl(CtlOp::Modify, fd, events);
+}
+
+bool IoUringPoller::remove_fd(int fd) {
+    return queue_ctl(CtlOp::Remove, fd, 0);
+}
+
+bool IoUringPoller::add_acceptor(int listen_fd) {
+    return queue_ctl(CtlOp::Accept, listen_fd, EPOLLIN);
+}
+
+bool IoUringPoller::add_receiver(int fd) {
+    if (!receive_) return false;
+    return queue_ctl(CtlOp::Receive, fd, EPOLLIN);
+}
+
+void IoUringPoller::release_buffer(uint16_t buffer) {
+    if (buffer >= kRecvBuffers) return;
+    if (poll_thread_.load(std::memory_order_acquire) == std::this_thread::get_id()) {
+        recycle_buffer(buffer);
+        return;
+    }
+    // A connection closed on a worker: back into the ring at the next poll(), no wakeup needed.
+    std::lock_guard<std::mutex> lock(ctl_mutex_);
+    pending_release_.push_back(buffer);
+}
+
+bool IoUringPoller::queue_ctl(CtlOp op, int fd, uint32_t events) {
+    if (!valid() || fd < 0) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(ctl_mutex_);
+        pending_ctl_.push_back(CtlRequest{op, fd, events & ~kEpollOnlyFlags});
+    }
+    // Kick the polling thread so the new registration is submitted without waiting for the timeout.
+    if (poll_thread_.load(std::memory_order_acquire) != std::this_thread::get_id()) {
+        uint64_t one = 1;
+        if (::write(wake_fd_, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+            error_cpp20("io_uring wake write failed: " + std::string(strerror(errno)));
+        }
+    }
+    return true;
+}
+
+void IoUringPoller::apply_pending_ctl() {
+    {
+        std::lock_guard<std::mutex> lock(ctl_mutex_);
+        applying_ctl_.swap(pending_ctl_);
+        applying_release_.swap(pending_release_);
+    }
+    for (uint16_t buffer : applying_release_) recycle_buffer(buffer);
+    applying_release_.clear();
+    for (const auto& req : applying_ctl_) {
+        if (req.op == CtlOp::Accept) {
+            accept_fd_ = req.fd;
+            prep_accept();
+            continue;
+        }
+        if (static_cast<size_t>(req.fd) >= registrations_.size()) {
+            if (req.op == CtlOp::Remove) continue;
+            registrations_.resize(static_cast<size_t>(req.fd) + 1);
+        }
+        Registration& reg = registrations_[req.fd];
+        if (reg.active) {
+            // A receiver has no poll mask to change; its input keeps coming as completions.
+            if (reg.receiver && req.op == CtlOp::Modify) continue;
+            // Cancel the armed request; the generation bump turns its final CQE into a stale one.
+            if (!reg.receiver) {
+                prep_poll_remove(req.fd, reg);
+            } else if (reg.recv_armed) {
+                prep_cancel(encode(req.fd, reg.generation, Kind::Recv));
+            }
+            reg.generation = (reg.generation + 1) & kGenerationMask;
+            reg.active = false;
+        }
+        if (req.op == CtlOp::Remove) continue;
+        reg = Registration{req.events, reg.generation, true, req.op == CtlOp::Receive};
+        if (reg.receiver) {
+            prep_recv(req.fd, reg);
+        } else {
+            prep_poll_add(req.fd, reg);
+        }
+    }
+    applying_ctl_.clear();
+}
+
+io_uring_sqe* IoUringPoller::next_sqe() {
+    unsigned tail = *sq_tail_;
+    if (tail - load_acquire(sq_head_) >= sq_entries_) {
+        // SQ full: push what we have to the kernel before queueing more.
+        enter(to_submit_, 0);
+        if (tail - load_acquire(sq_head_) >= sq_entries_) {
+            return nullptr;
+        }
+    }
+    unsigned index = tail & *sq_mask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    store_release(sq_tail_, tail + 1);
+    ++to_submit_;
+    return sqe;
+}
+
+void IoUringPoller::prep_poll_add(int fd, const Registration& reg) {
+    io_uring_sqe* sqe = next_sqe();
+    if (!sqe) {
+        error_cpp20("io_uring SQ exhausted, cannot arm fd " + std::to_string(fd));
+        return;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = reg.events;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = encode(fd, reg.generation);
+}
+
+void IoUringPoller::prep_poll_remove(int fd, const Registration& reg) {
+    io_uring_sqe* sqe = next_sqe();
+    if (!sqe) {
+        error_cpp20("io_uring SQ exhausted, cannot disarm fd " + std::to_string(fd));
+        return;
+    }
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = encode(fd, reg.generation);
+    sqe->user_data = kCtlTag;
+}
+
+void IoUringPoller::prep_recv(int fd, Registration& reg) {
+    io_uring_sqe* sqe = next_sqe();
+    if (!sqe) {
+        error_cpp20("io_uring SQ exhausted, cannot receive on fd " + std::to_string(fd));
+        idle_receivers_.push_back(fd);
+        return;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufferGroup;
+    sqe->user_data = encode(fd, reg.generation, Kind::Recv);
+    reg.recv_armed = true;
+    reg.recv_cancelling = false;
+}
+
+void IoUringPoller::prep_cancel(uint64_t user_data) {
+    io_uring_sqe* sqe = next_sqe();
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = user_data;
+    sqe->user_data = kCtlTag;
+}
+
+void IoUringPoller::prep_timeout(int timeout_ms) {
+    io_uring_sqe* sqe = next_sqe();
+    if (!sqe) return;
+    timeout_ts_.tv_sec = timeout_ms / 1000;
+    timeout_ts_.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000ll;
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->fd = -1;
+    sqe->addr = reinterpret_cast<uint64_t>(&timeout_ts_);
+    sqe->len = 1;
+    sqe->off = 0;
+    sqe->user_data = kTimeoutTag;
+    timeout_armed_ = true;
+    timeout_deadline_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+}
+
+void IoUringPoller::prep_timeout_remove() {
+    io_uring_sqe* sqe = next_sqe();
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_TIMEOUT_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = kTimeoutTag;
+    sqe->user_data = kCtlTag;
+}
+
+void IoUringPoller::arm_timeout(int timeout_ms) {
+    if (timeout_armed_) {
+        // An armed timeout that fires first only costs an early, empty poll(); one that fires
+        // later would oversleep the caller's deadline (timer wheel ticks), so replace it.
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        if (deadline >= timeout_deadline_) return;
+        // The replaced timeout completes -ECANCELED: reap() ignores it, at worst one early poll().
+        prep_timeout_remove();
+    }
+    prep_timeout(timeout_ms);
+}
+
+void IoUringPoller::prep_accept() {
+    io_uring_sqe* sqe = next_sqe();
+    if (!sqe) {
+        error_cpp20("io_uring SQ exhausted, cannot arm listener " + std::to_string(accept_fd_));
+        return;
+    }
+    sqe->fd = accept_fd_;
+    if (accept_multishot_) {
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    } else {
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->poll32_events = EPOLLIN;
+        sqe->len = IORING_POLL_ADD_MULTI;
+    }
+    sqe->user_data = kAcceptTag;
+    accept_armed_ = true;
+}
+
+void IoUringPoller::on_accept(const io_uring_cqe& cqe, bool more) {
+    if (!more) accept_armed_ = false;
+    if (cqe.res >= 0) {
+        if (!accept_multishot_) {
+            accept_ready();
+        } else {
+            accepted_.push_back(cqe.res);
+            accept_seen_ = true;
+        }
+        if (!more) accept_retry_at_ = {};   // dropped on CQ overflow: re-arm right away
+        return;
+    }
+    if (accept_multishot_ && cqe.res == -EINVAL && !accept_seen_) {
+        // Kernel before 5.19: no multishot accept. Fall back to readiness plus accept4().
+        log_cpp20("io_uring: multishot accept unsupported, polling listener " + std::to_string(accept_fd_));
+        accept_multishot_ = false;
+        accept_retry_at_ = {};
+        return;
+    }
+    error_cpp20("io_uring accept failed on fd " + std::to_string(accept_fd_) + ": " + std::string(strerror(-cqe.res)));
+    if (!more) accept_retry_at_ = std::chrono::steady_clock::now() + kAcceptRetry;
+}
+
+void IoUringPoller::accept_ready() {
+    // The poll is edge triggered, so drain the whole backlog per wakeup.
+    while (true) {
+        int fd = ::accept4(accept_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                error_cpp20("io_uring poller: accept failed: " + std::string(strerror(errno)));
+            }
+            return;
+        }
+        accepted_.push_back(fd);
+    }
+}
+
+void IoUringPoller::on_recv(const io_uring_cqe& cqe, bool more) {
+    const bool has_buffer = cqe.flags & IORING_CQE_F_BUFFER;
+    const auto buffer = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+    if (has_buffer) ++buffers_out_;
+    const int fd = fd_of(cqe.user_data);
+    Registration* reg = static_cast<size_t>(fd) < registrations_.size() ? &registrations_[fd] : nullptr;
+    if (!reg || !reg->active || !reg->receiver || reg->generation != generation_of(cqe.user_data)) {
+        if (has_buffer) recycle_buffer(buffer);     // stale: the socket was removed
+        return;
+    }
+    if (!more) reg->recv_armed = false;
+    if (cqe.res > 0 && has_buffer) {
+        buffer_owner_[buffer] = cqe.user_data;
+        ++reg->held;
+        received_.push_back(Received{fd, cqe.res, buffer, buffers_ + buffer * kRecvBufferSize});
+        if (more && reg->held >= kMaxHeldBuffers && !reg->recv_cancelling) {
+            // The handler is not keeping up: leave the rest in the socket until it has.
+            prep_cancel(cqe.user_data);
+            reg->recv_cancelling = true;
+        }
+    } else {
+        if (has_buffer) recycle_buffer(buffer);
+        // Out of buffers, or cancelled above: armed again by rearm_receivers(). Anything else
+        // ends the stream.
+        if (cqe.res != -ENOBUFS && cqe.res != -ECANCELED && cqe.res != -EAGAIN && cqe.res != -EINTR) {
+            received_.push_back(Received{fd, cqe.res, 0, nullptr});
+            reg->recv_done = true;
+        }
+    }
+    if (!reg->recv_armed && !reg->recv_done) idle_receivers_.push_back(fd);
+}
+
+void IoUringPoller::on_send(const io_uring_cqe& cqe) {
+    const auto index = static_cast<uint32_t>(cqe.user_data);
+    if (index >= sends_.size()) return;
+    SendSlot& slot = *sends_[index];
+    slot.frames.clear();
+    free_sends_.push_back(index);
+    if (slot.fd < 0 || static_cast<size_t>(slot.fd) >= registrations_.size()) return;
+    const Registration& reg = registrations_[slot.fd];
+    if (reg.active && reg.generation == slot.generation) sent_.push_back(Sent{slot.fd, cqe.res});
+}
+
+bool IoUringPoller::submit_send(int fd, std::span<const iovec> iov, std::span<FrameRef> frames) {
+    if (!receive_ || fd < 0 || iov.empty()) return false;
+    // A registration queued before this send has to be in place, or the completion would be
+    // matched against the socket's previous one.
+    apply_pending_ctl();
+    if (static_cast<size_t>(fd) >= registrations_.size()) return false;
+    const Registration& reg = registrations_[fd];
+    if (!reg.active || !reg.receiver) return false;
+    io_uring_sqe* sqe = next_sqe();
+    if (!sqe) return false;
+    uint32_t index;
+    if (!free_sends_.empty()) {
+        index = free_sends_.back();
+        free_sends_.pop_back();
+    } else {
+        index = static_cast<uint32_t>(sends_.size());
+        sends_.push_back(std::make_unique<SendSlot>());
+    }
+    SendSlot& slot = *sends_[index];
+    slot.fd = fd;
+    slot.generation = reg.generation;
+    const size_t n = std::min<size_t>(iov.size(), kMaxSendIov);
+    std::copy_n(iov.begin(), n, slot.iov);
+    slot.frames.assign(std::make_move_iterator(frames.begin()), std::make_move_iterator(frames.end()));
+    slot.msg = msghdr{};
+    slot.msg.msg_iov = slot.iov;
+    slot.msg.msg_iovlen = n;
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(&slot.msg);
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = (static_cast<uint64_t>(Kind::Send) << 62) | index;
+    return true;
+}
+
+void IoUringPoller::recycle_buffer(uint16_t buffer) {
+    const uint64_t owner = std::exchange(buffer_owner_[buffer], 0);
+    if (kind_of(owner) == static_cast<uint64_t>(Kind::Recv)) {
+        const int fd = fd_of(owner);
+        if (static_cast<size_t>(fd) < registrations_.size()) {
+            Registration& reg = registrations_[fd];
+            if (reg.active && reg.generation == generation_of(owner) && reg.held > 0) --reg.held;
+        }
+    }
+    --buffers_out_;
+    // Not buf_ring_->bufs: in C++ the header's flexible-array wrapper starts it 8 bytes in,
+    // while the kernel reads slot 0 at the ring's start (the tail overlays its resv field).
+    io_uring_buf& slot = reinterpret_cast<io_uring_buf*>(buf_ring_)[buf_tail_ & (kRecvBuffers - 1)];
+    slot.addr = reinterpret_cast<uint64_t>(buffers_ + buffer * kRecvBufferSize);
+    slot.len = kRecvBufferSize;
+    slot.bid = buffer;
+    ++buf_tail_;
+}
+
+void IoUringPoller::publish_buffers() {
+    std::atomic_ref<uint16_t>(buf_ring_->tail).store(buf_tail_, std::memory_order_release);
+}
+
+void IoUringPoller::rearm_receivers() {
+    size_t kept = 0;
+    for (int fd : idle_receivers_) {
+        Registration& reg = registrations_[fd];
+        if (!reg.active || !reg.receiver || reg.recv_armed || reg.recv_done) continue;
+        // Half the hold limit, so a stalled handler is not re-armed for every buffer it frees.
+        if (reg.held >= kMaxHeldBuffers / 2 || buffers_out_ >= kRecvBuffers) {
+            idle_receivers_[kept++] = fd;
+            continue;
+        }
+        prep_recv(fd, reg);
+    }
+    idle_receivers_.resize(kept);
+}
+
+int IoUringPoller::enter(unsigned to_submit, unsigned min_complete, const __kernel_timespec* wait) {
+    unsigned flags = min_complete ? IORING_ENTER_GETEVENTS : 0;
+    io_uring_getevents_arg arg{};
+    const void* argp = nullptr;
+    size_t argsz = 0;
+    if (wait) {
+        arg.sigmask_sz = _NSIG / 8;
+        arg.ts = reinterpret_cast<uint64_t>(wait);
+        flags |= IORING_ENTER_EXT_ARG;
+        argp = &arg;
+        argsz = sizeof(arg);
+    }
+    int ret = static_cast<int>(::syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete,
+                                         flags, argp, argsz));
+    if (ret > 0) {
+        to_submit_ -= std::min<unsigned>(to_submit_, static_cast<unsigned>(ret));
+    }
+    return ret;
+}
+
+void IoUringPoller::reap() {
+    ready_.clear();
+    accepted_.clear();
+    received_.clear();
+    sent_.clear();
+    unsigned head = *cq_head_;
+    unsigned tail = load_acquire(cq_tail_);
+    for (; head != tail; ++head) {
+        const io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+        const bool more = cqe.flags & IORING_CQE_F_MORE;
+        if (cqe.user_data == kTimeoutTag) {
+            if (cqe.res != -ECANCELED) timeout_armed_ = false;   // -ECANCELED: one we replaced
+            continue;
+        }
+        if (cqe.user_data == kAcceptTag) {
+            on_accept(cqe, more);
+            continue;
+        }
+        if (cqe.user_data == kCtlTag) {
+            continue;
+        }
+        if (cqe.user_data == kProbeTag) {
+            // A probe receive that was still running when probe_receive() gave up.
+            if (cqe.flags & IORING_CQE_F_BUFFER) {
+                ++buffers_out_;
+                recycle_buffer(static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+            }
+            continue;
+        }
+        if (kind_of(cqe.user_data) == static_cast<uint64_t>(Kind::Recv)) {
+            on_recv(cqe, more);
+            continue;
+        }
+        if (kind_of(cqe.user_data) == static_cast<uint64_t>(Kind::Send)) {
+            on_send(cqe);
+            continue;
+        }
+        if (cqe.user_data == kWakeTag) {
+            uint64_t count;
+            while (::read(wake_fd_, &count, sizeof(count)) > 0) {}
+            if (!more) wake_armed_ = false;
+            continue;
+        }
+        int fd = fd_of(cqe.user_data);
+        uint32_t generation = generation_of(cqe.user_data);
+        if (fd < 0 || static_cast<size_t>(fd) >= registrations_.size()) continue;
+        Registration& reg = registrations_[fd];
+        if (!reg.active || reg.generation != generation) continue; // stale completion
+
+        epoll_event ev{};
+        ev.data.fd = fd;
+        if (cqe.res < 0) {
+            ev.events = EPOLLERR;
+        } else {
+            ev.events = static_cast<uint32_t>(cqe.res);
+        }
+        ready_.push_back(ev);
+        if (!more) {
+            // Kernel dropped the multishot poll (e.g. CQ overflow); arm it again.
+            prep_poll_add(fd, reg);
+        }
+    }
+    store_release(cq_head_, head);
+}
+
+std::optional<std::span<const epoll_event>> IoUringPoller::poll(int timeout) {
+    if (!valid()) {
+        error_cpp20("io_uring poller is not initialized");
+        return std::nullopt;
+    }
+    poll_thread_.store(std::this_thread::get_id(), std::memory_order_release);
+
+    if (!wake_armed_) {
+        io_uring_sqe* sqe = next_sqe();
+        if (sqe) {
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd = wake_fd_;
+            sqe->poll32_events = EPOLLIN;
+            sqe->len = IORING_POLL_ADD_MULTI;
+            sqe->user_data = kWakeTag;
+            wake_armed_ = true;
+        }
+    }
+    apply_pending_ctl();
+    if (receive_) {
+        publish_buffers();
+        rearm_receivers();
+    }
+    if (accept_fd_ >= 0 && !accept_armed_) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= accept_retry_at_) {
+            prep_accept();
+        } else {
+            auto wait = std::chrono::ceil<std::chrono::milliseconds>(accept_retry_at_ - now).count();
+            if (timeout < 0 || timeout > wait) timeout = static_cast<int>(wait);
+        }
+    }
+
+    // Completions left over from a previous round are returned without waiting.
+    unsigned ready = load_acquire(cq_tail_) - *cq_head_;
+    unsigned min_complete = 0;
+    __kernel_timespec wait_ts{};
+    const __kernel_timespec* wait = nullptr;
+    if (ready == 0 && timeout != 0) {
+        min_complete = 1;
+        if (timeout > 0 && ext_arg_) {
+            wait_ts.tv_sec = timeout / 1000;
+            wait_ts.tv_nsec = static_cast<long long>(timeout % 1000) * 1000000ll;
+            wait = &wait_ts;
+        } else if (timeout > 0) {
+            arm_timeout(timeout);
+        }
+    }
+
+    // One syscall per loop iteration: submit every queued SQE and wait for completions.
+    int ret = enter(to_submit_, min_complete, wait);
+    if (ret < 0) {
+        if (errno == EINTR) {
+            log_cpp20("io_uring_enter interrupted by signal: " + std::string(strerror(errno)));
+        } else if (errno != EBUSY && errno != EAGAIN && errno != ETIME) {
+            error_cpp20("io_uring_enter failed: " + std::string(strerror(errno)));
+            return std::nullopt;
+        }
+    }
+
+    reap();
+    return std::span<const epoll_event>(ready_.data(), ready_.size());
+}
+
+} // namespace net
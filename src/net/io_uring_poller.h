@@ -0,0 +1,205 @@
+#pragma once
+
+#include <linux/io_uring.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <optional>
+#include <span>
+
+#include "poller.h"
+
+namespace net {
+
+// Readiness poller on top of a raw io_uring instance (no liburing dependency).
+//
+// Every registered fd gets one multishot IORING_OP_POLL_ADD, so a connection costs no
+// syscall per wakeup once armed. add/modify/remove only queue control operations; they are
+// turned into SQEs and submitted together with the wait in a single io_uring_enter() per
+// poll() call. Control calls may come from any thread (MainReactor hands fds to IOReactors),
+// a private eventfd wakes the polling thread when that happens.
+//
+// Multishot poll only fires on new wakeups, so the semantics match EPOLLET.
+//
+// A listener added with add_acceptor() gets a multishot IORING_OP_ACCEPT instead: one CQE
+// per new connection, no accept4() call. Kernels without multishot accept (before 5.19) get
+// a multishot poll on the listener and an accept4() loop here, so callers see the same thing.
+//
+// Connection sockets added with add_receiver() get a multishot IORING_OP_RECV that selects
+// from a buffer ring (IORING_REGISTER_PBUF_RING) instead of a poll: one CQE per read, no recv()
+// call. A socket holding kMaxHeldBuffers unreleased buffers (its handler stalled) has its
+// receive cancelled, so it cannot drain the ring for everybody else; what the socket already
+// had still arrives, the rest waits in the kernel until it is re-armed once the handler caught
+// up. A receive that ran out of buffers (-ENOBUFS) is re-armed once some came back.
+// submit_send() queues an IORING_OP_SENDMSG that goes out with the next io_uring_enter(), with
+// everything else of that loop iteration. Kernels without multishot recv (before 6.0) get no
+// receive path: add_receiver() returns false and the reactor reads on readiness as before.
+class IoUringPoller : public Poller {
+public:
+    explicit IoUringPoller(unsigned entries = 1024);
+    ~IoUringPoller() override;
+
+    IoUringPoller(const IoUringPoller&) = delete;
+    IoUringPoller& operator=(const IoUringPoller&) = delete;
+
+    bool valid() const { return ring_fd_ >= 0; }
+
+    bool add_fd(int fd, uint32_t events) override;
+    bool modify_fd(int fd, uint32_t events) override;
+    bool remove_fd(int fd) override;
+    std::optional<std::span<const epoll_event>> poll(int timeout) override;
+
+    bool add_acceptor(int listen_fd) override;
+    std::span<const int> accepted() const override { return {accepted_.data(), accepted_.size()}; }
+
+    bool add_receiver(int fd) override;
+    void release_buffer(uint16_t buffer) override;
+    std::span<const Received> received() const override { return {received_.data(), received_.size()}; }
+    bool submit_send(int fd, std::span<const iovec> iov, std::span<FrameRef> frames) override;
+    std::span<const Sent> sent() const override { return {sent_.data(), sent_.size()}; }
+
+    const char* name() const override { return "io_uring"; }
+
+    static constexpr unsigned kRecvBuffers = 256;           // power of two (buffer ring size)
+    static constexpr std::size_t kRecvBufferSize = 16 * 1024;
+    static constexpr uint16_t kMaxHeldBuffers = 8;          // per socket, before its receive is paused
+    static constexpr int kMaxSendIov = 64;                  // iovecs of one send, more are cut off
+
+private:
+    enum class CtlOp : uint8_t { Add, Modify, Remove, Accept, Receive };
+
+    // What a CQE belongs to, in the top two bits of user_data (the fixed tags have both set).
+    enum class Kind : uint8_t { Poll = 0, Recv = 1, Send = 2 };
+
+    struct CtlRequest {
+        CtlOp op;
+        int fd;
+        uint32_t events;
+    };
+
+    struct Registration {
+        uint32_t events{0};
+        uint32_t generation{0};
+        bool active{false};
+        bool receiver{false};       // read with multishot recv instead of polled
+        bool recv_armed{false};
+        bool recv_cancelling{false};
+        bool recv_done{false};      // end of stream or error reported, not re-armed
+        uint16_t held{0};           // buffers handed out and not released yet
+    };
+
+    // An IORING_OP_SENDMSG in flight: the message, and the frames it points into.
+    struct SendSlot {
+        int fd{-1};
+        uint32_t generation{0};
+        msghdr msg{};
+        iovec iov[kMaxSendIov];
+        std::vector<FrameRef> frames;
+    };
+
+    bool setup(unsigned entries);
+    bool setup_receive();
+    bool register_buf_ring();
+    bool probe_receive();
+    void teardown();
+
+    bool queue_ctl(CtlOp op, int fd, uint32_t events);
+    void apply_pending_ctl();
+
+    io_uring_sqe* next_sqe();
+    void prep_poll_add(int fd, const Registration& reg);
+    void prep_poll_remove(int fd, const Registration& reg);
+    void prep_timeout(int timeout_ms);
+    void prep_timeout_remove();
+    void arm_timeout(int timeout_ms);
+    void prep_accept();
+    void on_accept(const io_uring_cqe& cqe, bool more);
+    void accept_ready();
+    void prep_recv(int fd, Registration& reg);
+    void prep_cancel(uint64_t user_data);
+    void on_recv(const io_uring_cqe& cqe, bool more);
+    void on_send(const io_uring_cqe& cqe);
+    void recycle_buffer(uint16_t buffer);
+    void publish_buffers();
+    void rearm_receivers();
+    int enter(unsigned to_submit, unsigned min_complete, const __kernel_timespec* wait = nullptr);
+    void reap();
+
+    static constexpr uint32_t kGenerationMask = (1u << 30) - 1;
+
+    static uint64_t encode(int fd, uint32_t generation, Kind kind = Kind::Poll) {
+        return (static_cast<uint64_t>(kind) << 62) | (static_cast<uint64_t>(generation & kGenerationMask) << 32)
+             | static_cast<uint32_t>(fd);
+    }
+
+    int ring_fd_{-1};
+    int wake_fd_{-1};
+    bool wake_armed_{false};
+    // IORING_ENTER_EXT_ARG (5.11+): the wait carries its own timeout and no timeout SQE is
+    // needed. Without it one IORING_OP_TIMEOUT is kept armed and replaced when a poll() asks
+    // for an earlier deadline than the armed one.
+    bool ext_arg_{false};
+    bool timeout_armed_{false};
+    std::chrono::steady_clock::time_point timeout_deadline_{};
+    __kernel_timespec timeout_ts_{};
+
+    int accept_fd_{-1};
+    bool accept_multishot_{true};       // cleared when the kernel rejects IORING_ACCEPT_MULTISHOT
+    bool accept_armed_{false};
+    bool accept_seen_{false};           // multishot accept has produced a socket
+    std::chrono::steady_clock::time_point accept_retry_at_{};   // re-arm after an error, not before
+    std::vector<int> accepted_;         // reused across poll() calls
+
+    // SQ ring
+    void* sq_ring_{nullptr};
+    size_t sq_ring_size_{0};
+    unsigned* sq_head_{nullptr};
+    unsigned* sq_tail_{nullptr};
+    unsigned* sq_mask_{nullptr};
+    unsigned* sq_array_{nullptr};
+    unsigned sq_entries_{0};
+    io_uring_sqe* sqes_{nullptr};
+    size_t sqes_size_{0};
+    unsigned to_submit_{0};
+
+    // CQ ring (may share the SQ mapping with IORING_FEAT_SINGLE_MMAP)
+    void* cq_ring_{nullptr};
+    size_t cq_ring_size_{0};
+    unsigned* cq_head_{nullptr};
+    unsigned* cq_tail_{nullptr};
+    unsigned* cq_mask_{nullptr};
+    io_uring_cqe* cqes_{nullptr};
+
+    // Provided buffers of the receive path: kRecvBuffers of kRecvBufferSize in one mapping,
+    // handed to the kernel through buf_ring_.
+    bool receive_{false};
+    uint8_t* buffers_{nullptr};
+    io_uring_buf_ring* buf_ring_{nullptr};
+    size_t buf_ring_size_{0};
+    uint16_t buf_tail_{0};                      // ring tail including buffers not yet published
+    unsigned buffers_out_{0};                   // buffers not in the ring: received and unreleased
+    std::vector<uint64_t> buffer_owner_;        // encode(fd, generation) of the receive that filled it
+    std::vector<int> idle_receivers_;           // receivers to re-arm once they hold fewer buffers
+    std::vector<Received> received_;            // reused across poll() calls
+
+    std::vector<std::unique_ptr<SendSlot>> sends_;
+    std::vector<uint32_t> free_sends_;
+    std::vector<Sent> sent_;                    // reused across poll() calls
+
+    std::vector<Registration> registrations_;   // indexed by fd, touched only by the polling thread
+    std::vector<epoll_event> ready_;            // reused across poll() calls
+
+    std::mutex ctl_mutex_;
+    std::vector<CtlRequest> pending_ctl_;
+    std::vector<CtlRequest> applying_ctl_;
+    std::vector<uint16_t> pending_release_;     // buffers released off the polling thread
+    std::vector<uint16_t> applying_release_;
+    std::atomic<std::thread::id> poll_thread_{};
+};
+
+} // namespace net
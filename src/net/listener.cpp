@@ -34,8 +34,8 @@ Listener& Listener::operator=(Listener&& other) noexcept {
     return *this;
 }
 
-bool Listener::listen_on(uint16_t port, std::string ip) {
-    listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+bool Listener::listen_on(uint16_t port, std::string ip, bool reuse_port) {
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (listen_fd_ < 0) {
         RUNTIME_ERROR("socket() failed: %s", strerror(errno));
         return false;
@@ -49,6 +49,13 @@ bool Listener::listen_on(uint16_t port, std::string ip) {
         return false;
     }
 
+    if (reuse_port && setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        RUNTIME_ERROR("setsockopt(SO_REUSEPORT) failed: %s", strerror(errno));
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+
     struct sockaddr_in server_addr;
     ::memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;
@@ -3,9 +3,25 @@
 #include <cstdint> // For uint16_t
 #include <netinet/in.h> // For sockaddr_in
 #include <string>
+#include <string_view>
+#include <optional>
 
 namespace net {
 
+// Who accepts new connections.
+enum class AcceptMode : uint8_t {
+    MainReactor = 0,     // MainReactor accepts and hands fds to IOReactors (default)
+    ReusePort = 1,       // every IOReactor owns a SO_REUSEPORT listener, the kernel balances
+    SharedExclusive = 2  // one listener registered in every IOReactor with EPOLLEXCLUSIVE
+};
+
+inline std::optional<AcceptMode> parse_accept_mode(std::string_view name) {
+    if (name == "main") return AcceptMode::MainReactor;
+    if (name == "reuseport") return AcceptMode::ReusePort;
+    if (name == "exclusive") return AcceptMode::SharedExclusive;
+    return std::nullopt;
+}
+
 class Listener {
 public:
     Listener();
@@ -17,7 +33,8 @@ public:
     Listener(Listener&& other) noexcept;
     Listener& operator=(Listener&& other) noexcept;
 
-    bool listen_on(uint16_t port, std::string ip);
+    // The listening socket is non-blocking: reactors drain accept4() until EAGAIN.
+    bool listen_on(uint16_t port, std::string ip, bool reuse_port = false);
 
     int accept_connection(struct sockaddr_in* client_addr = nullptr);
 
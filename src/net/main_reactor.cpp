@@ -7,9 +7,11 @@
 #include <sys/socket.h>
 #include <fcntl.h>
 #include <string>
+#include <algorithm>
 
 #include "common/debug.h"
 #include "concurrency/lf_thread_pool.h"
+#include "concurrency/admission_controller.h"
 #include "reactor.h"
 #include "io_reactor.h"
 #include "connection.h"
@@ -19,18 +21,98 @@ namespace net {
 
 
 bool MainReactor::listen_on(uint16_t port, std::string ip, int backlog) {
-    listener_.listen_on(port, ip);
-    
+    if (accept_mode_ == AcceptMode::ReusePort) {
+        // Each IOReactor binds its own SO_REUSEPORT socket; MainReactor only supervises.
+        for (auto& r : io_reactors_) {
+            if (!r->listen_reuseport(port, ip)) {
+                return false;
+            }
+        }
+        log_cpp20("MainReactor: " + std::to_string(io_reactors_.size()) + " SO_REUSEPORT acceptors on " + ip + ":" + std::to_string(port));
+        return true;
+    }
+
+    if (!listener_.listen_on(port, ip)) {
+        return false;
+    }
     listen_fd_ = listener_.get_fd();
-    epoll_poller_.add_fd(listen_fd_, EPOLLIN | EPOLLET);
+
+    if (accept_mode_ == AcceptMode::SharedExclusive) {
+        for (auto& r : io_reactors_) {
+            if (!r->share_listener(listen_fd_)) {
+                return false;
+            }
+        }
+        log_cpp20("MainReactor: listener shared by " + std::to_string(io_reactors_.size()) + " IO reactors (EPOLLEXCLUSIVE)");
+        return true;
+    }
+
+    if (!poller_->add_acceptor(listen_fd_)) {
+        poller_->add_fd(listen_fd_, EPOLLIN | EPOLLET);
+    }
     return true;
 }
 
 
 
+IOReactor::Ptr MainReactor::pick_reactor() {
+    if (io_reactors_.empty()) return nullptr;
+    const std::size_t n = io_reactors_.size();
+    std::size_t start = rr_.fetch_add(1, std::memory_order_relaxed) % n;
+    std::size_t best = start;
+    double best_score = io_reactors_[start]->load().score();
+    for (std::size_t k = 1; k < n; ++k) {
+        std::size_t idx = (start + k) % n;
+        double score = io_reactors_[idx]->load().score();
+        if (score < best_score) {
+            best = idx;
+            best_score = score;
+        }
+    }
+    return io_reactors_[best];
+}
+
+std::vector<ReactorLoad> MainReactor::reactor_loads() const {
+    std::vector<ReactorLoad> loads;
+    loads.reserve(io_reactors_.size());
+    for (auto& r : io_reactors_) {
+        loads.push_back(r->load());
+    }
+    return loads;
+}
+
+void MainReactor::rebalance() {
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_rebalance_ < std::chrono::seconds(1)) return;
+    last_rebalance_ = now;
+    if (io_reactors_.size() < 2) return;
+
+    auto loads = reactor_loads();
+    std::size_t hi = 0, lo = 0;
+    for (std::size_t i = 1; i < loads.size(); ++i) {
+        if (loads[i].score() > loads[hi].score()) hi = i;
+        if (loads[i].score() < loads[lo].score()) lo = i;
+    }
+    double hi_score = loads[hi].score();
+    double lo_score = loads[lo].score();
+    if (hi_score - lo_score < kRebalanceMinGap || hi_score < lo_score * kRebalanceRatio) return;
+
+    // Halve the connection gap, limited by how many connections are actually idle on the source.
+    std::size_t gap = loads[hi].connections > loads[lo].connections
+                    ? (loads[hi].connections - loads[lo].connections) / 2 : 1;
+    int count = static_cast<int>(std::min<std::size_t>({gap, loads[hi].idle_connections,
+                                                        static_cast<std::size_t>(kMaxMigrationsPerRound)}));
+    if (count <= 0) return;
+    log_cpp20("MainReactor: rebalance " + std::to_string(count) + " connections from IOReactor "
+              + std::to_string(loads[hi].reactor_id) + " (score " + std::to_string(hi_score) + ") to IOReactor "
+              + std::to_string(loads[lo].reactor_id) + " (score " + std::to_string(lo_score) + ")");
+    io_reactors_[hi]->request_migration(io_reactors_[lo].get(), count);
+}
+
 void MainReactor::loop() {
     while (running_.load(std::memory_order_acquire)) {
-        auto events_opt = epoll_poller_.poll(1000);
+        rebalance();
+        auto events_opt = poller_->poll(1000);
         if (!events_opt) {
             if (errno == EINTR) {
                 RUNTIME_ERROR("epoll_wait interrupted by signal: %s", strerror(errno));
@@ -38,37 +120,54 @@ void MainReactor::loop() {
             }
             else break;
         }
-        auto events = *events_opt;
-        if (events.empty()) continue;
-        for (int i = 0; i < events.size(); ++i) {
-            if (events[i].data.fd != listen_fd_) {
-                error_cpp20("MainReactor: unexpected event on fd " + std::to_string(events[i].data.fd));
-                continue;
-            }
-            int client_fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
-            if (client_fd < 0) {
-                if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                    // No more incoming connections to accept
-                    log_cpp20("MainReactor: no more incoming connections to accept");
-                    break;
-                }
-                error_cpp20("MainReactor: accept failed: " + std::string(strerror(errno)));
-                continue;
-            }
-            log_cpp20("MainReactor: new connection on fd " + std::to_string(client_fd));
-            auto r = pick_reactor();
-            if (!r) {
-                error_cpp20("No IO reactor available, closing fd " + std::to_string(client_fd));
-                ::close(client_fd);
+        for (const epoll_event& event : *events_opt) {
+            if (event.data.fd != listen_fd_) {
+                error_cpp20("MainReactor: unexpected event on fd " + std::to_string(event.data.fd));
                 continue;
             }
-            if (r->addConnection(client_fd) == false) {
-                error_cpp20("Failed to add connection to IO reactor, closing fd " + std::to_string(client_fd));
-                ::close(client_fd);
-                continue;
+            accept_pending();
+        }
+        // Sockets the poller accepted itself (multishot accept on io_uring).
+        for (int client_fd : poller_->accepted()) {
+            place_connection(client_fd);
+        }
+    }
+}
+
+void MainReactor::accept_pending() {
+    // The listen fd is edge triggered (multishot poll on io_uring), so drain the whole backlog per wakeup.
+    while (true) {
+        int client_fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // No more incoming connections to accept
+                log_cpp20("MainReactor: no more incoming connections to accept");
+                return;
             }
-            
+            error_cpp20("MainReactor: accept failed: " + std::string(strerror(errno)));
+            return;
         }
+        place_connection(client_fd);
+    }
+}
+
+void MainReactor::place_connection(int client_fd) {
+    log_cpp20("MainReactor: new connection on fd " + std::to_string(client_fd));
+    auto* admission = server_context_ ? server_context_->admission.get() : nullptr;
+    if (admission && !admission->admit_connection()) {
+        log_cpp20("MainReactor: over capacity, refusing fd " + std::to_string(client_fd));
+        IOReactor::reject_connection(client_fd, admission->retry_after_ms());
+        return;
+    }
+    auto r = pick_reactor();
+    if (!r) {
+        error_cpp20("No IO reactor available, closing fd " + std::to_string(client_fd));
+        ::close(client_fd);
+        return;
+    }
+    if (r->addConnection(client_fd) == false) {
+        error_cpp20("Failed to add connection to IO reactor, fd " + std::to_string(client_fd) + " closed");
     }
 }
 
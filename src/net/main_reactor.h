@@ -3,6 +3,8 @@
 #include <atomic>
 #include <random>
 #include <memory>
+#include <unordered_map>
+#include <chrono>
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <fcntl.h>
@@ -11,8 +13,9 @@
 #include "concurrency/lf_thread_pool.h"
 #include "reactor.h"
 #include "io_reactor.h"
-#include "epoll_poller.h"
+#include "poller.h"
 #include "listener.h"
+#include "reactor_load.h"
 #include "types/context.h"
 
 namespace net {
@@ -23,15 +26,16 @@ public:
 
     explicit MainReactor(int core_id = -1, std::vector<int> cpu_cores = {},
                         ServerContext::Ptr server_context = nullptr)
-    : ReactorBase(core_id), 
-        reactor_context_(std::make_shared<ReactorContext>(server_context)) {
-        reactor_context_->main_reactor = this;
+    : ReactorBase(core_id, poller_backend_of(server_context)), 
+        accept_mode_(server_context ? server_context->accept_mode : AcceptMode::MainReactor),
+        server_context_(server_context) {
+        // Every IOReactor gets its own context: response queue, close callback and traffic counters are per reactor.
         if (cpu_cores.empty()) {
-            io_reactors_.push_back(std::make_shared<IOReactor>(1, -1, reactor_context_));
+            io_reactors_.push_back(std::make_shared<IOReactor>(1, -1, make_reactor_context()));
             io_reactors_.back().get()->start();
         } else {
             for (int i = 0; i < cpu_cores.size(); ++i) {
-                io_reactors_.push_back(std::make_shared<IOReactor>(i, cpu_cores[i], reactor_context_));
+                io_reactors_.push_back(std::make_shared<IOReactor>(i, cpu_cores[i], make_reactor_context()));
                 io_reactors_.back().get()->start();
             }
         }
@@ -39,7 +43,6 @@ public:
 
     ~MainReactor() override {
         handlers_.erase(listen_fd_);
-        ::close(listen_fd_);
     }
 
     void set_io_reactors(std::vector<IOReactor::Ptr> reactors) {
@@ -48,25 +51,46 @@ public:
 
     bool listen_on(uint16_t port, std::string ip = "127.0.0.1", int backlog = 1024);
 
+    AcceptMode accept_mode() const { return accept_mode_; }
+
+    // Current load of every IO reactor, in reactor order.
+    std::vector<ReactorLoad> reactor_loads() const;
+
 
 protected:
     void loop() override;
 
-    IOReactor::Ptr pick_reactor() {
-        if (io_reactors_.empty()) return nullptr;
-        // simple round robin
-        auto idx = rr_.fetch_add(1,std::memory_order_relaxed) % io_reactors_.size();
-        return io_reactors_[idx];
-    }
+    void accept_pending();
+    // Admission check, then hand client_fd to the least loaded IO reactor.
+    void place_connection(int client_fd);
+
+    // Least loaded reactor by ReactorLoad::score(). Connection counts are live, byte rates are
+    // sampled; the round robin cursor only breaks ties.
+    IOReactor::Ptr pick_reactor();
+
+    // Move idle connections from the busiest reactor to the least busy one when the gap is large.
+    void rebalance();
 
 private:
+    ReactorContext::Ptr make_reactor_context() {
+        auto ctx = std::make_shared<ReactorContext>(server_context_);
+        ctx->main_reactor = this;
+        return ctx;
+    }
+
+    static constexpr double kRebalanceMinGap = 8.0;      // in connection-equivalents
+    static constexpr double kRebalanceRatio = 1.5;
+    static constexpr int kMaxMigrationsPerRound = 16;
+
     int listen_fd_{-1};
+    AcceptMode accept_mode_{AcceptMode::MainReactor};
     Listener listener_;
     std::unordered_map<int, IEventHandler::Ptr> handlers_;
     std::vector<IOReactor::Ptr> io_reactors_;
     std::atomic<uint64_t> rr_{0};
+    std::chrono::steady_clock::time_point last_rebalance_{};
 
-    ReactorContext::Ptr reactor_context_{nullptr};
+    ServerContext::Ptr server_context_{nullptr};
 };
 
 } // namespace net
@@ -0,0 +1,87 @@
+#include "metrics_listener.h"
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "metrics/metrics.h"
+#include "metrics/trace.h"
+#include "utils/log.h"
+
+namespace net {
+
+namespace {
+constexpr int kPollMs = 200;                 // how quickly stop() is noticed
+constexpr std::size_t kMaxRequestBytes = 8192;
+}
+
+bool MetricsListener::start(uint16_t port, const std::string& ip) {
+    if (running_.load()) return true;
+    if (!listener_.listen_on(port, ip)) {
+        LOG_ERROR("metrics listener: cannot listen on {}:{}", ip, port);
+        return false;
+    }
+    running_.store(true);
+    thread_ = std::thread([this] { run(); });
+    LOG_INFO("metrics listener on http://{}:{}/metrics", ip, port);
+    return true;
+}
+
+void MetricsListener::stop() {
+    if (!running_.exchange(false)) return;
+    if (thread_.joinable()) thread_.join();
+}
+
+void MetricsListener::run() {
+    pollfd pfd{listener_.get_fd(), POLLIN, 0};
+    while (running_.load(std::memory_order_relaxed)) {
+        int ready = ::poll(&pfd, 1, kPollMs);
+        if (ready <= 0) continue;
+        int fd = ::accept4(listener_.get_fd(), nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) continue;
+        serve(fd);
+        ::close(fd);
+    }
+}
+
+void MetricsListener::serve(int fd) {
+    timeval timeout{1, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    // Only the request line is looked at: GET /trace dumps the trace buffers, any other path
+    // the metrics.
+    std::string request;
+    char buf[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < kMaxRequestBytes) {
+        ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) break;
+        request.append(buf, static_cast<std::size_t>(n));
+    }
+
+    std::string body;
+    std::string status = "200 OK";
+    std::string content_type = "text/plain; version=0.0.4";
+    if (request.rfind("GET /trace ", 0) == 0) {
+        body = metrics::trace::dump_json();
+        content_type = "application/json";
+    } else if (request.rfind("GET ", 0) == 0) {
+        body = metrics::Registry::global().render();
+    } else {
+        status = "405 Method Not Allowed";
+    }
+    std::string response = "HTTP/1.0 " + status + "\r\nContent-Type: " + content_type + "\r\nContent-Length: "
+        + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+    std::size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t n = ::send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        sent += static_cast<std::size_t>(n);
+    }
+}
+
+} // namespace net
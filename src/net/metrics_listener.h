@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "listener.h"
+
+namespace net {
+
+// Serves metrics::Registry::global() in the Prometheus text format over HTTP, for scrapers
+// on the same host: bound to loopback, one request per connection, answered from its own
+// thread so a slow scrape never runs on a reactor. GET /trace returns the sampled request
+// spans (metrics::trace) as Chrome trace JSON.
+class MetricsListener {
+public:
+    MetricsListener() = default;
+    ~MetricsListener() { stop(); }
+
+    MetricsListener(const MetricsListener&) = delete;
+    MetricsListener& operator=(const MetricsListener&) = delete;
+
+    bool start(uint16_t port, const std::string& ip = "127.0.0.1");
+    void stop();
+
+private:
+    void run();
+    void serve(int fd);
+
+    Listener listener_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+};
+
+} // namespace net
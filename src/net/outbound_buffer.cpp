@@ -0,0 +1,81 @@
+#include "outbound_buffer.h"
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <algorithm>
+#include <cerrno>
+
+namespace net {
+
+void OutboundBuffer::append(FrameRef frame) {
+    if (!frame) return;
+    frame->seal();
+    pending_ += frame->wire_size();
+    chunks_.push_back(std::move(frame));
+}
+
+void OutboundBuffer::splice(OutboundBuffer& other) {
+    if (other.empty()) return;
+    // Only a buffer that was never flushed is spliced behind a non-empty one.
+    if (chunks_.empty()) head_offset_ = other.head_offset_;
+    for (auto& chunk : other.chunks_) {
+        chunks_.push_back(std::move(chunk));
+    }
+    pending_ += other.pending_;
+    other.chunks_.clear();
+    other.head_offset_ = 0;
+    other.pending_ = 0;
+}
+
+OutboundBuffer::FlushResult OutboundBuffer::flush(int fd, std::size_t& bytes_written) {
+    while (pending_ > 0) {
+        iovec iov[kMaxIov];
+        int iovcnt = prepare(iov, nullptr, kMaxIov);
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovcnt;
+        ssize_t n = ::sendmsg(fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return FlushResult::WouldBlock;
+            return FlushResult::Error;
+        }
+        bytes_written += static_cast<std::size_t>(n);
+        consume(static_cast<std::size_t>(n));
+    }
+    return FlushResult::Drained;
+}
+
+int OutboundBuffer::prepare(iovec* iov, FrameRef* frames, int max) const {
+    int iovcnt = 0;
+    for (auto it = chunks_.begin(); it != chunks_.end() && iovcnt < max; ++it, ++iovcnt) {
+        std::size_t skip = (iovcnt == 0) ? head_offset_ : 0;
+        iov[iovcnt].iov_base = const_cast<uint8_t*>((*it)->wire_data()) + skip;
+        iov[iovcnt].iov_len = (*it)->wire_size() - skip;
+        if (frames) frames[iovcnt] = *it;
+    }
+    return iovcnt;
+}
+
+void OutboundBuffer::consume(std::size_t n) {
+    n = std::min(n, pending_);
+    pending_ -= n;
+    while (n > 0) {
+        std::size_t avail = chunks_.front()->wire_size() - head_offset_;
+        if (n < avail) {
+            head_offset_ += n;
+            break;
+        }
+        n -= avail;
+        chunks_.pop_front();
+        head_offset_ = 0;
+    }
+}
+
+void OutboundBuffer::clear() {
+    chunks_.clear();
+    head_offset_ = 0;
+    pending_ = 0;
+}
+
+} // namespace net
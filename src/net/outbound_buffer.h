@@ -0,0 +1,60 @@
+#pragma once
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+#include "frame_buffer.h"
+#include "utils/inline_function.h"
+
+namespace net {
+
+class OutboundBuffer;
+
+// Pull-based body producer attached to a connection (e.g. a GET file stream). The reactor
+// calls it whenever the buffer drops below the low watermark; it appends the next piece and
+// returns false once it has nothing more to produce. Move-only; the capture is stored inline
+// (24 bytes, e.g. one shared_ptr), so a ResponseQueue cell stays within a cache line.
+using OutboundSource = utils::InlineFunction<bool(OutboundBuffer&), 24>;
+
+// Per-connection chain of frames waiting for the socket. Only touched by the owning reactor thread.
+// Frames are referenced, not copied; flush() writes as much as the socket accepts with one
+// vectored sendmsg per round and keeps the rest.
+class OutboundBuffer {
+public:
+    enum class FlushResult : uint8_t {
+        Drained,     // everything written
+        WouldBlock,  // socket full, wait for EPOLLOUT
+        Error        // peer gone or fatal socket error
+    };
+
+    static constexpr std::size_t kLowWatermark = 256 * 1024;  // refill sources below this
+    static constexpr int kMaxIov = 64;
+
+    // Seals the frame (FrameBuffer::seal) and queues it; the body must not change afterwards.
+    void append(FrameRef frame);
+    // Move all of other's frames behind ours (other must be unflushed unless we are empty).
+    void splice(OutboundBuffer& other);
+
+    // bytes_written accumulates what reached the socket.
+    FlushResult flush(int fd, std::size_t& bytes_written);
+
+    // For sends submitted elsewhere (Poller::submit_send): fill up to max iovecs from the head,
+    // with a reference to each frame in frames so the memory outlives the buffer's copy; the
+    // count is returned. consume() drops what the send reported as written.
+    int prepare(iovec* iov, FrameRef* frames, int max) const;
+    void consume(std::size_t n);
+
+    std::size_t pending_bytes() const { return pending_; }
+    bool empty() const { return pending_ == 0; }
+    void clear();
+
+private:
+    std::deque<FrameRef> chunks_;
+    std::size_t head_offset_{0};   // wire bytes of chunks_.front() already written
+    std::size_t pending_{0};
+};
+
+} // namespace net
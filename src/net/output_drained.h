@@ -0,0 +1,73 @@
+#pragma once
+
+#include <coroutine>
+#include <memory>
+#include <utility>
+
+#include "concurrency/coroutine.h"
+#include "outbound_buffer.h"
+#include "response_queue.h"
+#include "types/context.h"
+
+namespace net {
+
+// co_await net::output_drained(ctx): socket readiness for a coroutine handler. Suspends until
+// the connection's reactor has everything submitted before it on its way and the outbound
+// buffer is down to OutboundBuffer::kLowWatermark, so a handler producing a large response
+// piece by piece never buffers more than that. Yields true then, false when the connection
+// went away first. The coroutine continues on the pool it was suspended from.
+//
+// It rides the response queue as an OutboundSource: the reactor calls it like any stream
+// when output runs low, and one dropped without being called (closed connection, reactor
+// shut down) resumes the coroutine as well. The queue never refuses it (a full ring spills
+// into the overflow list), so false always means the connection is gone, never "busy".
+class OutputDrained {
+public:
+    explicit OutputDrained(ConnectionContext::Ptr ctx) : ctx_(std::move(ctx)) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> h) {
+        auto waiter = std::make_unique<Waiter>(h, concurrency::LFThreadPool::current(), metrics::trace::current(), &drained_);
+        // Locals only from here on: the coroutine, and *this with it, may be gone once the
+        // waiter is handed over.
+        auto ctx = ctx_;
+        ctx->responses_queued.fetch_add(1, std::memory_order_acq_rel);
+        ctx->reactor_context->response_queue->submit_source(
+            ctx->connection_id, ctx->connection_generation,
+            [waiter = std::move(waiter)](OutboundBuffer&) {
+                waiter->fire(true);
+                return false;
+            });
+    }
+
+    bool await_resume() const noexcept { return drained_; }
+
+private:
+    class Waiter {
+    public:
+        Waiter(std::coroutine_handle<> h, concurrency::LFThreadPool* home, uint64_t trace, bool* drained)
+            : h_(h), home_(home), trace_(trace), drained_(drained) {}
+        ~Waiter() {
+            if (h_) fire(false);
+        }
+
+        void fire(bool drained) {
+            *drained_ = drained;
+            concurrency::detail::resume_on(home_, std::exchange(h_, {}), trace_);
+        }
+
+    private:
+        std::coroutine_handle<> h_;
+        concurrency::LFThreadPool* home_;
+        uint64_t trace_;
+        bool* drained_;
+    };
+
+    ConnectionContext::Ptr ctx_;
+    bool drained_{false};
+};
+
+inline OutputDrained output_drained(ConnectionContext::Ptr ctx) { return OutputDrained(std::move(ctx)); }
+
+} // namespace net
@@ -0,0 +1,26 @@
+#include "poller.h"
+
+#include "epoll_poller.h"
+#include "io_uring_poller.h"
+#include "common/debug.h"
+
+namespace net {
+
+std::unique_ptr<Poller> make_poller(PollerBackend backend) {
+    if (backend == PollerBackend::IoUring) {
+        auto poller = std::make_unique<IoUringPoller>();
+        if (poller->valid()) {
+            return poller;
+        }
+        RUNTIME_ERROR("io_uring backend unavailable, falling back to epoll");
+    }
+    return std::make_unique<EpollPoller>();
+}
+
+std::optional<PollerBackend> parse_poller_backend(std::string_view name) {
+    if (name == "epoll") return PollerBackend::Epoll;
+    if (name == "io_uring" || name == "uring") return PollerBackend::IoUring;
+    return std::nullopt;
+}
+
+} // namespace net
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#include "frame_buffer.h"
+
+namespace net {
+
+// Backend used by reactors to wait for fd readiness. Selected once at startup.
+enum class PollerBackend : uint8_t {
+    Epoll = 0,
+    IoUring = 1
+};
+
+// Readiness poller interface shared by the epoll and io_uring backends.
+// Events are reported as epoll_event (data.fd + EPOLL* mask) regardless of backend,
+// so reactors and handlers stay backend agnostic. poll() returns a view over a buffer
+// owned by the poller; it stays valid until the next poll() call and never allocates.
+class Poller {
+public:
+    virtual ~Poller() = default;
+
+    virtual bool add_fd(int fd, uint32_t events) = 0;
+    virtual bool modify_fd(int fd, uint32_t events) = 0;
+    virtual bool remove_fd(int fd) = 0;
+    virtual std::optional<std::span<const epoll_event>> poll(int timeout) = 0;
+
+    // Accept on listen_fd inside the poller, where the backend has a completion path for it
+    // (multishot accept on io_uring). Sockets accepted during a poll() call, non-blocking and
+    // close-on-exec, are listed by accepted() until the next poll(). Returns false when the
+    // backend has no such path; the caller then registers listen_fd for readiness instead.
+    virtual bool add_acceptor(int listen_fd) { (void)listen_fd; return false; }
+    virtual std::span<const int> accepted() const { return {}; }
+
+    // Completion paths for a connection socket, where the backend has them (io_uring).
+    //
+    // A socket added with add_receiver() instead of add_fd() is read by the poller: bytes land
+    // in buffers the poller owns and are listed by received() until the next poll(), in arrival
+    // order. Every buffer must be handed back with release_buffer() once its bytes are used;
+    // that may happen on any thread. remove_fd() stops the receiving.
+    //
+    // submit_send() sends iov on fd from the poller's next poll() call and keeps frames (the
+    // memory iov points into) until the send completes; the completion is listed by sent()
+    // after a later poll(). The caller keeps one send per socket in flight.
+    //
+    // add_receiver() returns false when the backend has no such path; the caller then
+    // registers the socket for readiness and reads and writes it itself.
+    struct Received {
+        int fd;
+        int32_t res;                // bytes received, 0 at end of stream, -errno on error
+        uint16_t buffer;            // the poller buffer holding the bytes, when res > 0
+        const uint8_t* data;
+    };
+    struct Sent {
+        int fd;
+        int32_t res;                // bytes sent or -errno
+    };
+    virtual bool add_receiver(int fd) { (void)fd; return false; }
+    virtual void release_buffer(uint16_t buffer) { (void)buffer; }
+    virtual std::span<const Received> received() const { return {}; }
+    virtual bool submit_send(int fd, std::span<const iovec> iov, std::span<FrameRef> frames) {
+        (void)fd; (void)iov; (void)frames;
+        return false;
+    }
+    virtual std::span<const Sent> sent() const { return {}; }
+
+    virtual const char* name() const = 0;
+};
+
+// Create a poller for the requested backend. Falls back to epoll when io_uring is unavailable.
+std::unique_ptr<Poller> make_poller(PollerBackend backend);
+
+std::optional<PollerBackend> parse_poller_backend(std::string_view name);
+
+} // namespace net
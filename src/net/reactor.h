@@ -9,9 +9,10 @@
 #include <unistd.h>
 
 #include "i_event_handler.h"
-#include "epoll_poller.h"
+#include "poller.h"
 #include "concurrency/cpu_affinity.h"
 #include "common/debug.h"
+#include "types/context.h"
 
 // Basic Reactor interface and main/io reactor skeleton.
 // This is a lightweight framework demonstrating integration with lock-free queues.
@@ -26,7 +27,8 @@ struct FdEvent {
 
 class ReactorBase {
 public:
-    ReactorBase(int core_id = -1): core_id_(core_id) {}
+    ReactorBase(int core_id = -1, PollerBackend backend = PollerBackend::Epoll)
+        : poller_(make_poller(backend)), core_id_(core_id) {}
     virtual ~ReactorBase() { stop(); }
 
     // Usage: create reactor with a desired core id.
@@ -47,11 +49,17 @@ public:
         }
     }
 
-    int epoll_fd() const { return epoll_poller_.epoll_fd(); }
+    const char* poller_name() const { return poller_->name(); }
+
+    // True on the thread running loop(); state owned by the loop must only be touched there.
+    bool in_loop_thread() const {
+        return loop_thread_id_.load(std::memory_order_acquire) == std::this_thread::get_id();
+    }
 
 protected:
     virtual void loop() = 0;
     void run_with_affinity() {
+        loop_thread_id_.store(std::this_thread::get_id(), std::memory_order_release);
         if (core_id_ >= 0) {
             if (!concurrency::set_current_thread_affinity(core_id_)) {
                 RUNTIME_ERROR("[reactor] failed to bind core %d\n", core_id_);
@@ -61,14 +69,19 @@ protected:
     }
 protected:
     std::atomic<bool> running_{false};
-    EpollPoller epoll_poller_{};
+    std::unique_ptr<Poller> poller_;
     std::thread thread_{};
+    std::atomic<std::thread::id> loop_thread_id_{};
     int core_id_{-1};
 };
 
 // Forward declaration
 class IOReactor;
 
+inline PollerBackend poller_backend_of(const ServerContext::Ptr& server_context) {
+    return server_context ? server_context->poller_backend : PollerBackend::Epoll;
+}
+
 using TaskFn = std::function<void()>;
 
 } // namespace net
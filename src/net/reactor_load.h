@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace net {
+
+// Snapshot of an IOReactor's live load, used for connection placement and migration.
+struct ReactorLoad {
+    int reactor_id{-1};
+    std::size_t connections{0};
+    uint64_t rx_bytes_per_sec{0};
+    uint64_t tx_bytes_per_sec{0};
+    std::size_t queue_depth{0};      // responses waiting in the reactor's ResponseQueue
+    std::size_t idle_connections{0}; // connections between requests (migratable)
+    uint64_t pending_out_bytes{0};   // sum of all connections' unsent outbound bytes
+    uint64_t max_conn_pending_bytes{0};
+    uint64_t write_stalls{0};        // times a connection had to wait for EPOLLOUT (cumulative)
+    std::size_t timers{0};           // armed timers (connection timeouts, housekeeping)
+
+    // One connection-equivalent per connection, per MB/s of traffic, per MB of unsent
+    // output and per queued response.
+    double score() const {
+        constexpr double kBytesPerConnection = 1024.0 * 1024.0;
+        return static_cast<double>(connections)
+             + static_cast<double>(rx_bytes_per_sec + tx_bytes_per_sec + pending_out_bytes) / kBytesPerConnection
+             + static_cast<double>(queue_depth);
+    }
+};
+
+} // namespace net
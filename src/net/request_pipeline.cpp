@@ -0,0 +1,44 @@
+#include "request_pipeline.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace net {
+
+namespace {
+
+std::size_t window_bits(uint32_t depth) {
+    return static_cast<std::size_t>(std::bit_width(std::max<uint32_t>(depth, 1) - 1));
+}
+
+} // namespace
+
+RequestPipeline::RequestPipeline(uint32_t depth)
+    : ordered_(window_bits(depth)), depth_(std::max<uint32_t>(depth, 1)) {}
+
+uint64_t RequestPipeline::begin() {
+    uint64_t seq = next_seq_++;
+    outstanding_.fetch_add(1, std::memory_order_acq_rel);
+    ordered_.expect_until(next_seq_);
+    return seq;
+}
+
+std::size_t RequestPipeline::complete(uint64_t seq, Deliver deliver) {
+    // A null callback still fills the slot; drain() skips it.
+    ordered_.push(seq, std::move(deliver));
+    std::size_t delivered = 0;
+    // One drainer at a time keeps deliveries in order. The fences pair a completion that finds
+    // the drainer busy with the drainer's final head check, so neither can miss the other.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (!draining_.exchange(true, std::memory_order_acq_rel)) {
+        std::size_t n = ordered_.drain([](Deliver&& d) { d(); });
+        outstanding_.fetch_sub(static_cast<uint32_t>(n), std::memory_order_acq_rel);
+        delivered += n;
+        draining_.store(false, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!ordered_.head_ready()) break;
+    }
+    return delivered;
+}
+
+} // namespace net
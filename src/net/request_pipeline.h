@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+#include "concurrency/ordered_callback_queue.h"
+
+namespace net {
+
+// Requests of one connection that run concurrently on the thread pool but must be answered in
+// the order they arrived. The reactor numbers requests with begin(); whichever worker completes
+// the oldest outstanding request delivers its responses and those of every later request that
+// is already done. A request completing out of order only parks its delivery.
+class RequestPipeline {
+public:
+    using Deliver = std::function<void()>;
+
+    static constexpr uint32_t kDefaultDepth = 64;
+
+    explicit RequestPipeline(uint32_t depth = kDefaultDepth);
+
+    // Reactor thread.
+    bool full() const { return outstanding() >= depth_; }
+    uint64_t begin();
+
+    // Any thread, once per begin(). `deliver` hands the request's responses to the reactor
+    // (may be empty). Returns how many requests this call delivered, possibly none.
+    std::size_t complete(uint64_t seq, Deliver deliver);
+
+    uint32_t outstanding() const { return outstanding_.load(std::memory_order_acquire); }
+    uint32_t depth() const { return depth_; }
+
+private:
+    concurrency::OrderedCallbackQueue ordered_;
+    const uint32_t depth_;
+    uint64_t next_seq_{0};                  // reactor thread only
+    std::atomic<uint32_t> outstanding_{0};  // begun and not yet delivered
+    std::atomic<bool> draining_{false};
+};
+
+} // namespace net
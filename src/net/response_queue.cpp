@@ -5,47 +5,61 @@
 
 #include "common/debug.h"
 #include "i_event_handler.h"
-#include "types/message.h"
 #include "lockfreequeue/array_mpmc_queue.hpp"
+#include "utils/log.h"
 
 namespace net {
 
 
-bool ResponseQueue::submit(int fd, Message&& response) {
-    if (push(fd, std::move(response))) {
-        uint64_t value = 1;
-        ssize_t n = ::write(eventfd_, &value, sizeof(value));
-        if (n != sizeof(value)) {
-            error_cpp20("Failed to write to eventfd: " +  std::string(strerror(errno)));
-            return false;
+bool ResponseQueue::submit(int fd, uint32_t generation, FrameRef response) {
+    push(ResponseTask{fd, generation, std::move(response), {}});
+    return notify();
+}
+
+bool ResponseQueue::submit_source(int fd, uint32_t generation, OutboundSource source) {
+    push(ResponseTask{fd, generation, FrameRef{}, std::move(source)});
+    return notify();
+}
+
+bool ResponseQueue::submit_resume(int fd, uint32_t generation) {
+    push(ResponseTask{fd, generation, FrameRef{}, {}});
+    return notify();
+}
+
+bool ResponseQueue::push(ResponseTask&& task) {
+    if (!has_overflow_.load(std::memory_order_acquire)) {
+        for (int i = 0; i < 3; ++i) {
+            if (queue_.try_push(std::move(task))) {
+                return true;
+            }
         }
-        return true;
-    } else {
-        error_cpp20("Response queue is full, dropping response");
-        return false;
     }
+    std::lock_guard<std::mutex> lock(overflow_mutex_);
+    if (overflow_.empty()) LOG_WARN("[ResponseQueue] ring full ({} slots), queueing in overflow", queue_.capacity());
+    overflow_.push_back(std::move(task));
+    overflow_size_.store(overflow_.size(), std::memory_order_relaxed);
+    has_overflow_.store(true, std::memory_order_release);
+    return false;
+}
+
+bool ResponseQueue::notify() {
+    submitted_.fetch_add(1, std::memory_order_relaxed);
+    return signal();
 }
 
-void ResponseQueue::on_readable() {
-    uint64_t count;
-    ssize_t n = ::read(eventfd_, &count, sizeof(count));
-    if (n != sizeof(count)) {
-        error_cpp20("Failed to read from eventfd:" + std::string(strerror(errno)));
+bool ResponseQueue::signal() {
+    if (signaled_.exchange(true, std::memory_order_acq_rel)) {
+        return true;    // reactor already woken, it will see this task
     }
-    for (uint64_t i = 0; i < count; ++i) {
-        ResponseTask task;
-        if (pop(task)) {
-            Message& msg = task.message;
-            log_cpp20("Sending message to fd " + std::to_string(task.fd) + ": " + 
-                      std::string(reinterpret_cast<char*>(msg.body), msg.header.length));
-            int fd = task.fd;
-            ssize_t nsent = ::send(fd, &msg, sizeof(msg.header) + msg.header.length, MSG_WAITALL);
-            if (nsent < 0) {
-                error_cpp20("Failed to send message: " + std::string(strerror(errno)));
-            }
-            log_cpp20("Header length " + std::to_string(msg.header.length) + " Sent " + std::to_string(nsent) + " bytes to fd " + std::to_string(fd));
-        }
+    wakeups_.fetch_add(1, std::memory_order_relaxed);
+    uint64_t value = 1;
+    ssize_t n = ::write(eventfd_, &value, sizeof(value));
+    if (n != sizeof(value)) {
+        signaled_.store(false, std::memory_order_release);
+        error_cpp20("Failed to write to eventfd: " +  std::string(strerror(errno)));
+        return false;
     }
+    return true;
 }
 
-} // namespace net
\ No newline at end of file
+} // namespace net
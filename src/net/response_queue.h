@@ -2,15 +2,32 @@
 
 #include <sys/eventfd.h>
 #include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 #include "common/debug.h"
 #include "i_event_handler.h"
-#include "types/message.h"
+#include "frame_buffer.h"
+#include "outbound_buffer.h"
 #include "lockfreequeue/array_mpmc_queue.hpp"
 
 namespace net {
 
+// Hands responses produced on worker threads over to the owning IO reactor.
+// The reactor drains it and appends each response to the connection's OutboundBuffer;
+// nothing here touches the socket.
+//
+// Wakeups are coalesced: the eventfd is written only by the submit that finds the queue
+// unsignalled, so a burst of responses costs one write and one reactor wakeup.
+//
+// Nothing is ever dropped. A task that finds the ring full goes to an overflow list, and so
+// does every task submitted after it until the reactor has drained the list, so a producer's
+// tasks keep their order. Neither admission nor the ring size has to bound the responses in
+// flight: busy replies, streams and transfer output are not admitted at all.
 class ResponseQueue {
 
 public:
@@ -30,37 +47,94 @@ public:
 
     int getEventFd() const { return eventfd_; }
 
-    bool push(int fd, Message&& response) {
-        for (int i = 0; i < 3; ++i) {
-            if (queue_.try_push(ResponseTask{fd, std::move(response)})) {
-                return true;
+    // Responses waiting to be picked up by the reactor (load sampling).
+    std::size_t depth() const { return queue_.size() + overflowed(); }
+    std::size_t capacity() const { return queue_.capacity(); }
+    uint64_t submitted() const { return submitted_.load(std::memory_order_relaxed); }
+    uint64_t wakeups() const { return wakeups_.load(std::memory_order_relaxed); }
+
+    // generation is the connection's slab generation, so a late response never reaches a reused fd.
+    // The task is always queued; false means the reactor could not be woken (eventfd write
+    // failed) and the task waits for its next drain.
+    bool submit(int fd, uint32_t generation, FrameRef response);
+    // Attach a streaming body producer to fd, ordered after previously submitted responses.
+    bool submit_source(int fd, uint32_t generation, OutboundSource source);
+    // Ask the reactor to resume decoding input it held back while a request was in flight.
+    bool submit_resume(int fd, uint32_t generation);
+    // Tasks waiting in the overflow list (load sampling, tests).
+    std::size_t overflowed() const { return overflow_size_.load(std::memory_order_relaxed); }
+
+    // Reactor side: consume the eventfd and hand every queued task to
+    // deliver(fd, generation, frame, source). source is empty for plain frames; a task with
+    // neither frame nor source is a resume request.
+    // Returns the number of tasks delivered.
+    template <typename Fn>
+    size_t drain(Fn&& deliver) {
+        uint64_t count;
+        ssize_t n = ::read(eventfd_, &count, sizeof(count));
+        if (n != sizeof(count) && errno != EAGAIN) {
+            error_cpp20("Failed to read from eventfd:" + std::string(strerror(errno)));
+        }
+        // Re-arm before draining: a submit that lands after this point signals again, one that
+        // landed before is visible to the pops below (acq_rel pairs with the producer's exchange).
+        signaled_.exchange(false, std::memory_order_acq_rel);
+        // Bounded so producers that never pause cannot starve the rest of the loop.
+        const size_t budget = queue_.capacity();
+        size_t delivered = 0;
+        ResponseTask task;
+        bool ring_empty = false;
+        while (delivered < budget) {
+            if (!queue_.try_pop(task)) {
+                ring_empty = true;
+                break;
             }
+            deliver(task.fd, task.generation, task.frame, task.source);
+            task.frame.reset();
+            task.source = nullptr;
+            ++delivered;
+        }
+        if (!ring_empty) ring_empty = queue_.empty();
+        // Overflowed tasks are behind everything in the ring; only once that is out.
+        if (ring_empty && has_overflow_.load(std::memory_order_acquire)) {
+            std::vector<ResponseTask> overflow;
+            {
+                std::lock_guard<std::mutex> lock(overflow_mutex_);
+                overflow.swap(overflow_);
+                overflow_size_.store(0, std::memory_order_relaxed);
+                has_overflow_.store(false, std::memory_order_release);
+            }
+            for (auto& t : overflow) {
+                deliver(t.fd, t.generation, t.frame, t.source);
+                ++delivered;
+            }
+        }
+        if (!ring_empty) {
+            signal();
         }
-        return false;
+        return delivered;
     }
 
-    
-
-    bool submit(int fd, Message&& response);
-
-    void on_readable();
-
 private:
     struct ResponseTask {
         int fd{-1};
-        Message message;
+        uint32_t generation{0};
+        FrameRef frame{};
+        OutboundSource source{};
     };
 
-    bool pop(ResponseTask& response) {
-        for (int i = 0; i < 3; ++i) {
-            if (queue_.try_pop(response)) {
-                return true;
-            }
-        }
-        return false;
-    }
+    bool push(ResponseTask&& task);
+    bool notify();
+    bool signal();
 
     int eventfd_{-1};
+    // Tasks that found the ring full, and the ones submitted behind them.
+    std::mutex overflow_mutex_;
+    std::vector<ResponseTask> overflow_;
+    std::atomic<std::size_t> overflow_size_{0};
+    std::atomic<bool> has_overflow_{false};
+    std::atomic<bool> signaled_{false};     // eventfd written and not yet drained
+    std::atomic<uint64_t> submitted_{0};
+    std::atomic<uint64_t> wakeups_{0};
     lf::ArrayMPMCQueue<ResponseTask> queue_;
 };
-} // namespace net
\ No newline at end of file
+} // namespace net
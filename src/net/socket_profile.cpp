@@ -0,0 +1,128 @@
+#include "socket_profile.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#include "common/debug.h"
+
+namespace net {
+
+namespace {
+
+enum Option { kNoDelay, kCork, kNotSentLowat, kBusyPoll, kRcvLowat, kSndBuf, kRcvBuf, kCongestion, kOptionCount };
+
+const char* const kOptionNames[kOptionCount] = {
+    "TCP_NODELAY", "TCP_CORK", "TCP_NOTSENT_LOWAT", "SO_BUSY_POLL",
+    "SO_RCVLOWAT", "SO_SNDBUF", "SO_RCVBUF", "TCP_CONGESTION"
+};
+
+// A refused option (EPERM for busy poll, unknown congestion module) fails on every
+// connection; report it once instead of once per socket.
+std::atomic<bool> g_reported[kOptionCount];
+
+bool set_option(int fd, Option option, int level, int name, const void* value, socklen_t len) {
+    if (::setsockopt(fd, level, name, value, len) == 0) return true;
+    if (!g_reported[option].exchange(true, std::memory_order_relaxed)) {
+        error_cpp20(std::string("[SocketProfile] setsockopt(") + kOptionNames[option] + ") failed: " + strerror(errno));
+    }
+    return false;
+}
+
+bool set_int(int fd, Option option, int level, int name, int value) {
+    return set_option(fd, option, level, name, &value, sizeof(value));
+}
+
+// The table of the connection's current reactor, defaults when none was configured.
+const SocketProfiles& profiles_of(const ConnectionContext& ctx) {
+    static const SocketProfiles kDefaults = SocketProfiles::defaults();
+    const auto& reactor = ctx.reactor_context;
+    return reactor && reactor->socket_profiles ? *reactor->socket_profiles : kDefaults;
+}
+
+} // namespace
+
+const SocketProfile& SocketProfiles::operator[](SocketProfileKind kind) const {
+    switch (kind) {
+        case SocketProfileKind::BulkUpload: return bulk_upload;
+        case SocketProfileKind::BulkDownload: return bulk_download;
+        case SocketProfileKind::Control: break;
+    }
+    return control;
+}
+
+SocketProfiles SocketProfiles::defaults() {
+    SocketProfiles p;
+    // Replies go out as one vectored write, but a header and body sent back to back must
+    // not wait for the client's delayed ACK.
+    p.control.nodelay = 1;
+    // Wake the reactor per 64KB of spliced body instead of per segment.
+    p.bulk_upload.nodelay = 1;
+    p.bulk_upload.rcvlowat = 64 * 1024;
+    // Keep unsent data in the socket close to OutboundBuffer::kLowWatermark: EPOLLOUT then
+    // fires while there is still enough queued to keep the link busy, and the rest of the
+    // file stays in the page cache rather than in socket memory.
+    p.bulk_download.nodelay = 1;
+    p.bulk_download.notsent_lowat = 256 * 1024;
+    return p;
+}
+
+const char* socket_profile_name(SocketProfileKind kind) {
+    switch (kind) {
+        case SocketProfileKind::Control: return "control";
+        case SocketProfileKind::BulkUpload: return "bulk-upload";
+        case SocketProfileKind::BulkDownload: return "bulk-download";
+    }
+    return "unknown";
+}
+
+std::optional<SocketProfileKind> parse_socket_profile(std::string_view name) {
+    if (name == "control") return SocketProfileKind::Control;
+    if (name == "bulk-upload") return SocketProfileKind::BulkUpload;
+    if (name == "bulk-download") return SocketProfileKind::BulkDownload;
+    return std::nullopt;
+}
+
+int apply_socket_profile(int fd, const SocketProfile& to, const SocketProfile* from) {
+    int failed = 0;
+    auto changed = [&](int SocketProfile::*field) { return !from || from->*field != to.*field; };
+
+    // Uncork last so that anything corked goes out with the final option set.
+    if (to.cork && changed(&SocketProfile::cork)) failed += !set_int(fd, kCork, IPPROTO_TCP, TCP_CORK, 1);
+    if (changed(&SocketProfile::nodelay)) failed += !set_int(fd, kNoDelay, IPPROTO_TCP, TCP_NODELAY, to.nodelay);
+    if (changed(&SocketProfile::notsent_lowat)) {
+        failed += !set_int(fd, kNotSentLowat, IPPROTO_TCP, TCP_NOTSENT_LOWAT, to.notsent_lowat);
+    }
+    if (changed(&SocketProfile::busy_poll_us)) failed += !set_int(fd, kBusyPoll, SOL_SOCKET, SO_BUSY_POLL, to.busy_poll_us);
+    if (to.sndbuf > 0 && changed(&SocketProfile::sndbuf)) failed += !set_int(fd, kSndBuf, SOL_SOCKET, SO_SNDBUF, to.sndbuf);
+    if (to.rcvbuf > 0 && changed(&SocketProfile::rcvbuf)) failed += !set_int(fd, kRcvBuf, SOL_SOCKET, SO_RCVBUF, to.rcvbuf);
+    if (!to.congestion.empty() && (!from || from->congestion != to.congestion)) {
+        failed += !set_option(fd, kCongestion, IPPROTO_TCP, TCP_CONGESTION,
+                              to.congestion.data(), static_cast<socklen_t>(to.congestion.size()));
+    }
+    if (!to.cork && changed(&SocketProfile::cork)) failed += !set_int(fd, kCork, IPPROTO_TCP, TCP_CORK, 0);
+    return failed;
+}
+
+bool set_socket_rcvlowat(int fd, int bytes) {
+    return set_int(fd, kRcvLowat, SOL_SOCKET, SO_RCVLOWAT, bytes > 0 ? bytes : 1);
+}
+
+void use_socket_profile(ConnectionContext& ctx, SocketProfileKind to) {
+    SocketProfileKind from = ctx.socket_profile.exchange(to, std::memory_order_acq_rel);
+    if (from == to) return;
+    const SocketProfiles& profiles = profiles_of(ctx);
+    apply_socket_profile(ctx.connection_id, profiles[to], &profiles[from]);
+}
+
+void leave_socket_profile(ConnectionContext& ctx, SocketProfileKind from) {
+    if (from == SocketProfileKind::Control) return;
+    if (!ctx.socket_profile.compare_exchange_strong(from, SocketProfileKind::Control, std::memory_order_acq_rel)) return;
+    const SocketProfiles& profiles = profiles_of(ctx);
+    apply_socket_profile(ctx.connection_id, profiles.control, &profiles[from]);
+}
+
+} // namespace net
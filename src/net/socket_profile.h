@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "types/context.h"
+
+namespace net {
+
+// What a connection is currently doing, selecting the socket options it runs with.
+enum class SocketProfileKind : uint8_t {
+    Control = 0,        // request/response traffic: small frames, latency bound
+    BulkUpload = 1,     // client -> server file body
+    BulkDownload = 2    // server -> client file body
+};
+
+// Socket options of one profile. Switching profiles only issues setsockopt for the options
+// that differ from the profile being left. Buffer sizes and the congestion control algorithm
+// are one-way: a fixed SO_SNDBUF/SO_RCVBUF disables autotuning for the rest of the connection,
+// so 0 / empty means "leave as is".
+//
+// SO_RCVLOWAT is per connection rather than per profile: EPOLLIN stays quiet until that many
+// bytes are queued, so it must never exceed what the peer still has to send. Handlers that
+// know the remaining length set it with set_socket_rcvlowat() and reset it to 1.
+struct SocketProfile {
+    int nodelay{0};             // TCP_NODELAY
+    int cork{0};                // TCP_CORK
+    int notsent_lowat{0};       // TCP_NOTSENT_LOWAT bytes, 0 = net.ipv4.tcp_notsent_lowat
+    int busy_poll_us{0};        // SO_BUSY_POLL, raising it above net.core.busy_read needs CAP_NET_ADMIN
+    int rcvlowat{1};            // SO_RCVLOWAT cap for raw (spliced) uploads, see above
+    int sndbuf{0};              // SO_SNDBUF, 0 = autotuned
+    int rcvbuf{0};              // SO_RCVBUF, 0 = autotuned
+    std::string congestion{};   // TCP_CONGESTION, empty = system default
+
+    // What a fresh accepted socket has.
+    static SocketProfile kernel_defaults() { return SocketProfile{}; }
+};
+
+// The profile table of one IO reactor (ReactorContext::socket_profiles).
+struct SocketProfiles {
+    SocketProfile control;
+    SocketProfile bulk_upload;
+    SocketProfile bulk_download;
+
+    const SocketProfile& operator[](SocketProfileKind kind) const;
+
+    static SocketProfiles defaults();
+};
+
+const char* socket_profile_name(SocketProfileKind kind);
+std::optional<SocketProfileKind> parse_socket_profile(std::string_view name);
+
+// Set the options of `to` on fd, skipping those equal in `from` (nullptr: set all).
+// Best effort; returns the number of options the kernel refused (each kind is logged once).
+int apply_socket_profile(int fd, const SocketProfile& to, const SocketProfile* from = nullptr);
+bool set_socket_rcvlowat(int fd, int bytes);
+
+// Switch a connection's profile, using its reactor's table. Callable from any thread.
+void use_socket_profile(ConnectionContext& ctx, SocketProfileKind to);
+// Back to Control, unless another transfer switched the connection away from `from` meanwhile.
+void leave_socket_profile(ConnectionContext& ctx, SocketProfileKind from);
+
+} // namespace net
@@ -0,0 +1,184 @@
+#include "timer_wheel.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace net {
+
+TimerWheel::TimerWheel(std::chrono::milliseconds tick, Clock::time_point start)
+    : tick_(tick.count() > 0 ? tick : std::chrono::milliseconds(1)), start_(start) {
+    std::fill(std::begin(heads_), std::end(heads_), kNil);
+}
+
+TimerWheel::TimerId TimerWheel::arm(std::chrono::milliseconds delay, Callback cb) {
+    uint64_t ticks = delay.count() <= 0 ? 1 : (delay.count() + tick_.count() - 1) / tick_.count();
+    uint32_t idx = allocate();
+    Node& n = nodes_[idx];
+    n.cb = std::move(cb);
+    n.expires = now_ + ticks;
+    n.active = true;
+    link(idx);
+    ++size_;
+    return (static_cast<uint64_t>(n.generation) << 32) | idx;
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    if (!armed(id)) return false;
+    uint32_t idx = static_cast<uint32_t>(id);
+    unlink(idx);
+    release(idx);
+    --size_;
+    return true;
+}
+
+bool TimerWheel::armed(TimerId id) const {
+    uint32_t idx = static_cast<uint32_t>(id);
+    uint32_t generation = static_cast<uint32_t>(id >> 32);
+    return idx < nodes_.size() && nodes_[idx].active && nodes_[idx].generation == generation;
+}
+
+std::size_t TimerWheel::advance(Clock::time_point now) {
+    if (now <= start_) return 0;
+    uint64_t target = static_cast<uint64_t>((now - start_) / tick_);
+    std::size_t fired = 0;
+    while (now_ < target) {
+        if (size_ == 0) {
+            now_ = target;
+            break;
+        }
+        // Jump over empty level-0 slots up to the end of the current 64-tick block;
+        // the tick that wraps into the next block has to run for the cascade.
+        uint64_t stop = std::min(now_ | kSlotMask, target);
+        if (stop > now_) {
+            uint32_t from = static_cast<uint32_t>(now_ & kSlotMask) + 1;
+            uint32_t to = static_cast<uint32_t>(stop & kSlotMask);
+            uint64_t range = (to == kSlotMask ? ~uint64_t(0) : (uint64_t(1) << (to + 1)) - 1)
+                           & ~((uint64_t(1) << from) - 1);
+            if ((occupied_[0] & range) == 0) {
+                now_ = stop;
+                continue;
+            }
+        }
+        fired += tick_once();
+    }
+    return fired;
+}
+
+int TimerWheel::next_timeout_ms(Clock::time_point now, int cap_ms) const {
+    if (size_ == 0) return cap_ms;
+
+    uint64_t ahead = UINT64_MAX;   // ticks after now_ until the wheel has work
+    if (occupied_[0]) {
+        // bit k of the rotated mask is the slot k + 1 ticks ahead
+        uint64_t rotated = std::rotr(occupied_[0], static_cast<int>((now_ + 1) & kSlotMask));
+        ahead = static_cast<uint64_t>(std::countr_zero(rotated)) + 1;
+    }
+    for (int level = 1; level < kLevels; ++level) {
+        if (!occupied_[level]) continue;
+        // next cascade of an occupied slot: the start of that slot's block
+        int shift = level * kSlotBits;
+        uint64_t block = now_ >> shift;
+        uint64_t rotated = std::rotr(occupied_[level], static_cast<int>((block + 1) & kSlotMask));
+        uint64_t at = (block + 1 + static_cast<uint64_t>(std::countr_zero(rotated))) << shift;
+        ahead = std::min(ahead, at - now_);
+    }
+
+    auto deadline = start_ + tick_ * static_cast<int64_t>(now_ + ahead);
+    if (deadline <= now) return 0;
+    auto wait = std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count();
+    return wait < cap_ms ? static_cast<int>(wait) : cap_ms;
+}
+
+void TimerWheel::link(uint32_t idx) {
+    Node& n = nodes_[idx];
+    // n.expires >= now_ always holds: arm() adds at least one tick, cascades run at block starts.
+    uint64_t delta = n.expires - now_;
+    uint64_t slot_tick = n.expires;
+    if (delta > kMaxDelta) {
+        delta = kMaxDelta;
+        slot_tick = now_ + kMaxDelta;
+    }
+    int level = delta < kSlots ? 0 : std::min(static_cast<int>(std::bit_width(delta) - 1) / kSlotBits, kLevels - 1);
+    uint32_t slot = static_cast<uint32_t>((slot_tick >> (level * kSlotBits)) & kSlotMask);
+    uint32_t bucket = static_cast<uint32_t>(level) * kSlots + slot;
+
+    n.bucket = static_cast<uint16_t>(bucket);
+    n.prev = kNil;
+    n.next = heads_[bucket];
+    if (n.next != kNil) nodes_[n.next].prev = idx;
+    heads_[bucket] = idx;
+    occupied_[level] |= uint64_t(1) << slot;
+}
+
+void TimerWheel::unlink(uint32_t idx) {
+    Node& n = nodes_[idx];
+    if (n.prev != kNil) {
+        nodes_[n.prev].next = n.next;
+    } else {
+        heads_[n.bucket] = n.next;
+        if (n.next == kNil) occupied_[n.bucket / kSlots] &= ~(uint64_t(1) << (n.bucket % kSlots));
+    }
+    if (n.next != kNil) nodes_[n.next].prev = n.prev;
+    n.prev = n.next = kNil;
+}
+
+void TimerWheel::cascade(int level) {
+    uint32_t slot = static_cast<uint32_t>((now_ >> (level * kSlotBits)) & kSlotMask);
+    uint32_t bucket = static_cast<uint32_t>(level) * kSlots + slot;
+    // Detach first: clamped far-future timers may land in this very slot again.
+    uint32_t idx = heads_[bucket];
+    heads_[bucket] = kNil;
+    occupied_[level] &= ~(uint64_t(1) << slot);
+    while (idx != kNil) {
+        uint32_t next = nodes_[idx].next;
+        link(idx);
+        idx = next;
+    }
+}
+
+std::size_t TimerWheel::expire_current() {
+    uint32_t bucket = static_cast<uint32_t>(now_ & kSlotMask);
+    std::size_t fired = 0;
+    // Callbacks only ever arm timers for later ticks, so popping the live list terminates.
+    while (heads_[bucket] != kNil) {
+        uint32_t idx = heads_[bucket];
+        unlink(idx);
+        Callback cb = std::move(nodes_[idx].cb);
+        release(idx);
+        --size_;
+        ++fired;
+        if (cb) cb();
+    }
+    return fired;
+}
+
+std::size_t TimerWheel::tick_once() {
+    ++now_;
+    for (int level = 1; level < kLevels; ++level) {
+        if ((now_ & ((uint64_t(1) << (level * kSlotBits)) - 1)) != 0) break;
+        cascade(level);
+    }
+    return expire_current();
+}
+
+uint32_t TimerWheel::allocate() {
+    if (free_head_ != kNil) {
+        uint32_t idx = free_head_;
+        free_head_ = nodes_[idx].next;
+        nodes_[idx].next = kNil;
+        return idx;
+    }
+    nodes_.emplace_back();
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+void TimerWheel::release(uint32_t idx) {
+    Node& n = nodes_[idx];
+    n.cb = nullptr;
+    n.active = false;
+    if (++n.generation == 0) n.generation = 1;
+    n.next = free_head_;
+    free_head_ = idx;
+}
+
+} // namespace net
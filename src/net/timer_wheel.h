@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace net {
+
+// Hierarchical hashed timing wheel, one per IO reactor, reactor thread only.
+//
+// Four levels of 64 slots: a level-L slot spans 64^L ticks, so with the default 10ms tick
+// level 0 covers 640ms and level 3 about 46 hours (longer delays are clamped and cascaded
+// again). Timers are intrusive doubly linked list nodes in a single array, which makes arm
+// and cancel O(1) without a heap allocation per timer once the array has grown. A bitmap of
+// occupied slots per level lets advance() skip empty ticks and next_timeout_ms() find the
+// next deadline without scanning.
+//
+// Callbacks run inside advance() and may arm or cancel timers, including their own successor.
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void()>;
+    // Node index + generation; 0 is never returned. Ids go stale once their timer fired or was cancelled.
+    using TimerId = uint64_t;
+
+    explicit TimerWheel(std::chrono::milliseconds tick = std::chrono::milliseconds(10),
+                        Clock::time_point start = Clock::now());
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // Fire cb once, on the first tick at least `delay` after the wheel's current time.
+    TimerId arm(std::chrono::milliseconds delay, Callback cb);
+    // False if the timer already fired, was cancelled, or id is 0.
+    bool cancel(TimerId id);
+    bool armed(TimerId id) const;
+
+    // Run every timer due at `now`. Returns the number of callbacks invoked.
+    std::size_t advance(Clock::time_point now);
+    // How long poll() may sleep before the wheel has work again, capped at cap_ms.
+    int next_timeout_ms(Clock::time_point now, int cap_ms) const;
+
+    std::size_t size() const { return size_; }
+    std::chrono::milliseconds tick() const { return tick_; }
+
+private:
+    static constexpr int kLevels = 4;
+    static constexpr int kSlotBits = 6;
+    static constexpr uint32_t kSlots = 1u << kSlotBits;
+    static constexpr uint64_t kSlotMask = kSlots - 1;
+    static constexpr uint64_t kMaxDelta = (uint64_t(1) << (kLevels * kSlotBits)) - 1;
+    static constexpr uint32_t kNil = UINT32_MAX;
+
+    struct Node {
+        Callback cb{};
+        uint64_t expires{0};        // absolute tick
+        uint32_t prev{kNil};
+        uint32_t next{kNil};        // doubles as the free list link
+        uint32_t generation{1};
+        uint16_t bucket{0};         // level * kSlots + slot
+        bool active{false};
+    };
+
+    void link(uint32_t idx);
+    void unlink(uint32_t idx);
+    void cascade(int level);
+    std::size_t expire_current();
+    std::size_t tick_once();
+    uint32_t allocate();
+    void release(uint32_t idx);
+
+    std::chrono::milliseconds tick_;
+    Clock::time_point start_;
+    uint64_t now_{0};               // last processed tick
+    std::size_t size_{0};
+
+    std::vector<Node> nodes_;
+    uint32_t free_head_{kNil};
+    uint32_t heads_[kLevels * kSlots];
+    uint64_t occupied_[kLevels]{};
+};
+
+} // namespace net
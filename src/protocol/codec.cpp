@@ -0,0 +1,281 @@
+#include "codec.h"
+
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+namespace protocol {
+
+namespace {
+
+using nlohmann::json;
+
+template <typename V> struct is_optional : std::false_type {};
+template <typename V> struct is_optional<std::optional<V>> : std::true_type {};
+
+template <typename T>
+constexpr uint8_t tag_of() {
+    if constexpr (requires { T::kCommand; }) return static_cast<uint8_t>(T::kCommand);
+    else return static_cast<uint8_t>(T::kKind);
+}
+
+// ---- binary ----
+
+void put_varint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+template <typename V>
+void put_value(std::string& out, const V& v) {
+    if constexpr (std::is_same_v<V, bool>) {
+        out.push_back(v ? 1 : 0);
+    } else if constexpr (std::is_integral_v<V> && std::is_unsigned_v<V>) {
+        put_varint(out, v);
+    } else if constexpr (std::is_integral_v<V>) {
+        auto s = static_cast<int64_t>(v);
+        put_varint(out, (static_cast<uint64_t>(s) << 1) ^ static_cast<uint64_t>(s >> 63));
+    } else if constexpr (std::is_same_v<V, std::string>) {
+        put_varint(out, v.size());
+        out.append(v);
+    } else {
+        static_assert(is_optional<V>::value, "unsupported field type");
+        out.push_back(v ? 1 : 0);
+        if (v) put_value(out, *v);
+    }
+}
+
+struct Reader {
+    const uint8_t* p;
+    const uint8_t* end;
+
+    bool done() const { return p == end; }
+
+    bool varint(uint64_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 64 && p != end; shift += 7) {
+            uint8_t b = *p++;
+            v |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+};
+
+template <typename V>
+bool get_value(Reader& in, V& v) {
+    if constexpr (std::is_same_v<V, bool>) {
+        if (in.done() || *in.p > 1) return false;
+        v = *in.p++ != 0;
+        return true;
+    } else if constexpr (std::is_integral_v<V> && std::is_unsigned_v<V>) {
+        uint64_t raw;
+        if (!in.varint(raw) || raw > std::numeric_limits<V>::max()) return false;
+        v = static_cast<V>(raw);
+        return true;
+    } else if constexpr (std::is_integral_v<V>) {
+        uint64_t raw;
+        if (!in.varint(raw)) return false;
+        auto s = static_cast<int64_t>((raw >> 1) ^ (~(raw & 1) + 1));
+        if (s < std::numeric_limits<V>::min() || s > std::numeric_limits<V>::max()) return false;
+        v = static_cast<V>(s);
+        return true;
+    } else if constexpr (std::is_same_v<V, std::string>) {
+        uint64_t size;
+        if (!in.varint(size) || size > static_cast<uint64_t>(in.end - in.p)) return false;
+        v.assign(reinterpret_cast<const char*>(in.p), size);
+        in.p += size;
+        return true;
+    } else {
+        if (in.done() || *in.p > 1) return false;
+        if (*in.p++ == 0) {
+            v.reset();
+            return true;
+        }
+        return get_value(in, v.emplace());
+    }
+}
+
+template <typename T>
+void encode_message(const T& msg, std::string& out) {
+    out.push_back(static_cast<char>(tag_of<T>()));
+    std::apply([&](auto... f) { (put_value(out, msg.*f.member), ...); }, T::fields());
+}
+
+template <typename T>
+bool decode_fields(Reader& in, T& msg) {
+    // A shorter body from an older peer leaves the remaining fields at their defaults.
+    return std::apply([&](auto... f) { return ((in.done() || get_value(in, msg.*f.member)) && ...); }, T::fields());
+}
+
+template <typename Variant, std::size_t I = 0>
+bool decode_alternative(uint8_t tag, Reader& in, Variant& out) {
+    if constexpr (I == std::variant_size_v<Variant>) {
+        return false;
+    } else {
+        using T = std::variant_alternative_t<I, Variant>;
+        if (tag != tag_of<T>()) return decode_alternative<Variant, I + 1>(tag, in, out);
+        T msg;
+        if (!decode_fields(in, msg)) return false;
+        out = std::move(msg);
+        return true;
+    }
+}
+
+template <typename Variant>
+std::optional<Variant> decode_message(const uint8_t* data, std::size_t size) {
+    if (size == 0) return std::nullopt;
+    Reader in{data + 1, data + size};
+    Variant out;
+    if (!decode_alternative(data[0], in, out)) return std::nullopt;
+    return out;
+}
+
+// ---- JSON ----
+
+template <typename V>
+bool get_json(const json& j, V& v) {
+    if constexpr (std::is_same_v<V, bool>) {
+        if (!j.is_boolean()) return false;
+        v = j.get<bool>();
+    } else if constexpr (std::is_integral_v<V> && std::is_unsigned_v<V>) {
+        if (j.is_number_unsigned()) {
+            auto raw = j.get<uint64_t>();
+            if (raw > std::numeric_limits<V>::max()) return false;
+            v = static_cast<V>(raw);
+        } else {
+            return false;   // negative, fractional or not a number
+        }
+    } else if constexpr (std::is_integral_v<V>) {
+        if (!j.is_number_integer()) return false;
+        if (j.is_number_unsigned()) {
+            auto raw = j.get<uint64_t>();
+            if (raw > static_cast<uint64_t>(std::numeric_limits<V>::max())) return false;
+            v = static_cast<V>(raw);
+        } else {
+            auto raw = j.get<int64_t>();
+            if (raw < std::numeric_limits<V>::min() || raw > std::numeric_limits<V>::max()) return false;
+            v = static_cast<V>(raw);
+        }
+    } else if constexpr (std::is_same_v<V, std::string>) {
+        if (!j.is_string()) return false;
+        v = j.get<std::string>();
+    } else {
+        if (j.is_null()) {
+            v.reset();
+            return true;
+        }
+        return get_json(j, v.emplace());
+    }
+    return true;
+}
+
+template <typename V>
+void put_json(json& object, std::string_view name, const V& v) {
+    if constexpr (is_optional<V>::value) {
+        if (v) object[std::string(name)] = *v;
+    } else {
+        object[std::string(name)] = v;
+    }
+}
+
+template <typename T>
+json message_fields(const T& msg) {
+    json object = json::object();
+    if constexpr (requires { T::kStatus; }) object["status"] = std::string(T::kStatus);
+    std::apply([&](auto... f) { (put_json(object, f.name, msg.*f.member), ...); }, T::fields());
+    return object;
+}
+
+template <typename T>
+json request_json(const T& msg) {
+    json j = {{"command", std::string(command_name(T::kCommand))}};
+    if constexpr (requires { T::kScalarParams; }) {
+        j["params"] = msg.*std::get<0>(T::fields()).member;
+    } else {
+        j["params"] = message_fields(msg);
+    }
+    return j;
+}
+
+template <typename T>
+json response_json(const T& msg) {
+    if constexpr (requires { T::kNested; }) {
+        return json{{"responseMessage", message_fields(msg).dump()}};
+    } else {
+        return message_fields(msg);
+    }
+}
+
+template <typename T>
+bool request_fields_from_json(const json& j, T& msg) {
+    auto params = j.find("params");
+    if (params == j.end() || params->is_null()) return true;
+    if constexpr (requires { T::kScalarParams; }) {
+        return get_json(*params, msg.*std::get<0>(T::fields()).member);
+    } else {
+        if (!params->is_object()) return std::tuple_size_v<decltype(T::fields())> == 0;
+        return std::apply([&](auto... f) {
+            return ([&] {
+                auto it = params->find(std::string(f.name));
+                return it == params->end() || get_json(*it, msg.*f.member);
+            }() && ...);
+        }, T::fields());
+    }
+}
+
+template <std::size_t I = 0>
+bool request_alternative_from_json(Command command, const json& j, Request& out) {
+    if constexpr (I == std::variant_size_v<Request>) {
+        return false;
+    } else {
+        using T = std::variant_alternative_t<I, Request>;
+        if (command != T::kCommand) return request_alternative_from_json<I + 1>(command, j, out);
+        T msg;
+        if (!request_fields_from_json(j, msg)) return false;
+        out = std::move(msg);
+        return true;
+    }
+}
+
+} // namespace
+
+void encode_request(const Request& request, std::string& out) {
+    std::visit([&](const auto& msg) { encode_message(msg, out); }, request);
+}
+
+void encode_response(const Response& response, std::string& out) {
+    std::visit([&](const auto& msg) { encode_message(msg, out); }, response);
+}
+
+std::optional<Request> decode_request(const uint8_t* data, std::size_t size) {
+    return decode_message<Request>(data, size);
+}
+
+std::optional<Response> decode_response(const uint8_t* data, std::size_t size) {
+    return decode_message<Response>(data, size);
+}
+
+json request_to_json(const Request& request) {
+    return std::visit([](const auto& msg) { return request_json(msg); }, request);
+}
+
+json response_to_json(const Response& response) {
+    return std::visit([](const auto& msg) { return response_json(msg); }, response);
+}
+
+std::optional<Request> request_from_json(const json& j) {
+    if (!j.is_object()) return std::nullopt;
+    auto name = j.find("command");
+    if (name == j.end() || !name->is_string()) return std::nullopt;
+    auto command = command_from_name(name->get_ref<const std::string&>());
+    if (!command) return std::nullopt;
+    Request out;
+    if (!request_alternative_from_json(*command, j, out)) return std::nullopt;
+    return out;
+}
+
+} // namespace protocol
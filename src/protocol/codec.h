@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "messages.h"
+#include "nlohmann/json.hpp"
+
+namespace protocol {
+
+// Codecs for the messages of protocol/messages.h.
+//
+// Binary (REQUEST/RESPONSE/ERROR frames with kFrameBinary, protocol v2 and kCapBinaryControl):
+//   body    = tag (1 byte: Command for requests, ResponseKind for responses), fields in order
+//   integer = LEB128 varint, zigzag for signed types
+//   bool    = 1 byte
+//   string  = varint length, bytes
+//   optional = 1 byte present, value if present
+// A body may end before its last fields (they keep their defaults); trailing bytes after the
+// known fields are ignored, so either side may be older.
+//
+// JSON is the v1 format and stays available on v2 for debugging; requests may use either
+// encoding and are answered in the same one.
+
+// Appends the binary body to out.
+void encode_request(const Request& request, std::string& out);
+void encode_response(const Response& response, std::string& out);
+// nullopt for an unknown tag or a truncated or malformed field.
+std::optional<Request> decode_request(const uint8_t* data, std::size_t size);
+std::optional<Response> decode_response(const uint8_t* data, std::size_t size);
+
+nlohmann::json request_to_json(const Request& request);
+nlohmann::json response_to_json(const Response& response);
+// nullopt for an unknown command or a field of the wrong type; missing fields keep defaults.
+std::optional<Request> request_from_json(const nlohmann::json& json);
+
+} // namespace protocol
@@ -1,40 +1,95 @@
 #pragma once
 
-#include <string>
-#include <unordered_map>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
 
 namespace protocol {
 
-// Enum for defining command types
-enum class CommandType {
-    LOGIN,
-    UPLOAD,
-    DOWNLOAD,
-    LIST,
-    DELETE,
-    INVALID
+// Control commands. The value is the command's tag in binary request bodies (protocol/codec.h),
+// so existing values must not change.
+enum class Command : uint8_t {
+    Ls = 1,
+    Pwd = 2,
+    Cd = 3,
+    Mkdir = 4,
+    Rm = 5,
+    Rmdir = 6,
+    Get = 7,
+    Put = 8,
+    PutDataChannel = 9,
+    Login = 10,
+    Register = 11,
+    Pubkey = 12,
+    Hello = 13,
+    Stat = 14,
+    Stats = 15
 };
 
-// Structure to represent a command
-struct Command {
-    CommandType type;
-    std::string user_id;
-    std::string file_name;
-    std::string additional_data; // For any extra data needed for the command
+// Highest Command value; values are dense from 1.
+inline constexpr uint8_t kCommandCount = 15;
+
+// The "command" string of JSON requests.
+constexpr std::string_view command_name(Command command) {
+    switch (command) {
+        case Command::Ls: return "ls";
+        case Command::Pwd: return "pwd";
+        case Command::Cd: return "cd";
+        case Command::Mkdir: return "mkdir";
+        case Command::Rm: return "rm";
+        case Command::Rmdir: return "rmdir";
+        case Command::Get: return "get";
+        case Command::Put: return "put";
+        case Command::PutDataChannel: return "put_data_channel";
+        case Command::Login: return "login";
+        case Command::Register: return "register";
+        case Command::Pubkey: return "pubkey";
+        case Command::Hello: return "hello";
+        case Command::Stat: return "stat";
+        case Command::Stats: return "stats";
+    }
+    return "";
+}
+
+namespace detail {
+
+// Perfect hash of the command names over length, first and last character; make_name_table()
+// refuses constants that let two names collide, so a new command may need new ones.
+inline constexpr std::size_t kNameSlots = 32;
+
+constexpr std::size_t name_slot(std::string_view name) {
+    return (name.size() * 14 + static_cast<uint8_t>(name.front()) + static_cast<uint8_t>(name.back()) * 3)
+        % kNameSlots;
+}
+
+struct NameTable {
+    std::array<uint8_t, kNameSlots> command{};     // Command value per slot, 0 = free
+    bool perfect{true};
 };
 
-// Function to convert string to CommandType
-inline CommandType stringToCommandType(const std::string& command_str) {
-    static const std::unordered_map<std::string, CommandType> command_map = {
-        {"login", CommandType::LOGIN},
-        {"upload", CommandType::UPLOAD},
-        {"download", CommandType::DOWNLOAD},
-        {"list", CommandType::LIST},
-        {"delete", CommandType::DELETE}
-    };
-
-    auto it = command_map.find(command_str);
-    return (it != command_map.end()) ? it->second : CommandType::INVALID;
+constexpr NameTable make_name_table() {
+    NameTable table;
+    for (uint8_t v = 1; v <= kCommandCount; ++v) {
+        auto& slot = table.command[name_slot(command_name(static_cast<Command>(v)))];
+        if (slot != 0) table.perfect = false;
+        slot = v;
+    }
+    return table;
+}
+
+inline constexpr NameTable kNameTable = make_name_table();
+static_assert(kNameTable.perfect, "two command names share a name_slot()");
+
+} // namespace detail
+
+// One hash and one compare; requests with an unknown name are rejected just as cheaply.
+constexpr std::optional<Command> command_from_name(std::string_view name) {
+    if (name.empty()) return std::nullopt;
+    uint8_t v = detail::kNameTable.command[detail::name_slot(name)];
+    if (v == 0 || command_name(static_cast<Command>(v)) != name) return std::nullopt;
+    return static_cast<Command>(v);
 }
 
-} // namespace protocol
\ No newline at end of file
+} // namespace protocol
@@ -11,7 +11,8 @@ enum class ErrorCode {
     FILE_UPLOAD_FAILED = 5,
     FILE_DOWNLOAD_FAILED = 6,
     DATABASE_ERROR = 7,
-    UNKNOWN_ERROR = 8
+    UNKNOWN_ERROR = 8,
+    SERVER_BUSY = 9         // shed by admission control, retry after "retryAfterMs"
 };
 
 #endif // ERROR_CODES_H
\ No newline at end of file
@@ -0,0 +1,305 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <variant>
+
+#include "commands.h"
+
+namespace protocol {
+
+// Schema of the control messages. Each message lists its fields once in fields(); the binary
+// and JSON codecs (protocol/codec.h) are generated from that list, so a field added here is
+// on the wire in both encodings. Fields may only be appended: binary decoders stop at the
+// end of a body and leave later fields at their defaults.
+//
+// Field types: bool, integers, std::string and std::optional of those.
+
+template <typename T, typename M>
+struct Field {
+    std::string_view name;      // JSON key
+    M T::* member;
+};
+
+template <typename T, typename M>
+constexpr Field<T, M> field(std::string_view name, M T::* member) { return {name, member}; }
+
+// ---- requests: {"command": <name>, "params": {<fields>}} in JSON ----
+
+struct LsRequest {
+    static constexpr Command kCommand = Command::Ls;
+    static constexpr auto fields() { return std::tuple{}; }
+};
+
+struct PwdRequest {
+    static constexpr Command kCommand = Command::Pwd;
+    static constexpr auto fields() { return std::tuple{}; }
+};
+
+struct CdRequest {
+    static constexpr Command kCommand = Command::Cd;
+    static constexpr bool kScalarParams = true;     // "params" is the path itself
+    std::string path{"/"};
+    static constexpr auto fields() { return std::tuple{field("path", &CdRequest::path)}; }
+};
+
+struct MkdirRequest {
+    static constexpr Command kCommand = Command::Mkdir;
+    static constexpr bool kScalarParams = true;
+    std::string path;
+    static constexpr auto fields() { return std::tuple{field("path", &MkdirRequest::path)}; }
+};
+
+struct RmRequest {
+    static constexpr Command kCommand = Command::Rm;
+    std::string file_name;
+    static constexpr auto fields() { return std::tuple{field("file_name", &RmRequest::file_name)}; }
+};
+
+struct RmdirRequest {
+    static constexpr Command kCommand = Command::Rmdir;
+    std::string dir_name;
+    static constexpr auto fields() { return std::tuple{field("dir_name", &RmdirRequest::dir_name)}; }
+};
+
+struct GetRequest {
+    static constexpr Command kCommand = Command::Get;
+    std::string file_name;
+    uint64_t offset{0};
+    static constexpr auto fields() {
+        return std::tuple{field("file_name", &GetRequest::file_name), field("offset", &GetRequest::offset)};
+    }
+};
+
+struct PutRequest {
+    static constexpr Command kCommand = Command::Put;
+    std::string file_name;
+    uint64_t file_size{0};
+    std::string file_hash;
+    static constexpr auto fields() {
+        return std::tuple{field("file_name", &PutRequest::file_name), field("file_size", &PutRequest::file_size),
+                          field("file_hash", &PutRequest::file_hash)};
+    }
+};
+
+struct PutDataChannelRequest {
+    static constexpr Command kCommand = Command::PutDataChannel;
+    std::string token;
+    std::string file_hash;
+    static constexpr auto fields() {
+        return std::tuple{field("token", &PutDataChannelRequest::token),
+                          field("file_hash", &PutDataChannelRequest::file_hash)};
+    }
+};
+
+// username and passhash are RSA-encrypted by the client (pubkey).
+struct LoginRequest {
+    static constexpr Command kCommand = Command::Login;
+    std::string username;
+    std::string passhash;
+    static constexpr auto fields() {
+        return std::tuple{field("username", &LoginRequest::username), field("passhash", &LoginRequest::passhash)};
+    }
+};
+
+struct RegisterRequest {
+    static constexpr Command kCommand = Command::Register;
+    std::string username;
+    std::string passhash;
+    static constexpr auto fields() {
+        return std::tuple{field("username", &RegisterRequest::username),
+                          field("passhash", &RegisterRequest::passhash)};
+    }
+};
+
+struct PubkeyRequest {
+    static constexpr Command kCommand = Command::Pubkey;
+    static constexpr auto fields() { return std::tuple{}; }
+};
+
+struct HelloRequest {
+    static constexpr Command kCommand = Command::Hello;
+    uint32_t version{1};
+    uint32_t capabilities{0};
+    uint32_t max_frame{0};
+    static constexpr auto fields() {
+        return std::tuple{field("version", &HelloRequest::version),
+                          field("capabilities", &HelloRequest::capabilities),
+                          field("maxFrame", &HelloRequest::max_frame)};
+    }
+};
+
+struct StatRequest {
+    static constexpr Command kCommand = Command::Stat;
+    std::string file_name;
+    static constexpr auto fields() { return std::tuple{field("file_name", &StatRequest::file_name)}; }
+};
+
+// Server metrics in the Prometheus text format, answered as a TextResponse. Loopback peers only.
+struct StatsRequest {
+    static constexpr Command kCommand = Command::Stats;
+    static constexpr auto fields() { return std::tuple{}; }
+};
+
+using Request = std::variant<LsRequest, PwdRequest, CdRequest, MkdirRequest, RmRequest, RmdirRequest, GetRequest,
+                             PutRequest, PutDataChannelRequest, LoginRequest, RegisterRequest, PubkeyRequest,
+                             HelloRequest, StatRequest, StatsRequest>;
+
+inline Command command_of(const Request& request) {
+    return std::visit([](const auto& r) { return std::decay_t<decltype(r)>::kCommand; }, request);
+}
+
+// ---- responses ----
+
+// Tag of binary response bodies; existing values must not change.
+enum class ResponseKind : uint8_t {
+    Text = 1,
+    Error = 2,
+    PutStatus = 3,
+    GetInit = 4,
+    LargePutInit = 5,
+    LargePutComplete = 6,
+    Hello = 7,
+    Login = 8,
+    Pubkey = 9,
+    Stat = 10
+};
+
+// In JSON a kStatus message starts with {"status": kStatus}. A kNested one is sent as
+// {"responseMessage": "<its fields as a JSON string>"}, the form older clients parse.
+
+struct TextResponse {
+    static constexpr ResponseKind kKind = ResponseKind::Text;
+    std::string message;
+    static constexpr auto fields() { return std::tuple{field("responseMessage", &TextResponse::message)}; }
+};
+
+struct ErrorResponse {
+    static constexpr ResponseKind kKind = ResponseKind::Error;
+    static constexpr std::string_view kStatus = "error";
+    int32_t code{0};
+    std::string message;
+    std::optional<uint32_t> retry_after_ms;     // SERVER_BUSY only
+    static constexpr auto fields() {
+        return std::tuple{field("errorCode", &ErrorResponse::code), field("errorMessage", &ErrorResponse::message),
+                          field("retryAfterMs", &ErrorResponse::retry_after_ms)};
+    }
+};
+
+// PUT progress: status is "receiving" (fileSize = bytes the server has) or "completed".
+struct PutStatusResponse {
+    static constexpr ResponseKind kKind = ResponseKind::PutStatus;
+    std::string status;
+    std::string file_name;
+    uint64_t file_size{0};
+    std::string file_hash;
+    static constexpr auto fields() {
+        return std::tuple{field("status", &PutStatusResponse::status), field("fileName", &PutStatusResponse::file_name),
+                          field("fileSize", &PutStatusResponse::file_size),
+                          field("fileHash", &PutStatusResponse::file_hash)};
+    }
+};
+
+struct GetInitResponse {
+    static constexpr ResponseKind kKind = ResponseKind::GetInit;
+    static constexpr std::string_view kStatus = "get_init";
+    std::string file_name;
+    uint64_t offset{0};
+    uint64_t file_size{0};
+    std::string file_hash;
+    static constexpr auto fields() {
+        return std::tuple{field("fileName", &GetInitResponse::file_name), field("offset", &GetInitResponse::offset),
+                          field("fileSize", &GetInitResponse::file_size),
+                          field("fileHash", &GetInitResponse::file_hash)};
+    }
+};
+
+struct LargePutInitResponse {
+    static constexpr ResponseKind kKind = ResponseKind::LargePutInit;
+    static constexpr std::string_view kStatus = "large_put_init";
+    std::string file_name;
+    uint64_t file_size{0};
+    std::string file_hash;
+    std::string upload_token;
+    std::string mode;
+    uint64_t chunk_hint{0};
+    static constexpr auto fields() {
+        return std::tuple{field("fileName", &LargePutInitResponse::file_name),
+                          field("fileSize", &LargePutInitResponse::file_size),
+                          field("fileHash", &LargePutInitResponse::file_hash),
+                          field("uploadToken", &LargePutInitResponse::upload_token),
+                          field("mode", &LargePutInitResponse::mode),
+                          field("chunkHint", &LargePutInitResponse::chunk_hint)};
+    }
+};
+
+struct LargePutCompleteResponse {
+    static constexpr ResponseKind kKind = ResponseKind::LargePutComplete;
+    static constexpr std::string_view kStatus = "large_put_complete";
+    std::string file_name;
+    uint64_t file_size{0};
+    std::string file_hash;
+    bool hash_ok{false};
+    static constexpr auto fields() {
+        return std::tuple{field("fileName", &LargePutCompleteResponse::file_name),
+                          field("fileSize", &LargePutCompleteResponse::file_size),
+                          field("fileHash", &LargePutCompleteResponse::file_hash),
+                          field("hashOk", &LargePutCompleteResponse::hash_ok)};
+    }
+};
+
+struct HelloResponse {
+    static constexpr ResponseKind kKind = ResponseKind::Hello;
+    static constexpr std::string_view kStatus = "hello";
+    uint32_t version{1};
+    uint32_t capabilities{0};
+    uint32_t max_frame{0};
+    static constexpr auto fields() {
+        return std::tuple{field("version", &HelloResponse::version),
+                          field("capabilities", &HelloResponse::capabilities),
+                          field("maxFrame", &HelloResponse::max_frame)};
+    }
+};
+
+struct LoginResponse {
+    static constexpr ResponseKind kKind = ResponseKind::Login;
+    static constexpr bool kNested = true;
+    std::string token;
+    int32_t user_id{0};
+    int32_t session_id{0};
+    std::string username;
+    static constexpr auto fields() {
+        return std::tuple{field("token", &LoginResponse::token), field("user_id", &LoginResponse::user_id),
+                          field("session_id", &LoginResponse::session_id),
+                          field("username", &LoginResponse::username)};
+    }
+};
+
+struct PubkeyResponse {
+    static constexpr ResponseKind kKind = ResponseKind::Pubkey;
+    static constexpr bool kNested = true;
+    std::string pubkey;
+    static constexpr auto fields() { return std::tuple{field("pubkey", &PubkeyResponse::pubkey)}; }
+};
+
+struct StatResponse {
+    static constexpr ResponseKind kKind = ResponseKind::Stat;
+    static constexpr std::string_view kStatus = "stat";
+    std::string file_name;
+    bool is_directory{false};
+    uint64_t file_size{0};
+    std::string file_hash;
+    static constexpr auto fields() {
+        return std::tuple{field("fileName", &StatResponse::file_name),
+                          field("isDirectory", &StatResponse::is_directory),
+                          field("fileSize", &StatResponse::file_size), field("fileHash", &StatResponse::file_hash)};
+    }
+};
+
+using Response = std::variant<TextResponse, ErrorResponse, PutStatusResponse, GetInitResponse, LargePutInitResponse,
+                              LargePutCompleteResponse, HelloResponse, LoginResponse, PubkeyResponse, StatResponse>;
+
+} // namespace protocol
@@ -1,37 +1,40 @@
 #include "request_parser.h"
-#include "commands.h"
+#include "codec.h"
 #include "error_codes.h"
 #include <string>
-#include <sstream>
 
-namespace protocol {
+#include "nlohmann/json.hpp"
 
+namespace protocol {
 
-std::optional<json> RequestParser::parse(const std::string& request) {
-    reset();
-    // try {
-        auto j = json::parse(request);
-        if (j.contains("command") && j["command"].is_string()) {
-            command = j["command"].get<std::string>();
-        } else {
-            return std::nullopt;
-        }
+using nlohmann::json;
 
-        if (j.contains("parameters") && j["parameters"].is_object()) {
-            for (auto& [key, value] : j["parameters"].items()) {
-                if (value.is_string()) {
-                    parameters[key] = value.get<std::string>();
-                } else {
-                    parameters[key] = value.dump();
-                }
-            }
-        }
-        return j;
-    // } catch (const json::parse_error&) {
-    //     return std::nullopt;
-    // }
+std::optional<Request> RequestParser::parse(const uint8_t* body, std::size_t size, bool binary) {
+    error_.clear();
+    if (binary) {
+        auto request = decode_request(body, size);
+        if (!request) error_ = "malformed binary request";
+        return request;
+    }
+    auto j = json::parse(body, body + size, nullptr, false);
+    if (j.is_discarded() || !j.is_object()) {
+        error_ = "malformed JSON";
+        return std::nullopt;
+    }
+    auto command = j.find("command");
+    if (command == j.end() || !command->is_string()) {
+        error_ = "missing command";
+        return std::nullopt;
+    }
+    auto request = request_from_json(j);
+    if (!request) {
+        error_ = command_from_name(command->get_ref<const std::string&>())
+            ? "bad params for " + command->get<std::string>()
+            : "Unknown command";
+    }
+    return request;
 }
 
 
 
-} // namespace protocol
\ No newline at end of file
+} // namespace protocol
@@ -1,41 +1,30 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
-#include <unordered_map>
 #include <optional>
 #include "commands.h"
-#include "nlohmann/json.hpp"
+#include "messages.h"
 
 namespace protocol {
 
-using nlohmann::json;
-
 class RequestParser {
 public:
     RequestParser() = default;
     ~RequestParser() = default;
-    std::optional<json> parse(const std::string& request);
-
-    const std::string& getCommand() const {
-        return command;
-    }
+    // Parse a REQUEST body, binary (kFrameBinary, see protocol/codec.h) or JSON. nullopt when
+    // it is malformed or names an unknown command; error() tells which.
+    std::optional<Request> parse(const uint8_t* body, std::size_t size, bool binary);
 
-    const std::unordered_map<std::string, std::string>& getParameters() const {
-        return parameters;
+    const std::string& error() const {
+        return error_;
     }
 
 private:
-    inline void reset() {
-        command.clear();
-        parameters.clear();
-    }
-
-    std::string command;
-    std::unordered_map<std::string, std::string> parameters;
-    json requestJson;
-
+    std::string error_;
 };
 
 
 
-} // namespace protocol
\ No newline at end of file
+} // namespace protocol
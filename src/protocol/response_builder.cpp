@@ -1,5 +1,4 @@
 #include "response_builder.h"
-#include "commands.h"
 #include "error_codes.h"
 #include <string>
 
@@ -7,68 +6,48 @@
 
 namespace protocol {
 
-json ResponseBuilder::build(const std::string& response) {
-    json resp = {
-        {"responseMessage", response}
-    };
-    return resp;
+Response ResponseBuilder::build(const std::string& response) {
+    return TextResponse{response};
 }
 
-json ResponseBuilder::buildPutResponse(const std::string& status, const std::string& fileName, int fileSize, const std::string& fileHash) {
-    json resp = {
-        {"status", status},
-        {"fileName", fileName},
-        {"fileSize", fileSize},
-        {"fileHash", fileHash}
-    };
-    return resp;
+Response ResponseBuilder::buildPutResponse(const std::string& status, const std::string& fileName, uint64_t fileSize, const std::string& fileHash) {
+    return PutStatusResponse{status, fileName, fileSize, fileHash};
+}
+
+Response ResponseBuilder::buildGetInitResponse(const std::string& fileName, uint64_t offset, uint64_t fileSize, const std::string& fileHash) {
+    return GetInitResponse{fileName, offset, fileSize, fileHash};
+}
 
+Response ResponseBuilder::buildLargePutInit(const std::string& fileName, uint64_t fileSize, const std::string& fileHash, const std::string& token, const std::string& mode, uint64_t chunkHint) {
+    return LargePutInitResponse{fileName, fileSize, fileHash, token, mode, chunkHint};
 }
 
-json ResponseBuilder::buildGetInitResponse(const std::string& fileName, uint64_t offset, uint64_t fileSize, const std::string& fileHash) {
-    json resp = {
-        {"status", "get_init"},
-        {"fileName", fileName},
-        {"offset", offset},
-        {"fileSize", fileSize},
-        {"fileHash", fileHash}
-    };
-    return resp;
+Response ResponseBuilder::buildLargePutComplete(const std::string& fileName, uint64_t fileSize, const std::string& fileHash, bool hashOk) {
+    return LargePutCompleteResponse{fileName, fileSize, fileHash, hashOk};
 }
 
-json ResponseBuilder::buildLargePutInit(const std::string& fileName, uint64_t fileSize, const std::string& fileHash, const std::string& token, const std::string& mode, uint64_t chunkHint) {
-    json resp = {
-        {"status", "large_put_init"},
-        {"fileName", fileName},
-        {"fileSize", fileSize},
-        {"fileHash", fileHash},
-        {"uploadToken", token},
-        {"mode", mode},
-        {"chunkHint", chunkHint}
-    };
-    return resp;
+Response ResponseBuilder::buildErrorResponse(int errorCode, const std::string& errorMessage) {
+    return ErrorResponse{errorCode, errorMessage, std::nullopt};
 }
 
-json ResponseBuilder::buildLargePutComplete(const std::string& fileName, uint64_t fileSize, const std::string& fileHash, bool hashOk) {
-    json resp = {
-        {"status", "large_put_complete"},
-        {"fileName", fileName},
-        {"fileSize", fileSize},
-        {"fileHash", fileHash},
-        {"hashOk", hashOk}
-    };
-    return resp;
+Response ResponseBuilder::buildBusyResponse(uint32_t retryAfterMs) {
+    return ErrorResponse{static_cast<int32_t>(ErrorCode::SERVER_BUSY), "server busy", retryAfterMs};
 }
 
-json ResponseBuilder::buildErrorResponse(int errorCode, const std::string& errorMessage) {
-    json resp = {
-        {"status", "error"},
-        {"errorCode", errorCode},
-        {"errorMessage", errorMessage}
-    };
-    return resp;
+Response ResponseBuilder::buildHelloResponse(uint8_t version, uint32_t capabilities, uint32_t maxFrame) {
+    return HelloResponse{version, capabilities, maxFrame};
 }
 
+Response ResponseBuilder::buildLoginResponse(const std::string& token, int userId, int sessionId, const std::string& username) {
+    return LoginResponse{token, userId, sessionId, username};
+}
 
+Response ResponseBuilder::buildPubkeyResponse(const std::string& pubkey) {
+    return PubkeyResponse{pubkey};
+}
+
+Response ResponseBuilder::buildStatResponse(const std::string& fileName, bool isDirectory, uint64_t fileSize, const std::string& fileHash) {
+    return StatResponse{fileName, isDirectory, fileSize, fileHash};
+}
 
-} // namespace protocol
\ No newline at end of file
+} // namespace protocol
@@ -1,32 +1,29 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
-#include <map>
 #include "types/message.h"
-
-#include "nlohmann/json.hpp"
+#include "messages.h"
 
 namespace protocol {
 
-using nlohmann::json;
-
+// Responses as schema messages (protocol/messages.h); RequestHandler::sendResponse encodes
+// them as JSON or binary, whichever the request used.
 class ResponseBuilder {
 public:
     ResponseBuilder() = default;
     ~ResponseBuilder() = default;
-    json build(const std::string& response);
-    json buildPutResponse(const std::string& status, const std::string& fileName, int fileSize, const std::string& fileHash);
-    json buildGetInitResponse(const std::string& fileName, uint64_t offset, uint64_t fileSize, const std::string& fileHash);
-    json buildLargePutInit(const std::string& fileName, uint64_t fileSize, const std::string& fileHash, const std::string& token, const std::string& mode, uint64_t chunkHint);
-    json buildLargePutComplete(const std::string& fileName, uint64_t fileSize, const std::string& fileHash, bool hashOk);
-    json buildSuccessResponse(const std::string& message);
-    json buildErrorResponse(int errorCode, const std::string& errorMessage);
-    json buildFileListResponse(const std::map<std::string, std::string>& files);
-    json buildUploadResponse(const std::string& fileName, bool success);
-    json buildDownloadResponse(const std::string& fileName, bool success);
-
-private:
-    std::string createJsonResponse(const std::string& status, const std::string& message);
+    Response build(const std::string& response);
+    Response buildPutResponse(const std::string& status, const std::string& fileName, uint64_t fileSize, const std::string& fileHash);
+    Response buildGetInitResponse(const std::string& fileName, uint64_t offset, uint64_t fileSize, const std::string& fileHash);
+    Response buildLargePutInit(const std::string& fileName, uint64_t fileSize, const std::string& fileHash, const std::string& token, const std::string& mode, uint64_t chunkHint);
+    Response buildLargePutComplete(const std::string& fileName, uint64_t fileSize, const std::string& fileHash, bool hashOk);
+    Response buildErrorResponse(int errorCode, const std::string& errorMessage);
+    Response buildBusyResponse(uint32_t retryAfterMs);
+    Response buildHelloResponse(uint8_t version, uint32_t capabilities, uint32_t maxFrame);
+    Response buildLoginResponse(const std::string& token, int userId, int sessionId, const std::string& username);
+    Response buildPubkeyResponse(const std::string& pubkey);
+    Response buildStatResponse(const std::string& fileName, bool isDirectory, uint64_t fileSize, const std::string& fileHash);
 };
 
-} // namespace protocol
\ No newline at end of file
+} // namespace protocol
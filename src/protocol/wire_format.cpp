@@ -0,0 +1,81 @@
+#include "wire_format.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "utils/crc32c.h"
+
+namespace protocol {
+
+WireFormat negotiate(uint8_t version, uint32_t capabilities, uint32_t max_frame) {
+    WireFormat format;
+    if (version < kProtocolV2) return format;
+    format.version = kProtocolV2;
+    format.capabilities = capabilities & kServerCapabilities;
+    if (format.capabilities & kCapLargeFrames) {
+        format.max_body = std::clamp<uint32_t>(max_frame, kMaxBodyV1, kMaxBodyV2);
+    }
+    return format;
+}
+
+void encode_header(const FrameHeader& header, const WireFormat& format, const uint8_t* body, uint8_t* out) {
+    if (!format.v2()) {
+        MessageHeader h;
+        h.length = static_cast<uint16_t>(header.length);
+        h.type = header.type;
+        h.request_id = header.request_id;
+        std::memcpy(out, &h, sizeof(h));
+        return;
+    }
+    MessageHeaderV2 h;
+    h.length = header.length;
+    h.type = header.type;
+    h.flags = header.flags;
+    h.request_id = header.request_id;
+    if (format.crc()) {
+        h.flags |= kFrameCrc;
+        h.crc = utils::crc32c(body, header.length);
+    } else {
+        h.flags &= static_cast<uint8_t>(~kFrameCrc);
+    }
+    std::memcpy(out, &h, sizeof(h));
+}
+
+FrameHeader decode_header(const uint8_t* in, const WireFormat& format) {
+    FrameHeader header;
+    if (!format.v2()) {
+        MessageHeader h;
+        std::memcpy(&h, in, sizeof(h));
+        header.length = h.length;
+        header.type = h.type;
+        header.request_id = h.request_id;
+        return header;
+    }
+    MessageHeaderV2 h;
+    std::memcpy(&h, in, sizeof(h));
+    header.length = h.length;
+    header.type = h.type;
+    header.flags = h.flags;
+    header.request_id = h.request_id;
+    header.crc = h.crc;
+    return header;
+}
+
+bool verify_body(const FrameHeader& header, const uint8_t* body) {
+    return !(header.flags & kFrameCrc) || utils::crc32c(body, header.length) == header.crc;
+}
+
+std::string encode_frame(uint8_t type, const void* body, std::size_t size, const WireFormat& format,
+                         uint8_t flags) {
+    FrameHeader header;
+    header.length = static_cast<uint32_t>(size);
+    header.type = type;
+    header.flags = flags;
+    std::string wire(format.header_size() + size, '\0');
+    auto out = reinterpret_cast<uint8_t*>(wire.data());
+    std::memcpy(out + format.header_size(), body, size);
+    encode_header(header, format, out + format.header_size(), out);
+    return wire;
+}
+
+} // namespace protocol
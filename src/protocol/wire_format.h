@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "types/message.h"
+
+namespace protocol {
+
+enum : uint8_t {
+    kProtocolV1 = 1,    // MessageHeader, 64KB frames
+    kProtocolV2 = 2     // MessageHeaderV2
+};
+
+// MessageHeaderV2::flags
+enum FrameFlags : uint8_t {
+    kFrameCrc = 1u << 0,    // crc holds the CRC-32C of the body
+    kFrameBinary = 1u << 1  // REQUEST/RESPONSE/ERROR body in the binary encoding of protocol/codec.h
+};
+
+// Capability bits of the hello handshake; the server answers with the ones both sides have.
+enum Capability : uint32_t {
+    kCapLargeFrames = 1u << 0,  // bodies above 64KB, up to the agreed maxFrame
+    kCapCrc         = 1u << 1,  // every body carries a CRC-32C, checked by the receiver
+    kCapPipelining  = 1u << 2,  // pipelined requests are answered in order (request ids)
+    kCapBinaryControl = 1u << 3 // control bodies may be binary (kFrameBinary), answered in kind
+};
+
+constexpr uint32_t kServerCapabilities = kCapLargeFrames | kCapCrc | kCapPipelining | kCapBinaryControl;
+
+constexpr uint32_t kMaxBodyV1 = UINT16_MAX;     // what the v1 length field holds
+constexpr uint32_t kMaxBodyV2 = 1024 * 1024;
+constexpr std::size_t kMaxHeaderSize = sizeof(MessageHeaderV2);
+
+// A frame header independent of the wire version it came in or goes out with.
+struct FrameHeader {
+    uint32_t length{0};
+    uint8_t type{0};
+    uint8_t flags{0};
+    uint8_t request_id{0};
+    uint32_t crc{0};
+};
+
+// Framing agreed for one connection, the same in both directions. v1 until a hello changes it.
+struct WireFormat {
+    uint8_t version{kProtocolV1};
+    uint32_t capabilities{0};
+    uint32_t max_body{kMaxBodyV1};   // largest body either side may send
+
+    bool v2() const { return version >= kProtocolV2; }
+    bool crc() const { return v2() && (capabilities & kCapCrc); }
+    bool binary_control() const { return v2() && (capabilities & kCapBinaryControl); }
+    std::size_t header_size() const { return v2() ? sizeof(MessageHeaderV2) : sizeof(MessageHeader); }
+    // Body size of data stream frames (GET_DATA, PUT_DATA). v1 peers receive into a 64KB
+    // Message, so v1 chunks keep to MAX_MESSAGE_SIZE including the header.
+    uint32_t chunk_size() const { return v2() ? max_body : MAX_MESSAGE_SIZE - sizeof(MessageHeader); }
+};
+
+// Format the server agrees to for a client's hello. Anything below v2 keeps v1; maxFrame is
+// clamped to [64KB, 1MB] and only honoured with kCapLargeFrames.
+WireFormat negotiate(uint8_t version, uint32_t capabilities, uint32_t max_frame);
+
+// Write header_size() bytes of header for `format` to out. With format.crc() the CRC-32C of
+// the header.length body bytes is computed and the kFrameCrc flag set.
+void encode_header(const FrameHeader& header, const WireFormat& format, const uint8_t* body, uint8_t* out);
+// Parse header_size() bytes from in.
+FrameHeader decode_header(const uint8_t* in, const WireFormat& format);
+// Whether body matches the header's checksum; true for frames that carry none.
+bool verify_body(const FrameHeader& header, const uint8_t* body);
+
+// Header and body in one buffer, for senders without a frame pool (the client).
+std::string encode_frame(uint8_t type, const void* body, std::size_t size, const WireFormat& format,
+                         uint8_t flags = 0);
+
+} // namespace protocol
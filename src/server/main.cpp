@@ -1,15 +1,99 @@
 #include <iostream>
 #include <csignal>
+#include <cstring>
 
 #include "server.h"
 #include "db/mysql_pool.h"
 #include "db/user_file_repository.h"
 #include "storage/global_open_table.h"
 #include "auth/rsa_key_manager.h"
+#include "utils/log.h"
 
 
 
-int main() {
+int main(int argc, char* argv[]) {
+    // --poller=epoll|io_uring      reactor backend (epoll by default)
+    // --accept=main|reuseport|exclusive   who accepts connections (MainReactor by default)
+    // --idle-timeout=SEC --stall-timeout=SEC --session-ttl=SEC   connection/session limits, 0 disables
+    // --max-connections=N          refuse connections beyond N with a busy frame, 0 = unlimited
+    // --max-inflight=N             upper bound of the adaptive in-flight request limit
+    // --log-level=trace|debug|info|warn|error|off   runtime log level (warn by default)
+    // --metrics-port=N             serve Prometheus metrics on 127.0.0.1:N, 0 (default) disables
+    // --trace-sample=N             trace one request in N, dumped at http://127.0.0.1:<metrics-port>/trace
+    // --flexible-workers=MIN[-MAX]  flexible pool workers, grown up to MAX under load (4-16)
+    // --db-threads=N --disk-threads=N   executors for handlers' blocking calls (16 and 8), 0 runs them inline
+    // --numa-node=N --main-cpu=N --reactor-cpus=LIST --worker-cpus=LIST   override the CPU placement
+    //                              planned from the host topology (LIST as in sysfs: 1-4,8)
+    ServerOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--poller=", 9) == 0) {
+            auto backend = net::parse_poller_backend(argv[i] + 9);
+            if (!backend) {
+                std::cerr << "Unknown poller backend: " << (argv[i] + 9) << std::endl;
+                return EXIT_FAILURE;
+            }
+            options.poller_backend = *backend;
+        } else if (std::strncmp(argv[i], "--accept=", 9) == 0) {
+            auto mode = net::parse_accept_mode(argv[i] + 9);
+            if (!mode) {
+                std::cerr << "Unknown accept mode: " << (argv[i] + 9) << std::endl;
+                return EXIT_FAILURE;
+            }
+            options.accept_mode = *mode;
+        } else if (std::strncmp(argv[i], "--idle-timeout=", 15) == 0) {
+            options.timeouts.idle = std::chrono::seconds(std::atol(argv[i] + 15));
+        } else if (std::strncmp(argv[i], "--stall-timeout=", 16) == 0) {
+            options.timeouts.stall = std::chrono::seconds(std::atol(argv[i] + 16));
+        } else if (std::strncmp(argv[i], "--session-ttl=", 14) == 0) {
+            options.timeouts.session = std::chrono::seconds(std::atol(argv[i] + 14));
+        } else if (std::strncmp(argv[i], "--max-connections=", 18) == 0) {
+            options.admission.max_connections = static_cast<std::size_t>(std::atoll(argv[i] + 18));
+        } else if (std::strncmp(argv[i], "--max-inflight=", 15) == 0) {
+            options.admission.max_limit = static_cast<uint32_t>(std::atol(argv[i] + 15));
+        } else if (std::strncmp(argv[i], "--log-level=", 12) == 0) {
+            auto level = utils::log::parse_level(argv[i] + 12);
+            if (!level) {
+                std::cerr << "Unknown log level: " << (argv[i] + 12) << std::endl;
+                return EXIT_FAILURE;
+            }
+            if (*level < utils::log::kCompiledLevel) {
+                std::cerr << "Log level " << (argv[i] + 12) << " is compiled out, build with -DFILE_SERVER_LOG_LEVEL="
+                          << static_cast<int>(*level) << std::endl;
+            }
+            utils::log::set_level(*level);
+        } else if (std::strncmp(argv[i], "--metrics-port=", 15) == 0) {
+            options.metrics_port = static_cast<uint16_t>(std::atoi(argv[i] + 15));
+        } else if (std::strncmp(argv[i], "--trace-sample=", 15) == 0) {
+            options.trace_sample_every = static_cast<uint32_t>(std::atol(argv[i] + 15));
+        } else if (std::strncmp(argv[i], "--flexible-workers=", 19) == 0) {
+            char* end = nullptr;
+            options.flexible_workers = static_cast<std::size_t>(std::strtoul(argv[i] + 19, &end, 10));
+            options.max_flexible_workers = *end == '-' ? static_cast<std::size_t>(std::strtoul(end + 1, &end, 10))
+                                                       : options.flexible_workers;
+            if (*end != '\0' || options.max_flexible_workers < options.flexible_workers) {
+                std::cerr << "Bad worker range: " << (argv[i] + 19) << std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (std::strncmp(argv[i], "--db-threads=", 13) == 0) {
+            options.db_threads = static_cast<std::size_t>(std::atol(argv[i] + 13));
+        } else if (std::strncmp(argv[i], "--disk-threads=", 15) == 0) {
+            options.disk_threads = static_cast<std::size_t>(std::atol(argv[i] + 15));
+        } else if (std::strncmp(argv[i], "--numa-node=", 12) == 0) {
+            options.placement.numa_node = std::atoi(argv[i] + 12);
+        } else if (std::strncmp(argv[i], "--main-cpu=", 11) == 0) {
+            options.placement.main_reactor_cpu = std::atoi(argv[i] + 11);
+        } else if (std::strncmp(argv[i], "--reactor-cpus=", 15) == 0 || std::strncmp(argv[i], "--worker-cpus=", 14) == 0) {
+            bool reactors = argv[i][2] == 'r';
+            const char* list = std::strchr(argv[i], '=') + 1;
+            auto cpus = concurrency::parse_cpu_list(list);
+            if (!cpus || cpus->empty()) {
+                std::cerr << "Bad CPU list: " << list << std::endl;
+                return EXIT_FAILURE;
+            }
+            (reactors ? options.placement.io_reactor_cpus : options.placement.pinned_worker_cpus) = *cpus;
+        }
+    }
+
     db::MySQLConfig mysqlConfig = {
         "127.0.0.1",
         "root",
@@ -20,7 +104,7 @@ int main() {
     db::MySQLPool::init(mysqlConfig);
     storage::GlobalOpenTable::init("./repository");
     RSAKeyManager::getInstance().generateKeyPair();
-    Server server(8000);
+    Server server(8000, "127.0.0.1", options);
     server.start();
     getchar();
 
@@ -5,34 +5,140 @@
 #include "net/io_reactor.h"
 #include "common/debug.h"
 #include "db/user_file_repository.h"
+#include "cache/file_meta_cache.h"
+#include "metrics/metrics.h"
+#include "metrics/trace.h"
+#include "utils/log.h"
 
 
 
-Server::Server(int port, const std::string& address)
+Server::Server(int port, const std::string& address, const ServerOptions& options)
     : address_(address), port_(port) {
     server_context_ = std::make_shared<ServerContext>();
-    server_context_->thread_pool = 
-        std::make_shared<concurrency::LFThreadPool>(2, 4, 1024, 1024, std::vector<int>{5, 6});
-    log_cpp20("Server thread pool created with 2 pinned and 4 flexible threads.");
+    server_context_->poller_backend = options.poller_backend;
+    server_context_->accept_mode = options.accept_mode;
+    server_context_->timeouts = options.timeouts;
+
+    const auto topology = concurrency::CpuTopology::discover();
+    const auto plan = concurrency::plan_placement(topology, options.placement);
+    log_cpp20("CPU placement: " + plan.describe(topology));
+    // Pools, queues and reactors below are allocated on the plan's node.
+    concurrency::NumaScope numa(topology, plan.numa_node);
+    using Scheduling = concurrency::LFThreadPool::Scheduling;
+
+    // The flexible tier follows the load (login storms, bulk uploads) between the two bounds.
+    concurrency::PoolScalingConfig scaling;
+    scaling.max_flexible = options.max_flexible_workers;
+    server_context_->thread_pool = std::make_shared<concurrency::LFThreadPool>(
+        plan.pinned_worker_cpus.size(), options.flexible_workers, 1024, 1024, plan.pinned_worker_cpus,
+        Scheduling::WorkStealing, plan.shared_cpus, scaling);
+    log_cpp20("Server thread pool created with " + std::to_string(plan.pinned_worker_cpus.size())
+              + " pinned and " + std::to_string(options.flexible_workers) + "-"
+              + std::to_string(server_context_->thread_pool->max_flexible_worker_count()) + " flexible threads.");
+    // Workers of these mostly wait on MySQL or the disk: parked, they cost nothing.
+    if (options.db_threads > 0) {
+        server_context_->db_executor = std::make_shared<concurrency::LFThreadPool>(
+            0, options.db_threads, 1024, 1024, std::vector<int>{}, Scheduling::WorkStealing, plan.shared_cpus);
+    }
+    if (options.disk_threads > 0) {
+        server_context_->disk_executor = std::make_shared<concurrency::LFThreadPool>(
+            0, options.disk_threads, 1024, 1024, std::vector<int>{}, Scheduling::WorkStealing, plan.shared_cpus);
+    }
+    log_cpp20("Blocking call executors: " + std::to_string(options.db_threads) + " DB and " +
+              std::to_string(options.disk_threads) + " disk threads.");
+    server_context_->admission = std::make_shared<concurrency::AdmissionController>(options.admission);
     
-    main_reactor_ = std::make_shared<MainReactor>(0, std::vector<int>{1, 2, 3, 4}, server_context_);
+    main_reactor_ = std::make_shared<MainReactor>(plan.main_reactor_cpu, plan.io_reactor_cpus, server_context_);
     if (main_reactor_ == nullptr) {
         error_cpp20("Failed to create main reactor");
         return;
     }
-    log_cpp20("Main reactor created on core 0 with 4 IO reactors on cores 1,2,3,4.");
+    log_cpp20("Main reactor created with " + std::to_string(plan.io_reactor_cpus.size()) + " IO reactors.");
 
     if (main_reactor_->listen_on(port, address) == false) {
         error_cpp20("Failed to start listening on " + address + ":" + std::to_string(port));
         return;
     }
     log_cpp20("Server listening on " + address + ":" + std::to_string(port));
+
+    register_metrics();
+    metrics::trace::set_sample_every(options.trace_sample_every);
+    if (options.metrics_port != 0) metrics_listener_.start(options.metrics_port);
 }
 
 Server::~Server() {
+    metrics_listener_.stop();
+    metrics::Registry::global().forget(this);
     stop();
 }
 
+void Server::register_metrics() {
+    auto& registry = metrics::Registry::global();
+    using Type = metrics::Registry::Type;
+    auto add = [&](std::string_view name, std::string_view help, Type type, metrics::Labels labels,
+                   std::function<double()> read) {
+        registry.callback(name, help, type, std::move(labels), this,
+                          [read = std::move(read)] { return std::optional<double>(read()); });
+    };
+    auto load = [](const std::atomic<uint64_t>& v) { return static_cast<double>(v.load(std::memory_order_relaxed)); };
+
+    auto pool = server_context_->thread_pool;
+    const auto& ps = pool->stats();
+    add("fileserver_pool_submitted_total", "Tasks submitted to the worker pool.", Type::Counter, {{"queue", "pinned"}},
+        [&ps, load] { return load(ps.submitted_pinned); });
+    add("fileserver_pool_submitted_total", "", Type::Counter, {{"queue", "flexible"}},
+        [&ps, load] { return load(ps.submitted_flexible); });
+    add("fileserver_pool_executed_total", "Tasks run by the worker pool.", Type::Counter, {{"queue", "pinned"}},
+        [&ps, load] { return load(ps.executed_pinned); });
+    add("fileserver_pool_executed_total", "", Type::Counter, {{"queue", "flexible"}},
+        [&ps, load] { return load(ps.executed_flexible); });
+    add("fileserver_pool_rejected_total", "Tasks refused because the pool queue was full.", Type::Counter, {},
+        [&ps, load] { return load(ps.rejected); });
+    add("fileserver_pool_parks_total", "Times an idle worker went to sleep.", Type::Counter, {},
+        [&ps, load] { return load(ps.parks); });
+    add("fileserver_pool_wakes_total", "Parked workers woken by a submit.", Type::Counter, {},
+        [&ps, load] { return load(ps.wakes); });
+    add("fileserver_pool_flexible_workers", "Flexible pool workers running.", Type::Gauge, {},
+        [&ps, load] { return load(ps.flexible_workers); });
+    add("fileserver_pool_scaling_total", "Flexible workers started or retired by the pool scaler.", Type::Counter,
+        {{"direction", "up"}}, [&ps, load] { return load(ps.scale_ups); });
+    add("fileserver_pool_scaling_total", "", Type::Counter, {{"direction", "down"}},
+        [&ps, load] { return load(ps.scale_downs); });
+    add("fileserver_pool_backlog", "Queued flexible tasks at the scaler's last sample.", Type::Gauge, {},
+        [&ps, load] { return load(ps.sampled_backlog); });
+    add("fileserver_pool_queue_wait_seconds", "Queue wait of the scaler's last probe task.", Type::Gauge, {},
+        [&ps, load] { return load(ps.sampled_wait_us) / 1e6; });
+
+    auto* admission = server_context_->admission.get();
+    const auto& as = admission->stats();
+    add("fileserver_admission_admitted_total", "Requests let through admission control.", Type::Counter, {},
+        [&as, load] { return load(as.admitted); });
+    add("fileserver_admission_shed_total", "Requests answered busy.", Type::Counter, {{"reason", "limit"}},
+        [&as, load] { return load(as.shed) - load(as.shed_queue_full); });
+    add("fileserver_admission_shed_total", "", Type::Counter, {{"reason", "queue_full"}},
+        [&as, load] { return load(as.shed_queue_full); });
+    add("fileserver_admission_refused_connections_total", "Connections refused at accept.", Type::Counter, {},
+        [&as, load] { return load(as.shed_connections); });
+    add("fileserver_admission_queued", "Admitted requests waiting for a worker.", Type::Gauge, {},
+        [&as, load] { return load(as.queued); });
+    add("fileserver_admission_limit", "Current adaptive in-flight limit.", Type::Gauge, {},
+        [admission] { return static_cast<double>(admission->limit()); });
+    add("fileserver_admission_in_flight", "Requests currently in flight.", Type::Gauge, {},
+        [admission] { return static_cast<double>(admission->in_flight()); });
+
+    add("fileserver_meta_cache_lookups_total", "File metadata cache lookups.", Type::Counter,
+        {{"key", "id"}, {"result", "hit"}}, [] { return static_cast<double>(FileMetaCache::instance().stats().hits_id); });
+    add("fileserver_meta_cache_lookups_total", "", Type::Counter, {{"key", "id"}, {"result", "miss"}},
+        [] { return static_cast<double>(FileMetaCache::instance().stats().misses_id); });
+    add("fileserver_meta_cache_lookups_total", "", Type::Counter, {{"key", "hash"}, {"result", "hit"}},
+        [] { return static_cast<double>(FileMetaCache::instance().stats().hits_hash); });
+    add("fileserver_meta_cache_lookups_total", "", Type::Counter, {{"key", "hash"}, {"result", "miss"}},
+        [] { return static_cast<double>(FileMetaCache::instance().stats().misses_hash); });
+
+    add("fileserver_log_dropped_total", "Log records dropped because a thread's ring was full.", Type::Counter, {},
+        [] { return static_cast<double>(utils::log::dropped()); });
+}
+
 void Server::start() {
     if (main_reactor_) main_reactor_->start();
 }
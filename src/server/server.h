@@ -4,19 +4,39 @@
 #include <memory>
 
 #include "net/main_reactor.h"
+#include "concurrency/admission_controller.h"
+#include "concurrency/cpu_topology.h"
+#include "net/metrics_listener.h"
 #include "types/context.h"
 
 using namespace net;
 
+// Startup options, filled from the command line in main().
+struct ServerOptions {
+    PollerBackend poller_backend{PollerBackend::Epoll};
+    AcceptMode accept_mode{AcceptMode::MainReactor};
+    ConnectionTimeouts timeouts{};
+    concurrency::AdmissionConfig admission{};
+    uint16_t metrics_port{0};       // Prometheus text on 127.0.0.1:port, 0 disables
+    uint32_t trace_sample_every{0}; // trace one request in N (metrics::trace), 0 disables
+    std::size_t flexible_workers{4};        // pool workers kept at all times besides the pinned ones
+    std::size_t max_flexible_workers{16};   // ... and the most the elastic tier grows to under load
+    std::size_t db_threads{16};     // DB executor workers, one per MySQLPool connection; 0 runs DB calls inline
+    std::size_t disk_threads{8};    // disk executor workers (opens, metadata syscalls); 0 runs them inline
+    concurrency::PlacementRequest placement{};  // CPUs and NUMA node, planned from the host topology
+};
+
 class Server {
 public:
-    Server(int port, const std::string& address = "127.0.0.1");
+    Server(int port, const std::string& address = "127.0.0.1", const ServerOptions& options = {});
     ~Server();
 
     void start();
     void stop();
 
 private:
+    void register_metrics();
+
     std::string address_;
     int port_;
 
@@ -24,4 +44,6 @@ private:
 
     ServerContext::Ptr server_context_{nullptr};
 
+    MetricsListener metrics_listener_;
+
 };
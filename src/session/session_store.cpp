@@ -77,3 +77,21 @@ void SessionStore::remove_session(uint64_t sid) {
     by_user_.erase(uid);
     log_cpp20("[SessionStore] remove session sid=" + std::to_string(sid) + " user=" + std::to_string(uid));
 }
+
+std::size_t SessionStore::expire_idle(std::chrono::seconds max_idle) {
+    time_t cutoff = ::time(nullptr) - static_cast<time_t>(max_idle.count());
+    std::vector<uint64_t> expired;
+    {
+        std::shared_lock lock(mutex_);
+        for (auto& [sid, ctx] : by_session_) {
+            // Sessions with connections are expired by the owning reactor, which closes them.
+            if (ctx->connection_fds.empty() && ctx->last_active_time.load(std::memory_order_relaxed) <= cutoff) {
+                expired.push_back(sid);
+            }
+        }
+    }
+    for (uint64_t sid : expired) {
+        remove_session(sid);
+    }
+    return expired.size();
+}
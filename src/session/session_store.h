@@ -6,6 +6,7 @@
 #include <string>
 #include <cstdint>
 #include <mutex>
+#include <chrono>
 
 #include "types/context.h"
 #include "common/debug.h"
@@ -21,6 +22,8 @@ public:
     void attach_connection(uint64_t sid, int fd);
     void detach_connection(int fd);
     void remove_session(uint64_t sid);
+    // Drop detached sessions without a request for max_idle or longer. Returns how many were removed.
+    std::size_t expire_idle(std::chrono::seconds max_idle);
 
 private:
     SessionStore() = default;
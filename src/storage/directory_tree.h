@@ -40,6 +40,8 @@ public:
     };
     DeleteResult deleteFile(const std::string& file_name);
     bool isDirectoryEmpty(const std::string& dir_name);
+    // ls()/pwd() only read once the current directory is loaded.
+    bool isLoaded() const { return current_->is_loaded; }
 
 private:
     void loadDirectory();
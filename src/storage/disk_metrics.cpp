@@ -0,0 +1,25 @@
+#include "disk_metrics.h"
+
+#include <array>
+
+namespace storage {
+
+namespace {
+constexpr std::string_view kNames[] = {"open", "read", "write", "verify"};
+}
+
+std::string_view disk_op_name(DiskOp op) { return kNames[static_cast<uint8_t>(op)]; }
+
+metrics::Histogram& disk_latency(DiskOp op) {
+    static const auto histograms = [] {
+        std::array<metrics::Histogram*, std::size(kNames)> h{};
+        for (std::size_t i = 0; i < h.size(); ++i) {
+            h[i] = &metrics::Registry::global().histogram("fileserver_disk_seconds", "Latency of file system calls on stored files.",
+                                                          {{"op", std::string(kNames[i])}});
+        }
+        return h;
+    }();
+    return *histograms[static_cast<uint8_t>(op)];
+}
+
+} // namespace storage
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "metrics/metrics.h"
+#include "metrics/trace.h"
+
+namespace storage {
+
+// File system calls timed for fileserver_disk_seconds{op=...}.
+enum class DiskOp : uint8_t {
+    Open,       // opening a stored file
+    Read,       // one read/pread of file data
+    Write,      // one write/splice of file data
+    Verify,     // reading a whole upload back to check its hash
+};
+
+metrics::Histogram& disk_latency(DiskOp op);
+std::string_view disk_op_name(DiskOp op);
+
+// Times the scope into disk_latency(op), and as a span when the thread works for a traced request.
+class DiskTimer {
+public:
+    explicit DiskTimer(DiskOp op) : timer_(disk_latency(op)), span_(disk_op_name(op), "disk") {}
+
+private:
+    metrics::ScopedTimer timer_;
+    metrics::trace::Span span_;
+};
+
+} // namespace storage
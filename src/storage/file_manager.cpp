@@ -7,34 +7,73 @@
 
 namespace storage {
 
-void FileManager::setUser(int user_id) {
-    if (directory_tree_map_.find(user_id) == directory_tree_map_.end()) {
-        directory_tree_map_[user_id] = DirectoryTree(user_id);
+FileManager::UserTree& FileManager::userTree(int user_id) {
+    {
+        std::shared_lock<std::shared_mutex> lock(maps_mutex_);
+        auto it = directory_tree_map_.find(user_id);
+        if (it != directory_tree_map_.end()) return *it->second;
+    }
+    std::unique_lock<std::shared_mutex> lock(maps_mutex_);
+    auto& entry = directory_tree_map_[user_id];
+    if (!entry) entry = std::make_unique<UserTree>(user_id);
+    return *entry;
+}
+
+UserOpenTable& FileManager::userOpenTable(int user_id) {
+    {
+        std::shared_lock<std::shared_mutex> lock(maps_mutex_);
+        auto it = user_open_table_map_.find(user_id);
+        if (it != user_open_table_map_.end()) return it->second;
     }
+    std::unique_lock<std::shared_mutex> lock(maps_mutex_);
+    return user_open_table_map_[user_id];
+}
+
+template <typename Read>
+auto FileManager::readTree(int user_id, Read&& read) {
+    UserTree& user = userTree(user_id);
+    {
+        std::shared_lock<std::shared_mutex> lock(user.mutex);
+        if (user.tree.isLoaded()) return read(user.tree);
+    }
+    std::unique_lock<std::shared_mutex> lock(user.mutex);
+    return read(user.tree);
+}
+
+void FileManager::setUser(int user_id) {
+    userTree(user_id);
 }
 
 void FileManager::cd(int user_id, const std::string& path) {
-    directory_tree_map_[user_id].cd(path);
+    UserTree& user = userTree(user_id);
+    std::unique_lock<std::shared_mutex> lock(user.mutex);
+    user.tree.cd(path);
 }
 
 std::string FileManager::ls(int user_id) {
-    return directory_tree_map_[user_id].ls();
+    return readTree(user_id, [](DirectoryTree& tree) { return tree.ls(); });
 }
 
 std::string FileManager::pwd(int user_id) {
-    return directory_tree_map_[user_id].pwd();
+    return readTree(user_id, [](DirectoryTree& tree) { return tree.pwd(); });
 }
 
 void FileManager::mkdir(int user_id,const std::string& dir_name) {
-    directory_tree_map_[user_id].mkdir(dir_name);
+    UserTree& user = userTree(user_id);
+    std::unique_lock<std::shared_mutex> lock(user.mutex);
+    user.tree.mkdir(dir_name);
 }
 
 bool FileManager::isFileExists(int user_id, const std::string& file_name) {
-    return directory_tree_map_[user_id].isFileExists(file_name);
+    UserTree& user = userTree(user_id);
+    std::shared_lock<std::shared_mutex> lock(user.mutex);
+    return user.tree.isFileExists(file_name);
 }
 
 bool FileManager::deleteFile(int user_id, const std::string& file_name) {
-    DirectoryTree& directory_tree = directory_tree_map_[user_id];
+    UserTree& user = userTree(user_id);
+    std::unique_lock<std::shared_mutex> lock(user.mutex);
+    DirectoryTree& directory_tree = user.tree;
     if (!directory_tree.isFileExists(file_name)) {
         error_cpp20("Delete failed, file not exists: " + file_name);
         return false;
@@ -63,7 +102,9 @@ bool FileManager::deleteFile(int user_id, const std::string& file_name) {
 }
 
 bool FileManager::removeDirectory(int user_id, const std::string& dir_name) {
-    DirectoryTree& directory_tree = directory_tree_map_[user_id];
+    UserTree& user = userTree(user_id);
+    std::unique_lock<std::shared_mutex> lock(user.mutex);
+    DirectoryTree& directory_tree = user.tree;
     if (!directory_tree.isFileExists(dir_name)) {
         error_cpp20("rmdir failed, dir not exists: " + dir_name);
         return false;
@@ -79,7 +120,9 @@ bool FileManager::removeDirectory(int user_id, const std::string& dir_name) {
 }
 
 void FileManager::createFile(int user_id, const std::string& file_name, const std::string file_hash, int file_size) {
-    DirectoryTree& directory_tree = directory_tree_map_[user_id];
+    UserTree& user = userTree(user_id);
+    std::unique_lock<std::shared_mutex> lock(user.mutex);
+    DirectoryTree& directory_tree = user.tree;
     if (directory_tree.isFileExists(file_name)) {
         error_cpp20("File already exists: " + file_name);
         return;
@@ -101,13 +144,15 @@ void FileManager::createFile(int user_id, const std::string& file_name, const st
         FileMetaCache::instance().invalidateHash(meta_data.hashCode);
         FileMetaCache::instance().insert(meta_data);
     }
-    file_metadata_map_[meta_data.id] = meta_data;
+    {
+        std::unique_lock<std::shared_mutex> maps_lock(maps_mutex_);
+        file_metadata_map_[meta_data.id] = meta_data;
+    }
     directory_tree.createFile(file_name, meta_data.id);
 }
 
 int FileManager::openFile(int user_id, const std::string& file_name, const std::string& file_hash) {
-    UserOpenTable& user_open_table = user_open_table_map_[user_id];
-    DirectoryTree& directory_tree = directory_tree_map_[user_id];
+    UserOpenTable& user_open_table = userOpenTable(user_id);
 
     if (user_open_table.isFileOpen(file_hash)) {
         return user_open_table.getFD(file_hash);
@@ -122,8 +167,7 @@ int FileManager::openFile(int user_id, const std::string& file_name, const std::
 }
 
 UserFileHandle::Ptr FileManager::getFileHandle(int user_id, int user_fd) {
-    UserOpenTable& user_open_table = user_open_table_map_[user_id];
-    return user_open_table.getFileHandle(user_fd);
+    return userOpenTable(user_id).getFileHandle(user_fd);
 }
 
 } // namespace storage
\ No newline at end of file
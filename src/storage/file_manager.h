@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+#include <shared_mutex>
 #include <string>
 #include <unordered_map>
 
@@ -52,8 +54,23 @@ private:
     FileManager() = default;
     ~FileManager() = default;
 
+    // A user's tree is reached from several workers at once: pipelined reads of one connection
+    // and every connection of the user. Lookups share the lock; changes, and the lazy load of a
+    // directory a lookup may need first, hold it alone.
+    struct UserTree {
+        explicit UserTree(int user_id) : tree(user_id) {}
+        std::shared_mutex mutex;
+        DirectoryTree tree;
+    };
+    UserTree& userTree(int user_id);
+    UserOpenTable& userOpenTable(int user_id);
+    // Runs read on the tree under the shared lock if its current directory is loaded already.
+    template <typename Read>
+    auto readTree(int user_id, Read&& read);
+
+    std::shared_mutex maps_mutex_;  // the maps below; entries are never erased
     std::unordered_map<int, FileMetadata> file_metadata_map_; // Maps file hash to metadata
-    std::unordered_map<int, DirectoryTree> directory_tree_map_;
+    std::unordered_map<int, std::unique_ptr<UserTree>> directory_tree_map_;
     std::unordered_map<int, UserOpenTable> user_open_table_map_;
 
 };
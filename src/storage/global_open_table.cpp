@@ -6,6 +6,7 @@
 #include <fcntl.h>
 
 #include "common/debug.h"
+#include "disk_metrics.h"
 
 namespace storage {
 
@@ -48,7 +49,11 @@ std::optional<int> GlobalOpenTable::openFile(const std::string& file_name) {
         return it->second.fd;
     }
 
-    int fd = ::open((storage_root_ / file_name).c_str(), O_RDWR | O_APPEND | O_CREAT, 0644);
+    int fd;
+    {
+        DiskTimer timer(DiskOp::Open);
+        fd = ::open((storage_root_ / file_name).c_str(), O_RDWR | O_APPEND | O_CREAT, 0644);
+    }
     if (fd < 0) {
         RUNTIME_ERROR("Failed to open file %s: %s", file_name.c_str(), strerror(errno));
         return std::nullopt;
@@ -1,11 +1,16 @@
 #include "user_file_handle.h"
 
 #include "common/debug.h"
+#include "disk_metrics.h"
 
 namespace storage {
 
 int UserFileHandle::writeBuffer(const void* buffer, size_t size) {
-    int n = write(fd_, buffer, size);
+    int n;
+    {
+        DiskTimer timer(DiskOp::Write);
+        n = write(fd_, buffer, size);
+    }
     if (n < 0) {
         error_cpp20("Failed to write to file " + file_name_ + ": " + std::string(strerror(errno)));
         return -1;
@@ -15,7 +20,11 @@ int UserFileHandle::writeBuffer(const void* buffer, size_t size) {
 }
 
 int UserFileHandle::readBuffer(void* buffer, size_t size) {
-    int n = read(fd_, buffer, size);
+    int n;
+    {
+        DiskTimer timer(DiskOp::Read);
+        n = read(fd_, buffer, size);
+    }
     if (n < 0) {
         error_cpp20("Failed to read from file " + file_name_ + ": " + std::string(strerror(errno)));
         return -1;
@@ -1,10 +1,19 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
 #include <functional>
 #include <memory>
 
+#include "protocol/wire_format.h"
+#include "utils/inline_function.h"
+
 namespace concurrency {
     class LFThreadPool;
+    class AdmissionController;
+    template<typename Task> class SeriesTask;
 }
 
 namespace net {
@@ -12,6 +21,14 @@ namespace net {
     class IOReactor;
     class Connection;
     class ResponseQueue;
+    class FramePool;
+    class BlockPool;
+    class FrameDecoder;
+    class RequestPipeline;
+    enum class PollerBackend : uint8_t;
+    enum class AcceptMode : uint8_t;
+    enum class SocketProfileKind : uint8_t;
+    struct SocketProfiles;
 }
 
 namespace handlers {
@@ -29,6 +46,14 @@ namespace storage {
 class Server;
 
 
+// Connection and session lifetimes enforced by the IO reactors' timer wheels; 0 disables one.
+struct ConnectionTimeouts {
+    std::chrono::seconds idle{300};         // connection open between requests without traffic
+    std::chrono::seconds stall{60};         // transfer (upload, pending output) without progress
+    std::chrono::seconds session{1800};     // session without a request
+    std::chrono::seconds housekeeping{30};  // sweep of expired upload tokens and sessions
+};
+
 struct ServerContext {
     using Ptr = std::shared_ptr<ServerContext>;
 
@@ -37,21 +62,41 @@ struct ServerContext {
 
     Server* server{nullptr};
     std::shared_ptr<concurrency::LFThreadPool> thread_pool{nullptr};
+    // Where coroutine handlers park their blocking calls (concurrency::run_on), so a MySQL
+    // round trip or a file open does not hold a thread_pool worker; inline if unset.
+    std::shared_ptr<concurrency::LFThreadPool> db_executor{nullptr};
+    std::shared_ptr<concurrency::LFThreadPool> disk_executor{nullptr};
+    std::shared_ptr<concurrency::AdmissionController> admission{nullptr};  // unlimited if unset
+    net::PollerBackend poller_backend{}; // Epoll unless selected at startup
+    net::AcceptMode accept_mode{};       // MainReactor unless selected at startup
+    ConnectionTimeouts timeouts{};
+    std::shared_ptr<const net::SocketProfiles> socket_profiles{nullptr}; // SocketProfiles::defaults() if unset
 };
 
 
+// Traffic counters of one IO reactor, bumped by whoever moves bytes on its connections.
+struct ReactorCounters {
+    std::atomic<uint64_t> rx_bytes{0};
+    std::atomic<uint64_t> tx_bytes{0};
+};
+
 struct ReactorContext {
     using Ptr = std::shared_ptr<ReactorContext>;
 
     ReactorContext() = default;
     ReactorContext(ServerContext::Ptr ctx) : server_context(ctx) {}
 
-    int reactor_id;
+    int reactor_id{-1};
     net::MainReactor* main_reactor{nullptr};
     net::IOReactor* io_reactor{nullptr};
     std::shared_ptr<net::ResponseQueue> response_queue{nullptr};
+    std::shared_ptr<net::FramePool> frame_pool{nullptr};   // frames for this reactor's connections
+    std::shared_ptr<net::BlockPool> object_pool{nullptr};  // connections, their contexts and request handlers
+    std::shared_ptr<const net::SocketProfiles> socket_profiles{nullptr};   // options per connection role
+
+    std::function<void(int, uint32_t)> connection_close_callback{nullptr}; // (fd, slab generation)
 
-    std::function<void(int)> connection_close_callback{nullptr};
+    ReactorCounters counters{};
 
     ServerContext::Ptr server_context{nullptr};
 };
@@ -66,7 +111,7 @@ struct SessionContext {
     int session_id{-1};
     std::vector<int> connection_fds; // All connection fds associated with this session
     std::string session_token;
-    time_t last_active_time{0};
+    std::atomic<time_t> last_active_time{0};   // refreshed on every request
 };
 
 
@@ -77,6 +122,7 @@ struct ConnectionContext {
     ConnectionContext(ReactorContext::Ptr ctx) : reactor_context(ctx) {}
 
     int connection_id{-1};
+    uint32_t connection_generation{0}; // generation of the reactor slab slot owning connection_id
 
     net::Connection* connection{nullptr};
 
@@ -89,4 +135,37 @@ struct ConnectionContext {
 
     // 标记当前连接是否处于PUT文件上传数据流阶段，避免基础RequestHandler再次尝试解析后续数据块为JSON
     bool in_put_upload{false};
+
+    // Set when a request is dispatched, cleared when the connection is back on the base handler.
+    // Only idle connections may migrate to another IO reactor.
+    std::atomic<bool> request_in_flight{false};
+    // Pipelined requests (ls, stat, ...) in flight, created by the reactor on the first one.
+    std::shared_ptr<net::RequestPipeline> pipeline{nullptr};
+    // Work of this connection that must run one piece at a time and in order (upload chunks),
+    // created on first use.
+    std::shared_ptr<concurrency::SeriesTask<utils::InlineFunction<void()>>> strand{nullptr};
+    // Inbound framing state, reactor thread only.
+    std::shared_ptr<net::FrameDecoder> decoder{nullptr};
+    // Outbound framing agreed by a hello request (the decoder holds the inbound copy). Only
+    // changed on the reactor thread while no request of the connection is running.
+    protocol::WireFormat wire{};
+    // Set by the reactor when it left decoded input unread because a request was in flight or
+    // the pipeline was full; whoever completes a request asks the reactor to resume
+    // (ResponseQueue::submit_resume).
+    std::atomic<bool> input_stalled{false};
+
+    // Socket options currently applied (net::use_socket_profile), Control after accept.
+    std::atomic<net::SocketProfileKind> socket_profile{};
+
+    // Responses submitted to the ResponseQueue but not yet picked up by the reactor.
+    std::atomic<uint32_t> responses_queued{0};
+    // Bytes sitting in the connection's outbound buffer (published by the reactor after each flush).
+    std::atomic<uint64_t> pending_out_bytes{0};
+
+    void account_rx(uint64_t bytes) {
+        if (reactor_context) reactor_context->counters.rx_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    void account_tx(uint64_t bytes) {
+        if (reactor_context) reactor_context->counters.tx_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
 };
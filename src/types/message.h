@@ -7,13 +7,34 @@ static constexpr uint64_t MAX_MESSAGE_SIZE = 64 * 1024; // 64KB
 /*
     * Message structure:
     * +----------------+----------------+----------------+----------------+
-    * | Length (2 bytes) | Type (1 byte)  | Reserved (1 byte) | Body (variable length) |
+    * | Length (2 bytes) | Type (1 byte)  | Request id (1 byte) | Body (variable length) |
     * +----------------+----------------+----------------+----------------+
     *
     * Length: Length of the message body (excluding header)
     * Type: Type of the message (e.g., request, response, error)
-    * Reserved: Reserved for future use
+    * Request id: chosen by the client, echoed in every response to that request. A client
+    *   may send requests without waiting for the answers, which come in request order.
+    *   Requests that only read (ls, pwd, pubkey, stat) run concurrently. Any other command,
+    *   mkdir, rm and rmdir included, waits until the requests before it are answered and
+    *   runs alone; the server reads the next request once it is done.
     * Body: Actual message content
+    *
+    * Protocol v2 (MessageHeaderV2, 12 bytes) replaces the header once both sides agreed on it:
+    * +------------------+---------------+----------------+---------------------+--------------+-----------------+------+
+    * | Length (4 bytes) | Type (1 byte) | Flags (1 byte) | Request id (1 byte) | 0 (1 byte)   | CRC-32C (4 bytes) | Body |
+    * +------------------+---------------+----------------+---------------------+--------------+-----------------+------+
+    *
+    * Every connection starts on v1. A client that wants v2 sends, framed as v1,
+    * {"command": "hello", "params": {"version": 2, "capabilities": <bits>, "maxFrame": <bytes>}}
+    * and the server answers, still framed as v1,
+    * {"status": "hello", "version": 2, "capabilities": <agreed bits>, "maxFrame": <bytes>}.
+    * Both directions use the agreed header from the next frame on (see protocol/wire_format.h
+    * for the capability bits); a client must not send further frames before the answer.
+    * A server that does not know "hello" answers with an error and the connection stays on v1.
+    *
+    * With kCapBinaryControl agreed, a REQUEST may carry the kFrameBinary flag and a binary body
+    * (protocol/codec.h, schema in protocol/messages.h) instead of JSON; its RESPONSE/ERROR comes
+    * back in the same encoding. JSON requests keep working on the same connection.
 
     * Message Types:
     * 0x01: REQUEST
@@ -52,12 +73,26 @@ static constexpr uint64_t MAX_MESSAGE_SIZE = 64 * 1024; // 64KB
 struct MessageHeader {
     uint16_t length; // Length of the message body
     uint8_t type;   // Type of the message
-    uint8_t reserved; // Reserved for future use
+    uint8_t request_id; // Echoed in the response (was reserved, 0 from older clients)
+
+    MessageHeader() : length(0), type(0), request_id(0) {}
+
+} __attribute__((packed));
+
+// Protocol v2 header (see above); length is limited by the negotiated maxFrame, not the field.
+struct MessageHeaderV2 {
+    uint32_t length;    // Length of the message body
+    uint8_t type;       // Type of the message
+    uint8_t flags;      // protocol::FrameFlags
+    uint8_t request_id; // Echoed in the response
+    uint8_t reserved;   // 0
+    uint32_t crc;       // CRC-32C of the body when flags has kFrameCrc, 0 otherwise
 
-    MessageHeader() : length(0), type(0), reserved(0) {}
+    MessageHeaderV2() : length(0), type(0), flags(0), request_id(0), reserved(0), crc(0) {}
 
 } __attribute__((packed));
 
+// Fixed-size frame kept for the client; the server builds frames in pooled net::FrameBuffer.
 struct Message {
     MessageHeader header;
     uint8_t body[MAX_MESSAGE_SIZE - sizeof(MessageHeader)] = {0}; // Message body
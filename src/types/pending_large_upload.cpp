@@ -48,6 +48,10 @@ bool LargeUploadRegistry::consume(const std::string& token, PendingLargeUpload&
     auto it = map_.find(token);
     if (it == map_.end())
         return false;
+    if (it->second.expire_at < std::chrono::steady_clock::now()) {
+        map_.erase(it);     // expired but not swept yet
+        return false;
+    }
     out = it->second;
     map_.erase(it);
     return true; // remove to enforce one-time use
@@ -61,13 +65,16 @@ void LargeUploadRegistry::update_received(const std::string& token, uint64_t byt
     it->second.received += bytes;
 }
 
-void LargeUploadRegistry::cleanup() {
+std::size_t LargeUploadRegistry::cleanup() {
     std::lock_guard<std::mutex> lk(mtx_);
     auto now = std::chrono::steady_clock::now();
+    std::size_t removed = 0;
     for (auto it = map_.begin(); it != map_.end();) {
-        if (it->second.expire_at < now)
+        if (it->second.expire_at < now) {
             it = map_.erase(it);
-        else
+            ++removed;
+        } else
             ++it;
     }
+    return removed;
 }
@@ -24,7 +24,8 @@ public:
     std::optional<PendingLargeUpload> get(const std::string& token);
     bool consume(const std::string& token, PendingLargeUpload& out);
     void update_received(const std::string& token, uint64_t bytes);
-    void cleanup();
+    // Drop tokens past expire_at. Returns how many were removed.
+    std::size_t cleanup();
 private:
     LargeUploadRegistry() = default;
     std::mutex mtx_;
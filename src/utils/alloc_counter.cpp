@@ -0,0 +1,41 @@
+#include "alloc_counter.h"
+
+#ifdef FILE_SERVER_COUNT_ALLOCS
+
+#include <cstdlib>
+#include <new>
+
+namespace utils {
+thread_local uint64_t t_allocation_count = 0;
+}
+
+static void* counted_alloc(std::size_t size) {
+    ++utils::t_allocation_count;
+    if (size == 0) size = 1;
+    if (void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+static void* counted_aligned_alloc(std::size_t size, std::align_val_t align) {
+    ++utils::t_allocation_count;
+    std::size_t a = static_cast<std::size_t>(align);
+    if (size == 0) size = a;
+    size = (size + a - 1) & ~(a - 1);
+    if (void* p = std::aligned_alloc(a, size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size) { return counted_alloc(size); }
+void* operator new[](std::size_t size) { return counted_alloc(size); }
+void* operator new(std::size_t size, std::align_val_t align) { return counted_aligned_alloc(size, align); }
+void* operator new[](std::size_t size, std::align_val_t align) { return counted_aligned_alloc(size, align); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+#endif // FILE_SERVER_COUNT_ALLOCS
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+// Per-thread heap allocation counter used to verify that reactor hot paths do not allocate.
+// Counting is only active when the server is built with FILE_SERVER_COUNT_ALLOCS
+// (cmake -DENABLE_ALLOC_COUNTER=ON), which replaces the global operator new.
+// Otherwise thread_allocations() always returns 0.
+
+namespace utils {
+
+#ifdef FILE_SERVER_COUNT_ALLOCS
+extern thread_local uint64_t t_allocation_count;
+
+inline constexpr bool alloc_counter_enabled() { return true; }
+inline uint64_t thread_allocations() { return t_allocation_count; }
+#else
+inline constexpr bool alloc_counter_enabled() { return false; }
+inline uint64_t thread_allocations() { return 0; }
+#endif
+
+} // namespace utils
@@ -0,0 +1,63 @@
+#include "crc32c.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+namespace utils {
+
+namespace {
+
+constexpr uint32_t kPolynomial = 0x82f63b78;   // reflected Castagnoli polynomial
+
+using Tables = std::array<std::array<uint32_t, 256>, 8>;
+
+constexpr Tables make_tables() {
+    Tables t{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) crc = (crc >> 1) ^ ((crc & 1) ? kPolynomial : 0);
+        t[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+        for (std::size_t k = 1; k < 8; ++k) t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xff];
+    }
+    return t;
+}
+
+constexpr Tables kTables = make_tables();
+
+} // namespace
+
+uint32_t crc32c(const void* data, std::size_t size, uint32_t crc) {
+    auto p = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+#if defined(__SSE4_2__)
+    uint64_t c = crc;
+    for (; size >= 8; size -= 8, p += 8) {
+        uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        c = _mm_crc32_u64(c, word);
+    }
+    crc = static_cast<uint32_t>(c);
+    for (; size > 0; --size, ++p) crc = _mm_crc32_u8(crc, *p);
+#else
+    for (; size >= 8; size -= 8, p += 8) {
+        uint32_t lo, hi;
+        std::memcpy(&lo, p, sizeof(lo));
+        std::memcpy(&hi, p + 4, sizeof(hi));
+        lo ^= crc;
+        crc = kTables[7][lo & 0xff] ^ kTables[6][(lo >> 8) & 0xff]
+            ^ kTables[5][(lo >> 16) & 0xff] ^ kTables[4][lo >> 24]
+            ^ kTables[3][hi & 0xff] ^ kTables[2][(hi >> 8) & 0xff]
+            ^ kTables[1][(hi >> 16) & 0xff] ^ kTables[0][hi >> 24];
+    }
+    for (; size > 0; --size, ++p) crc = (crc >> 8) ^ kTables[0][(crc ^ *p) & 0xff];
+#endif
+    return ~crc;
+}
+
+} // namespace utils
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace utils {
+
+// CRC-32C (Castagnoli) as used for protocol v2 frame bodies. Uses the SSE4.2 crc32
+// instruction when the build targets it, a slicing-by-8 table otherwise.
+// Pass the previous result as `crc` to continue a checksum over several pieces.
+uint32_t crc32c(const void* data, std::size_t size, uint32_t crc = 0);
+
+} // namespace utils
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Move-only callable with its capture stored inline, never on the heap (a unique_function with
+// a fixed capacity). Meant for task queues: a cell holds the whole task, and a capture that
+// only moves (unique_ptr, FrameRef) needs no shared_ptr wrapper.
+//
+//   utils::InlineFunction<void()> task = [handler, queued_at] { handler->handle(); };
+//
+// A callable larger than Capacity bytes, aligned beyond a pointer, or not nothrow-movable does
+// not compile: capture less, or hold the state behind one pointer. The default capacity keeps
+// sizeof at 48, so a lf::ArrayMPMCQueue cell of one stays within a cache line.
+
+namespace utils {
+
+template<typename Signature, std::size_t Capacity = 40>
+class InlineFunction;
+
+template<typename R, typename... Args, std::size_t Capacity>
+class InlineFunction<R(Args...), Capacity> {
+public:
+    static constexpr std::size_t kCapacity = Capacity;
+
+    InlineFunction() noexcept = default;
+    InlineFunction(std::nullptr_t) noexcept {}
+
+    template<typename F,
+             typename Fn = std::decay_t<F>,
+             typename = std::enable_if_t<!std::is_same_v<Fn, InlineFunction> && std::is_invocable_r_v<R, Fn&, Args...>>>
+    InlineFunction(F&& f) {
+        static_assert(sizeof(Fn) <= Capacity, "InlineFunction: capture too large, capture less or hold it by pointer");
+        static_assert(alignof(Fn) <= alignof(void*), "InlineFunction: over-aligned capture");
+        static_assert(std::is_nothrow_move_constructible_v<Fn>, "InlineFunction: capture must be nothrow movable");
+        ::new (static_cast<void*>(storage_)) Fn(std::forward<F>(f));
+        ops_ = &kOps<Fn>;
+    }
+
+    InlineFunction(InlineFunction&& other) noexcept { take(other); }
+
+    InlineFunction& operator=(InlineFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    InlineFunction& operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, InlineFunction>>>
+    InlineFunction& operator=(F&& f) {
+        return *this = InlineFunction(std::forward<F>(f));
+    }
+
+    InlineFunction(const InlineFunction&) = delete;
+    InlineFunction& operator=(const InlineFunction&) = delete;
+
+    ~InlineFunction() { reset(); }
+
+    R operator()(Args... args) {
+        if (ops_ == nullptr) throw std::bad_function_call();
+        return ops_->invoke(storage_, std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+    friend bool operator==(const InlineFunction& f, std::nullptr_t) noexcept { return !f; }
+
+private:
+    struct Ops {
+        R (*invoke)(void* self, Args&&... args);
+        void (*relocate)(void* to, void* from) noexcept;    // move-construct at `to`, destroy `from`
+        void (*destroy)(void* self) noexcept;
+    };
+
+    template<typename Fn>
+    static constexpr Ops kOps{
+        [](void* self, Args&&... args) -> R {
+            return std::invoke(*static_cast<Fn*>(self), std::forward<Args>(args)...);
+        },
+        [](void* to, void* from) noexcept {
+            ::new (to) Fn(std::move(*static_cast<Fn*>(from)));
+            static_cast<Fn*>(from)->~Fn();
+        },
+        [](void* self) noexcept { static_cast<Fn*>(self)->~Fn(); },
+    };
+
+    void take(InlineFunction& other) noexcept {
+        if (other.ops_ == nullptr) return;
+        other.ops_->relocate(storage_, other.storage_);
+        ops_ = std::exchange(other.ops_, nullptr);
+    }
+
+    void reset() noexcept {
+        if (ops_ != nullptr) std::exchange(ops_, nullptr)->destroy(storage_);
+    }
+
+    alignas(void*) std::byte storage_[Capacity];
+    const Ops* ops_ = nullptr;
+};
+
+} // namespace utils
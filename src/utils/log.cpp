@@ -0,0 +1,478 @@
+#include "log.h"
+
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace utils::log {
+
+namespace detail {
+std::atomic<uint8_t> g_level{static_cast<uint8_t>(Level::Warn)};
+}
+
+namespace {
+
+using namespace std::chrono_literals;
+
+// Per-thread single-producer/single-consumer byte ring. head and tail only grow; a record is
+// a Header followed by its encoded arguments, padded to 8 bytes, and never wraps: when it
+// does not fit before the end of the buffer the rest of the buffer is skipped.
+constexpr std::size_t kRingBytes = 256 * 1024;
+constexpr std::size_t kMaxRecord = kRingBytes / 4;
+
+struct Header {
+    uint32_t size;          // whole record including padding
+    uint32_t args;
+    int64_t time_ns;        // since the epoch
+    const Site* site;       // nullptr: skip to the end of the buffer
+};
+
+constexpr std::size_t align8(std::size_t n) { return (n + 7) & ~std::size_t{7}; }
+
+struct Ring {
+    explicit Ring(uint32_t t) : thread(t), buffer(std::make_unique<uint8_t[]>(kRingBytes)) {}
+
+    const uint32_t thread;
+    std::unique_ptr<uint8_t[]> buffer;
+    alignas(64) std::atomic<uint64_t> head{0};  // written by the owning thread
+    alignas(64) std::atomic<uint64_t> tail{0};  // written by the logging thread
+    std::atomic<bool> retired{false};           // owning thread exited
+};
+
+std::atomic<uint32_t> g_next_thread{1};
+std::atomic<uint64_t> g_dropped{0};
+std::atomic<bool> g_stopped{false};
+
+struct ThreadState {
+    Ring* ring = nullptr;
+    bool exited = false;
+    uint32_t thread = 0;
+    // The record in progress between begin_record() and end_record().
+    uint8_t* record = nullptr;
+    uint32_t size = 0;
+    uint64_t advance = 0;       // size plus any skipped end of the buffer
+    std::string scratch;        // synchronous records
+
+    uint32_t id() {
+        if (!thread) thread = g_next_thread.fetch_add(1, std::memory_order_relaxed);
+        return thread;
+    }
+
+    ~ThreadState() {
+        exited = true;
+        if (ring) ring->retired.store(true, std::memory_order_release);
+    }
+};
+
+thread_local ThreadState t_state;
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::string_view base_name(const char* path) {
+    std::string_view p(path);
+    auto slash = p.rfind('/');
+    return slash == std::string_view::npos ? p : p.substr(slash + 1);
+}
+
+void append_digits(std::string& out, uint64_t value, int width) {
+    char buf[20];
+    for (int i = width - 1; i >= 0; --i, value /= 10) buf[i] = static_cast<char>('0' + value % 10);
+    out.append(buf, static_cast<std::size_t>(width));
+}
+
+void append_number(std::string& out, uint64_t value) {
+    char buf[20];
+    auto r = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, r.ptr);
+}
+
+// "HH:MM:SS.uuuuuu LEVEL tN file.cpp:line | message"
+void format_line(const Site& site, int64_t time_ns, uint32_t thread, const uint8_t* args, std::size_t count,
+                 std::string& out) {
+    // localtime_r takes a lock and checks the time zone: once per second per formatting thread.
+    thread_local time_t cached_secs = -1;
+    thread_local char clock[8];
+    time_t secs = static_cast<time_t>(time_ns / 1000000000);
+    if (secs != cached_secs) {
+        std::tm tm{};
+        localtime_r(&secs, &tm);
+        std::string hms;
+        append_digits(hms, tm.tm_hour, 2);
+        hms += ':';
+        append_digits(hms, tm.tm_min, 2);
+        hms += ':';
+        append_digits(hms, tm.tm_sec, 2);
+        std::memcpy(clock, hms.data(), sizeof(clock));
+        cached_secs = secs;
+    }
+    out.append(clock, sizeof(clock));
+    out += '.';
+    append_digits(out, static_cast<uint64_t>(time_ns % 1000000000 / 1000), 6);
+    out += ' ';
+    std::string_view level = level_name(site.level);
+    out += level;
+    out.append(6 - level.size(), ' ');
+    out += 't';
+    append_number(out, thread);
+    out += ' ';
+    out += base_name(site.file);
+    out += ':';
+    append_number(out, static_cast<uint64_t>(site.line));
+    out += " | ";
+    detail::format_args(site.format, args, count, out);
+}
+
+class Logger {
+public:
+    static Logger& instance() {
+        // Never destroyed: threads may log during static destruction.
+        static Logger* logger = [] {
+            auto* l = new Logger();
+            std::atexit([] { log::shutdown(); });
+            return l;
+        }();
+        return *logger;
+    }
+
+    Ring* attach(ThreadState& state) {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.push_back(std::make_unique<Ring>(state.id()));
+        if (!thread_.joinable() && !g_stopped.load(std::memory_order_acquire)) {
+            {
+                std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+                running_ = true;
+            }
+            thread_ = std::thread([this] { run(); });
+        }
+        return rings_.back().get();
+    }
+
+    void set_sink(Sink sink) {
+        std::lock_guard<std::mutex> lock(sink_mutex_);
+        sink_ = std::move(sink);
+    }
+
+    // Synchronous path, after shutdown() or from an exiting thread.
+    void write_now(const Site& site, uint32_t thread, const uint8_t* args, std::size_t count) {
+        std::string line;
+        format_line(site, now_ns(), thread, args, count, line);
+        std::lock_guard<std::mutex> lock(sink_mutex_);
+        emit(site.level, line);
+        flush_stderr();
+    }
+
+    void flush() {
+        std::unique_lock<std::mutex> lock(flush_mutex_);
+        if (!running_) return;
+        uint64_t ticket = ++flush_requested_;
+        wake_cv_.notify_one();
+        flushed_cv_.wait(lock, [&] { return flush_done_ >= ticket || !running_; });
+    }
+
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(rings_mutex_);
+            if (g_stopped.exchange(true, std::memory_order_acq_rel)) return;
+        }
+        stop_.store(true, std::memory_order_release);
+        if (thread_.joinable()) thread_.join();
+    }
+
+private:
+    Logger() = default;
+
+    void run() {
+        std::vector<Ring*> rings;
+        auto idle = 1ms;
+        for (;;) {
+            bool stopping = stop_.load(std::memory_order_acquire);
+            uint64_t requested;
+            {
+                std::lock_guard<std::mutex> lock(flush_mutex_);
+                requested = flush_requested_;
+            }
+            snapshot(rings);
+            std::size_t records = 0;
+            for (Ring* ring : rings) records += drain(*ring);
+            report_drops();
+            {
+                std::lock_guard<std::mutex> lock(sink_mutex_);
+                flush_stderr();
+            }
+            {
+                std::lock_guard<std::mutex> lock(flush_mutex_);
+                flush_done_ = requested;
+                if (stopping && records == 0) running_ = false;
+            }
+            flushed_cv_.notify_all();
+            if (stopping && records == 0) return;
+            if (records) {
+                idle = 1ms;
+            } else {
+                std::unique_lock<std::mutex> lock(flush_mutex_);
+                wake_cv_.wait_for(lock, idle, [&] { return flush_requested_ != requested; });
+                idle = std::min<std::chrono::milliseconds>(idle * 2, 8ms);
+            }
+        }
+    }
+
+    // Copies the ring list, dropping rings whose thread is gone and whose records are written.
+    void snapshot(std::vector<Ring*>& out) {
+        out.clear();
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        for (auto it = rings_.begin(); it != rings_.end();) {
+            Ring& r = **it;
+            if (r.retired.load(std::memory_order_acquire)
+                && r.tail.load(std::memory_order_relaxed) == r.head.load(std::memory_order_acquire)) {
+                it = rings_.erase(it);
+                continue;
+            }
+            out.push_back(&r);
+            ++it;
+        }
+    }
+
+    std::size_t drain(Ring& ring) {
+        uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+        const uint64_t head = ring.head.load(std::memory_order_acquire);
+        std::size_t records = 0;
+        std::lock_guard<std::mutex> lock(sink_mutex_);
+        while (tail != head) {
+            std::size_t offset = tail & (kRingBytes - 1);
+            if (kRingBytes - offset < sizeof(Header)) {
+                tail += kRingBytes - offset;
+                continue;
+            }
+            Header h;
+            std::memcpy(&h, ring.buffer.get() + offset, sizeof(h));
+            if (h.site) {
+                line_.clear();
+                format_line(*h.site, h.time_ns, ring.thread, ring.buffer.get() + offset + sizeof(Header), h.args, line_);
+                emit(h.site->level, line_);
+                ++records;
+            }
+            tail += h.size;
+        }
+        ring.tail.store(tail, std::memory_order_release);
+        return records;
+    }
+
+    void report_drops() {
+        uint64_t dropped = g_dropped.load(std::memory_order_relaxed);
+        if (dropped == reported_drops_) return;
+        static constexpr Site site{Level::Warn, "dropped {} log records, ring full", __FILE__, __LINE__};
+        line_.clear();
+        uint8_t args[16];
+        detail::encode(args, dropped - reported_drops_);
+        format_line(site, now_ns(), 0, args, 1, line_);
+        reported_drops_ = dropped;
+        std::lock_guard<std::mutex> lock(sink_mutex_);
+        emit(site.level, line_);
+    }
+
+    // Caller holds sink_mutex_.
+    void emit(Level level, const std::string& line) {
+        if (sink_) {
+            sink_(level, line);
+            return;
+        }
+        pending_ += line;
+        pending_ += '\n';
+        if (pending_.size() >= 64 * 1024) flush_stderr();
+    }
+
+    void flush_stderr() {
+        if (pending_.empty()) return;
+        std::fwrite(pending_.data(), 1, pending_.size(), stderr);
+        pending_.clear();
+    }
+
+    std::mutex rings_mutex_;
+    std::vector<std::unique_ptr<Ring>> rings_;
+    std::thread thread_;
+    std::atomic<bool> stop_{false};
+
+    std::mutex sink_mutex_;
+    Sink sink_;
+    std::string pending_;       // stderr lines of the current pass
+    std::string line_;          // logging thread only
+    uint64_t reported_drops_ = 0;
+
+    std::mutex flush_mutex_;
+    std::condition_variable wake_cv_;       // flush requested
+    std::condition_variable flushed_cv_;
+    bool running_ = false;
+    uint64_t flush_requested_ = 0;
+    uint64_t flush_done_ = 0;
+};
+
+void append_arg(const uint8_t*& p, std::string& out) {
+    auto type = static_cast<detail::ArgType>(*p++);
+    char buf[32];
+    auto number = [&](auto v) {
+        std::memcpy(&v, p, sizeof(v));
+        p += sizeof(v);
+        return v;
+    };
+    switch (type) {
+        case detail::ArgType::Int: {
+            auto r = std::to_chars(buf, buf + sizeof(buf), number(int64_t{}));
+            out.append(buf, r.ptr);
+            break;
+        }
+        case detail::ArgType::Uint: {
+            auto r = std::to_chars(buf, buf + sizeof(buf), number(uint64_t{}));
+            out.append(buf, r.ptr);
+            break;
+        }
+        case detail::ArgType::Double: {
+            auto r = std::to_chars(buf, buf + sizeof(buf), number(double{}));
+            out.append(buf, r.ptr);
+            break;
+        }
+        case detail::ArgType::Bool:
+            out += number(uint8_t{}) ? "true" : "false";
+            break;
+        case detail::ArgType::Char:
+            out += number(char{});
+            break;
+        case detail::ArgType::Pointer: {
+            out += "0x";
+            auto r = std::to_chars(buf, buf + sizeof(buf), number(uint64_t{}), 16);
+            out.append(buf, r.ptr);
+            break;
+        }
+        case detail::ArgType::String: {
+            uint32_t tagged = number(uint32_t{});
+            uint32_t n = tagged & 0x7fffffffu;
+            out.append(reinterpret_cast<const char*>(p), n);
+            p += n;
+            if (tagged & 0x80000000u) out += "...[cut]";
+            break;
+        }
+    }
+}
+
+} // namespace
+
+void set_level(Level level) {
+    detail::g_level.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+}
+
+std::optional<Level> parse_level(std::string_view name) {
+    static constexpr std::string_view kNames[] = {"trace", "debug", "info", "warn", "error", "off"};
+    for (uint8_t i = 0; i < std::size(kNames); ++i) {
+        if (name == kNames[i]) return static_cast<Level>(i);
+    }
+    return std::nullopt;
+}
+
+std::string_view level_name(Level level) {
+    switch (level) {
+        case Level::Trace: return "TRACE";
+        case Level::Debug: return "DEBUG";
+        case Level::Info:  return "INFO";
+        case Level::Warn:  return "WARN";
+        case Level::Error: return "ERROR";
+        case Level::Off:   return "OFF";
+    }
+    return "?";
+}
+
+void set_sink(Sink sink) { Logger::instance().set_sink(std::move(sink)); }
+
+void flush() { Logger::instance().flush(); }
+
+void shutdown() { Logger::instance().shutdown(); }
+
+uint64_t dropped() { return g_dropped.load(std::memory_order_relaxed); }
+
+namespace detail {
+
+uint8_t* begin_record(std::size_t size) {
+    ThreadState& t = t_state;
+    std::size_t total = align8(sizeof(Header) + size);
+    if (t.exited || g_stopped.load(std::memory_order_acquire)) {
+        t.scratch.resize(size);
+        t.record = nullptr;
+        return reinterpret_cast<uint8_t*>(t.scratch.data());
+    }
+    if (total > kMaxRecord) {
+        g_dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    if (!t.ring) t.ring = Logger::instance().attach(t);
+    Ring& ring = *t.ring;
+
+    const uint64_t head = ring.head.load(std::memory_order_relaxed);
+    const uint64_t tail = ring.tail.load(std::memory_order_acquire);
+    std::size_t offset = head & (kRingBytes - 1);
+    std::size_t room = kRingBytes - offset;
+    uint64_t advance = total;
+    if (room < total) {
+        advance += room;
+        offset = 0;
+    }
+    if (kRingBytes - (head - tail) < advance) {
+        g_dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    if (advance != total && room >= sizeof(Header)) {
+        Header skip{static_cast<uint32_t>(room), 0, 0, nullptr};
+        std::memcpy(ring.buffer.get() + (head & (kRingBytes - 1)), &skip, sizeof(skip));
+    }
+    t.record = ring.buffer.get() + offset;
+    t.size = static_cast<uint32_t>(total);
+    t.advance = advance;
+    return t.record + sizeof(Header);
+}
+
+void end_record(const Site& site, std::size_t args) {
+    ThreadState& t = t_state;
+    if (!t.record) {
+        Logger::instance().write_now(site, t.id(), reinterpret_cast<const uint8_t*>(t.scratch.data()), args);
+        return;
+    }
+    Header h{t.size, static_cast<uint32_t>(args), now_ns(), &site};
+    std::memcpy(t.record, &h, sizeof(h));
+    t.ring->head.fetch_add(t.advance, std::memory_order_release);
+    t.record = nullptr;
+}
+
+void format_args(const char* format, const uint8_t* args, std::size_t count, std::string& out) {
+    std::size_t used = 0;
+    for (const char* f = format; *f; ++f) {
+        if (f[0] == '{' && f[1] == '}') {
+            if (used < count) {
+                append_arg(args, out);
+                ++used;
+            } else {
+                out += "{}";
+            }
+            ++f;
+        } else if ((f[0] == '{' && f[1] == '{') || (f[0] == '}' && f[1] == '}')) {
+            out += *f++;
+        } else {
+            out += *f;
+        }
+    }
+    // Arguments without a placeholder are appended rather than lost.
+    for (; used < count; ++used) {
+        out += ' ';
+        append_arg(args, out);
+    }
+}
+
+} // namespace detail
+
+} // namespace utils::log
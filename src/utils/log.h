@@ -0,0 +1,174 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Logging with compile-time and runtime level filters and deferred formatting.
+//
+//   LOG_DEBUG("sendResponse fd={} type={} bytes={}", fd, type, size);
+//
+// A call below FILE_SERVER_LOG_LEVEL compiles to nothing; below the runtime level it costs one
+// relaxed load, and its arguments are not evaluated. An enabled call copies its arguments
+// (integers, floating point, bool, char, strings, pointers; enums as their value) into a
+// per-thread ring buffer and returns; a background thread formats the `{}` placeholders and
+// writes the lines to the sink (stderr by default). When a ring is full the record is dropped
+// and counted rather than blocking the caller. After shutdown(), calls format in place.
+
+#ifndef FILE_SERVER_LOG_LEVEL
+#if defined(DEBUG) && DEBUG == 1
+#define FILE_SERVER_LOG_LEVEL 0
+#else
+#define FILE_SERVER_LOG_LEVEL 2     // info
+#endif
+#endif
+
+namespace utils::log {
+
+enum class Level : uint8_t { Trace = 0, Debug = 1, Info = 2, Warn = 3, Error = 4, Off = 5 };
+
+// Lowest level compiled in.
+inline constexpr Level kCompiledLevel = static_cast<Level>(FILE_SERVER_LOG_LEVEL);
+
+namespace detail {
+extern std::atomic<uint8_t> g_level;
+}
+
+// Runtime threshold, Warn by default. Any thread, takes effect immediately.
+void set_level(Level level);
+inline Level level() { return static_cast<Level>(detail::g_level.load(std::memory_order_relaxed)); }
+inline bool enabled(Level l) { return static_cast<uint8_t>(l) >= detail::g_level.load(std::memory_order_relaxed); }
+
+std::optional<Level> parse_level(std::string_view name);     // "trace" ... "error", "off"
+std::string_view level_name(Level level);
+
+// Receives each formatted line (without the newline) on the logging thread.
+using Sink = std::function<void(Level level, std::string_view line)>;
+// nullptr restores the stderr sink.
+void set_sink(Sink sink);
+
+// Blocks until every record logged before the call has reached the sink.
+void flush();
+// Drains the rings and stops the logging thread; later records are written synchronously.
+// Runs at exit.
+void shutdown();
+// Records lost to full rings so far.
+uint64_t dropped();
+
+// A call site: static, so a record only stores its address.
+struct Site {
+    Level level;
+    const char* format;
+    const char* file;
+    int line;
+};
+
+namespace detail {
+
+enum class ArgType : uint8_t { Int, Uint, Double, Bool, Char, String, Pointer };
+
+// Longer strings are cut (and marked) so one record cannot take over a ring.
+inline constexpr uint32_t kMaxStringArg = 4096;
+
+template <typename T>
+concept StringLike = std::is_convertible_v<const T&, std::string_view>;
+
+template <typename T>
+std::string_view as_view(const T& v) {
+    if constexpr (std::is_pointer_v<T>) {       // char arrays are never null
+        if (!v) return "(null)";
+    }
+    return std::string_view(v);
+}
+
+template <typename T>
+std::size_t encoded_size(const T& v) {
+    if constexpr (StringLike<T>) {
+        std::size_t n = as_view(v).size();
+        return 1 + sizeof(uint32_t) + (n > kMaxStringArg ? kMaxStringArg : n);
+    } else if constexpr (std::is_same_v<T, bool> || std::is_same_v<T, char>) {
+        return 2;
+    } else {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>
+                          || std::is_null_pointer_v<T>,
+                      "log arguments are numbers, strings, enums and pointers");
+        return 1 + 8;
+    }
+}
+
+template <typename V>
+inline uint8_t* put(uint8_t* p, ArgType type, const V& v) {
+    *p++ = static_cast<uint8_t>(type);
+    std::memcpy(p, &v, sizeof(V));
+    return p + sizeof(V);
+}
+
+template <typename T>
+uint8_t* encode(uint8_t* p, const T& v) {
+    if constexpr (StringLike<T>) {
+        std::string_view s = as_view(v);
+        uint32_t n = static_cast<uint32_t>(s.size() > kMaxStringArg ? kMaxStringArg : s.size());
+        // The top bit marks a cut string.
+        uint32_t tagged = n | (s.size() > kMaxStringArg ? 0x80000000u : 0);
+        p = put(p, ArgType::String, tagged);
+        std::memcpy(p, s.data(), n);
+        return p + n;
+    } else if constexpr (std::is_same_v<T, bool>) {
+        return put(p, ArgType::Bool, static_cast<uint8_t>(v));
+    } else if constexpr (std::is_same_v<T, char>) {
+        return put(p, ArgType::Char, v);
+    } else if constexpr (std::is_enum_v<T>) {
+        return encode(p, static_cast<std::underlying_type_t<T>>(v));
+    } else if constexpr (std::is_pointer_v<T> || std::is_null_pointer_v<T>) {
+        return put(p, ArgType::Pointer, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(static_cast<const void*>(v))));
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return put(p, ArgType::Double, static_cast<double>(v));
+    } else if constexpr (std::is_signed_v<T>) {
+        return put(p, ArgType::Int, static_cast<int64_t>(v));
+    } else {
+        return put(p, ArgType::Uint, static_cast<uint64_t>(v));
+    }
+}
+
+// Room for `size` bytes of encoded arguments: in the calling thread's ring, or in a scratch
+// buffer once records are written synchronously. nullptr when the ring is full (dropped).
+uint8_t* begin_record(std::size_t size);
+// Publishes the record begun by the last begin_record() of this thread.
+void end_record(const Site& site, std::size_t args);
+
+// Formats a record's arguments into out; the logging thread and the synchronous path share it.
+void format_args(const char* format, const uint8_t* args, std::size_t count, std::string& out);
+
+template <typename... Args>
+void write(const Site& site, const Args&... args) {
+    uint8_t* p = begin_record((std::size_t{0} + ... + encoded_size(args)));
+    if (!p) return;
+    ((p = encode(p, args)), ...);
+    end_record(site, sizeof...(args));
+}
+
+} // namespace detail
+
+} // namespace utils::log
+
+#define FS_LOG_AT(lvl, fmt, ...)                                                                   \
+    do {                                                                                           \
+        if constexpr ((lvl) >= ::utils::log::kCompiledLevel && (lvl) != ::utils::log::Level::Off) { \
+            if (::utils::log::enabled(lvl)) {                                                      \
+                static constexpr ::utils::log::Site fs_log_site{(lvl), fmt, __FILE__, __LINE__};   \
+                ::utils::log::detail::write(fs_log_site __VA_OPT__(, ) __VA_ARGS__);               \
+            }                                                                                      \
+        }                                                                                          \
+    } while (0)
+
+#define LOG_TRACE(fmt, ...) FS_LOG_AT(::utils::log::Level::Trace, fmt __VA_OPT__(, ) __VA_ARGS__)
+#define LOG_DEBUG(fmt, ...) FS_LOG_AT(::utils::log::Level::Debug, fmt __VA_OPT__(, ) __VA_ARGS__)
+#define LOG_INFO(fmt, ...)  FS_LOG_AT(::utils::log::Level::Info, fmt __VA_OPT__(, ) __VA_ARGS__)
+#define LOG_WARN(fmt, ...)  FS_LOG_AT(::utils::log::Level::Warn, fmt __VA_OPT__(, ) __VA_ARGS__)
+#define LOG_ERROR(fmt, ...) FS_LOG_AT(::utils::log::Level::Error, fmt __VA_OPT__(, ) __VA_ARGS__)
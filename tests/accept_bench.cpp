@@ -0,0 +1,226 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <string>
+#include <iomanip>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "net/poller.h"
+#include "net/listener.h"
+
+// Accept-rate benchmark of the three AcceptMode strategies used by MainReactor/IOReactor:
+//   main       one acceptor thread drains accept4() and hands fds to worker pollers round-robin
+//   reuseport  every worker owns a SO_REUSEPORT listener and accepts in batches
+//   exclusive  one listener registered in every worker poller with EPOLLEXCLUSIVE
+// Clients run a connection storm (connect + RST close); workers register and then drop each fd.
+
+struct BenchConfig {
+    int workers = 4;
+    int clients = 8;
+    int connects = 5000;      // connections per client thread
+    std::string mode = "all";
+    std::string backend = "epoll";
+};
+
+static BenchConfig parse_args(int argc, char** argv) {
+    BenchConfig cfg;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        auto need = [&](int i){ if (i+1>=argc) { std::cerr << "Missing value after " << a << "\n"; std::exit(1);} };
+        if (a == "--workers") { need(i); cfg.workers = std::atoi(argv[++i]); }
+        else if (a == "--clients") { need(i); cfg.clients = std::atoi(argv[++i]); }
+        else if (a == "--connects") { need(i); cfg.connects = std::atoi(argv[++i]); }
+        else if (a == "--mode") { need(i); cfg.mode = argv[++i]; }
+        else if (a == "--backend") { need(i); cfg.backend = argv[++i]; }
+        else if (a == "--help") {
+            std::cout << "Usage: accept_bench [options]\n"
+                      << "  --workers N            IO reactor threads (default 4)\n"
+                      << "  --clients N            connecting client threads (default 8)\n"
+                      << "  --connects N           connections per client thread (default 5000)\n"
+                      << "  --mode NAME            main | reuseport | exclusive | all (default all)\n"
+                      << "  --backend NAME         epoll | io_uring (default epoll)\n"
+                      << "  --help                 show this help\n";
+            std::exit(0);
+        }
+    }
+    return cfg;
+}
+
+static uint16_t bound_port(int fd) {
+    sockaddr_in addr{};
+    socklen_t len = sizeof(addr);
+    ::getsockname(fd, (sockaddr*)&addr, &len);
+    return ntohs(addr.sin_port);
+}
+
+struct Worker {
+    std::unique_ptr<net::Poller> poller;
+    net::Listener listener;
+    int listen_fd{-1};
+    std::thread thread;
+};
+
+static bool run_mode(net::AcceptMode mode, const char* mode_name, const BenchConfig& cfg) {
+    constexpr int kAcceptBatch = 64;
+    net::PollerBackend backend = net::parse_poller_backend(cfg.backend).value_or(net::PollerBackend::Epoll);
+    const int64_t total = int64_t(cfg.clients) * cfg.connects;
+    std::atomic<int64_t> accepted{0};
+    std::atomic<bool> done{false};
+
+    std::vector<Worker> workers(cfg.workers);
+    for (auto& w : workers) w.poller = net::make_poller(backend);
+
+    net::Listener main_listener;
+    uint16_t port = 0;
+    if (mode == net::AcceptMode::ReusePort) {
+        for (auto& w : workers) {
+            if (!w.listener.listen_on(port, "127.0.0.1", true)) return false;
+            port = bound_port(w.listener.get_fd());
+            w.listen_fd = w.listener.get_fd();
+            if (!w.poller->add_acceptor(w.listen_fd)) w.poller->add_fd(w.listen_fd, EPOLLIN);
+        }
+    } else {
+        if (!main_listener.listen_on(0, "127.0.0.1")) return false;
+        port = bound_port(main_listener.get_fd());
+        if (mode == net::AcceptMode::SharedExclusive) {
+            for (auto& w : workers) {
+                w.listen_fd = main_listener.get_fd();
+                w.poller->add_fd(w.listen_fd, EPOLLIN | EPOLLEXCLUSIVE);
+            }
+        }
+    }
+
+    auto accept_into = [&](int listen_fd, int limit, auto&& place) {
+        for (int i = 0; limit < 0 || i < limit; ++i) {
+            int fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR) continue;
+                return;
+            }
+            accepted.fetch_add(1, std::memory_order_relaxed);
+            place(fd);
+        }
+    };
+
+    for (auto& w : workers) {
+        w.thread = std::thread([&, wp = &w]{
+            while (!done.load(std::memory_order_relaxed)) {
+                auto events = wp->poller->poll(50);
+                if (!events) break;
+                for (auto& ev : *events) {
+                    if (ev.data.fd == wp->listen_fd) {
+                        accept_into(wp->listen_fd, kAcceptBatch, [&](int fd){ wp->poller->add_fd(fd, EPOLLIN | EPOLLET); });
+                        continue;
+                    }
+                    wp->poller->remove_fd(ev.data.fd);
+                    ::close(ev.data.fd);
+                }
+                for (int fd : wp->poller->accepted()) {
+                    accepted.fetch_add(1, std::memory_order_relaxed);
+                    wp->poller->add_fd(fd, EPOLLIN | EPOLLET);
+                }
+            }
+        });
+    }
+
+    std::thread acceptor;
+    if (mode == net::AcceptMode::MainReactor) {
+        acceptor = std::thread([&]{
+            auto poller = net::make_poller(backend);
+            int listen_fd = main_listener.get_fd();
+            const bool in_poller = poller->add_acceptor(listen_fd);
+            if (!in_poller) poller->add_fd(listen_fd, EPOLLIN | EPOLLET);
+            uint64_t rr = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                auto events = poller->poll(50);
+                if (!events) break;
+                for (int fd : poller->accepted()) {
+                    accepted.fetch_add(1, std::memory_order_relaxed);
+                    workers[rr++ % workers.size()].poller->add_fd(fd, EPOLLIN | EPOLLET);
+                }
+                if (in_poller || events->empty()) continue;
+                accept_into(listen_fd, -1, [&](int fd){
+                    workers[rr++ % workers.size()].poller->add_fd(fd, EPOLLIN | EPOLLET);
+                });
+            }
+        });
+    }
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::thread> clients;
+    std::atomic<int64_t> failed{0};
+    for (int c = 0; c < cfg.clients; ++c) {
+        clients.emplace_back([&]{
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = htons(port);
+            linger lg{1, 0}; // RST on close: no TIME_WAIT, so the storm does not exhaust ephemeral ports
+            for (int i = 0; i < cfg.connects; ++i) {
+                int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+                if (::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+                    failed.fetch_add(1, std::memory_order_relaxed);
+                }
+                ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+                ::close(fd);
+            }
+        });
+    }
+    for (auto& t : clients) t.join();
+
+    const int64_t expected = total - failed.load();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (accepted.load() < expected && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+    done.store(true);
+    if (acceptor.joinable()) acceptor.join();
+    for (auto& w : workers) w.thread.join();
+
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+    double sec = ns / 1e9;
+    std::cout << "ACCEPT BENCH RESULT\n"
+              << " mode=" << mode_name
+              << " backend=" << workers[0].poller->name()
+              << " workers=" << cfg.workers
+              << " clients=" << cfg.clients
+              << " connections=" << total
+              << " time_sec=" << std::fixed << std::setprecision(6) << sec
+              << " accepts_K_per_sec=" << std::setprecision(3) << (accepted.load() / 1e3 / sec)
+              << "\n";
+
+    if (accepted.load() != expected || failed.load() != 0) {
+        std::cerr << "ERROR: accepted=" << accepted.load() << " expected=" << total
+                  << " failed_connects=" << failed.load() << "\n";
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg = parse_args(argc, argv);
+    bool ok = true;
+    if (cfg.mode == "all" || cfg.mode == "main") {
+        ok &= run_mode(net::AcceptMode::MainReactor, "main", cfg);
+    }
+    if (cfg.mode == "all" || cfg.mode == "reuseport") {
+        ok &= run_mode(net::AcceptMode::ReusePort, "reuseport", cfg);
+    }
+    if (cfg.mode == "all" || cfg.mode == "exclusive") {
+        ok &= run_mode(net::AcceptMode::SharedExclusive, "exclusive", cfg);
+    }
+    return ok ? 0 : 1;
+}
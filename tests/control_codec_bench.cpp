@@ -0,0 +1,235 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "net/frame_buffer.h"
+#include "nlohmann/json.hpp"
+#include "protocol/codec.h"
+#include "protocol/request_parser.h"
+#include "protocol/response_builder.h"
+#include "protocol/wire_format.h"
+#include "types/enums.h"
+
+// Control messages in JSON against the binary encoding of protocol/codec.h.
+//
+// codec: encode and decode ns/op and body bytes of single messages. JSON decode of a request
+//        is nlohmann parse plus the schema mapping; responses are decoded the way the client
+//        does (binary: decode_response + response_to_json).
+// path:  the server side of one ls / cd / stat call on one thread, ops/s: RequestParser::parse
+//        of the REQUEST body, the handler's ResponseBuilder call, the encoding sendResponse
+//        does and a sealed pooled frame. FileManager and database work is replaced by fixed
+//        results (a 32-entry listing, a path, file metadata), so this is the protocol cost only.
+//        json_legacy is the code before the schema: nlohmann::json in, nlohmann::json out.
+
+using Clock = std::chrono::steady_clock;
+using nlohmann::json;
+
+struct BenchConfig {
+    int64_t iterations = 500000;
+    std::string part = "all";   // codec, path or all
+};
+
+static BenchConfig parse_args(int argc, char** argv) {
+    BenchConfig cfg;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        auto need = [&](int i){ if (i+1>=argc) { std::cerr << "Missing value after " << a << "\n"; std::exit(1);} };
+        if (a == "--iterations") { need(i); cfg.iterations = std::atoll(argv[++i]); }
+        else if (a == "--part") { need(i); cfg.part = argv[++i]; }
+        else if (a == "--help") {
+            std::cout << "Usage: control_codec_bench [options]\n"
+                      << "  --part codec|path|all  what to measure (default all)\n"
+                      << "  --iterations N         operations per measurement (default 500000)\n"
+                      << "  --help                 show this help\n";
+            std::exit(0);
+        }
+    }
+    return cfg;
+}
+
+static uint64_t g_sink = 0;     // results feed main()'s exit code so nothing is optimised away
+
+static double ns_per_op(int64_t n, const std::function<void()>& op) {
+    for (int64_t i = 0; i < n / 10; ++i) op();    // warm up
+    auto t0 = Clock::now();
+    for (int64_t i = 0; i < n; ++i) op();
+    return std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / n;
+}
+
+static std::string listing() {
+    std::string out;
+    for (int i = 0; i < 32; ++i) {
+        out += (i % 5 == 0 ? "[DIR]  dir_" : "[FILE] report_") + std::to_string(i) + (i % 5 == 0 ? "" : ".pdf")
+             + "\t" + std::to_string(1000 + i * 7919) + "\n";
+    }
+    return out;
+}
+
+static const uint8_t* bytes(const std::string& s) { return reinterpret_cast<const uint8_t*>(s.data()); }
+
+static void report_codec(const std::string& name, const std::string& encoding, size_t size, double enc, double dec) {
+    std::cout << "CODEC BENCH RESULT"
+              << " msg=" << name
+              << " encoding=" << encoding
+              << " bytes=" << size
+              << std::fixed << std::setprecision(0)
+              << " encode_ns=" << enc
+              << " decode_ns=" << dec
+              << "\n";
+}
+
+static void bench_request(const std::string& name, const protocol::Request& request, int64_t n) {
+    std::string text = protocol::request_to_json(request).dump();
+    double enc = ns_per_op(n, [&] { g_sink += protocol::request_to_json(request).dump().size(); });
+    double dec = ns_per_op(n, [&] {
+        auto r = protocol::request_from_json(json::parse(text));
+        g_sink += r->index();
+    });
+    report_codec(name, "json", text.size(), enc, dec);
+
+    std::string bin;
+    protocol::encode_request(request, bin);
+    enc = ns_per_op(n, [&] {
+        std::string out;
+        protocol::encode_request(request, out);
+        g_sink += out.size();
+    });
+    dec = ns_per_op(n, [&] { g_sink += protocol::decode_request(bytes(bin), bin.size())->index(); });
+    report_codec(name, "binary", bin.size(), enc, dec);
+}
+
+// nested: the JSON form carries its fields as a string in responseMessage (login, pubkey),
+// which the client parses a second time.
+static void bench_response(const std::string& name, const protocol::Response& response, int64_t n,
+                           bool nested = false) {
+    std::string text = protocol::response_to_json(response).dump();
+    double enc = ns_per_op(n, [&] { g_sink += protocol::response_to_json(response).dump().size(); });
+    double dec = ns_per_op(n, [&] {
+        auto j = json::parse(text);
+        if (nested) j = json::parse(j["responseMessage"].get<std::string>());
+        g_sink += j.size();
+    });
+    report_codec(name, "json", text.size(), enc, dec);
+
+    std::string bin;
+    protocol::encode_response(response, bin);
+    enc = ns_per_op(n, [&] {
+        std::string out;
+        protocol::encode_response(response, out);
+        g_sink += out.size();
+    });
+    dec = ns_per_op(n, [&] { g_sink += protocol::decode_response(bytes(bin), bin.size())->index(); });
+    report_codec(name, "binary", bin.size(), enc, dec);
+}
+
+static void run_codec(const BenchConfig& cfg) {
+    protocol::ResponseBuilder rb;
+    int64_t n = cfg.iterations;
+    bench_request("req_ls", protocol::LsRequest{}, n);
+    bench_request("req_cd", protocol::CdRequest{"/projects/2024/reports"}, n);
+    bench_request("req_stat", protocol::StatRequest{"/projects/2024/reports/q3.pdf"}, n);
+    bench_request("req_put", protocol::PutRequest{"q3.pdf", 7340032, std::string(40, 'c')}, n);
+    bench_response("resp_ls", rb.build(listing()), n / 4);
+    bench_response("resp_cd", rb.build("/projects/2024/reports"), n);
+    bench_response("resp_stat", rb.buildStatResponse("q3.pdf", false, 7340032, std::string(40, 'c')), n);
+    bench_response("resp_get_init", rb.buildGetInitResponse("q3.pdf", 0, 7340032, std::string(40, 'c')), n);
+    bench_response("resp_login", rb.buildLoginResponse(std::string(600, 't'), 42, 7, "alice"), n / 4, true);
+    bench_response("resp_error", rb.buildErrorResponse(404, "virtual path not found"), n);
+}
+
+// One ls/cd/stat on the server: parse, handler result, encode, pooled frame.
+struct PathCase {
+    std::string op;
+    protocol::Request request;
+};
+
+static void run_path(const BenchConfig& cfg) {
+    auto pool = net::FramePool::create();
+    auto format = protocol::negotiate(protocol::kProtocolV2, protocol::kCapLargeFrames | protocol::kCapBinaryControl,
+                                      protocol::kMaxBodyV2);
+    protocol::ResponseBuilder rb;
+    const std::string ls_result = listing();
+    const std::string cwd = "/projects/2024/reports";
+    const std::string hash(40, 'c');
+
+    auto handle = [&](const protocol::Request& request) -> protocol::Response {
+        switch (protocol::command_of(request)) {
+            case protocol::Command::Ls: return rb.build(ls_result);
+            case protocol::Command::Cd: return rb.build(std::get<protocol::CdRequest>(request).path);
+            default: return rb.buildStatResponse(std::get<protocol::StatRequest>(request).file_name, false, 7340032, hash);
+        }
+    };
+    auto frame_out = [&](const std::string& raw, uint8_t flags) {
+        net::FrameRef frame = pool->acquire(raw.size(), format);
+        frame->header().type = static_cast<uint8_t>(MessageType::RESPONSE);
+        frame->header().flags = flags;
+        std::memcpy(frame->body(), raw.data(), raw.size());
+        frame->seal();
+        g_sink += frame->wire_size();
+    };
+
+    std::vector<PathCase> cases{
+        {"ls", protocol::LsRequest{}},
+        {"cd", protocol::CdRequest{cwd}},
+        {"stat", protocol::StatRequest{"/projects/2024/reports/q3.pdf"}},
+    };
+    for (const auto& c : cases) {
+        std::string text = protocol::request_to_json(c.request).dump();
+        std::string bin;
+        protocol::encode_request(c.request, bin);
+        protocol::RequestParser parser;
+
+        // The pre-schema server: handlers read and wrote nlohmann::json directly.
+        double legacy = ns_per_op(cfg.iterations, [&] {
+            json req = json::parse(text);
+            std::string command = req.value("command", "");
+            json resp;
+            if (command == "ls") {
+                resp = {{"responseMessage", ls_result}};
+            } else if (command == "cd") {
+                resp = {{"responseMessage", req.value("params", "/")}};
+            } else {
+                auto params = req.value("params", json::object());
+                resp = {{"status", "stat"}, {"fileName", params.value("file_name", "")}, {"isDirectory", false},
+                        {"fileSize", 7340032}, {"fileHash", hash}};
+            }
+            frame_out(resp.dump(), 0);
+        });
+        double json_ns = ns_per_op(cfg.iterations, [&] {
+            auto request = parser.parse(bytes(text), text.size(), false);
+            frame_out(protocol::response_to_json(handle(*request)).dump(), 0);
+        });
+        double binary_ns = ns_per_op(cfg.iterations, [&] {
+            auto request = parser.parse(bytes(bin), bin.size(), true);
+            std::string raw;
+            protocol::encode_response(handle(*request), raw);
+            frame_out(raw, protocol::kFrameBinary);
+        });
+
+        struct Row { const char* encoding; double ns; };
+        for (const Row& row : {Row{"json_legacy", legacy}, Row{"json", json_ns}, Row{"binary", binary_ns}}) {
+            std::cout << "CONTROL PATH BENCH RESULT"
+                      << " op=" << c.op
+                      << " encoding=" << row.encoding
+                      << std::fixed << std::setprecision(0)
+                      << " ns_per_op=" << row.ns
+                      << " ops_per_sec=" << (1e9 / row.ns)
+                      << std::setprecision(2)
+                      << " speedup=" << (legacy / row.ns)
+                      << "\n";
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg = parse_args(argc, argv);
+    if (cfg.part == "all" || cfg.part == "codec") run_codec(cfg);
+    if (cfg.part == "all" || cfg.part == "path") run_path(cfg);
+    return g_sink == 0xdeadbeef;
+}
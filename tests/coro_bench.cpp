@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "concurrency/coroutine.h"
+#include "concurrency/lf_thread_pool.h"
+
+// Requests that wait on a slow database, on the server's worker layout (2 pinned + 4 flexible
+// workers, no core pinning here). A request is --cpu-us of handler work, one DB round trip of
+// --db-us (a sleep), and --cpu-us more, like GET's lookup-then-respond. --clients requests are
+// kept outstanding (closed loop) until --requests have completed.
+//
+// blocking:    the handler as before: the DB call holds its worker for the whole round trip,
+//              so at most 6 requests make progress at a time.
+// coroutine:   the handler is a concurrency::Co coroutine; the DB call is co_await run_on()
+//              on a --db-threads executor and the worker goes on with other requests.
+//
+// max_in_db is the most requests inside the DB call at once (the concurrency reached);
+// latency is from issuing a request to its completion.
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    int requests = 20000;
+    int clients = 256;
+    int db_us = 5000;
+    int cpu_us = 20;
+    int db_threads = 64;
+};
+
+static BenchConfig parse_args(int argc, char** argv) {
+    BenchConfig cfg;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        auto need = [&](int i){ if (i+1>=argc) { std::cerr << "Missing value after " << a << "\n"; std::exit(1);} };
+        if (a == "--requests") { need(i); cfg.requests = std::atoi(argv[++i]); }
+        else if (a == "--clients") { need(i); cfg.clients = std::atoi(argv[++i]); }
+        else if (a == "--db-us") { need(i); cfg.db_us = std::atoi(argv[++i]); }
+        else if (a == "--cpu-us") { need(i); cfg.cpu_us = std::atoi(argv[++i]); }
+        else if (a == "--db-threads") { need(i); cfg.db_threads = std::atoi(argv[++i]); }
+        else if (a == "--help") {
+            std::cout << "Usage: coro_bench [options]\n"
+                      << "  --requests N           requests to complete per variant (default 20000)\n"
+                      << "  --clients N            requests kept outstanding (default 256)\n"
+                      << "  --db-us N              DB round trip, slept (default 5000)\n"
+                      << "  --cpu-us N             handler work before and after the DB call (default 20)\n"
+                      << "  --db-threads N         DB executor workers of the coroutine variant (default 64)\n"
+                      << "  --help                 show this help\n";
+            std::exit(0);
+        }
+    }
+    return cfg;
+}
+
+static uint64_t g_sink = 0;     // results feed main()'s exit code so nothing is optimised away
+
+static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+static void burn(int us) {
+    const int64_t until = now_ns() + us * 1000ll;
+    uint64_t x = 0;
+    while (now_ns() < until) x += x * 31 + 7;
+    g_sink += x & 1;
+}
+
+// The closed loop: every completion issues the next request until enough were issued.
+struct Load {
+    const BenchConfig& cfg;
+    concurrency::LFThreadPool& pool;
+    concurrency::LFThreadPool* db;      // nullptr: blocking handlers
+    std::vector<int64_t> issued_at;
+    std::vector<int64_t> latency;
+    std::atomic<int> issued{0};
+    std::atomic<int> completed{0};
+    std::atomic<int> in_db{0};
+    std::atomic<int> max_in_db{0};
+
+    Load(const BenchConfig& cfg, concurrency::LFThreadPool& pool, concurrency::LFThreadPool* db)
+        : cfg(cfg), pool(pool), db(db), issued_at(cfg.requests), latency(cfg.requests) {}
+
+    void db_call() {
+        int now = in_db.fetch_add(1) + 1;
+        int seen = max_in_db.load();
+        while (now > seen && !max_in_db.compare_exchange_weak(seen, now)) {}
+        std::this_thread::sleep_for(std::chrono::microseconds(cfg.db_us));
+        in_db.fetch_sub(1);
+    }
+
+    void issue() {
+        int id = issued.fetch_add(1);
+        if (id >= cfg.requests) return;
+        issued_at[id] = now_ns();
+        while (!pool.submit([this, id] { db ? concurrency::spawn(serve(id)) : handle(id); })) std::this_thread::yield();
+    }
+
+    void handle(int id) {
+        burn(cfg.cpu_us);
+        db_call();
+        burn(cfg.cpu_us);
+        complete(id);
+    }
+
+    concurrency::Co<void> serve(int id) {
+        burn(cfg.cpu_us);
+        co_await concurrency::run_on(db, [this] { db_call(); }, "db");
+        burn(cfg.cpu_us);
+        complete(id);
+    }
+
+    void complete(int id) {
+        latency[id] = now_ns() - issued_at[id];
+        completed.fetch_add(1);
+        issue();
+    }
+};
+
+static void run(const char* variant, const BenchConfig& cfg, bool coroutine) {
+    concurrency::LFThreadPool pool(2, 4, 1024, 1024);
+    concurrency::LFThreadPool db(static_cast<std::size_t>(cfg.db_threads), 1024);
+    Load load(cfg, pool, coroutine ? &db : nullptr);
+    auto t0 = Clock::now();
+    for (int i = 0; i < cfg.clients; ++i) load.issue();
+    while (load.completed.load() < cfg.requests) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    std::vector<int64_t>& lat = load.latency;
+    std::sort(lat.begin(), lat.end());
+    auto pct = [&](double q) { return lat[std::min<std::size_t>(lat.size() - 1, lat.size() * q)] / 1e6; };
+    g_sink += load.completed.load();
+
+    std::cout << "CORO BENCH RESULT"
+              << " variant=" << variant
+              << " workers=" << pool.pinned_worker_count() + pool.flexible_worker_count()
+              << " db_threads=" << (coroutine ? cfg.db_threads : 0)
+              << " clients=" << cfg.clients
+              << " db_us=" << cfg.db_us
+              << std::fixed << std::setprecision(0)
+              << " requests_per_sec=" << cfg.requests / secs
+              << " max_in_db=" << load.max_in_db.load()
+              << std::setprecision(2)
+              << " p50_ms=" << pct(0.5)
+              << " p99_ms=" << pct(0.99)
+              << "\n";
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg = parse_args(argc, argv);
+    run("blocking", cfg, false);
+    run("coroutine", cfg, true);
+    return g_sink == 0xdeadbeef;
+}
@@ -0,0 +1,258 @@
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "concurrency/lf_thread_pool.h"
+#include "lockfreequeue/array_mpmc_queue.hpp"
+#include "net/block_pool.h"
+#include "net/frame_buffer.h"
+#include "net/request_pipeline.h"
+#include "protocol/commands.h"
+#include "utils/alloc_counter.h"
+
+// Heap allocations and ns per request of the dispatch machinery around a handler, on one
+// thread: command lookup, handler creation, the thread pool task, holding the response for
+// in-order delivery, and resetting the connection to its base handler. The handler classes
+// are stand-ins of RequestHandler's size; parsing, the handler's own work, the response body
+// and logging are left out.
+//
+// before: if-chains on the command (and the string compare chain of the base handler's
+//         handle() for non-pipelined commands), make_shared per handler, a task capturing the
+//         handler and the admission controller, a vector for held responses, and
+//         `new RequestHandler` + control block to reset the connection.
+// after:  the CommandRoute table, handlers from the reactor's BlockPool, a task capturing the
+//         handler only, one inline held response.
+// open:   a connection's Connection, ConnectionContext, FrameDecoder and base handler.
+// lookup: the JSON "command" name to protocol::Command, linear scan vs the perfect hash.
+//
+// Built with FILE_SERVER_COUNT_ALLOCS, so allocs_per_request is exact. Both variants keep the
+// std::function closure of the pipeline delivery, which libstdc++ stores on the heap once it
+// captures a shared_ptr; the thread pool task (utils::InlineFunction) stores its capture inline.
+
+using Clock = std::chrono::steady_clock;
+using Task = concurrency::LFThreadPool::Task;
+
+struct BenchConfig {
+    int64_t requests = 1000000;
+};
+
+static BenchConfig parse_args(int argc, char** argv) {
+    BenchConfig cfg;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        auto need = [&](int i){ if (i+1>=argc) { std::cerr << "Missing value after " << a << "\n"; std::exit(1);} };
+        if (a == "--requests") { need(i); cfg.requests = std::atoll(argv[++i]); }
+        else if (a == "--help") {
+            std::cout << "Usage: dispatch_bench [options]\n"
+                      << "  --requests N           requests per measurement (default 1000000)\n"
+                      << "  --help                 show this help\n";
+            std::exit(0);
+        }
+    }
+    return cfg;
+}
+
+static uint64_t g_sink = 0;     // results feed main()'s exit code so nothing is optimised away
+
+struct Context {
+    std::shared_ptr<net::RequestPipeline> pipeline;
+    std::shared_ptr<int> admission;
+    std::shared_ptr<struct Handler> installed;     // Connection::handler
+    std::shared_ptr<std::array<char, 56>> decoder;
+};
+
+// RequestHandler stand-in: same size, vtable, enable_shared_from_this and move-assignment.
+struct Handler : std::enable_shared_from_this<Handler> {
+    Handler() = default;
+    explicit Handler(std::shared_ptr<Context> c) : ctx(std::move(c)) {}
+    virtual ~Handler() = default;
+    virtual void handle() { ++g_sink; }
+    Handler& operator=(Handler&& other) {
+        ctx = std::move(other.ctx);
+        return *this;
+    }
+
+    std::shared_ptr<Context> ctx;
+    uint64_t seq{0};
+    net::FrameRef held;
+    std::vector<net::FrameRef> held_more;
+    char state[400]{};
+};
+struct ListStub : Handler {};
+struct CdStub : Handler {};
+static_assert(sizeof(Handler) == 480, "keep the stand-in at sizeof(handlers::RequestHandler)");
+
+
+struct ConnectionStub {
+    explicit ConnectionStub(std::shared_ptr<Context> c) : ctx(std::move(c)) {}
+    std::shared_ptr<Context> ctx;
+    char state[304]{};
+};
+
+// The dispatch of both variants: pipelined "ls" and non-pipelined "cd".
+class Dispatcher {
+public:
+    explicit Dispatcher(bool pooled) : pooled_(pooled), tasks_(16), objects_(net::BlockPool::create()),
+                                       frames_(net::FramePool::create()) {
+        ctx_ = std::make_shared<Context>();
+        ctx_->admission = std::make_shared<int>(0);
+        ctx_->pipeline = std::make_shared<net::RequestPipeline>();
+        ctx_->installed = std::make_shared<Handler>(ctx_);
+    }
+
+    void request(protocol::Command command) {
+        using protocol::Command;
+        if (pooled_) {
+            if (kPipelined[static_cast<uint8_t>(command)]) pipelined_after();
+            else connection_after();
+        } else {
+            if (command == Command::Ls || command == Command::Pwd || command == Command::Mkdir || command == Command::Rm
+                || command == Command::Rmdir || command == Command::Pubkey || command == Command::Stat) {
+                pipelined_before();
+            } else {
+                connection_before(command);
+            }
+        }
+    }
+
+    // Accept and close of one connection.
+    void open_close() {
+        auto* pool = pooled_ ? objects_.get() : nullptr;
+        auto ctx = net::make_pooled<Context>(pool);
+        auto conn = net::make_pooled<ConnectionStub>(pool, ctx);
+        ctx->decoder = net::make_pooled<std::array<char, 56>>(pool);
+        ctx->installed = net::make_pooled<Handler>(pool, ctx);
+        g_sink += conn->state[0];
+        ctx->installed.reset();
+    }
+
+private:
+    static constexpr auto kPipelined = [] {
+        std::array<bool, protocol::kCommandCount + 1> t{};
+        t[static_cast<uint8_t>(protocol::Command::Ls)] = true;
+        return t;
+    }();
+
+    void run_task() {
+        Task t;
+        while (tasks_.try_pop(t)) t();
+    }
+
+    net::FrameRef respond() {
+        auto frame = frames_->acquire(64);
+        frame->header().length = 64;
+        return frame;
+    }
+
+    void pipelined_before() {
+        std::shared_ptr<Handler> h = std::make_shared<ListStub>();
+        h->ctx = ctx_;
+        h->seq = ctx_->pipeline->begin();
+        tasks_.try_push(Task([h, admission = ctx_->admission]() { h->handle(); }));
+        run_task();
+        h->held_more.push_back(respond());
+        auto ctx = h->ctx;
+        ctx_->pipeline->complete(h->seq, [ctx, frames = std::move(h->held_more)]() {
+            for (const auto& f : frames) g_sink += f->header().length;
+        });
+    }
+
+    void pipelined_after() {
+        std::shared_ptr<Handler> h = net::make_pooled<ListStub>(objects_.get());
+        h->ctx = ctx_;
+        h->seq = ctx_->pipeline->begin();
+        tasks_.try_push(Task([h]() { h->handle(); }));
+        run_task();
+        h->held = respond();
+        ctx_->pipeline->complete(h->seq, [self = h]() { g_sink += std::move(self->held)->header().length; });
+    }
+
+    void connection_before(protocol::Command c) {
+        // dispatch(): the base handler goes to the pool, handle() there picks the command
+        auto base = ctx_->installed;
+        tasks_.try_push(Task([base, admission = ctx_->admission]() { base->handle(); }));
+        run_task();
+        std::string command(protocol::command_name(c));
+        if (command == "ls" || command == "pwd" || command == "cd") {
+            auto h = std::make_shared<CdStub>();
+            static_cast<Handler&>(*h) = std::move(*base);
+            ctx_->installed = h;
+            h->handle();
+            g_sink += respond()->header().length;
+            ctx_->installed = std::shared_ptr<Handler>(new Handler(h->ctx));    // finish()
+        }
+    }
+
+    void connection_after() {
+        auto base = ctx_->installed;
+        std::shared_ptr<Handler> h = net::make_pooled<CdStub>(objects_.get());
+        static_cast<Handler&>(*h) = std::move(*base);
+        ctx_->installed = h;
+        tasks_.try_push(Task([h]() { h->handle(); }));
+        run_task();
+        g_sink += respond()->header().length;
+        ctx_->installed = net::make_pooled<Handler>(objects_.get(), h->ctx);     // finish()
+    }
+
+    bool pooled_;
+    lf::ArrayMPMCQueue<Task> tasks_;
+    net::BlockPool::Ptr objects_;
+    net::FramePool::Ptr frames_;
+    std::shared_ptr<Context> ctx_;
+};
+
+static void measure(const char* path, const char* variant, int64_t n, const std::function<void()>& op) {
+    for (int64_t i = 0; i < 1000; ++i) op();     // warm up the pools
+    uint64_t allocs = utils::thread_allocations();
+    auto t0 = Clock::now();
+    for (int64_t i = 0; i < n; ++i) op();
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / n;
+    allocs = utils::thread_allocations() - allocs;
+    std::cout << "DISPATCH BENCH RESULT"
+              << " path=" << path
+              << " variant=" << variant
+              << std::fixed << std::setprecision(2)
+              << " allocs_per_request=" << (static_cast<double>(allocs) / n)
+              << std::setprecision(0)
+              << " ns_per_op=" << ns
+              << " ops_per_sec=" << (1e9 / ns)
+              << "\n";
+}
+
+// command_from_name before the perfect hash.
+static std::optional<protocol::Command> scan_name(std::string_view name) {
+    for (uint8_t v = 1; v <= protocol::kCommandCount; ++v) {
+        if (protocol::command_name(static_cast<protocol::Command>(v)) == name) return static_cast<protocol::Command>(v);
+    }
+    return std::nullopt;
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg = parse_args(argc, argv);
+    if (!utils::alloc_counter_enabled()) std::cerr << "warning: built without FILE_SERVER_COUNT_ALLOCS\n";
+    for (bool pooled : {false, true}) {
+        Dispatcher d(pooled);
+        const char* variant = pooled ? "after" : "before";
+        measure("pipelined", variant, cfg.requests, [&] { d.request(protocol::Command::Ls); });
+        measure("connection", variant, cfg.requests, [&] { d.request(protocol::Command::Cd); });
+        measure("open", variant, cfg.requests / 4, [&] { d.open_close(); });
+    }
+    std::vector<std::string> names;
+    for (uint8_t v = 1; v <= protocol::kCommandCount; ++v) names.emplace_back(protocol::command_name(static_cast<protocol::Command>(v)));
+    names.emplace_back("frobnicate");
+    size_t i = 0;
+    measure("lookup", "before", cfg.requests, [&] { g_sink += scan_name(names[i++ % names.size()]).has_value(); });
+    measure("lookup", "after", cfg.requests,
+            [&] { g_sink += protocol::command_from_name(names[i++ % names.size()]).has_value(); });
+    return g_sink == 0xdeadbeef;
+}
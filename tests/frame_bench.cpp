@@ -0,0 +1,165 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "lockfreequeue/array_mpmc_queue.hpp"
+#include "net/frame_buffer.h"
+#include "types/message.h"
+
+// Small-response path benchmark: workers build `ls`-sized replies and hand them to a reactor
+// thread through a 1024-slot ResponseQueue-style MPMC queue; the reactor writes them to a
+// socketpair drained by a reader thread.
+//   message  the old fixed 64KB Message carried by value (zeroed on construction)
+//   frame    pooled FrameRef carried by handle
+// Run one mode per process so VmHWM reflects only that mode.
+
+struct BenchConfig {
+    int workers = 4;
+    int64_t responses = 2000000;    // total
+    size_t body = 200;
+    int queues = 4;                 // reactors (one queue each, as in the server)
+    std::string mode = "frame";
+};
+
+static BenchConfig parse_args(int argc, char** argv) {
+    BenchConfig cfg;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        auto need = [&](int i){ if (i+1>=argc) { std::cerr << "Missing value after " << a << "\n"; std::exit(1);} };
+        if (a == "--workers") { need(i); cfg.workers = std::atoi(argv[++i]); }
+        else if (a == "--responses") { need(i); cfg.responses = std::atoll(argv[++i]); }
+        else if (a == "--body") { need(i); cfg.body = std::atoi(argv[++i]); }
+        else if (a == "--reactors") { need(i); cfg.queues = std::atoi(argv[++i]); }
+        else if (a == "--mode") { need(i); cfg.mode = argv[++i]; }
+        else if (a == "--help") {
+            std::cout << "Usage: frame_bench [options]\n"
+                      << "  --mode NAME            message | frame (default frame)\n"
+                      << "  --workers N            producer threads (default 4)\n"
+                      << "  --reactors N           queues / consumer threads (default 4)\n"
+                      << "  --responses N          total responses (default 2000000)\n"
+                      << "  --body N               response body bytes (default 200)\n"
+                      << "  --help                 show this help\n";
+            std::exit(0);
+        }
+    }
+    return cfg;
+}
+
+static long vm_hwm_kb() {
+    std::ifstream in("/proc/self/status");
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) return std::atol(line.c_str() + 6);
+    }
+    return -1;
+}
+
+struct MessageTask { int fd{-1}; Message message; };
+struct FrameTask { int fd{-1}; net::FrameRef frame; };
+
+template <typename Task, typename Make, typename Wire>
+static double run(const BenchConfig& cfg, Make&& make, Wire&& wire) {
+    struct Lane {
+        int fds[2];
+        std::unique_ptr<lf::ArrayMPMCQueue<Task>> queue;
+        std::thread reactor, reader;
+    };
+    std::vector<Lane> lanes(cfg.queues);
+    std::atomic<int64_t> delivered{0};
+    std::atomic<bool> producing{true};
+    for (auto& l : lanes) {
+        ::socketpair(AF_UNIX, SOCK_STREAM, 0, l.fds);
+        l.queue = std::make_unique<lf::ArrayMPMCQueue<Task>>(1024);
+    }
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for (auto& l : lanes) {
+        l.reader = std::thread([&l]{
+            char buf[1 << 16];
+            while (::read(l.fds[1], buf, sizeof(buf)) > 0) {}
+        });
+        l.reactor = std::thread([&, lp = &l]{
+            Task task;
+            while (true) {
+                if (lp->queue->try_pop(task)) {
+                    auto [data, len] = wire(task);
+                    ::send(lp->fds[0], data, len, MSG_NOSIGNAL);
+                    task = Task{};
+                    delivered.fetch_add(1, std::memory_order_relaxed);
+                } else if (!producing.load(std::memory_order_acquire) && lp->queue->empty()) {
+                    break;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::string body(cfg.body, 'x');
+    std::vector<std::thread> workers;
+    for (int w = 0; w < cfg.workers; ++w) {
+        workers.emplace_back([&, w]{
+            int64_t share = cfg.responses / cfg.workers;
+            for (int64_t i = 0; i < share; ++i) {
+                Lane& l = lanes[(w + i) % lanes.size()];
+                Task task = make(l.fds[0], body, (w + i) % lanes.size());
+                while (!l.queue->try_push(std::move(task))) std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& t : workers) t.join();
+    producing.store(false, std::memory_order_release);
+    for (auto& l : lanes) { l.reactor.join(); ::shutdown(l.fds[0], SHUT_WR); l.reader.join(); ::close(l.fds[0]); ::close(l.fds[1]); }
+    auto t1 = std::chrono::high_resolution_clock::now();
+    double sec = std::chrono::duration<double>(t1 - t0).count();
+    return delivered.load() / sec;
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg = parse_args(argc, argv);
+    double rate = 0;
+    if (cfg.mode == "message") {
+        rate = run<MessageTask>(cfg,
+            [](int fd, const std::string& body, size_t) {
+                MessageTask t;
+                t.fd = fd;
+                t.message.header.length = body.size();
+                std::memcpy(t.message.body, body.data(), body.size());
+                return t;
+            },
+            [](MessageTask& t) { return std::pair<const void*, size_t>(&t.message, sizeof(MessageHeader) + t.message.header.length); });
+    } else {
+        std::vector<net::FramePool::Ptr> pools;
+        for (int i = 0; i < cfg.queues; ++i) pools.push_back(net::FramePool::create());
+        rate = run<FrameTask>(cfg,
+            [&](int fd, const std::string& body, size_t lane) {
+                FrameTask t{fd, pools[lane]->acquire(body.size())};
+                std::memcpy(t.frame->body(), body.data(), body.size());
+                t.frame->seal();
+                return t;
+            },
+            [](FrameTask& t) { return std::pair<const void*, size_t>(t.frame->wire_data(), t.frame->wire_size()); });
+    }
+    std::cout << "FRAME BENCH RESULT\n"
+              << " mode=" << cfg.mode
+              << " workers=" << cfg.workers
+              << " reactors=" << cfg.queues
+              << " body=" << cfg.body
+              << " responses=" << cfg.responses
+              << " K_resp_per_sec=" << std::fixed << std::setprecision(1) << rate / 1e3
+              << " vm_hwm_MB=" << std::setprecision(1) << vm_hwm_kb() / 1024.0
+              << "\n";
+    return 0;
+}
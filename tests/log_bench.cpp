@@ -0,0 +1,142 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "utils/log.h"
+
+// ns per request of the logging a control request goes through in RequestHandler: the raw
+// JSON body, the parsed command, the pool task, sendResponse with the response body and the
+// reset to the base handler (five calls).
+//
+// legacy:      log_cpp20 as it was, an inline function taking a std::string: with DEBUG=0 it
+//              prints nothing, but every message is still concatenated at the call site.
+// compiled:    LOG_DEBUG/LOG_TRACE below FILE_SERVER_LOG_LEVEL (the default build).
+// disabled:    compiled in, runtime level above the calls: one relaxed load per call.
+// async:       enabled, arguments copied into the thread's ring; the logging thread formats
+//              into a discarding sink. Timed in batches with the drain outside the timing,
+//              drained_ns is the logging thread's share per request.
+// sync:        enabled after shutdown(), formatted on the calling thread.
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    int64_t requests = 1000000;
+    int batch = 200;
+};
+
+static BenchConfig parse_args(int argc, char** argv) {
+    BenchConfig cfg;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        auto need = [&](int i){ if (i+1>=argc) { std::cerr << "Missing value after " << a << "\n"; std::exit(1);} };
+        if (a == "--requests") { need(i); cfg.requests = std::atoll(argv[++i]); }
+        else if (a == "--batch") { need(i); cfg.batch = std::atoi(argv[++i]); }
+        else if (a == "--help") {
+            std::cout << "Usage: log_bench [options]\n"
+                      << "  --requests N           requests per measurement (default 1000000)\n"
+                      << "  --batch N              async requests between drains (default 200)\n"
+                      << "  --help                 show this help\n";
+            std::exit(0);
+        }
+    }
+    return cfg;
+}
+
+static uint64_t g_sink = 0;     // results feed main()'s exit code so nothing is optimised away
+
+// The DEBUG=0 definition from common/debug.h before the LOG_* macros.
+__attribute__((noinline)) static void legacy_log(const std::string& message) { g_sink += message.size() == 1; }
+
+struct Request {
+    int fd = 17;
+    uint8_t id = 3;
+    std::string body = R"({"command":"ls","path":"/home/user/projects","token":"eyJhbGciOiJSUzI1NiJ9"})";
+    std::string response = R"({"code":200,"message":"a.txt\tb.txt\tnotes.md\treport.pdf\tsrc/\ttests/"})";
+    int type = 2;
+};
+
+static void legacy_request(const Request& r) {
+    legacy_log("[RequestHandler] raw request body fd=" + std::to_string(r.fd) + ": " + r.body);
+    legacy_log("[RequestHandler] parsed command='" + std::string("ls") + "' fd=" + std::to_string(r.fd)
+               + " id=" + std::to_string(r.id));
+    legacy_log("[RequestHandler] thread_pool executing handle for fd=" + std::to_string(r.fd));
+    legacy_log("[RequestHandler] sendResponse fd=" + std::to_string(r.fd) + " type=" + std::to_string(r.type)
+               + " body=" + r.response);
+    legacy_log("[RequestHandler] onSuccess reset to base handler fd=" + std::to_string(r.fd));
+}
+
+// The same five calls at Debug/Trace, as in request_handler.cpp; compiled out by default.
+static void compiled_request(const Request& r) {
+    LOG_TRACE("[RequestHandler] raw request body fd={}: {}", r.fd, r.body);
+    LOG_DEBUG("[RequestHandler] parsed command='{}' fd={} id={} binary={}", "ls", r.fd, r.id, false);
+    LOG_TRACE("[RequestHandler] thread_pool executing handle for fd={}", r.fd);
+    LOG_TRACE("[RequestHandler] sendResponse fd={} type={} body={}", r.fd, r.type, r.response);
+    LOG_TRACE("[RequestHandler] onSuccess reset to base handler fd={}", r.fd);
+}
+
+// The same five calls at Info, so the runtime level decides.
+static void runtime_request(const Request& r) {
+    LOG_INFO("[RequestHandler] raw request body fd={}: {}", r.fd, r.body);
+    LOG_INFO("[RequestHandler] parsed command='{}' fd={} id={} binary={}", "ls", r.fd, r.id, false);
+    LOG_INFO("[RequestHandler] thread_pool executing handle for fd={}", r.fd);
+    LOG_INFO("[RequestHandler] sendResponse fd={} type={} body={}", r.fd, r.type, r.response);
+    LOG_INFO("[RequestHandler] onSuccess reset to base handler fd={}", r.fd);
+}
+
+static void report(const char* variant, double ns, double drained_ns = 0) {
+    std::cout << "LOG BENCH RESULT"
+              << " variant=" << variant
+              << std::fixed << std::setprecision(1)
+              << " ns_per_request=" << ns
+              << " ns_per_call=" << ns / 5
+              << " drained_ns_per_request=" << drained_ns
+              << std::setprecision(0)
+              << " requests_per_sec=" << (1e9 / ns)
+              << " dropped=" << utils::log::dropped()
+              << "\n";
+}
+
+static double time_ns(int64_t n, const std::function<void()>& op) {
+    for (int64_t i = 0; i < 1000; ++i) op();
+    auto t0 = Clock::now();
+    for (int64_t i = 0; i < n; ++i) op();
+    return std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / n;
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg = parse_args(argc, argv);
+    Request r;
+    utils::log::set_sink([](utils::log::Level, std::string_view line) { g_sink += line.size(); });
+
+    report("legacy", time_ns(cfg.requests, [&] { legacy_request(r); }));
+    utils::log::set_level(utils::log::Level::Trace);
+    report("compiled", time_ns(cfg.requests, [&] { compiled_request(r); }));
+    utils::log::set_level(utils::log::Level::Warn);
+    report("disabled", time_ns(cfg.requests, [&] { runtime_request(r); }));
+
+    // A ring holds about 400 requests of these five records: drain between batches so the
+    // timing covers the enqueue and not the drop path.
+    utils::log::set_level(utils::log::Level::Info);
+    int batch = std::min<int64_t>(cfg.batch, cfg.requests);
+    double enqueue = 0, drain = 0;
+    int64_t done = 0;
+    for (; done + batch <= cfg.requests; done += batch) {
+        auto t0 = Clock::now();
+        for (int i = 0; i < batch; ++i) runtime_request(r);
+        auto t1 = Clock::now();
+        utils::log::flush();
+        enqueue += std::chrono::duration<double, std::nano>(t1 - t0).count();
+        drain += std::chrono::duration<double, std::nano>(Clock::now() - t1).count();
+    }
+    report("async", enqueue / done, drain / done);
+
+    utils::log::shutdown();
+    report("sync", time_ns(cfg.requests / 10, [&] { runtime_request(r); }));
+    return g_sink == 0xdeadbeef;
+}
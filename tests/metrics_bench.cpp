@@ -0,0 +1,110 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "metrics/metrics.h"
+#include "metrics/trace.h"
+
+// ns per recorded latency sample with N threads recording into the same series.
+//
+// sharded:     metrics::Histogram::record, one shard per thread, relaxed atomics.
+// mutex:       the same log-linear buckets in one array behind a std::mutex.
+// timer:       a ScopedTimer around an empty scope: two clock reads plus record().
+// span_off:    metrics::trace::begin() and a Span for a request that is not sampled (the
+//              default, tracing off).
+// span_on:     a Span of a traced request: two clock reads and the thread's buffer.
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    int threads = 4;
+    int64_t samples = 5000000;      // per thread
+};
+
+static BenchConfig parse_args(int argc, char** argv) {
+    BenchConfig cfg;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        auto need = [&](int i){ if (i+1>=argc) { std::cerr << "Missing value after " << a << "\n"; std::exit(1);} };
+        if (a == "--threads") { need(i); cfg.threads = std::atoi(argv[++i]); }
+        else if (a == "--samples") { need(i); cfg.samples = std::atoll(argv[++i]); }
+        else if (a == "--help") {
+            std::cout << "Usage: metrics_bench [options]\n"
+                      << "  --threads N            recording threads (default 4)\n"
+                      << "  --samples N            samples per thread (default 5000000)\n"
+                      << "  --help                 show this help\n";
+            std::exit(0);
+        }
+    }
+    return cfg;
+}
+
+static uint64_t g_sink = 0;     // results feed main()'s exit code so nothing is optimised away
+
+struct LockedHistogram {
+    std::mutex mutex;
+    std::vector<uint64_t> counts = std::vector<uint64_t>(metrics::Histogram::kBuckets);
+    uint64_t sum = 0;
+
+    void record(uint64_t ns) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++counts[metrics::Histogram::bucket_of(ns)];
+        sum += ns;
+    }
+};
+
+template <typename Op>
+static double run(const BenchConfig& cfg, Op op) {
+    std::vector<std::thread> threads;
+    auto t0 = Clock::now();
+    for (int t = 0; t < cfg.threads; ++t) {
+        threads.emplace_back([&, t] {
+            for (int64_t i = 0; i < cfg.samples; ++i) op(static_cast<uint64_t>(i * 37 + t) & 0xfffff);
+        });
+    }
+    for (auto& th : threads) th.join();
+    return std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / cfg.samples;
+}
+
+static void report(const char* variant, const BenchConfig& cfg, double ns) {
+    std::cout << "METRICS BENCH RESULT"
+              << " variant=" << variant
+              << " threads=" << cfg.threads
+              << std::fixed << std::setprecision(1)
+              << " ns_per_sample=" << ns
+              << std::setprecision(0)
+              << " samples_per_sec=" << (1e9 / ns * cfg.threads)
+              << "\n";
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg = parse_args(argc, argv);
+
+    metrics::Histogram sharded;
+    report("sharded", cfg, run(cfg, [&](uint64_t v) { sharded.record(v); }));
+    g_sink += sharded.snapshot().count;
+
+    LockedHistogram locked;
+    report("mutex", cfg, run(cfg, [&](uint64_t v) { locked.record(v); }));
+    g_sink += locked.sum;
+
+    metrics::Histogram timed;
+    report("timer", cfg, run(cfg, [&](uint64_t) { metrics::ScopedTimer timer(timed); }));
+    g_sink += timed.snapshot().count;
+
+    report("span_off", cfg, run(cfg, [&](uint64_t) {
+        metrics::trace::Scope scope(metrics::trace::begin());
+        metrics::trace::Span span("bench", "bench");
+    }));
+    report("span_on", cfg, run(cfg, [&](uint64_t v) {
+        metrics::trace::Scope scope(v + 1);
+        metrics::trace::Span span("bench", "bench");
+    }));
+    return g_sink == 0xdeadbeef;
+}
@@ -0,0 +1,303 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "concurrency/lf_thread_pool.h"
+#include "net/frame_buffer.h"
+#include "net/frame_decoder.h"
+#include "net/request_pipeline.h"
+#include "net/response_queue.h"
+#include "types/enums.h"
+#include "types/message.h"
+
+// Small-request throughput of one connection at a given pipeline depth, over loopback TCP.
+// The server side follows RequestHandler's dispatch: FrameDecoder with the stall/resume gate,
+// RequestPipeline numbering, LFThreadPool workers that spend --work-us per request (database
+// and filesystem calls, sleeping by default, --spin for CPU bound handlers), SERVER_BUSY when
+// the pool refuses, in-order completion through the pipeline and the ResponseQueue back to
+// the reactor. "ls" requests run concurrently; "mkdir" requests run alone, the next one being
+// read once the previous one is answered, so only the round trips are saved. Depth 1 is the
+// old one-request-at-a-time protocol.
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    int64_t requests = 200000;
+    int work_us = 50;
+    bool sleep = true;      // handler time spent waiting (database, disk) rather than on CPU
+    int workers = 4;
+    std::string command = "ls";
+    std::vector<int> depths{1, 8, 64};
+};
+
+static BenchConfig parse_args(int argc, char** argv) {
+    BenchConfig cfg;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        auto need = [&](int i){ if (i+1>=argc) { std::cerr << "Missing value after " << a << "\n"; std::exit(1);} };
+        if (a == "--requests") { need(i); cfg.requests = std::atoll(argv[++i]); }
+        else if (a == "--work-us") { need(i); cfg.work_us = std::atoi(argv[++i]); }
+        else if (a == "--workers") { need(i); cfg.workers = std::atoi(argv[++i]); }
+        else if (a == "--spin") { cfg.sleep = false; }
+        else if (a == "--depth") { need(i); cfg.depths = {std::atoi(argv[++i])}; }
+        else if (a == "--command") { need(i); cfg.command = argv[++i]; }
+        else if (a == "--help") {
+            std::cout << "Usage: pipeline_bench [options]\n"
+                      << "  --depth N              pipeline depth (default: 1, 8 and 64)\n"
+                      << "  --requests N           requests per run (default 200000)\n"
+                      << "  --work-us N            handler time per request (default 50)\n"
+                      << "  --spin                 burn the handler time on CPU instead of sleeping\n"
+                      << "  --workers N            thread pool workers (default 4)\n"
+                      << "  --command NAME         ls (runs concurrently) | mkdir (runs alone) (default ls)\n"
+                      << "  --help                 show this help\n";
+            std::exit(0);
+        }
+    }
+    return cfg;
+}
+
+static void work_for(int us, bool sleep) {
+    if (sleep) {
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+        return;
+    }
+    auto until = Clock::now() + std::chrono::microseconds(us);
+    while (Clock::now() < until) {}
+}
+
+static void send_all(int fd, const uint8_t* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::send(fd, data, len, MSG_NOSIGNAL);
+        if (n > 0) { data += n; len -= static_cast<size_t>(n); continue; }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            pollfd p{fd, POLLOUT, 0};
+            ::poll(&p, 1, 100);
+            continue;
+        }
+        std::cerr << "send failed: " << strerror(errno) << "\n";
+        std::exit(1);
+    }
+}
+
+static std::pair<int, int> tcp_pair() {
+    int lfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (::bind(lfd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(lfd, 1) != 0) {
+        std::cerr << "listen failed: " << strerror(errno) << "\n";
+        std::exit(1);
+    }
+    ::getsockname(lfd, reinterpret_cast<sockaddr*>(&addr), &len);
+    int client = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (::connect(client, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::cerr << "connect failed: " << strerror(errno) << "\n";
+        std::exit(1);
+    }
+    int server = ::accept4(lfd, nullptr, nullptr, SOCK_NONBLOCK);
+    ::close(lfd);
+    int one = 1;
+    ::setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    ::setsockopt(server, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return {client, server};
+}
+
+// Reactor + workers for one connection.
+class Server {
+public:
+    // A mkdir waits for the requests before it and input stops until it is answered: the same
+    // as a pipeline of depth 1 on the server side.
+    Server(int fd, const BenchConfig& cfg, int depth)
+        : fd_(fd), work_us_(cfg.work_us), sleep_(cfg.sleep), pool_(cfg.workers, 4096),
+          pipeline_(cfg.command == "mkdir" ? 1 : depth),
+          frames_(net::FramePool::create()) {}
+
+    void run() {
+        int ep = ::epoll_create1(0);
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLET;
+        ev.data.fd = fd_;
+        ::epoll_ctl(ep, EPOLL_CTL_ADD, fd_, &ev);
+        ev.events = EPOLLIN;
+        ev.data.fd = responses_.getEventFd();
+        ::epoll_ctl(ep, EPOLL_CTL_ADD, ev.data.fd, &ev);
+
+        epoll_event events[4];
+        while (!done_) {
+            int n = ::epoll_wait(ep, events, 4, 100);
+            for (int i = 0; i < n; ++i) {
+                if (events[i].data.fd == fd_) read_requests();
+                else drain_responses();
+            }
+        }
+        ::close(ep);
+    }
+
+private:
+    void read_requests() {
+        auto accept = [this]() {
+            if (!pipeline_.full()) return true;
+            stalled_.store(true);
+            return !pipeline_.full() && stalled_.exchange(false);
+        };
+        size_t nread = 0;
+        auto status = decoder_.read_frames(fd_, *frames_, accept, [this](net::FrameRef frame) {
+            dispatch(frame->header().request_id);
+        }, nread);
+        if (status == net::FrameDecoder::Status::Closed || status == net::FrameDecoder::Status::Error) done_ = true;
+    }
+
+    void dispatch(uint8_t request_id) {
+        uint64_t seq = pipeline_.begin();
+        bool queued = pool_.submit([this, seq, request_id]() {
+            work_for(work_us_, sleep_);
+            static const char kBody[] = "{\"responseMessage\":\"a b c\"}";
+            complete(seq, request_id, MessageType::RESPONSE, kBody, sizeof(kBody) - 1);
+        });
+        if (!queued) {
+            // pool queue full: answered at once, as RequestHandler::rejectBusy does
+            static const char kBusy[] = "{\"status\":\"error\",\"errorCode\":9,\"errorMessage\":\"server busy\",\"retryAfterMs\":0}";
+            complete(seq, request_id, MessageType::ERROR, kBusy, sizeof(kBusy) - 1);
+        }
+    }
+
+    void complete(uint64_t seq, uint8_t request_id, MessageType type, const char* body, size_t len) {
+        net::FrameRef frame = frames_->acquire(len);
+        frame->header().type = static_cast<uint8_t>(type);
+        frame->header().request_id = request_id;
+        std::memcpy(frame->body(), body, len);
+        size_t delivered = pipeline_.complete(seq, [this, frame]() { responses_.submit(fd_, 0, frame); });
+        if (delivered > 0 && stalled_.exchange(false)) responses_.submit_resume(fd_, 0);
+    }
+
+    void drain_responses() {
+        bool resume = false;
+        std::string out;
+        responses_.drain([&](int, uint32_t, const net::FrameRef& frame, const net::OutboundSource&) {
+            if (!frame) { resume = true; return; }
+            frame->seal();
+            out.append(reinterpret_cast<const char*>(frame->wire_data()), frame->wire_size());
+        });
+        if (!out.empty()) send_all(fd_, reinterpret_cast<const uint8_t*>(out.data()), out.size());
+        if (resume) read_requests();
+    }
+
+    int fd_;
+    int work_us_;
+    bool sleep_;
+    concurrency::LFThreadPool pool_;
+    net::RequestPipeline pipeline_;
+    net::FramePool::Ptr frames_;
+    net::FrameDecoder decoder_;
+    net::ResponseQueue responses_{4096};
+    std::atomic<bool> stalled_{false};
+    bool done_{false};
+};
+
+struct RunResult {
+    double ops_per_sec;
+    double avg_latency_us;
+    int64_t out_of_order;
+    int64_t busy;
+};
+
+static RunResult run_depth(const BenchConfig& cfg, int depth) {
+    auto [client, server_fd] = tcp_pair();
+    auto server = std::make_unique<Server>(server_fd, cfg, depth);
+    std::thread reactor([&] { server->run(); });
+
+    const std::string body = cfg.command == "mkdir" ? "{\"command\":\"mkdir\",\"params\":\"d\"}"
+                                                    : "{\"command\":\"ls\"}";
+    std::vector<Clock::time_point> sent_at(256);
+    int64_t sent = 0, received = 0, out_of_order = 0, busy = 0;
+    double latency_sum_us = 0;
+    std::vector<uint8_t> in;
+    in.reserve(64 * 1024);
+    uint8_t buf[64 * 1024];
+
+    auto t0 = Clock::now();
+    while (received < cfg.requests) {
+        // keep `depth` requests outstanding, written in one send
+        std::string batch;
+        while (sent < cfg.requests && sent - received < depth) {
+            MessageHeader h;
+            h.length = static_cast<uint32_t>(body.size());
+            h.type = static_cast<uint8_t>(MessageType::REQUEST);
+            h.request_id = static_cast<uint8_t>(sent);
+            batch.append(reinterpret_cast<const char*>(&h), sizeof(h));
+            batch.append(body);
+            sent_at[static_cast<uint8_t>(sent)] = Clock::now();
+            ++sent;
+        }
+        if (!batch.empty()) send_all(client, reinterpret_cast<const uint8_t*>(batch.data()), batch.size());
+
+        ssize_t n = ::recv(client, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            std::cerr << "recv failed\n";
+            std::exit(1);
+        }
+        in.insert(in.end(), buf, buf + n);
+        size_t pos = 0;
+        auto now = Clock::now();
+        while (in.size() - pos >= sizeof(MessageHeader)) {
+            MessageHeader h;
+            std::memcpy(&h, in.data() + pos, sizeof(h));
+            if (in.size() - pos < sizeof(h) + h.length) break;
+            if (h.request_id != static_cast<uint8_t>(received)) ++out_of_order;
+            if (h.type == static_cast<uint8_t>(MessageType::ERROR)) ++busy;
+            latency_sum_us += std::chrono::duration<double, std::micro>(now - sent_at[h.request_id]).count();
+            ++received;
+            pos += sizeof(h) + h.length;
+        }
+        in.erase(in.begin(), in.begin() + static_cast<std::ptrdiff_t>(pos));
+    }
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    ::shutdown(client, SHUT_WR);
+    reactor.join();
+    ::close(client);
+    ::close(server_fd);
+    return {cfg.requests / secs, latency_sum_us / cfg.requests, out_of_order, busy};
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg = parse_args(argc, argv);
+    double base = 0;
+    for (int depth : cfg.depths) {
+        RunResult r = run_depth(cfg, depth);
+        if (base == 0) base = r.ops_per_sec;
+        std::cout << "PIPELINE BENCH RESULT\n"
+                  << " command=" << cfg.command
+                  << " depth=" << depth
+                  << " requests=" << cfg.requests
+                  << " work_us=" << cfg.work_us << (cfg.sleep ? "" : " spin")
+                  << " workers=" << cfg.workers
+                  << std::fixed << std::setprecision(0)
+                  << " ops_per_sec=" << r.ops_per_sec
+                  << std::setprecision(1)
+                  << " avg_latency_us=" << r.avg_latency_us
+                  << " speedup=" << std::setprecision(2) << (r.ops_per_sec / base)
+                  << " out_of_order=" << r.out_of_order
+                  << " busy=" << r.busy
+                  << "\n";
+    }
+    return 0;
+}
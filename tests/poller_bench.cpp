@@ -0,0 +1,181 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <string>
+#include <iomanip>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "net/poller.h"
+
+// A/B benchmark of the reactor poller backends on loopback.
+// Clients ping-pong small messages over TCP; a single "reactor" thread waits on the poller
+// and echoes every message back, which mirrors the IOReactor hot path (wait -> recv -> send).
+
+struct BenchConfig {
+    int connections = 64;
+    int clients = 4;
+    int rounds = 20000;       // round trips per connection
+    int payload = 64;         // bytes per message
+    std::string backend = "both";
+};
+
+static BenchConfig parse_args(int argc, char** argv) {
+    BenchConfig cfg;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        auto need = [&](int i){ if (i+1>=argc) { std::cerr << "Missing value after " << a << "\n"; std::exit(1);} };
+        if (a == "--connections") { need(i); cfg.connections = std::atoi(argv[++i]); }
+        else if (a == "--clients") { need(i); cfg.clients = std::atoi(argv[++i]); }
+        else if (a == "--rounds") { need(i); cfg.rounds = std::atoi(argv[++i]); }
+        else if (a == "--payload") { need(i); cfg.payload = std::atoi(argv[++i]); }
+        else if (a == "--backend") { need(i); cfg.backend = argv[++i]; }
+        else if (a == "--help") {
+            std::cout << "Usage: poller_bench [options]\n"
+                      << "  --connections N        loopback connections (default 64)\n"
+                      << "  --clients N            client threads driving the connections (default 4)\n"
+                      << "  --rounds N             round trips per connection (default 20000)\n"
+                      << "  --payload N            bytes per message (default 64)\n"
+                      << "  --backend NAME         epoll | io_uring | both (default both)\n"
+                      << "  --help                 show this help\n";
+            std::exit(0);
+        }
+    }
+    return cfg;
+}
+
+static int open_listener(uint16_t& port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    if (fd < 0 || ::bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(fd, SOMAXCONN) < 0) {
+        std::perror("listener");
+        std::exit(1);
+    }
+    socklen_t len = sizeof(addr);
+    ::getsockname(fd, (sockaddr*)&addr, &len);
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+static bool run_backend(net::PollerBackend backend, const BenchConfig& cfg) {
+    uint16_t port = 0;
+    int listen_fd = open_listener(port);
+
+    std::vector<int> client_fds(cfg.connections);
+    std::vector<int> server_fds(cfg.connections);
+    for (int i = 0; i < cfg.connections; ++i) {
+        client_fds[i] = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+        if (::connect(client_fds[i], (sockaddr*)&addr, sizeof(addr)) < 0) {
+            std::perror("connect");
+            return false;
+        }
+        server_fds[i] = ::accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK);
+        int one = 1;
+        ::setsockopt(client_fds[i], IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        ::setsockopt(server_fds[i], IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    ::close(listen_fd);
+
+    auto poller = net::make_poller(backend);
+    for (int fd : server_fds) poller->add_fd(fd, EPOLLIN | EPOLLET);
+
+    const int64_t total = int64_t(cfg.connections) * cfg.rounds;
+    std::atomic<bool> done{false};
+    std::atomic<int64_t> echoed{0};
+    uint64_t wakeups = 0;
+
+    std::thread reactor([&]{
+        std::vector<char> buf(64 * 1024);
+        while (!done.load(std::memory_order_relaxed)) {
+            auto events = poller->poll(100);
+            if (!events) break;
+            ++wakeups;
+            for (auto& ev : *events) {
+                // edge triggered: drain until EAGAIN
+                while (true) {
+                    ssize_t n = ::recv(ev.data.fd, buf.data(), buf.size(), 0);
+                    if (n <= 0) break;
+                    ::send(ev.data.fd, buf.data(), n, MSG_NOSIGNAL);
+                    echoed.fetch_add(n / cfg.payload, std::memory_order_relaxed);
+                }
+            }
+        }
+    });
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::thread> clients;
+    for (int c = 0; c < cfg.clients; ++c) {
+        clients.emplace_back([&, c]{
+            std::vector<char> msg(cfg.payload, 'x');
+            std::vector<char> in(cfg.payload);
+            for (int r = 0; r < cfg.rounds; ++r) {
+                for (int i = c; i < cfg.connections; i += cfg.clients) {
+                    ::send(client_fds[i], msg.data(), msg.size(), MSG_NOSIGNAL);
+                }
+                for (int i = c; i < cfg.connections; i += cfg.clients) {
+                    ::recv(client_fds[i], in.data(), in.size(), MSG_WAITALL);
+                }
+            }
+        });
+    }
+    for (auto& t : clients) t.join();
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    done.store(true);
+    reactor.join();
+
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+    double sec = ns / 1e9;
+    double krtt = (double)total / 1e3 / sec;
+
+    std::cout << "POLLER BENCH RESULT\n"
+              << " backend=" << poller->name()
+              << " connections=" << cfg.connections
+              << " clients=" << cfg.clients
+              << " rounds=" << cfg.rounds
+              << " payload=" << cfg.payload
+              << " time_sec=" << std::fixed << std::setprecision(6) << sec
+              << " round_trips_K_per_sec=" << std::setprecision(3) << krtt
+              << " events_per_wakeup=" << std::setprecision(2)
+              << (wakeups ? (double)echoed.load() / wakeups : 0.0)
+              << "\n";
+
+    for (int fd : client_fds) ::close(fd);
+    for (int fd : server_fds) ::close(fd);
+
+    if (echoed.load() != total) {
+        std::cerr << "ERROR: echoed=" << echoed.load() << " expected=" << total << "\n";
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg = parse_args(argc, argv);
+    bool ok = true;
+    if (cfg.backend == "both" || cfg.backend == "epoll") {
+        ok &= run_backend(net::PollerBackend::Epoll, cfg);
+    }
+    if (cfg.backend == "both" || cfg.backend == "io_uring") {
+        ok &= run_backend(net::PollerBackend::IoUring, cfg);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,238 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "concurrency/lf_thread_pool.h"
+#include "concurrency/task.h"
+#include "utils/crc32c.h"
+
+// Many concurrent small-file PUTs through the server's upload data path, without sockets:
+// --reactors threads play the IO reactors, each delivering one chunk per read round-robin
+// over its connections; a connection starts its next upload once the previous one is
+// complete. A chunk write is a memcpy into the connection's file buffer plus a running
+// CRC-32C over the upload, which is order-sensitive like the SHA-1 the handler keeps.
+// Pool layout as in the server: 2 pinned + 4 flexible workers.
+//
+// mutex:       the previous PUTHandler: frames pushed to a mutex-guarded queue and one pool
+//              task per read, which drains the queue unlocking around each write, so two
+//              workers can write chunks of one upload at once.
+// strand:      one SeriesTask per connection, one task per chunk.
+//
+// reordered counts chunks written out of order, overlapped chunks written while another
+// chunk of the same upload was being written, corrupt uploads whose checksum came out wrong.
+
+using Clock = std::chrono::steady_clock;
+using concurrency::LFThreadPool;
+
+struct BenchConfig {
+    int connections = 256;
+    int uploads = 20;          // per connection
+    int chunks = 16;           // per upload
+    int chunk_size = 4096;
+    int reactors = 2;
+};
+
+static BenchConfig parse_args(int argc, char** argv) {
+    BenchConfig cfg;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        auto need = [&](int i){ if (i+1>=argc) { std::cerr << "Missing value after " << a << "\n"; std::exit(1);} };
+        if (a == "--connections") { need(i); cfg.connections = std::atoi(argv[++i]); }
+        else if (a == "--uploads") { need(i); cfg.uploads = std::atoi(argv[++i]); }
+        else if (a == "--chunks") { need(i); cfg.chunks = std::atoi(argv[++i]); }
+        else if (a == "--chunk-size") { need(i); cfg.chunk_size = std::atoi(argv[++i]); }
+        else if (a == "--reactors") { need(i); cfg.reactors = std::atoi(argv[++i]); }
+        else if (a == "--help") {
+            std::cout << "Usage: put_strand_bench [options]\n"
+                      << "  --connections N        concurrent uploading connections (default 256)\n"
+                      << "  --uploads N            uploads per connection (default 20)\n"
+                      << "  --chunks N             chunks per upload (default 16)\n"
+                      << "  --chunk-size N         bytes per chunk (default 4096)\n"
+                      << "  --reactors N           delivering threads (default 2)\n"
+                      << "  --help                 show this help\n";
+            std::exit(0);
+        }
+    }
+    return cfg;
+}
+
+static uint64_t g_sink = 0;     // results feed main()'s exit code so nothing is optimised away
+
+struct Payload {
+    std::vector<uint8_t> bytes;
+    uint32_t crc = 0;           // of the whole upload, chunks in order
+};
+
+struct Counters {
+    std::atomic<int64_t> uploads{0};
+    std::atomic<int64_t> reordered{0};
+    std::atomic<int64_t> overlapped{0};
+    std::atomic<int64_t> corrupt{0};
+};
+
+// The part of an upload the chunk writes share. Atomics only so that the mutex variant's
+// overlapping writes are counted instead of being undefined behaviour.
+class Connection {
+public:
+    Connection(const BenchConfig& cfg, const Payload& payload, Counters& counters)
+        : cfg_(cfg), payload_(payload), counters_(counters), file_(payload.bytes.size()) {}
+    virtual ~Connection() = default;
+
+    virtual void recv(int chunk) = 0;
+
+    void start_upload() {
+        crc_.store(0, std::memory_order_relaxed);
+        next_chunk_.store(0, std::memory_order_relaxed);
+        written_.store(0, std::memory_order_relaxed);
+        done_.store(false, std::memory_order_release);
+        sent = 0;
+    }
+    bool done() const { return done_.load(std::memory_order_acquire); }
+
+    int sent = 0;               // reactor thread only
+    int uploads_left = 0;
+
+protected:
+    void write(int chunk) {
+        if (inside_.fetch_add(1, std::memory_order_acq_rel) != 0) counters_.overlapped.fetch_add(1, std::memory_order_relaxed);
+        if (next_chunk_.exchange(chunk + 1, std::memory_order_relaxed) != chunk) counters_.reordered.fetch_add(1, std::memory_order_relaxed);
+        const std::size_t offset = static_cast<std::size_t>(chunk) * cfg_.chunk_size;
+        std::memcpy(file_.data() + offset, payload_.bytes.data() + offset, cfg_.chunk_size);
+        uint32_t crc = crc_.load(std::memory_order_relaxed);
+        crc_.store(utils::crc32c(file_.data() + offset, cfg_.chunk_size, crc), std::memory_order_relaxed);
+        inside_.fetch_sub(1, std::memory_order_acq_rel);
+        if (written_.fetch_add(1, std::memory_order_acq_rel) + 1 == cfg_.chunks) {
+            if (crc_.load(std::memory_order_relaxed) != payload_.crc) counters_.corrupt.fetch_add(1, std::memory_order_relaxed);
+            counters_.uploads.fetch_add(1, std::memory_order_relaxed);
+            done_.store(true, std::memory_order_release);
+        }
+    }
+
+    const BenchConfig& cfg_;
+    const Payload& payload_;
+    Counters& counters_;
+    std::vector<uint8_t> file_;
+    std::atomic<uint32_t> crc_{0};
+    std::atomic<int> next_chunk_{0};
+    std::atomic<int> written_{0};
+    std::atomic<int> inside_{0};
+    std::atomic<bool> done_{true};
+};
+
+class MutexConnection : public Connection {
+public:
+    MutexConnection(const BenchConfig& cfg, const Payload& payload, Counters& counters, LFThreadPool& pool)
+        : Connection(cfg, payload, counters), pool_(pool) {}
+
+    void recv(int chunk) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push(chunk);
+        }
+        if (!pool_.submit([this] { handle(); })) handle();
+    }
+
+private:
+    void handle() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!queue_.empty()) {
+            int chunk = queue_.front();
+            queue_.pop();
+            lock.unlock();
+            write(chunk);
+            lock.lock();
+        }
+    }
+
+    LFThreadPool& pool_;
+    std::mutex mutex_;
+    std::queue<int> queue_;
+};
+
+class StrandConnection : public Connection {
+public:
+    StrandConnection(const BenchConfig& cfg, const Payload& payload, Counters& counters, LFThreadPool& pool)
+        : Connection(cfg, payload, counters), strand_(pool.make_series()) {}
+
+    void recv(int chunk) override {
+        if (strand_->post([this, chunk] { write(chunk); })) return;
+        // Pool full: the reactor stops reading this connection until the pool takes the drain.
+        while (!strand_->retry()) std::this_thread::yield();
+    }
+
+private:
+    concurrency::SeriesTask<LFThreadPool::Task>::Ptr strand_;
+};
+
+template <typename Conn>
+static void run(const char* variant, const BenchConfig& cfg, const Payload& payload) {
+    Counters counters;
+    std::vector<std::unique_ptr<Connection>> conns;
+    LFThreadPool pool(2, 4, 1024, 1024);    // declared after conns: workers are joined first
+    for (int i = 0; i < cfg.connections; ++i) {
+        conns.push_back(std::make_unique<Conn>(cfg, payload, counters, pool));
+        conns.back()->uploads_left = cfg.uploads;
+    }
+
+    auto t0 = Clock::now();
+    std::vector<std::thread> reactors;
+    for (int r = 0; r < cfg.reactors; ++r) {
+        reactors.emplace_back([&, r] {
+            int active = 1;
+            while (active > 0) {
+                active = 0;
+                for (std::size_t i = r; i < conns.size(); i += cfg.reactors) {
+                    Connection& conn = *conns[i];
+                    if (conn.sent == cfg.chunks || conn.uploads_left == cfg.uploads) {
+                        // waiting for the reply, or not started
+                        if (!conn.done()) { ++active; continue; }
+                        if (conn.uploads_left == 0) continue;
+                        --conn.uploads_left;
+                        conn.start_upload();
+                    }
+                    conn.recv(conn.sent++);
+                    ++active;
+                }
+            }
+        });
+    }
+    for (auto& th : reactors) th.join();
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+    int64_t uploads = counters.uploads.load();
+    g_sink += uploads;
+
+    std::cout << "PUT BENCH RESULT"
+              << " variant=" << variant
+              << " connections=" << cfg.connections
+              << std::fixed << std::setprecision(0)
+              << " uploads_per_sec=" << uploads / secs
+              << std::setprecision(1)
+              << " mb_per_sec=" << uploads * static_cast<double>(payload.bytes.size()) / secs / 1e6
+              << " reordered=" << counters.reordered.load()
+              << " overlapped=" << counters.overlapped.load()
+              << " corrupt=" << counters.corrupt.load()
+              << "\n";
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg = parse_args(argc, argv);
+    Payload payload;
+    payload.bytes.resize(static_cast<std::size_t>(cfg.chunks) * cfg.chunk_size);
+    for (std::size_t i = 0; i < payload.bytes.size(); ++i) payload.bytes[i] = static_cast<uint8_t>(i * 131 + (i >> 12));
+    payload.crc = utils::crc32c(payload.bytes.data(), payload.bytes.size());
+
+    run<MutexConnection>("mutex", cfg, payload);
+    run<StrandConnection>("strand", cfg, payload);
+    return g_sink == 0xdeadbeef;
+}
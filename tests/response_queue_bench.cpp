@@ -0,0 +1,207 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "lockfreequeue/array_mpmc_queue.hpp"
+#include "net/frame_buffer.h"
+#include "net/outbound_buffer.h"
+#include "net/response_queue.h"
+
+// Replies per second through one reactor's response path under bursty small replies.
+//   legacy   eventfd write per submit, one send() per reply (the previous ResponseQueue)
+//   batched  coalesced eventfd wakeups, replies staged per fd and flushed with one sendmsg
+// Workers submit `pwd`-sized replies round robin over N connections (socketpairs whose peers
+// are drained by a reader thread).
+
+struct BenchConfig {
+    int workers = 4;
+    int connections = 64;
+    int64_t replies = 2000000;
+    size_t body = 64;
+    std::string mode = "all";
+};
+
+static BenchConfig parse_args(int argc, char** argv) {
+    BenchConfig cfg;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        auto need = [&](int i){ if (i+1>=argc) { std::cerr << "Missing value after " << a << "\n"; std::exit(1);} };
+        if (a == "--workers") { need(i); cfg.workers = std::atoi(argv[++i]); }
+        else if (a == "--connections") { need(i); cfg.connections = std::atoi(argv[++i]); }
+        else if (a == "--replies") { need(i); cfg.replies = std::atoll(argv[++i]); }
+        else if (a == "--body") { need(i); cfg.body = std::atoi(argv[++i]); }
+        else if (a == "--mode") { need(i); cfg.mode = argv[++i]; }
+        else if (a == "--help") {
+            std::cout << "Usage: response_queue_bench [options]\n"
+                      << "  --mode NAME            legacy | batched | all (default all)\n"
+                      << "  --workers N            submitting threads (default 4)\n"
+                      << "  --connections N        connections on the reactor (default 64)\n"
+                      << "  --replies N            total replies (default 2000000)\n"
+                      << "  --body N               reply body bytes (default 64)\n"
+                      << "  --help                 show this help\n";
+            std::exit(0);
+        }
+    }
+    return cfg;
+}
+
+// The pre-coalescing queue: one eventfd write per submit.
+class LegacyQueue {
+public:
+    LegacyQueue() : queue_(1024), eventfd_(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {}
+    ~LegacyQueue() { ::close(eventfd_); }
+    int getEventFd() const { return eventfd_; }
+    bool submit(int fd, uint32_t, net::FrameRef frame) {
+        if (!queue_.try_push(Task{fd, std::move(frame)})) return false;
+        uint64_t one = 1;
+        return ::write(eventfd_, &one, sizeof(one)) == sizeof(one);
+    }
+    template <typename Fn>
+    size_t drain(Fn&& deliver) {
+        uint64_t count = 0;
+        if (::read(eventfd_, &count, sizeof(count)) != sizeof(count)) return 0;
+        size_t n = 0;
+        Task task;
+        for (uint64_t i = 0; i < count && queue_.try_pop(task); ++i, ++n) {
+            deliver(task.fd, task.frame);
+            task.frame.reset();
+        }
+        return n;
+    }
+private:
+    struct Task { int fd{-1}; net::FrameRef frame; };
+    lf::ArrayMPMCQueue<Task> queue_;
+    int eventfd_;
+};
+
+struct Peer {
+    int fds[2];
+    net::OutboundBuffer out;
+    bool staged{false};
+    size_t frames{0};
+};
+
+template <typename Queue, typename Drain>
+static void run_mode(const char* name, const BenchConfig& cfg, Drain&& drain_once) {
+    Queue queue;
+    auto pool = net::FramePool::create();
+    std::vector<Peer> peers(cfg.connections);
+    int reader_ep = ::epoll_create1(0);
+    for (auto& p : peers) {
+        ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, p.fds);
+        epoll_event ev{EPOLLIN, {.fd = p.fds[1]}};
+        ::epoll_ctl(reader_ep, EPOLL_CTL_ADD, p.fds[1], &ev);
+    }
+    std::atomic<bool> done{false};
+    std::atomic<int64_t> delivered{0};
+    std::atomic<uint64_t> sends{0};
+
+    std::thread reader([&]{
+        epoll_event evs[256];
+        char buf[1 << 16];
+        while (!done.load(std::memory_order_relaxed)) {
+            int n = ::epoll_wait(reader_ep, evs, 256, 10);
+            for (int i = 0; i < n; ++i) while (::read(evs[i].data.fd, buf, sizeof(buf)) > 0) {}
+        }
+    });
+
+    const int64_t total = cfg.replies / cfg.workers * cfg.workers;
+    std::thread reactor([&]{
+        int ep = ::epoll_create1(0);
+        epoll_event ev{EPOLLIN, {.fd = queue.getEventFd()}};
+        ::epoll_ctl(ep, EPOLL_CTL_ADD, queue.getEventFd(), &ev);
+        epoll_event evs[16];
+        while (delivered.load(std::memory_order_relaxed) < total) {
+            if (::epoll_wait(ep, evs, 16, 10) > 0) {
+                delivered.fetch_add(drain_once(queue, peers, sends), std::memory_order_relaxed);
+            }
+        }
+        ::close(ep);
+    });
+
+    std::string body(cfg.body, 'p');
+    auto t0 = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> workers;
+    for (int w = 0; w < cfg.workers; ++w) {
+        workers.emplace_back([&, w]{
+            for (int64_t i = 0; i < total / cfg.workers; ++i) {
+                int idx = static_cast<int>((w * 7919 + i) % peers.size());
+                while (true) {
+                    auto frame = pool->acquire(body.size());
+                    std::memcpy(frame->body(), body.data(), body.size());
+                    if (queue.submit(idx, 0, std::move(frame))) break;
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& t : workers) t.join();
+    reactor.join();
+    auto t1 = std::chrono::high_resolution_clock::now();
+    done.store(true);
+    reader.join();
+    for (auto& p : peers) { ::close(p.fds[0]); ::close(p.fds[1]); }
+    ::close(reader_ep);
+
+    double sec = std::chrono::duration<double>(t1 - t0).count();
+    uint64_t wakeups = 0;
+    if constexpr (std::is_same_v<Queue, net::ResponseQueue>) wakeups = queue.wakeups();
+    else wakeups = total;
+    std::cout << "RESPONSE QUEUE BENCH RESULT\n"
+              << " mode=" << name
+              << " workers=" << cfg.workers
+              << " connections=" << cfg.connections
+              << " body=" << cfg.body
+              << " replies=" << total
+              << " K_replies_per_sec=" << std::fixed << std::setprecision(1) << total / sec / 1e3
+              << " eventfd_writes_per_reply=" << std::setprecision(4) << double(wakeups) / total
+              << " socket_write_calls_per_reply=" << double(sends.load()) / total
+              << "\n";
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg = parse_args(argc, argv);
+    if (cfg.mode == "all" || cfg.mode == "legacy") {
+        run_mode<LegacyQueue>("legacy", cfg, [](LegacyQueue& q, std::vector<Peer>& peers, std::atomic<uint64_t>& sends) {
+            return q.drain([&](int idx, net::FrameRef& frame) {
+                frame->seal();
+                ::send(peers[idx].fds[0], frame->wire_data(), frame->wire_size(), MSG_NOSIGNAL);
+                sends.fetch_add(1, std::memory_order_relaxed);
+            });
+        });
+    }
+    if (cfg.mode == "all" || cfg.mode == "batched") {
+        run_mode<net::ResponseQueue>("batched", cfg, [batch = std::vector<Peer*>{}](net::ResponseQueue& q, std::vector<Peer>& peers, std::atomic<uint64_t>& sends) mutable {
+            size_t n = q.drain([&](int idx, uint32_t, net::FrameRef& frame, net::OutboundSource&) {
+                Peer& p = peers[idx];
+                p.out.append(std::move(frame));
+                if (!p.staged) { p.staged = true; batch.push_back(&p); }
+                ++p.frames;
+            });
+            for (Peer* p : batch) {
+                size_t written = 0;
+                p->out.flush(p->fds[0], written);
+                p->out.clear();  // the reader keeps up; drop what the socket refused
+                p->staged = false;
+                sends.fetch_add((p->frames + 63) / 64, std::memory_order_relaxed);   // 64 iovecs per sendmsg
+                p->frames = 0;
+            }
+            batch.clear();
+            return n;
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "concurrency/lf_thread_pool.h"
+
+// A day in fast-forward on the server's worker layout (2 pinned + --min flexible workers): a
+// storm phase of --storm-rate tasks/s for --storm-ms, then a quiet phase of --quiet-rate
+// tasks/s for --quiet-ms. Tasks arrive open-loop, in 1ms batches, and each is a blocking call
+// of --task-us (a sleep), like a login's DB round trip.
+//
+// fixed:       the flexible tier stays at --min workers, as before.
+// elastic:     the tier scales between --min and --max (PoolScalingConfig, with --interval-ms
+//              and --shrink-after samples; the server uses 100ms and 50).
+//
+// latency is submit to completion; peak_workers the most flexible workers seen running,
+// end_workers those left at the end of the quiet phase.
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    int storm_rate = 4000;
+    int storm_ms = 2000;
+    int quiet_rate = 100;
+    int quiet_ms = 3000;
+    int task_us = 2000;
+    int min_workers = 4;
+    int max_workers = 16;
+    int interval_ms = 50;
+    int shrink_after = 10;
+};
+
+static BenchConfig parse_args(int argc, char** argv) {
+    BenchConfig cfg;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        auto need = [&](int i){ if (i+1>=argc) { std::cerr << "Missing value after " << a << "\n"; std::exit(1);} };
+        if (a == "--storm-rate") { need(i); cfg.storm_rate = std::atoi(argv[++i]); }
+        else if (a == "--storm-ms") { need(i); cfg.storm_ms = std::atoi(argv[++i]); }
+        else if (a == "--quiet-rate") { need(i); cfg.quiet_rate = std::atoi(argv[++i]); }
+        else if (a == "--quiet-ms") { need(i); cfg.quiet_ms = std::atoi(argv[++i]); }
+        else if (a == "--task-us") { need(i); cfg.task_us = std::atoi(argv[++i]); }
+        else if (a == "--min") { need(i); cfg.min_workers = std::atoi(argv[++i]); }
+        else if (a == "--max") { need(i); cfg.max_workers = std::atoi(argv[++i]); }
+        else if (a == "--interval-ms") { need(i); cfg.interval_ms = std::atoi(argv[++i]); }
+        else if (a == "--shrink-after") { need(i); cfg.shrink_after = std::atoi(argv[++i]); }
+        else if (a == "--help") {
+            std::cout << "Usage: scaling_bench [options]\n"
+                      << "  --storm-rate N         tasks/s during the storm (default 4000)\n"
+                      << "  --storm-ms N           storm length (default 2000)\n"
+                      << "  --quiet-rate N         tasks/s afterwards (default 100)\n"
+                      << "  --quiet-ms N           quiet phase length (default 3000)\n"
+                      << "  --task-us N            blocking time per task, slept (default 2000)\n"
+                      << "  --min N                flexible workers kept (default 4)\n"
+                      << "  --max N                flexible workers of the elastic variant (default 16)\n"
+                      << "  --interval-ms N        scaler sample interval (default 50)\n"
+                      << "  --shrink-after N       idle samples before retiring a worker (default 10)\n"
+                      << "  --help                 show this help\n";
+            std::exit(0);
+        }
+    }
+    return cfg;
+}
+
+static uint64_t g_sink = 0;     // results feed main()'s exit code so nothing is optimised away
+
+static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+struct Phase {
+    std::vector<int64_t> latency;
+    std::atomic<int> completed{0};
+    int rejected = 0;
+};
+
+// Submits rate tasks/s for ms, recording each one's latency into phase.
+static void drive(concurrency::LFThreadPool& pool, const BenchConfig& cfg, int rate, int ms, Phase& phase,
+                  std::size_t& peak) {
+    const int total = static_cast<int>(static_cast<int64_t>(rate) * ms / 1000);
+    phase.latency.assign(total, -1);
+    const auto t0 = Clock::now();
+    int sent = 0;
+    while (sent < total) {
+        const double elapsed_ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        const int due = std::min(total, static_cast<int>(elapsed_ms * rate / 1000.0) + 1);
+        for (; sent < due; ++sent) {
+            const int id = sent;
+            const int64_t start = now_ns();
+            bool queued = pool.submit([&phase, &cfg, id, start] {
+                std::this_thread::sleep_for(std::chrono::microseconds(cfg.task_us));
+                phase.latency[id] = now_ns() - start;
+                phase.completed.fetch_add(1);
+            });
+            if (!queued) {
+                ++phase.rejected;
+                phase.completed.fetch_add(1);
+            }
+        }
+        peak = std::max(peak, pool.flexible_worker_count());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    while (phase.completed.load() < total) {
+        peak = std::max(peak, pool.flexible_worker_count());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+static double pct(std::vector<int64_t> lat, double q) {
+    lat.erase(std::remove(lat.begin(), lat.end(), -1), lat.end());
+    if (lat.empty()) return 0.0;
+    std::sort(lat.begin(), lat.end());
+    return lat[std::min<std::size_t>(lat.size() - 1, lat.size() * q)] / 1e6;
+}
+
+static void run(const char* variant, const BenchConfig& cfg, bool elastic) {
+    concurrency::PoolScalingConfig scaling;
+    if (elastic) scaling.max_flexible = static_cast<std::size_t>(cfg.max_workers);
+    scaling.interval = std::chrono::milliseconds(cfg.interval_ms);
+    scaling.shrink_after = static_cast<unsigned>(cfg.shrink_after);
+    concurrency::LFThreadPool pool(2, static_cast<std::size_t>(cfg.min_workers), 1024, 1024, {},
+                                   concurrency::LFThreadPool::Scheduling::WorkStealing, {}, scaling);
+    Phase storm, quiet;
+    std::size_t peak = 0;
+    drive(pool, cfg, cfg.storm_rate, cfg.storm_ms, storm, peak);
+    drive(pool, cfg, cfg.quiet_rate, cfg.quiet_ms, quiet, peak);
+    g_sink += storm.completed.load() + quiet.completed.load();
+
+    const auto& stats = pool.stats();
+    std::cout << "SCALING BENCH RESULT"
+              << " variant=" << variant
+              << " min=" << cfg.min_workers
+              << " max=" << (elastic ? cfg.max_workers : cfg.min_workers)
+              << " storm_rate=" << cfg.storm_rate
+              << " task_us=" << cfg.task_us
+              << std::fixed << std::setprecision(2)
+              << " storm_p50_ms=" << pct(storm.latency, 0.5)
+              << " storm_p99_ms=" << pct(storm.latency, 0.99)
+              << " storm_rejected=" << storm.rejected
+              << " quiet_p99_ms=" << pct(quiet.latency, 0.99)
+              << " peak_workers=" << peak
+              << " end_workers=" << pool.flexible_worker_count()
+              << " scale_ups=" << stats.scale_ups.load()
+              << " scale_downs=" << stats.scale_downs.load()
+              << "\n";
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg = parse_args(argc, argv);
+    run("fixed", cfg, false);
+    run("elastic", cfg, true);
+    return g_sink == 0xdeadbeef;
+}
@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "net/socket_profile.h"
+
+// Loopback latency and throughput of the server-side socket profiles (net::SocketProfiles),
+// to pick the defaults. The profile is applied to the accepted (server) socket only.
+//   latency   64B request, reply written as 4B header + 60B body (two sends) -> RTT p50/p99
+//   download  server streams --mb MB in 64KB writes, EPOLLOUT driven, client drains
+//   upload    client streams --mb MB, server reads EPOLLIN driven with the per-connection
+//             SO_RCVLOWAT clamped to the remaining length, as LargePutDataHandler does
+// Besides the shipped profiles, a few variants show what the other knobs do.
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    int64_t mb = 512;
+    int pings = 20000;
+    std::string only;
+};
+
+static BenchConfig parse_args(int argc, char** argv) {
+    BenchConfig cfg;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        auto need = [&](int i){ if (i+1>=argc) { std::cerr << "Missing value after " << a << "\n"; std::exit(1);} };
+        if (a == "--mb") { need(i); cfg.mb = std::atoll(argv[++i]); }
+        else if (a == "--pings") { need(i); cfg.pings = std::atoi(argv[++i]); }
+        else if (a == "--profile") { need(i); cfg.only = argv[++i]; }
+        else if (a == "--help") {
+            std::cout << "Usage: socket_profile_bench [options]\n"
+                      << "  --profile NAME         run one profile (default: all)\n"
+                      << "  --mb N                 MB per throughput run (default 512)\n"
+                      << "  --pings N              latency round trips (default 20000)\n"
+                      << "  --help                 show this help\n";
+            std::exit(0);
+        }
+    }
+    return cfg;
+}
+
+struct Pair {
+    int server{-1};
+    int client{-1};
+    ~Pair() { if (server >= 0) ::close(server); if (client >= 0) ::close(client); }
+};
+
+static bool make_pair(Pair& p) {
+    int lfd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (::bind(lfd, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(lfd, 1) < 0
+        || ::getsockname(lfd, (sockaddr*)&addr, &len) < 0) {
+        ::close(lfd);
+        return false;
+    }
+    p.client = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (::connect(p.client, (sockaddr*)&addr, sizeof(addr)) < 0) { ::close(lfd); return false; }
+    p.server = ::accept4(lfd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    ::close(lfd);
+    return p.server >= 0;
+}
+
+static bool read_full(int fd, char* buf, size_t n) {
+    while (n) {
+        ssize_t r = ::read(fd, buf, n);
+        if (r <= 0) { if (r < 0 && errno == EINTR) continue; return false; }
+        buf += r; n -= r;
+    }
+    return true;
+}
+
+static bool write_full(int fd, const char* buf, size_t n) {
+    while (n) {
+        ssize_t w = ::write(fd, buf, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // non-blocking server socket: wait for room
+            epoll_event ev{};
+            int ep = ::epoll_create1(EPOLL_CLOEXEC);
+            ev.events = EPOLLOUT;
+            ::epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev);
+            ::epoll_wait(ep, &ev, 1, 1000);
+            ::close(ep);
+            continue;
+        }
+        if (w <= 0) return false;
+        buf += w; n -= w;
+    }
+    return true;
+}
+
+static void latency(const net::SocketProfile& profile, const BenchConfig& cfg, double& p50_us, double& p99_us) {
+    Pair p;
+    if (!make_pair(p)) { std::cerr << "socket pair failed\n"; std::exit(1); }
+    net::apply_socket_profile(p.server, profile, nullptr);
+    int one = 1;
+    ::setsockopt(p.client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));   // the client side is fixed
+
+    std::atomic<bool> stop{false};
+    std::thread server([&] {
+        int ep = ::epoll_create1(EPOLL_CLOEXEC);
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ::epoll_ctl(ep, EPOLL_CTL_ADD, p.server, &ev);
+        char req[64];
+        size_t got = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            if (::epoll_wait(ep, &ev, 1, 100) <= 0) continue;
+            ssize_t r = ::read(p.server, req + got, sizeof(req) - got);
+            if (r <= 0) { if (r < 0 && errno == EAGAIN) continue; break; }
+            got += r;
+            if (got < sizeof(req)) continue;
+            got = 0;
+            write_full(p.server, req, 4);           // header
+            write_full(p.server, req + 4, 60);      // body
+        }
+        ::close(ep);
+    });
+
+    std::vector<double> rtt;
+    rtt.reserve(cfg.pings);
+    char buf[64] = {};
+    auto deadline = Clock::now() + std::chrono::seconds(5);
+    for (int i = 0; i < cfg.pings && Clock::now() < deadline; ++i) {
+        auto t0 = Clock::now();
+        if (!write_full(p.client, buf, sizeof(buf)) || !read_full(p.client, buf, sizeof(buf))) break;
+        rtt.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+    }
+    stop.store(true);
+    ::shutdown(p.client, SHUT_RDWR);
+    server.join();
+    std::sort(rtt.begin(), rtt.end());
+    p50_us = rtt.empty() ? 0 : rtt[rtt.size() / 2];
+    p99_us = rtt.empty() ? 0 : rtt[rtt.size() * 99 / 100];
+}
+
+static double download(const net::SocketProfile& profile, const BenchConfig& cfg, double& wakeups_per_mb) {
+    Pair p;
+    if (!make_pair(p)) { std::cerr << "socket pair failed\n"; std::exit(1); }
+    net::apply_socket_profile(p.server, profile, nullptr);
+    const int64_t total = cfg.mb << 20;
+
+    std::thread client([&] {
+        std::vector<char> buf(256 * 1024);
+        int64_t left = total;
+        while (left > 0) {
+            ssize_t r = ::read(p.client, buf.data(), std::min<int64_t>(left, buf.size()));
+            if (r <= 0) break;
+            left -= r;
+        }
+    });
+
+    std::vector<char> chunk(64 * 1024, 'd');
+    int ep = ::epoll_create1(EPOLL_CLOEXEC);
+    epoll_event ev{};
+    ev.events = EPOLLOUT | EPOLLET;
+    ::epoll_ctl(ep, EPOLL_CTL_ADD, p.server, &ev);
+    int64_t sent = 0, wakeups = 0;
+    auto t0 = Clock::now();
+    while (sent < total) {
+        ssize_t w = ::write(p.server, chunk.data(), std::min<int64_t>(chunk.size(), total - sent));
+        if (w > 0) { sent += w; continue; }
+        if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            ::epoll_wait(ep, &ev, 1, 1000);
+            ++wakeups;
+            continue;
+        }
+        break;
+    }
+    client.join();
+    double sec = std::chrono::duration<double>(Clock::now() - t0).count();
+    ::close(ep);
+    wakeups_per_mb = static_cast<double>(wakeups) / cfg.mb;
+    return cfg.mb / sec;
+}
+
+static double upload(const net::SocketProfile& profile, const BenchConfig& cfg, double& wakeups_per_mb) {
+    Pair p;
+    if (!make_pair(p)) { std::cerr << "socket pair failed\n"; std::exit(1); }
+    net::apply_socket_profile(p.server, profile, nullptr);
+    const int64_t total = cfg.mb << 20;
+
+    std::thread client([&] {
+        std::vector<char> chunk(64 * 1024, 'u');
+        int64_t left = total;
+        while (left > 0) {
+            ssize_t w = ::write(p.client, chunk.data(), std::min<int64_t>(left, chunk.size()));
+            if (w <= 0) break;
+            left -= w;
+        }
+    });
+
+    std::vector<char> buf(64 * 1024);
+    int ep = ::epoll_create1(EPOLL_CLOEXEC);
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLET;
+    ::epoll_ctl(ep, EPOLL_CTL_ADD, p.server, &ev);
+    int64_t got = 0, wakeups = 0;
+    int lowat = 1;
+    auto t0 = Clock::now();
+    while (got < total) {
+        ssize_t r = ::read(p.server, buf.data(), buf.size());
+        if (r > 0) { got += r; continue; }
+        if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            int want = static_cast<int>(std::max<int64_t>(1, std::min<int64_t>(profile.rcvlowat, total - got)));
+            if (want != lowat && net::set_socket_rcvlowat(p.server, want)) lowat = want;
+            ::epoll_wait(ep, &ev, 1, 1000);
+            ++wakeups;
+            continue;
+        }
+        break;
+    }
+    double sec = std::chrono::duration<double>(Clock::now() - t0).count();
+    client.join();
+    ::close(ep);
+    wakeups_per_mb = static_cast<double>(wakeups) / cfg.mb;
+    return cfg.mb / sec;
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg = parse_args(argc, argv);
+    const net::SocketProfiles defaults = net::SocketProfiles::defaults();
+
+    std::vector<std::pair<std::string, net::SocketProfile>> profiles = {
+        {"kernel", net::SocketProfile::kernel_defaults()},
+        {"control", defaults.control},
+        {"bulk-upload", defaults.bulk_upload},
+        {"bulk-download", defaults.bulk_download},
+    };
+    auto variant = [&](std::string name, net::SocketProfile p) { profiles.emplace_back(std::move(name), std::move(p)); };
+    { auto p = defaults.bulk_download; p.notsent_lowat = 0; variant("bulk-download:notsent=default", p); }
+    { auto p = defaults.bulk_download; p.notsent_lowat = 64 * 1024; variant("bulk-download:notsent=64K", p); }
+    { auto p = defaults.bulk_download; p.cork = 1; variant("bulk-download:cork", p); }
+    { auto p = defaults.bulk_download; p.sndbuf = 4 << 20; variant("bulk-download:sndbuf=4M", p); }
+    { auto p = defaults.bulk_upload; p.rcvlowat = 1; variant("bulk-upload:rcvlowat=1", p); }
+    { auto p = defaults.bulk_upload; p.rcvlowat = 256 * 1024; variant("bulk-upload:rcvlowat=256K", p); }
+    { auto p = defaults.bulk_upload; p.rcvbuf = 4 << 20; variant("bulk-upload:rcvbuf=4M", p); }
+    { auto p = defaults.control; p.nodelay = 0; variant("control:nagle", p); }
+    { auto p = defaults.control; p.busy_poll_us = 50; variant("control:busy_poll=50us", p); }
+    { auto p = defaults.bulk_download; p.congestion = "bbr"; variant("bulk-download:bbr", p); }
+
+    for (auto& [name, profile] : profiles) {
+        if (!cfg.only.empty() && cfg.only != name) continue;
+        double p50 = 0, p99 = 0, down_w = 0, up_w = 0;
+        latency(profile, cfg, p50, p99);
+        double down = download(profile, cfg, down_w);
+        double up = upload(profile, cfg, up_w);
+        std::cout << "SOCKET PROFILE BENCH RESULT\n"
+                  << " profile=" << name
+                  << std::fixed << std::setprecision(1)
+                  << " rtt_p50_us=" << p50
+                  << " rtt_p99_us=" << p99
+                  << " download_MB_per_sec=" << down
+                  << " download_wakeups_per_MB=" << std::setprecision(2) << down_w
+                  << " upload_MB_per_sec=" << std::setprecision(1) << up
+                  << " upload_wakeups_per_MB=" << std::setprecision(2) << up_w
+                  << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "concurrency/lf_thread_pool.h"
+#include "lockfreequeue/array_mpmc_queue.hpp"
+#include "utils/alloc_counter.h"
+#include "utils/inline_function.h"
+
+// Cost of the thread pool's task type, with the capture of RequestHandler::submitToPool (a
+// shared_ptr to the handler and a timestamp, 24 bytes).
+//
+// function:    std::function<void()>, the previous LFThreadPool::Task; libstdc++ keeps 16
+//              bytes inline, so this capture goes to the heap.
+// inline:      utils::InlineFunction<void()>, the capture stored in the queue cell.
+//
+// queue:       one submitter, one consumer spinning on a lf::ArrayMPMCQueue of the task type,
+//              so the task type is all that differs. pool: LFThreadPool::submit (inline only).
+// ns_per_task is a burst of --tasks; latency is submit to the task starting, one task at a
+// time; allocs_per_task counts the submitting thread's heap allocations (built with
+// FILE_SERVER_COUNT_ALLOCS). Waiting threads yield, so it also runs on a single core.
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    int tasks = 1000000;
+    int pings = 20000;
+};
+
+static BenchConfig parse_args(int argc, char** argv) {
+    BenchConfig cfg;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        auto need = [&](int i){ if (i+1>=argc) { std::cerr << "Missing value after " << a << "\n"; std::exit(1);} };
+        if (a == "--tasks") { need(i); cfg.tasks = std::atoi(argv[++i]); }
+        else if (a == "--pings") { need(i); cfg.pings = std::atoi(argv[++i]); }
+        else if (a == "--help") {
+            std::cout << "Usage: task_bench [options]\n"
+                      << "  --tasks N              tasks in the throughput burst (default 1000000)\n"
+                      << "  --pings N              one-at-a-time latency samples (default 20000)\n"
+                      << "  --help                 show this help\n";
+            std::exit(0);
+        }
+    }
+    return cfg;
+}
+
+static uint64_t g_sink = 0;     // results feed main()'s exit code so nothing is optimised away
+
+static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// Stand-in for the handler a pool task keeps alive.
+struct Handler {
+    std::atomic<int64_t> started{0};
+    std::atomic<uint64_t> ran{0};
+    void handle(int64_t queued_at) {
+        started.store(now_ns() - queued_at, std::memory_order_release);
+        ran.fetch_add(1, std::memory_order_release);
+    }
+};
+
+template <typename Task>
+class QueueRunner {
+public:
+    QueueRunner() : queue_(1024), consumer_([this] {
+        Task task;
+        while (!stop_.load(std::memory_order_relaxed)) {
+            if (queue_.try_pop(task)) {
+                task();
+                task = nullptr;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }) {}
+    ~QueueRunner() {
+        stop_ = true;
+        consumer_.join();
+    }
+    bool submit(Task task) { return queue_.try_push(std::move(task)); }
+
+private:
+    lf::ArrayMPMCQueue<Task> queue_;
+    std::atomic<bool> stop_{false};
+    std::thread consumer_;
+};
+
+template <typename Task, typename Runner>
+static void run(const char* variant, const char* path, Runner& runner, const BenchConfig& cfg) {
+    auto handler = std::make_shared<Handler>();
+    auto make = [&handler] { return Task([handler, queued_at = now_ns()] { handler->handle(queued_at); }); };
+
+    uint64_t a0 = utils::thread_allocations();
+    auto t0 = Clock::now();
+    for (int i = 0; i < cfg.tasks; ++i) {
+        while (!runner.submit(make())) std::this_thread::yield();
+    }
+    while (handler->ran.load(std::memory_order_acquire) < static_cast<uint64_t>(cfg.tasks)) std::this_thread::yield();
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / cfg.tasks;
+    double allocs = static_cast<double>(utils::thread_allocations() - a0) / cfg.tasks;
+
+    std::vector<int64_t> latencies;
+    latencies.reserve(cfg.pings);
+    for (int i = 0; i < cfg.pings; ++i) {
+        uint64_t before = handler->ran.load();
+        while (!runner.submit(make())) std::this_thread::yield();
+        while (handler->ran.load(std::memory_order_acquire) == before) std::this_thread::yield();
+        latencies.push_back(handler->started.load(std::memory_order_acquire));
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto pct = [&](double q) { return latencies[std::min<std::size_t>(latencies.size() - 1, latencies.size() * q)]; };
+    g_sink += handler->ran.load();
+
+    std::cout << "TASK BENCH RESULT"
+              << " variant=" << variant
+              << " path=" << path
+              << " sizeof_task=" << sizeof(Task)
+              << std::fixed << std::setprecision(2)
+              << " allocs_per_task=" << allocs
+              << std::setprecision(1)
+              << " ns_per_task=" << ns
+              << " latency_p50_ns=" << pct(0.5)
+              << " latency_p99_ns=" << pct(0.99)
+              << "\n";
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg = parse_args(argc, argv);
+    if (!utils::alloc_counter_enabled()) std::cerr << "warning: built without FILE_SERVER_COUNT_ALLOCS\n";
+    {
+        QueueRunner<std::function<void()>> runner;
+        run<std::function<void()>>("function", "queue", runner, cfg);
+    }
+    {
+        QueueRunner<utils::InlineFunction<void()>> runner;
+        run<utils::InlineFunction<void()>>("inline", "queue", runner, cfg);
+    }
+    {
+        concurrency::LFThreadPool pool(0, 1, 1024, 1024);
+        run<concurrency::LFThreadPool::Task>("inline", "pool", pool, cfg);
+    }
+    return g_sink == 0xdeadbeef;
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include "concurrency/admission_controller.h"
+
+using namespace std::chrono_literals;
+using concurrency::AdmissionConfig;
+using concurrency::AdmissionController;
+
+namespace {
+// Every completion closes a window once min_samples are in, so the tests drive the limit directly.
+AdmissionConfig test_config(uint32_t initial = 16) {
+    AdmissionConfig cfg;
+    cfg.initial_limit = initial;
+    cfg.min_limit = 4;
+    cfg.max_limit = 64;
+    cfg.window = 0ms;
+    cfg.min_samples = 4;
+    cfg.max_connections = 2;
+    return cfg;
+}
+
+// Fill the limit, then complete all requests with `latency`; one window per batch.
+void run_batch(AdmissionController& ac, std::chrono::microseconds latency) {
+    uint32_t taken = 0;
+    while (ac.try_acquire()) ++taken;
+    for (uint32_t i = 0; i < taken; ++i) ac.release(latency);
+}
+}
+
+TEST(AdmissionController, ShedsAboveLimit) {
+    AdmissionController ac(test_config(4));
+    for (int i = 0; i < 4; ++i) EXPECT_TRUE(ac.try_acquire());
+    EXPECT_FALSE(ac.try_acquire());
+    EXPECT_FALSE(ac.admit_transfer());
+    EXPECT_EQ(ac.in_flight(), 4u);
+    EXPECT_EQ(ac.stats().admitted.load(), 4u);
+    EXPECT_EQ(ac.stats().shed.load(), 2u);
+
+    ac.release(1ms);
+    EXPECT_TRUE(ac.admit_transfer());   // transfers do not take the freed slot
+    EXPECT_TRUE(ac.try_acquire());
+}
+
+TEST(AdmissionController, GrowsWhileLatencyIsFlat) {
+    AdmissionController ac(test_config(16));
+    for (int i = 0; i < 10; ++i) run_batch(ac, 100us);
+    EXPECT_GT(ac.limit(), 16u);
+    EXPECT_LE(ac.limit(), 64u);
+    EXPECT_GT(ac.stats().limit_increases.load(), 0u);
+    EXPECT_EQ(ac.stats().limit_decreases.load(), 0u);
+}
+
+TEST(AdmissionController, DoesNotGrowUnusedLimit) {
+    AdmissionController ac(test_config(32));
+    for (int i = 0; i < 40; ++i) {
+        ASSERT_TRUE(ac.try_acquire());
+        ac.release(100us);   // never more than one in flight
+    }
+    EXPECT_EQ(ac.limit(), 32u);
+}
+
+TEST(AdmissionController, BacksOffWhenLatencyRises) {
+    AdmissionController ac(test_config(32));
+    run_batch(ac, 100us);   // baseline
+    uint32_t before = ac.limit();
+    for (int i = 0; i < 20; ++i) run_batch(ac, 10ms);
+    EXPECT_LT(ac.limit(), before);
+    EXPECT_GE(ac.limit(), 4u);
+    EXPECT_GT(ac.stats().limit_decreases.load(), 0u);
+    // the retry hint follows the recent latency
+    EXPECT_GE(ac.retry_after_ms(), 20u);
+}
+
+TEST(AdmissionController, QueueFullIsShedAndBacksOff) {
+    AdmissionController ac(test_config(16));
+    ASSERT_TRUE(ac.try_acquire());
+    ac.on_queued();
+    ac.on_started();
+    ac.on_queue_full(true);
+    EXPECT_EQ(ac.in_flight(), 0u);
+    EXPECT_EQ(ac.stats().admitted.load(), 0u);
+    EXPECT_EQ(ac.stats().shed.load(), 1u);
+    EXPECT_EQ(ac.stats().shed_queue_full.load(), 1u);
+    EXPECT_EQ(ac.stats().queued.load(), 0u);
+    EXPECT_LT(ac.limit(), 16u);
+}
+
+TEST(AdmissionController, ConnectionLimit) {
+    AdmissionController ac(test_config());
+    EXPECT_TRUE(ac.admit_connection());
+    ac.connection_opened();
+    ac.connection_opened();
+    EXPECT_FALSE(ac.admit_connection());
+    ac.connection_closed();
+    EXPECT_TRUE(ac.admit_connection());
+    EXPECT_EQ(ac.stats().shed_connections.load(), 1u);
+}
+
+TEST(AdmissionController, RefusesConnectionsWhilePoolIsBehind) {
+    AdmissionConfig cfg = test_config(4);
+    cfg.max_connections = 0;
+    AdmissionController ac(cfg);
+    for (int i = 0; i < 4; ++i) ac.on_queued();
+    EXPECT_FALSE(ac.admit_connection());
+    ac.on_started();
+    EXPECT_TRUE(ac.admit_connection());
+}
+
+TEST(AdmissionController, ConcurrentCompletionsStillAdaptTheLimit) {
+    // Completions from many threads at once: the windows roll over without a lock on every
+    // release, and the limit still grows at flat latency and stays in bounds.
+    AdmissionController ac(test_config(8));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&ac] {
+            for (int i = 0; i < 20000; ++i) {
+                if (ac.try_acquire()) ac.release(100us);
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    EXPECT_EQ(ac.in_flight(), 0u);
+    EXPECT_GE(ac.limit(), 4u);
+    EXPECT_LE(ac.limit(), 64u);
+    EXPECT_EQ(ac.stats().limit_decreases.load(), 0u);
+}
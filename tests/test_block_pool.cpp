@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "net/block_pool.h"
+
+namespace {
+struct Node : std::enable_shared_from_this<Node> {
+    explicit Node(std::string n) : name(std::move(n)) {}
+    std::string name;
+    char payload[300]{};
+};
+}
+
+TEST(BlockPool, ReleasedBlocksAreReused) {
+    auto pool = net::BlockPool::create();
+    void* a = pool->allocate(100);
+    pool->deallocate(a, 100);
+    void* b = pool->allocate(120);          // same class
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(pool->stats().reused.load(), 1u);
+    void* c = pool->allocate(400);          // another class
+    EXPECT_NE(c, b);
+    EXPECT_EQ(pool->stats().outstanding.load(), 2u);
+    pool->deallocate(b, 120);
+    pool->deallocate(c, 400);
+    EXPECT_EQ(pool->stats().outstanding.load(), 0u);
+}
+
+TEST(BlockPool, OversizedBlocksComeFromTheHeap) {
+    auto pool = net::BlockPool::create();
+    std::size_t size = net::BlockPool::kClassSize.back() + 1;
+    void* a = pool->allocate(size);
+    pool->deallocate(a, size);
+    void* b = pool->allocate(size);
+    EXPECT_EQ(pool->stats().reused.load(), 0u);
+    pool->deallocate(b, size);
+}
+
+TEST(BlockPool, MakePooledRecyclesObjectAndControlBlock) {
+    auto pool = net::BlockPool::create();
+    const Node* first = nullptr;
+    {
+        auto node = net::make_pooled<Node>(pool.get(), "a");
+        first = node.get();
+        EXPECT_EQ(node->shared_from_this(), node);
+        EXPECT_EQ(pool->stats().outstanding.load(), 1u);    // one block for both
+    }
+    EXPECT_EQ(pool->stats().outstanding.load(), 0u);
+    auto again = net::make_pooled<Node>(pool.get(), "b");
+    EXPECT_EQ(again.get(), first);
+    EXPECT_EQ(again->name, "b");
+
+    auto unpooled = net::make_pooled<Node>(nullptr, "c");
+    EXPECT_EQ(pool->stats().acquired.load(), 2u);
+}
+
+TEST(BlockPool, ObjectsOutlivePoolHandle) {
+    auto pool = net::BlockPool::create();
+    auto node = net::make_pooled<Node>(pool.get(), "kept");
+    std::weak_ptr<Node> weak = node;
+    pool.reset();                 // owner gone, object still valid
+    EXPECT_EQ(node->name, "kept");
+    node.reset();                 // last user releases the pool
+    EXPECT_TRUE(weak.expired());
+}
+
+TEST(BlockPool, CrossThreadRelease) {
+    auto pool = net::BlockPool::create();
+    std::vector<std::shared_ptr<Node>> nodes;
+    for (int i = 0; i < 1000; ++i) nodes.push_back(net::make_pooled<Node>(pool.get(), std::to_string(i)));
+    std::thread t([moved = std::move(nodes)]() mutable { moved.clear(); });
+    t.join();
+    EXPECT_EQ(pool->stats().outstanding.load(), 0u);
+    for (int i = 0; i < 1000; ++i) nodes.push_back(net::make_pooled<Node>(pool.get(), "again"));
+    EXPECT_EQ(pool->stats().reused.load(), 1000u);
+}
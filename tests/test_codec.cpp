@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+
+#include <set>
+#include <string>
+
+#include "protocol/codec.h"
+#include "protocol/request_parser.h"
+#include "protocol/response_builder.h"
+#include "protocol/wire_format.h"
+
+using nlohmann::json;
+using namespace protocol;
+
+namespace {
+const uint8_t* bytes(const std::string& s) { return reinterpret_cast<const uint8_t*>(s.data()); }
+
+std::string binary(const Request& r) {
+    std::string out;
+    encode_request(r, out);
+    return out;
+}
+
+std::string binary(const Response& r) {
+    std::string out;
+    encode_response(r, out);
+    return out;
+}
+}
+
+TEST(Codec, CommandNames) {
+    for (uint8_t v = 1; v <= kCommandCount; ++v) {
+        auto c = static_cast<Command>(v);
+        EXPECT_EQ(command_from_name(command_name(c)), c);
+    }
+    static_assert(command_from_name("put_data_channel") == Command::PutDataChannel);
+    EXPECT_FALSE(command_from_name("list").has_value());
+    EXPECT_FALSE(command_from_name("").has_value());
+    EXPECT_FALSE(command_from_name("puT").has_value());     // same slot as "put"
+    EXPECT_FALSE(command_from_name("LS").has_value());
+}
+
+TEST(Codec, RequestsRoundTripBothEncodings) {
+    std::vector<Request> requests{
+        LsRequest{}, PwdRequest{}, CdRequest{"/a/b"}, MkdirRequest{"docs"}, RmRequest{"x.txt"},
+        RmdirRequest{"old"}, GetRequest{"big.bin", 1ull << 40}, PutRequest{"f", 5 << 20, "abc123"},
+        PutDataChannelRequest{"tok", "abc"}, LoginRequest{"u", "p"}, RegisterRequest{"u2", "p2"}, PubkeyRequest{},
+        HelloRequest{2, kServerCapabilities, kMaxBodyV2}, StatRequest{"x.txt"}, StatsRequest{}};
+    ASSERT_EQ(requests.size(), std::variant_size_v<Request>);
+    for (const auto& r : requests) {
+        std::string b = binary(r);
+        EXPECT_EQ(static_cast<uint8_t>(b[0]), static_cast<uint8_t>(command_of(r)));
+        auto back = decode_request(bytes(b), b.size());
+        ASSERT_TRUE(back.has_value());
+        EXPECT_EQ(binary(*back), b);
+
+        auto j = request_to_json(r);
+        auto from_json = request_from_json(json::parse(j.dump()));
+        ASSERT_TRUE(from_json.has_value()) << j.dump();
+        EXPECT_EQ(binary(*from_json), b) << j.dump();
+    }
+}
+
+TEST(Codec, RequestJsonKeepsLegacyShapes) {
+    EXPECT_EQ(request_to_json(CdRequest{"/x"}), json::parse(R"({"command":"cd","params":"/x"})"));
+    EXPECT_EQ(request_to_json(GetRequest{"a", 7}),
+              json::parse(R"({"command":"get","params":{"file_name":"a","offset":7}})"));
+
+    // what the client sends today
+    auto ls = request_from_json(json::parse(R"({"command":"ls","params":[]})"));
+    ASSERT_TRUE(ls && std::holds_alternative<LsRequest>(*ls));
+    auto pubkey = request_from_json(json::parse(R"({"command":"pubkey"})"));
+    ASSERT_TRUE(pubkey && std::holds_alternative<PubkeyRequest>(*pubkey));
+    auto cd = request_from_json(json::parse(R"({"command":"cd"})"));
+    ASSERT_TRUE(cd);
+    EXPECT_EQ(std::get<CdRequest>(*cd).path, "/");
+    auto get = request_from_json(json::parse(R"({"command":"get","params":{"file_name":"a"}})"));
+    ASSERT_TRUE(get);
+    EXPECT_EQ(std::get<GetRequest>(*get).offset, 0u);    // missing fields keep defaults
+
+    EXPECT_FALSE(request_from_json(json::parse(R"({"command":"nope"})")));
+    EXPECT_FALSE(request_from_json(json::parse(R"({"command":"put","params":{"file_size":-1}})")));
+    EXPECT_FALSE(request_from_json(json::parse(R"({"command":"rm","params":{"file_name":5}})")));
+    EXPECT_FALSE(request_from_json(json::parse(R"({"command":"hello","params":{"version":4294967296}})")));
+}
+
+TEST(Codec, ResponseJsonKeepsLegacyShapes) {
+    ResponseBuilder rb;
+    EXPECT_EQ(response_to_json(rb.build("/home")), json::parse(R"({"responseMessage":"/home"})"));
+    EXPECT_EQ(response_to_json(rb.buildErrorResponse(404, "nope")),
+              json::parse(R"({"status":"error","errorCode":404,"errorMessage":"nope"})"));
+    EXPECT_EQ(response_to_json(rb.buildBusyResponse(50)),
+              json::parse(R"({"status":"error","errorCode":9,"errorMessage":"server busy","retryAfterMs":50})"));
+    EXPECT_EQ(response_to_json(rb.buildGetInitResponse("f", 1, 2, "h")),
+              json::parse(R"({"status":"get_init","fileName":"f","offset":1,"fileSize":2,"fileHash":"h"})"));
+    EXPECT_EQ(response_to_json(rb.buildPutResponse("receiving", "f", 3, "h")),
+              json::parse(R"({"status":"receiving","fileName":"f","fileSize":3,"fileHash":"h"})"));
+    EXPECT_EQ(response_to_json(rb.buildHelloResponse(2, 5, 1024)),
+              json::parse(R"({"status":"hello","version":2,"capabilities":5,"maxFrame":1024})"));
+
+    // login/pubkey: the fields as a JSON string in responseMessage, as clients parse them
+    auto login = response_to_json(rb.buildLoginResponse("t", 3, -1, "bob"));
+    ASSERT_TRUE(login["responseMessage"].is_string());
+    EXPECT_EQ(json::parse(login["responseMessage"].get<std::string>()),
+              json::parse(R"({"token":"t","user_id":3,"session_id":-1,"username":"bob"})"));
+}
+
+TEST(Codec, ResponsesRoundTripBinary) {
+    ResponseBuilder rb;
+    std::vector<Response> responses{
+        rb.build("a\nb"), rb.buildErrorResponse(-7, "neg"), rb.buildBusyResponse(0),
+        rb.buildPutResponse("completed", "f", 1ull << 33, "h"), rb.buildGetInitResponse("f", 1, 2, "h"),
+        rb.buildLargePutInit("f", 9, "h", "tok", "splice", 65536), rb.buildLargePutComplete("f", 9, "h", true),
+        rb.buildHelloResponse(2, 15, 1 << 20), rb.buildLoginResponse("t", 1, 2, "u"), rb.buildPubkeyResponse("pem"),
+        rb.buildStatResponse("d", true, 0, "")};
+    std::set<size_t> kinds;
+    for (const auto& r : responses) {
+        kinds.insert(r.index());
+        std::string b = binary(r);
+        auto back = decode_response(bytes(b), b.size());
+        ASSERT_TRUE(back.has_value());
+        EXPECT_EQ(back->index(), r.index());
+        EXPECT_EQ(response_to_json(*back), response_to_json(r));
+    }
+    EXPECT_EQ(kinds.size(), std::variant_size_v<Response>);
+    auto busy = decode_response(bytes(binary(rb.buildBusyResponse(0))), binary(rb.buildBusyResponse(0)).size());
+    EXPECT_EQ(std::get<ErrorResponse>(*busy).retry_after_ms, 0u);      // present, not absent
+}
+
+TEST(Codec, BinaryIsCompact) {
+    // tag, length, "x.txt"
+    EXPECT_EQ(binary(Request{RmRequest{"x.txt"}}).size(), 1u + 1u + 5u);
+    EXPECT_EQ(binary(Request{LsRequest{}}).size(), 1u);
+    EXPECT_LT(binary(Response{GetInitResponse{"f", 0, 1 << 20, std::string(40, 'a')}}).size(), 50u);
+}
+
+TEST(Codec, BinaryToleratesOlderAndNewerPeers) {
+    std::string full = binary(Request{GetRequest{"abc", 300}});
+    // older peer: the body ends before offset
+    auto shorter = decode_request(bytes(full), 1 + 1 + 3);
+    ASSERT_TRUE(shorter);
+    EXPECT_EQ(std::get<GetRequest>(*shorter).file_name, "abc");
+    EXPECT_EQ(std::get<GetRequest>(*shorter).offset, 0u);
+    // newer peer: fields we do not know yet follow
+    std::string longer = full + std::string("\x05\x01", 2);
+    auto extended = decode_request(bytes(longer), longer.size());
+    ASSERT_TRUE(extended);
+    EXPECT_EQ(std::get<GetRequest>(*extended).offset, 300u);
+}
+
+TEST(Codec, BinaryRejectsMalformed) {
+    std::string unknown("\x7f", 1);
+    EXPECT_FALSE(decode_request(bytes(unknown), unknown.size()));
+    EXPECT_FALSE(decode_request(nullptr, 0));
+    std::string full = binary(Request{RmRequest{"x.txt"}});
+    EXPECT_FALSE(decode_request(bytes(full), full.size() - 1));       // string cut short
+    std::string unterminated("\x07\x01" "a" "\xff\xff", 5);          // offset varint never ends
+    EXPECT_FALSE(decode_request(bytes(unterminated), unterminated.size()));
+    std::string bad_bool = binary(Response{StatResponse{"d", true, 0, ""}});
+    bad_bool[3] = 2;
+    EXPECT_FALSE(decode_response(bytes(bad_bool), bad_bool.size()));
+    std::string too_big = binary(Request{HelloRequest{1, 0, 0}});
+    too_big = too_big.substr(0, 1) + std::string("\x80\x80\x80\x80\x10", 5);   // 2^32 into a uint32_t
+    EXPECT_FALSE(decode_request(bytes(too_big), too_big.size()));
+}
+
+TEST(Codec, RequestParserTakesEitherEncoding) {
+    RequestParser parser;
+    std::string text = R"({"command":"stat","params":{"file_name":"a"}})";
+    auto from_text = parser.parse(bytes(text), text.size(), false);
+    ASSERT_TRUE(from_text && std::holds_alternative<StatRequest>(*from_text));
+
+    std::string b = binary(*from_text);
+    auto from_binary = parser.parse(bytes(b), b.size(), true);
+    ASSERT_TRUE(from_binary);
+    EXPECT_EQ(std::get<StatRequest>(*from_binary).file_name, "a");
+
+    std::string garbage = "{not json";
+    EXPECT_FALSE(parser.parse(bytes(garbage), garbage.size(), false));
+    EXPECT_EQ(parser.error(), "malformed JSON");
+    std::string unknown = R"({"command":"frobnicate"})";
+    EXPECT_FALSE(parser.parse(bytes(unknown), unknown.size(), false));
+    EXPECT_EQ(parser.error(), "Unknown command");
+}
@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+#include "concurrency/coroutine.h"
+#include "concurrency/lf_thread_pool.h"
+#include "metrics/trace.h"
+#include "net/frame_buffer.h"
+#include "net/output_drained.h"
+#include "net/response_queue.h"
+#include "types/context.h"
+
+using concurrency::Co;
+using concurrency::LFThreadPool;
+
+namespace {
+
+bool wait_for(const std::atomic<int>& value, int expected) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (value.load() != expected) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+Co<int> add(int a, int b) { co_return a + b; }
+
+Co<int> sum_to(int n) {
+    int total = 0;
+    for (int i = 1; i <= n; ++i) total = co_await add(total, i);
+    co_return total;
+}
+
+Co<int> fail() {
+    throw std::runtime_error("boom");
+    co_return 0;
+}
+
+} // namespace
+
+TEST(Coroutine, AwaitsNestedTasksAndPropagatesExceptions) {
+    std::atomic<int> result{0};
+    std::atomic<int> caught{0};
+    concurrency::spawn([](std::atomic<int>& result, std::atomic<int>& caught) -> Co<void> {
+        result = co_await sum_to(10000);   // symmetric transfer: no stack growth per await
+        try {
+            co_await fail();
+        } catch (const std::runtime_error&) {
+            caught = 1;
+        }
+    }(result, caught));
+    EXPECT_EQ(result.load(), 50005000);
+    EXPECT_EQ(caught.load(), 1);
+}
+
+TEST(Coroutine, RunOnFreesTheWorkerAndResumesOnItsPool) {
+    LFThreadPool home(0, 1, 64, 64);
+    LFThreadPool executor(0, 8, 64, 64);
+    constexpr int kCalls = 8;
+    std::atomic<int> blocked{0};
+    std::atomic<int> release{0};
+    std::atomic<int> on_home{0};
+    std::atomic<int> done{0};
+    auto request = [&]() -> Co<void> {
+        std::thread::id worker = std::this_thread::get_id();
+        int value = co_await concurrency::run_on(&executor, [&] {
+            if (std::this_thread::get_id() == worker) return -1;
+            ++blocked;
+            while (release.load() == 0) std::this_thread::yield();
+            return 7;
+        });
+        if (value == 7 && LFThreadPool::current() == &home) ++on_home;
+        ++done;
+    };
+    for (int i = 0; i < kCalls; ++i) {
+        ASSERT_TRUE(home.submit([&] { concurrency::spawn(request()); }));
+    }
+    // One home worker, all calls blocked at once: each request let go of it while waiting.
+    bool all_blocked = wait_for(blocked, kCalls);
+    release = 1;
+    ASSERT_TRUE(all_blocked) << blocked.load() << " calls blocked";
+    ASSERT_TRUE(wait_for(done, kCalls));
+    EXPECT_EQ(on_home.load(), kCalls);
+}
+
+TEST(Coroutine, RunOnWithoutExecutorRunsInlineAndRethrows) {
+    std::atomic<int> ran_here{0};
+    std::atomic<int> caught{0};
+    const std::thread::id self = std::this_thread::get_id();
+    concurrency::spawn([&]() -> Co<void> {
+        co_await concurrency::run_on(nullptr, [&] {
+            if (std::this_thread::get_id() == self) ran_here = 1;
+        });
+        try {
+            co_await concurrency::run_on(nullptr, []() -> int { throw std::runtime_error("db down"); });
+        } catch (const std::runtime_error&) {
+            caught = 1;
+        }
+    }());
+    EXPECT_EQ(ran_here.load(), 1);
+    EXPECT_EQ(caught.load(), 1);
+}
+
+TEST(Coroutine, KeepsTheTraceAcrossThreads) {
+    LFThreadPool executor(0, 2, 64, 64);
+    std::atomic<int> seen_in_call{0};
+    std::atomic<int> seen_after{0};
+    std::atomic<int> done{0};
+    // A named lambda: its captures must outlive the suspended coroutine.
+    auto traced = [&]() -> Co<void> {
+        co_await concurrency::run_on(&executor, [&] { seen_in_call = static_cast<int>(metrics::trace::current()); });
+        seen_after = static_cast<int>(metrics::trace::current());
+        ++done;
+    };
+    {
+        metrics::trace::Scope scope(42);
+        concurrency::spawn(traced());
+    }
+    ASSERT_TRUE(wait_for(done, 1));
+    EXPECT_EQ(seen_in_call.load(), 42);
+    EXPECT_EQ(seen_after.load(), 42);
+}
+
+TEST(Coroutine, OutputDrainedResumesWhenTheReactorGetsToIt) {
+    auto reactor = std::make_shared<ReactorContext>();
+    reactor->response_queue = std::make_shared<net::ResponseQueue>(16);
+    auto ctx = std::make_shared<ConnectionContext>(reactor);
+    ctx->connection_id = 9;
+    ctx->connection_generation = 3;
+
+    std::atomic<int> result{-1};
+    auto writer = [&]() -> Co<void> { result = (co_await net::output_drained(ctx)) ? 1 : 0; };
+
+    // The reactor calls the source once output is low: drained.
+    concurrency::spawn(writer());
+    EXPECT_EQ(result.load(), -1);
+    EXPECT_EQ(ctx->responses_queued.load(), 1u);
+    net::OutboundBuffer out;
+    std::size_t delivered = reactor->response_queue->drain([&](int fd, uint32_t generation, net::FrameRef&, net::OutboundSource& source) {
+        EXPECT_EQ(fd, 9);
+        EXPECT_EQ(generation, 3u);
+        ASSERT_TRUE(source);
+        EXPECT_FALSE(source(out));    // done after one call, like a finished stream
+    });
+    EXPECT_EQ(delivered, 1u);
+    EXPECT_EQ(result.load(), 1);
+    EXPECT_TRUE(out.empty());
+
+    // The connection is gone: the reactor drops the source uncalled.
+    result = -1;
+    concurrency::spawn(writer());
+    reactor->response_queue->drain([](int, uint32_t, net::FrameRef&, net::OutboundSource&) {});
+    EXPECT_EQ(result.load(), 0);
+}
+
+TEST(Coroutine, OutputDrainedWaitsBehindAFullQueue) {
+    auto reactor = std::make_shared<ReactorContext>();
+    reactor->response_queue = std::make_shared<net::ResponseQueue>(16);
+    auto ctx = std::make_shared<ConnectionContext>(reactor);
+    ctx->connection_id = 9;
+    ctx->connection_generation = 3;
+    auto frames = net::FramePool::create();
+    for (std::size_t i = 0; i < reactor->response_queue->capacity(); ++i) {
+        reactor->response_queue->submit(9, 3, frames->acquire(8));
+    }
+
+    std::atomic<int> result{-1};
+    auto writer = [&]() -> Co<void> { result = (co_await net::output_drained(ctx)) ? 1 : 0; };
+    concurrency::spawn(writer());
+    // Queued behind the frames, not refused: nothing resumes the coroutine yet.
+    EXPECT_EQ(result.load(), -1);
+    EXPECT_EQ(reactor->response_queue->overflowed(), 1u);
+
+    std::size_t frames_before = 0;
+    bool source_seen = false;
+    net::OutboundBuffer out;
+    for (int i = 0; i < 8 && !source_seen; ++i) {
+        reactor->response_queue->drain([&](int, uint32_t, net::FrameRef& frame, net::OutboundSource& source) {
+            if (frame) ++frames_before;
+            if (source) {
+                source_seen = true;
+                source(out);
+            }
+        });
+    }
+    EXPECT_EQ(frames_before, reactor->response_queue->capacity());
+    EXPECT_EQ(result.load(), 1);
+}
@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+#include "concurrency/cpu_topology.h"
+
+using concurrency::CpuTopology;
+using concurrency::PlacementRequest;
+using concurrency::parse_cpu_list;
+using concurrency::plan_placement;
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// A sysfs tree of sockets x cores x threads, numbered like x86 Linux: the first thread of
+// every core, socket by socket, then the second threads. One NUMA node per socket.
+class FakeSysfs {
+public:
+    FakeSysfs(int sockets, int cores, int threads, const std::string& isolated = "")
+        : root_(fs::temp_directory_path() / ("cpu_topology_test_" + std::to_string(::getpid()) + "_" + std::to_string(counter_++))) {
+        const int cpus = sockets * cores * threads;
+        write("cpu/online", "0-" + std::to_string(cpus - 1));
+        write("cpu/isolated", isolated);
+        std::vector<std::string> node_lists(sockets);
+        for (int cpu = 0; cpu < cpus; ++cpu) {
+            const int socket = (cpu / cores) % sockets;
+            const std::string dir = "cpu/cpu" + std::to_string(cpu) + "/topology/";
+            write(dir + "physical_package_id", std::to_string(socket));
+            write(dir + "core_id", std::to_string(cpu % cores));
+            node_lists[socket] += (node_lists[socket].empty() ? "" : ",") + std::to_string(cpu);
+        }
+        for (int s = 0; s < sockets; ++s) write("node/node" + std::to_string(s) + "/cpulist", node_lists[s]);
+    }
+    ~FakeSysfs() {
+        std::error_code ec;
+        fs::remove_all(root_, ec);
+    }
+
+    std::string root() const { return root_.string(); }
+
+private:
+    void write(const std::string& path, const std::string& content) {
+        fs::create_directories((root_ / path).parent_path());
+        std::ofstream(root_ / path) << content << "\n";
+    }
+
+    static inline int counter_ = 0;
+    fs::path root_;
+};
+
+std::vector<int> cpus(const char* list) { return parse_cpu_list(list).value(); }
+
+} // namespace
+
+TEST(CpuTopology, ParsesAndFormatsCpuLists) {
+    EXPECT_EQ(parse_cpu_list("0-3,8,10-11").value(), (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(parse_cpu_list("").value(), std::vector<int>{});
+    EXPECT_FALSE(parse_cpu_list("3-1").has_value());
+    EXPECT_FALSE(parse_cpu_list("a,b").has_value());
+    EXPECT_EQ(concurrency::format_cpu_list({11, 0, 1, 2, 3, 8, 10}), "0-3,8,10-11");
+    EXPECT_EQ(concurrency::format_cpu_list({}), "none");
+}
+
+TEST(CpuTopology, ReadsSocketsNodesCoresAndIsolation) {
+    FakeSysfs sysfs(2, 8, 2, "4-7");
+    auto topology = CpuTopology::from_sysfs(sysfs.root());
+    ASSERT_EQ(topology.cpus().size(), 32u);
+    EXPECT_EQ(topology.sockets(), 2u);
+    EXPECT_EQ(topology.cores(), 16u);
+    EXPECT_EQ(topology.nodes(), (std::vector<int>{0, 1}));
+    EXPECT_EQ(topology.node_cpus(1), cpus("8-15,24-31"));
+    // SMT siblings share a core, the same core_id on the other socket does not.
+    EXPECT_EQ(topology.find(3)->core, topology.find(19)->core);
+    EXPECT_NE(topology.find(3)->core, topology.find(11)->core);
+    EXPECT_TRUE(topology.find(5)->isolated);
+    EXPECT_FALSE(topology.find(21)->isolated);
+
+    auto limited = CpuTopology::from_sysfs(sysfs.root(), {0, 1, 2});
+    EXPECT_EQ(limited.cpus().size(), 3u);
+}
+
+TEST(CpuTopology, PlansOneNodeAndWholeCoresFirst) {
+    FakeSysfs sysfs(2, 8, 2);
+    auto topology = CpuTopology::from_sysfs(sysfs.root());
+    auto plan = plan_placement(topology, PlacementRequest{});
+    EXPECT_EQ(plan.numa_node, 0);
+    // CPU 0's core last; no two dedicated threads on SMT siblings.
+    EXPECT_EQ(plan.io_reactor_cpus, (std::vector<int>{1, 2, 3, 4}));
+    EXPECT_EQ(plan.pinned_worker_cpus, (std::vector<int>{5, 6}));
+    EXPECT_FALSE(plan.smt_shared);
+    // Not the siblings of the dedicated cores (17-22).
+    EXPECT_EQ(plan.shared_cpus, cpus("0,7,16,23"));
+    EXPECT_EQ(plan.main_reactor_cpu, 0);
+    EXPECT_NE(plan.describe(topology).find("IO reactors 1,2,3,4"), std::string::npos);
+}
+
+TEST(CpuTopology, PrefersIsolatedCoresForDedicatedThreads) {
+    FakeSysfs sysfs(2, 8, 2, "4-7");
+    auto topology = CpuTopology::from_sysfs(sysfs.root());
+    auto plan = plan_placement(topology, PlacementRequest{});
+    EXPECT_EQ(plan.io_reactor_cpus, (std::vector<int>{4, 5, 6, 7}));
+    EXPECT_EQ(plan.pinned_worker_cpus, (std::vector<int>{1, 2}));
+    // Isolated CPUs are never handed to the scheduler-balanced threads.
+    EXPECT_EQ(plan.shared_cpus, cpus("0,3,16,19"));
+}
+
+TEST(CpuTopology, UsesSmtSiblingsOnlyWhenCoresRunOut) {
+    FakeSysfs sysfs(1, 4, 2);
+    auto topology = CpuTopology::from_sysfs(sysfs.root());
+    auto plan = plan_placement(topology, PlacementRequest{});
+    EXPECT_EQ(plan.io_reactor_cpus, (std::vector<int>{1, 2, 3, 0}));
+    EXPECT_EQ(plan.pinned_worker_cpus, (std::vector<int>{5, 6}));
+    EXPECT_TRUE(plan.smt_shared);
+    // Every core runs a dedicated thread: the shared threads get the siblings left over.
+    EXPECT_EQ(plan.shared_cpus, cpus("4,7"));
+}
+
+TEST(CpuTopology, HonoursOverrides) {
+    FakeSysfs sysfs(2, 8, 2);
+    auto topology = CpuTopology::from_sysfs(sysfs.root());
+    PlacementRequest request;
+    request.numa_node = 1;
+    request.io_reactor_cpus = {8, 9};
+    request.main_reactor_cpu = 31;
+    auto plan = plan_placement(topology, request);
+    EXPECT_EQ(plan.numa_node, 1);
+    EXPECT_EQ(plan.io_reactor_cpus, (std::vector<int>{8, 9}));
+    EXPECT_EQ(plan.pinned_worker_cpus, (std::vector<int>{10, 11}));
+    EXPECT_EQ(plan.main_reactor_cpu, 31);
+    EXPECT_EQ(plan.shared_cpus, cpus("12-15,28-31"));
+}
+
+TEST(CpuTopology, LeavesThreadsUnpinnedOnASmallHost) {
+    FakeSysfs sysfs(1, 1, 1);
+    auto topology = CpuTopology::from_sysfs(sysfs.root());
+    auto plan = plan_placement(topology, PlacementRequest{});
+    EXPECT_EQ(plan.io_reactor_cpus, (std::vector<int>{0, -1, -1, -1}));
+    EXPECT_EQ(plan.pinned_worker_cpus, (std::vector<int>{-1, -1}));
+    EXPECT_TRUE(plan.shared_cpus.empty());
+    EXPECT_EQ(plan.main_reactor_cpu, 0);
+}
+
+TEST(CpuTopology, NumaScopeRestoresThePreviousMemoryPolicy) {
+    FakeSysfs sysfs(2, 2, 1);
+    auto topology = CpuTopology::from_sysfs(sysfs.root());
+    unsigned long node0 = 1;
+    if (::syscall(SYS_set_mempolicy, MPOL_BIND, &node0, sizeof(node0) * 8) != 0) GTEST_SKIP() << "no set_mempolicy";
+    {
+        concurrency::NumaScope scope(topology, 0);
+        int mode = -1;
+        ::syscall(SYS_get_mempolicy, &mode, nullptr, 0, nullptr, 0);
+        EXPECT_EQ(mode, MPOL_PREFERRED);
+    }
+    int mode = -1;
+    unsigned long nodes = 0;
+    ::syscall(SYS_get_mempolicy, &mode, &nodes, sizeof(nodes) * 8, nullptr, 0);
+    EXPECT_EQ(mode, MPOL_BIND);
+    EXPECT_EQ(nodes, node0);
+    ::syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0);
+}
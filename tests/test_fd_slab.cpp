@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include "net/fd_slab.h"
+#include <thread>
+#include <vector>
+
+TEST(FdSlab, InsertGetErase) {
+    net::FdSlab<int> slab(1024);
+    EXPECT_EQ(slab.get(3), nullptr);
+    uint32_t gen = slab.insert(3, std::make_shared<int>(42));
+    EXPECT_NE(gen, 0u);
+    ASSERT_NE(slab.get(3), nullptr);
+    EXPECT_EQ(*slab.get(3), 42);
+    EXPECT_EQ(slab.size(), 1u);
+    EXPECT_TRUE(slab.erase(3));
+    EXPECT_FALSE(slab.erase(3));
+    EXPECT_EQ(slab.get(3), nullptr);
+    EXPECT_EQ(slab.size(), 0u);
+}
+
+TEST(FdSlab, GenerationChangesOnReuse) {
+    net::FdSlab<int> slab(1024);
+    uint32_t first = slab.insert(7, std::make_shared<int>(1));
+    slab.erase(7);
+    uint32_t second = slab.insert(7, std::make_shared<int>(2));
+    EXPECT_NE(first, second);
+    EXPECT_EQ(slab.generation(7), second);
+}
+
+TEST(FdSlab, OutOfRange) {
+    net::FdSlab<int> slab(16);
+    EXPECT_EQ(slab.insert(-1, std::make_shared<int>(1)), 0u);
+    EXPECT_EQ(slab.insert(1 << 20, std::make_shared<int>(1)), 0u);
+    EXPECT_EQ(slab.get(1 << 20), nullptr);
+}
+
+TEST(FdSlab, ConcurrentInsertAcrossChunks) {
+    net::FdSlab<int> slab(1 << 16);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t]{
+            for (int fd = t; fd < (1 << 16); fd += 4) {
+                slab.insert(fd, std::make_shared<int>(fd));
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    EXPECT_EQ(slab.size(), static_cast<size_t>(1 << 16));
+    for (int fd = 0; fd < (1 << 16); fd += 997) {
+        ASSERT_NE(slab.get(fd), nullptr);
+        EXPECT_EQ(*slab.get(fd), fd);
+    }
+}
+
+TEST(FdSlab, ForEachVisitsOccupiedSlotsInOrder) {
+    net::FdSlab<int> slab(1 << 14);
+    for (int fd : {9000, 3, 4097, 70}) {
+        slab.insert(fd, std::make_shared<int>(fd));
+    }
+    slab.erase(70);
+    std::vector<int> seen;
+    slab.for_each([&](int fd, const std::shared_ptr<int>& item) {
+        EXPECT_EQ(*item, fd);
+        seen.push_back(fd);
+        return true;
+    });
+    EXPECT_EQ(seen, (std::vector<int>{3, 4097, 9000}));
+
+    seen.clear();
+    slab.for_each([&](int fd, const std::shared_ptr<int>&) {
+        seen.push_back(fd);
+        return seen.size() < 2;
+    });
+    EXPECT_EQ(seen, (std::vector<int>{3, 4097}));
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "net/frame_buffer.h"
+
+TEST(FramePool, PicksSmallestClass) {
+    auto pool = net::FramePool::create();
+    auto small = pool->acquire(10);
+    auto mid = pool->acquire(3000);
+    auto big = pool->acquire(65535);
+    ASSERT_TRUE(small && mid && big);
+    EXPECT_EQ(small->body_capacity(), 256u);
+    EXPECT_EQ(mid->body_capacity(), 4096u);
+    EXPECT_EQ(big->body_capacity(), 65536u);
+    EXPECT_EQ(small->header().length, 10);
+    EXPECT_EQ(small->wire_size(), 10 + sizeof(MessageHeader));
+    EXPECT_FALSE(pool->acquire(65536));
+}
+
+TEST(FramePool, ReleasedFramesAreReused) {
+    auto pool = net::FramePool::create();
+    net::FrameBuffer* first = nullptr;
+    {
+        auto f = pool->acquire(100);
+        first = f.get();
+    }
+    EXPECT_EQ(pool->stats().outstanding.load(), 0u);
+    auto again = pool->acquire(200);
+    EXPECT_EQ(again.get(), first);
+    EXPECT_EQ(pool->stats().reused.load(), 1u);
+}
+
+TEST(FramePool, RefcountKeepsFrameAlive) {
+    auto pool = net::FramePool::create();
+    auto f = pool->acquire(5);
+    std::memcpy(f->body(), "hello", 5);
+    net::FrameRef copy = f;
+    f.reset();
+    EXPECT_EQ(pool->stats().outstanding.load(), 1u);
+    EXPECT_EQ(std::memcmp(copy->body(), "hello", 5), 0);
+    copy.reset();
+    EXPECT_EQ(pool->stats().outstanding.load(), 0u);
+}
+
+TEST(FramePool, FramesOutlivePoolHandle) {
+    auto pool = net::FramePool::create();
+    auto f = pool->acquire(64);
+    pool.reset();                 // owner gone, frame still valid
+    std::memset(f->body(), 0xab, 64);
+    f.reset();                    // last user releases the pool
+}
+
+TEST(FramePool, CrossThreadRelease) {
+    auto pool = net::FramePool::create();
+    std::vector<net::FrameRef> frames;
+    for (int i = 0; i < 1000; ++i) frames.push_back(pool->acquire(i % 2000));
+    std::thread t([moved = std::move(frames)]() mutable { moved.clear(); });
+    t.join();
+    EXPECT_EQ(pool->stats().outstanding.load(), 0u);
+    EXPECT_EQ(pool->stats().acquired.load(), 1000u);
+}
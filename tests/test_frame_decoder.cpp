@@ -0,0 +1,283 @@
+#include <gtest/gtest.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "net/frame_decoder.h"
+
+namespace {
+
+struct SocketPair {
+    int fds[2]{-1, -1};
+    SocketPair() { ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds); }
+    ~SocketPair() { ::close(fds[0]); if (fds[1] >= 0) ::close(fds[1]); }
+};
+
+std::string wire(uint8_t type, const std::string& body) {
+    MessageHeader h;
+    h.length = static_cast<uint16_t>(body.size());
+    h.type = type;
+    return std::string(reinterpret_cast<const char*>(&h), sizeof(h)) + body;
+}
+
+void send_all(int fd, const std::string& data) {
+    size_t off = 0;
+    while (off < data.size()) {
+        ssize_t n = ::send(fd, data.data() + off, data.size() - off, 0);
+        if (n > 0) off += n;
+    }
+}
+
+std::string body_of(const net::FrameRef& f) {
+    return std::string(reinterpret_cast<const char*>(f->body()), f->header().length);
+}
+
+// Stands in for a completion backend: hands out buffers and records which came back.
+struct FakeReceiver : net::Poller {
+    std::vector<std::string> buffers;
+    std::vector<uint16_t> released;
+
+    net::Poller::Received stage(const std::string& bytes) {
+        buffers.push_back(bytes);
+        auto id = static_cast<uint16_t>(buffers.size() - 1);
+        return {0, static_cast<int32_t>(bytes.size()), id,
+                reinterpret_cast<const uint8_t*>(buffers.back().data())};
+    }
+    void release_buffer(uint16_t buffer) override { released.push_back(buffer); }
+    bool add_fd(int, uint32_t) override { return true; }
+    bool modify_fd(int, uint32_t) override { return true; }
+    bool remove_fd(int) override { return true; }
+    std::optional<std::span<const epoll_event>> poll(int) override { return std::span<const epoll_event>{}; }
+    const char* name() const override { return "fake"; }
+};
+
+} // namespace
+
+TEST(FrameDecoder, PipelinedFramesFromOneRead) {
+    SocketPair sp;
+    auto pool = net::FramePool::create();
+    net::FrameDecoder dec;
+    send_all(sp.fds[1], wire(1, "ls") + wire(1, "pwd") + wire(1, "") + wire(2, "cd /"));
+    std::vector<std::string> got;
+    size_t bytes = 0;
+    auto s = dec.read_frames(sp.fds[0], *pool, []{ return true; },
+                             [&](net::FrameRef f) { got.push_back(body_of(f)); }, bytes);
+    EXPECT_EQ(s, net::FrameDecoder::Status::Drained);
+    EXPECT_EQ(got, (std::vector<std::string>{"ls", "pwd", "", "cd /"}));
+    EXPECT_EQ(bytes, 4 * sizeof(MessageHeader) + 9);
+    EXPECT_TRUE(dec.idle());
+}
+
+TEST(FrameDecoder, TrickledBytesResumeAcrossCalls) {
+    SocketPair sp;
+    auto pool = net::FramePool::create();
+    net::FrameDecoder dec;
+    std::string data = wire(1, std::string(300, 'a')) + wire(1, "tail");
+    std::vector<std::string> got;
+    size_t bytes = 0;
+    for (char c : data) {
+        send_all(sp.fds[1], std::string(1, c));
+        auto s = dec.read_frames(sp.fds[0], *pool, []{ return true; },
+                                 [&](net::FrameRef f) { got.push_back(body_of(f)); }, bytes);
+        ASSERT_EQ(s, net::FrameDecoder::Status::Drained);
+    }
+    ASSERT_EQ(got.size(), 2u);
+    EXPECT_EQ(got[0], std::string(300, 'a'));
+    EXPECT_EQ(got[1], "tail");
+}
+
+TEST(FrameDecoder, LargeBodyLargerThanBuffer) {
+    SocketPair sp;
+    auto pool = net::FramePool::create();
+    net::FrameDecoder dec;
+    std::string big(60000, 'z');
+    for (size_t i = 0; i < big.size(); ++i) big[i] = static_cast<char>('a' + i % 26);
+    std::string data = wire(5, big) + wire(1, "next");
+    std::vector<std::string> got;
+    size_t bytes = 0, off = 0;
+    while (off < data.size()) {
+        size_t n = std::min<size_t>(7000, data.size() - off);
+        send_all(sp.fds[1], data.substr(off, n));
+        off += n;
+        dec.read_frames(sp.fds[0], *pool, []{ return true; },
+                        [&](net::FrameRef f) { got.push_back(body_of(f)); }, bytes);
+    }
+    ASSERT_EQ(got.size(), 2u);
+    EXPECT_EQ(got[0], big);
+    EXPECT_EQ(got[1], "next");
+    EXPECT_EQ(bytes, data.size());
+}
+
+TEST(FrameDecoder, StopKeepsBufferedFrames) {
+    SocketPair sp;
+    auto pool = net::FramePool::create();
+    net::FrameDecoder dec;
+    send_all(sp.fds[1], wire(1, "one") + wire(1, "two") + wire(1, "three"));
+    std::vector<std::string> got;
+    size_t bytes = 0;
+    bool open = true;
+    auto s = dec.read_frames(sp.fds[0], *pool, [&]{ return open; },
+                             [&](net::FrameRef f) { got.push_back(body_of(f)); open = false; }, bytes);
+    EXPECT_EQ(s, net::FrameDecoder::Status::Stopped);
+    EXPECT_EQ(got, (std::vector<std::string>{"one"}));
+    EXPECT_FALSE(dec.idle());
+
+    open = true;
+    s = dec.read_frames(sp.fds[0], *pool, [&]{ return true; },
+                        [&](net::FrameRef f) { got.push_back(body_of(f)); }, bytes);
+    EXPECT_EQ(s, net::FrameDecoder::Status::Drained);
+    EXPECT_EQ(got, (std::vector<std::string>{"one", "two", "three"}));
+}
+
+TEST(FrameDecoder, FramesBeforeCloseAreDelivered) {
+    SocketPair sp;
+    auto pool = net::FramePool::create();
+    net::FrameDecoder dec;
+    send_all(sp.fds[1], wire(1, "bye"));
+    ::close(sp.fds[1]);
+    sp.fds[1] = -1;
+    std::vector<std::string> got;
+    size_t bytes = 0;
+    auto s = dec.read_frames(sp.fds[0], *pool, []{ return true; },
+                             [&](net::FrameRef f) { got.push_back(body_of(f)); }, bytes);
+    EXPECT_EQ(s, net::FrameDecoder::Status::Closed);
+    EXPECT_EQ(got, (std::vector<std::string>{"bye"}));
+}
+
+TEST(FrameDecoder, RawBytesAfterLastFrame) {
+    SocketPair sp;
+    auto pool = net::FramePool::create();
+    net::FrameDecoder dec;
+    send_all(sp.fds[1], wire(1, "hello") + "RAWDATA");
+    size_t bytes = 0;
+    bool first = true;
+    dec.read_frames(sp.fds[0], *pool, [&]{ return first; },
+                    [&](net::FrameRef) { first = false; }, bytes);
+    auto raw = dec.raw_bytes();
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(raw.data()), raw.size()), "RAWDATA");
+    dec.consume_raw(raw.size());
+    EXPECT_TRUE(dec.idle());
+}
+
+TEST(FrameDecoder, SwitchesToV2AfterHandshakeFrame) {
+    SocketPair sp;
+    auto pool = net::FramePool::create();
+    net::FrameDecoder dec;
+    auto v2 = protocol::negotiate(protocol::kProtocolV2, protocol::kCapLargeFrames | protocol::kCapCrc, 1u << 20);
+    std::string big(1u << 20, 'q');
+    for (size_t i = 0; i < big.size(); ++i) big[i] = static_cast<char>(i % 251);
+    std::string data = wire(1, "hello")
+        + protocol::encode_frame(4, big.data(), big.size(), v2)
+        + protocol::encode_frame(1, "ls", 2, v2);
+    std::vector<std::string> got;
+    size_t bytes = 0, off = 0;
+    auto on_frame = [&](net::FrameRef f) {
+        if (got.empty()) dec.set_format(v2);   // what the hello handler does
+        got.push_back(body_of(f));
+    };
+    while (off < data.size()) {
+        size_t n = std::min<size_t>(100000, data.size() - off);
+        send_all(sp.fds[1], data.substr(off, n));
+        off += n;
+        auto s = dec.read_frames(sp.fds[0], *pool, []{ return true; }, on_frame, bytes);
+        ASSERT_EQ(s, net::FrameDecoder::Status::Drained);
+    }
+    ASSERT_EQ(got.size(), 3u);
+    EXPECT_EQ(got[0], "hello");
+    EXPECT_EQ(got[1], big);
+    EXPECT_EQ(got[2], "ls");
+}
+
+TEST(FrameDecoder, CorruptV2FrameIsAnError) {
+    SocketPair sp;
+    auto pool = net::FramePool::create();
+    net::FrameDecoder dec;
+    auto v2 = protocol::negotiate(protocol::kProtocolV2, protocol::kCapCrc, 0);
+    dec.set_format(v2);
+    std::string frame = protocol::encode_frame(1, "payload", 7, v2);
+    frame.back() ^= 0x20;
+    send_all(sp.fds[1], frame);
+    size_t bytes = 0;
+    int frames = 0;
+    auto s = dec.read_frames(sp.fds[0], *pool, []{ return true; }, [&](net::FrameRef) { ++frames; }, bytes);
+    EXPECT_EQ(s, net::FrameDecoder::Status::Error);
+    EXPECT_EQ(frames, 0);
+}
+
+TEST(FrameDecoder, FrameAboveAgreedSizeIsAnError) {
+    SocketPair sp;
+    auto pool = net::FramePool::create();
+    net::FrameDecoder dec;
+    auto v2 = protocol::negotiate(protocol::kProtocolV2, 0, 0);   // no large frames
+    dec.set_format(v2);
+    MessageHeaderV2 h;
+    h.length = 100000;
+    h.type = 4;
+    send_all(sp.fds[1], std::string(reinterpret_cast<const char*>(&h), sizeof(h)));
+    size_t bytes = 0;
+    auto s = dec.read_frames(sp.fds[0], *pool, []{ return true; }, [](net::FrameRef) {}, bytes);
+    EXPECT_EQ(s, net::FrameDecoder::Status::Error);
+}
+
+TEST(FrameDecoder, DecodesStagedPollerInput) {
+    auto pool = net::FramePool::create();
+    FakeReceiver poller;
+    poller.buffers.reserve(8);      // staged bytes must not move
+    net::FrameDecoder dec;
+    dec.use_poller_input(&poller);
+    // One frame split over two buffers, the second also carrying the next frame and raw bytes.
+    const std::string data = wire(1, std::string(300, 'a')) + wire(1, "tail") + "RAW";
+    dec.push_input(poller.stage(data.substr(0, 100)));
+    dec.push_input(poller.stage(data.substr(100)));
+    EXPECT_EQ(dec.buffered(), data.size());
+    std::vector<std::string> got;
+    size_t bytes = 0;
+    auto s = dec.read_frames(-1, *pool, []{ return true; },
+                             [&](net::FrameRef f) { got.push_back(body_of(f)); }, bytes);
+    EXPECT_EQ(s, net::FrameDecoder::Status::Drained);
+    EXPECT_EQ(got, (std::vector<std::string>{std::string(300, 'a'), "tail"}));
+    EXPECT_EQ(bytes, 0u);      // counted by whoever staged it
+    EXPECT_EQ(poller.released, (std::vector<uint16_t>{0, 1}));
+    // Raw bytes come from the decoder's buffer first, then straight from staged buffers.
+    dec.push_input(poller.stage("MORE"));
+    auto raw = dec.raw_bytes();
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(raw.data()), raw.size()), "RAW");
+    dec.consume_raw(raw.size());
+    raw = dec.raw_bytes();
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(raw.data()), raw.size()), "MORE");
+    dec.consume_raw(2);
+    EXPECT_EQ(dec.buffered(), 2u);
+    dec.consume_raw(2);
+    EXPECT_EQ(poller.released, (std::vector<uint16_t>{0, 1, 2}));
+    EXPECT_TRUE(dec.idle());
+    EXPECT_EQ(dec.read_frames(-1, *pool, []{ return true; }, [](net::FrameRef) {}, bytes),
+              net::FrameDecoder::Status::Drained);
+    // The end of input is reported once the frames before it are out.
+    dec.push_input(poller.stage(wire(1, "bye")));
+    dec.push_input({0, 0, 0, nullptr});
+    got.clear();
+    s = dec.read_frames(-1, *pool, []{ return true; },
+                        [&](net::FrameRef f) { got.push_back(body_of(f)); }, bytes);
+    EXPECT_EQ(s, net::FrameDecoder::Status::Closed);
+    EXPECT_EQ(got, (std::vector<std::string>{"bye"}));
+    EXPECT_TRUE(dec.input_ended());
+}
+
+TEST(FrameDecoder, DropInputReturnsStagedBuffers) {
+    FakeReceiver poller;
+    poller.buffers.reserve(8);
+    {
+        net::FrameDecoder dec;
+        dec.use_poller_input(&poller);
+        dec.push_input(poller.stage("abc"));
+        dec.push_input(poller.stage("def"));
+        dec.drop_input();
+        EXPECT_EQ(poller.released.size(), 2u);
+        EXPECT_TRUE(dec.idle());
+        dec.push_input(poller.stage("ghi"));
+    }
+    EXPECT_EQ(poller.released.size(), 3u);     // the destructor returns the rest
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include "utils/inline_function.h"
+
+using utils::InlineFunction;
+
+namespace {
+
+struct Tracker {
+    static inline int alive = 0;
+    Tracker() { ++alive; }
+    Tracker(Tracker&&) noexcept { ++alive; }
+    Tracker(const Tracker&) = delete;
+    ~Tracker() { --alive; }
+};
+
+} // namespace
+
+TEST(InlineFunction, HoldsMoveOnlyCaptures) {
+    auto value = std::make_unique<int>(41);
+    InlineFunction<int(int)> fn = [v = std::move(value)](int add) { return *v + add; };
+    ASSERT_TRUE(fn);
+    EXPECT_EQ(fn(1), 42);
+
+    InlineFunction<int(int)> moved = std::move(fn);
+    EXPECT_FALSE(fn);
+    EXPECT_TRUE(fn == nullptr);
+    EXPECT_EQ(moved(2), 43);
+}
+
+TEST(InlineFunction, DestroysCaptureExactlyOnce) {
+    ASSERT_EQ(Tracker::alive, 0);
+    {
+        InlineFunction<void()> a = [t = Tracker()] {};
+        EXPECT_EQ(Tracker::alive, 1);
+        InlineFunction<void()> b = std::move(a);
+        EXPECT_EQ(Tracker::alive, 1);
+        a = std::move(b);
+        EXPECT_EQ(Tracker::alive, 1);
+        a = nullptr;
+        EXPECT_EQ(Tracker::alive, 0);
+        b = [t = Tracker()] {};
+        EXPECT_EQ(Tracker::alive, 1);
+    }
+    EXPECT_EQ(Tracker::alive, 0);
+}
+
+TEST(InlineFunction, PassesArgumentsThrough) {
+    int calls = 0;
+    InlineFunction<void(int&, std::unique_ptr<int>)> fn = [&calls](int& out, std::unique_ptr<int> in) {
+        out = *in;
+        ++calls;
+    };
+    int out = 0;
+    fn(out, std::make_unique<int>(7));
+    EXPECT_EQ(out, 7);
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(InlineFunction, FillsItsCapacity) {
+    // Capacity is the largest capture accepted; one byte more does not compile.
+    std::array<char, InlineFunction<char()>::kCapacity> bytes{};
+    bytes.back() = 'x';
+    InlineFunction<char()> fn = [bytes] { return bytes.back(); };
+    EXPECT_EQ(fn(), 'x');
+    EXPECT_EQ(sizeof(InlineFunction<void()>), 48u);
+    EXPECT_EQ(sizeof(InlineFunction<bool(int&), 24>), 32u);
+}
+
+TEST(InlineFunction, EmptyCallThrows) {
+    InlineFunction<void()> fn;
+    EXPECT_FALSE(fn);
+    EXPECT_THROW(fn(), std::bad_function_call);
+}
@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "concurrency/lf_thread_pool.h"
+#include "net/main_reactor.h"
+#include "types/enums.h"
+#include "types/message.h"
+
+namespace {
+
+// A port nobody listens on right now (bound once, released).
+uint16_t free_port() {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    socklen_t len = sizeof(addr);
+    ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    ::close(fd);
+    return ntohs(addr.sin_port);
+}
+
+int connect_to(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+std::vector<std::size_t> connection_counts(const net::MainReactor& main) {
+    std::vector<std::size_t> counts;
+    for (const auto& load : main.reactor_loads()) counts.push_back(load.connections);
+    return counts;
+}
+
+std::string request_frame(const std::string& json, uint8_t request_id) {
+    MessageHeader h;
+    h.length = static_cast<uint16_t>(json.size());
+    h.type = static_cast<uint8_t>(MessageType::REQUEST);
+    h.request_id = request_id;
+    return std::string(reinterpret_cast<const char*>(&h), sizeof(h)) + json;
+}
+
+// Blocking read of one v1 frame, false on timeout or close.
+bool read_frame(int fd, MessageHeader& header, std::string& body) {
+    timeval tv{5, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    auto read_exact = [fd](char* p, size_t n) {
+        while (n > 0) {
+            ssize_t r = ::recv(fd, p, n, 0);
+            if (r <= 0) return false;
+            p += r;
+            n -= static_cast<size_t>(r);
+        }
+        return true;
+    };
+    if (!read_exact(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    body.resize(header.length);
+    return read_exact(body.data(), body.size());
+}
+
+template <typename Pred>
+bool wait_until(Pred pred) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return true;
+}
+
+// Run against both backends: on io_uring MainReactor accepts through the poller (multishot accept).
+class IOReactorTest : public ::testing::TestWithParam<net::PollerBackend> {
+protected:
+    void SetUp() override {
+        server_ = std::make_shared<ServerContext>();
+        server_->thread_pool = std::make_shared<concurrency::LFThreadPool>(1);
+        server_->poller_backend = GetParam();
+        main_ = std::make_shared<net::MainReactor>(-1, std::vector<int>{-1, -1}, server_);
+        port_ = free_port();
+        ASSERT_TRUE(main_->listen_on(port_));
+        main_->start();
+    }
+
+    void TearDown() override {
+        for (int fd : clients_) ::close(fd);
+        main_.reset();
+    }
+
+    // Connects one client and returns the reactor it landed on.
+    std::size_t connect_one() {
+        auto before = connection_counts(*main_);
+        int fd = connect_to(port_);
+        EXPECT_GE(fd, 0);
+        clients_.push_back(fd);
+        std::size_t landed = before.size();
+        EXPECT_TRUE(wait_until([&] {
+            auto now = connection_counts(*main_);
+            for (std::size_t i = 0; i < now.size(); ++i) {
+                if (now[i] > before[i]) landed = i;
+            }
+            return landed < now.size();
+        }));
+        return landed;
+    }
+
+    ServerContext::Ptr server_;
+    net::MainReactor::Ptr main_;
+    uint16_t port_{0};
+    std::vector<int> clients_;
+};
+
+} // namespace
+
+TEST_P(IOReactorTest, ClosedConnectionsLeaveTheCount) {
+    for (int i = 0; i < 6; ++i) connect_one();
+    EXPECT_EQ(connection_counts(*main_), (std::vector<std::size_t>{3, 3}));
+    for (int fd : clients_) ::close(fd);
+    clients_.clear();
+    EXPECT_TRUE(wait_until([&] { return connection_counts(*main_) == std::vector<std::size_t>{0, 0}; }));
+}
+
+TEST_P(IOReactorTest, PlacementFollowsClosedConnections) {
+    std::vector<std::size_t> landed;
+    for (int i = 0; i < 4; ++i) landed.push_back(connect_one());
+    ASSERT_EQ(connection_counts(*main_), (std::vector<std::size_t>{2, 2}));
+    // Empty reactor 0: the next two connections belong there, not split between both.
+    std::vector<int> kept;
+    for (std::size_t i = 0; i < clients_.size(); ++i) {
+        if (landed[i] == 0) ::close(clients_[i]);
+        else kept.push_back(clients_[i]);
+    }
+    clients_ = kept;
+    ASSERT_TRUE(wait_until([&] { return connection_counts(*main_) == std::vector<std::size_t>{0, 2}; }));
+    EXPECT_EQ(connect_one(), 0u);
+    EXPECT_EQ(connect_one(), 0u);
+    EXPECT_EQ(connection_counts(*main_), (std::vector<std::size_t>{2, 2}));
+}
+
+// On io_uring the connection is received into provided buffers and answered with poller sends.
+TEST_P(IOReactorTest, PipelinedRequestsAreAnsweredInOrder) {
+    connect_one();
+    const int fd = clients_.back();
+    std::string burst;
+    for (uint8_t id = 1; id <= 3; ++id) burst += request_frame(R"({"command":"hello","version":1})", id);
+    ASSERT_EQ(::send(fd, burst.data(), burst.size(), 0), static_cast<ssize_t>(burst.size()));
+    for (uint8_t id = 1; id <= 3; ++id) {
+        MessageHeader header;
+        std::string body;
+        ASSERT_TRUE(read_frame(fd, header, body));
+        EXPECT_EQ(header.type, static_cast<uint8_t>(MessageType::RESPONSE));
+        EXPECT_EQ(header.request_id, id);
+        EXPECT_NE(body.find("hello"), std::string::npos) << body;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends, IOReactorTest,
+                         ::testing::Values(net::PollerBackend::Epoll, net::PollerBackend::IoUring),
+                         [](const auto& info) {
+                             return std::string(info.param == net::PollerBackend::Epoll ? "epoll" : "io_uring");
+                         });
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils/log.h"
+
+namespace {
+
+// Collects lines from the logging thread; restores the level and the stderr sink afterwards.
+class LogTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        utils::log::set_sink([this](utils::log::Level, std::string_view line) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto bar = line.find(" | ");
+            lines_.emplace_back(line.substr(bar + 3));
+        });
+        utils::log::set_level(utils::log::Level::Trace);
+    }
+    void TearDown() override {
+        utils::log::flush();
+        utils::log::set_sink(nullptr);
+        utils::log::set_level(utils::log::Level::Warn);
+    }
+
+    std::vector<std::string> lines() {
+        utils::log::flush();
+        std::lock_guard<std::mutex> lock(mutex_);
+        return lines_;
+    }
+
+    std::mutex mutex_;
+    std::vector<std::string> lines_;
+};
+
+enum class Color : uint8_t { Red = 3 };
+
+} // namespace
+
+TEST_F(LogTest, FormatsArguments) {
+    std::string owned = "str";
+    const char* missing = nullptr;
+    LOG_INFO("int={} neg={} u64={} dbl={} bool={} char={}", 42, -7, uint64_t{1} << 40, 1.5, true, 'x');
+    LOG_INFO("s={} sv={} lit={} null={} enum={}", owned, std::string_view("view"), "lit", missing, Color::Red);
+    LOG_INFO("braces {{}} {} missing {}", 1);
+    LOG_INFO("extra", 1, "two");
+    auto got = lines();
+    ASSERT_EQ(got.size(), 4u);
+    EXPECT_EQ(got[0], "int=42 neg=-7 u64=1099511627776 dbl=1.5 bool=true char=x");
+    EXPECT_EQ(got[1], "s=str sv=view lit=lit null=(null) enum=3");
+    EXPECT_EQ(got[2], "braces {} 1 missing {}");
+    EXPECT_EQ(got[3], "extra 1 two");
+}
+
+TEST_F(LogTest, CutsLongStrings) {
+    std::string big(utils::log::detail::kMaxStringArg + 10, 'a');
+    LOG_INFO("{}", big);
+    auto got = lines();
+    ASSERT_EQ(got.size(), 1u);
+    EXPECT_EQ(got[0], std::string(utils::log::detail::kMaxStringArg, 'a') + "...[cut]");
+}
+
+TEST_F(LogTest, RuntimeLevelSkipsArguments) {
+    int evaluated = 0;
+    auto arg = [&] { return ++evaluated; };
+    utils::log::set_level(utils::log::Level::Error);
+    LOG_WARN("skipped {}", arg());
+    LOG_ERROR("kept {}", arg());
+    EXPECT_EQ(evaluated, 1);
+    utils::log::set_level(utils::log::Level::Off);
+    LOG_ERROR("skipped {}", arg());
+    EXPECT_EQ(evaluated, 1);
+    auto got = lines();
+    ASSERT_EQ(got.size(), 1u);
+    EXPECT_EQ(got[0], "kept 1");
+}
+
+TEST_F(LogTest, KeepsPerThreadOrder) {
+    constexpr int kThreads = 4;
+    constexpr int kRecords = 2000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < kRecords; ++i) LOG_INFO("{} {}", t, i);
+            utils::log::flush();
+        });
+    }
+    for (auto& th : threads) th.join();
+    auto got = lines();
+    ASSERT_EQ(got.size() + utils::log::dropped(), static_cast<std::size_t>(kThreads * kRecords));
+    std::vector<int> next(kThreads, -1);
+    for (const auto& line : got) {
+        int t = 0, i = 0;
+        ASSERT_EQ(std::sscanf(line.c_str(), "%d %d", &t, &i), 2);
+        EXPECT_GT(i, next[t]);
+        next[t] = i;
+    }
+}
+
+TEST_F(LogTest, DropsInsteadOfBlocking) {
+    std::atomic<bool> release{false};
+    std::atomic<int> seen{0};
+    utils::log::set_sink([&](utils::log::Level, std::string_view) {
+        ++seen;
+        while (!release.load()) std::this_thread::yield();
+    });
+    uint64_t before = utils::log::dropped();
+    std::string payload(1000, 'p');
+    // The first record holds the logging thread in the sink; the ring (256 KiB) fills behind it.
+    for (int i = 0; i < 1000; ++i) LOG_INFO("{}", payload);
+    EXPECT_GT(utils::log::dropped(), before);
+    release = true;
+    utils::log::flush();
+    EXPECT_GT(seen.load(), 0);
+}
+
+TEST(LogLevel, ParsesNames) {
+    EXPECT_EQ(utils::log::parse_level("debug"), utils::log::Level::Debug);
+    EXPECT_EQ(utils::log::parse_level("off"), utils::log::Level::Off);
+    EXPECT_FALSE(utils::log::parse_level("verbose"));
+    EXPECT_EQ(utils::log::level_name(utils::log::Level::Warn), "WARN");
+}
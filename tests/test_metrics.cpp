@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "metrics/metrics.h"
+
+using metrics::Histogram;
+
+TEST(Histogram, BucketsCoverValues) {
+    for (uint64_t v = 0; v < 16; ++v) EXPECT_EQ(Histogram::bucket_of(v), v);
+    for (uint64_t v : {16ull, 17ull, 31ull, 32ull, 1000ull, 123456789ull, (1ull << 39) + 5}) {
+        std::size_t b = Histogram::bucket_of(v);
+        EXPECT_LE(Histogram::bucket_floor(b), v) << v;
+        EXPECT_GT(Histogram::bucket_floor(b + 1), v) << v;
+    }
+    EXPECT_EQ(Histogram::bucket_of(~uint64_t{0}), Histogram::kBuckets - 1);
+    for (std::size_t b = 1; b < Histogram::kBuckets; ++b) {
+        EXPECT_EQ(Histogram::bucket_of(Histogram::bucket_floor(b)), b);
+    }
+}
+
+TEST(Histogram, QuantilesWithinBucketWidth) {
+    Histogram h;
+    for (uint64_t v = 1; v <= 10000; ++v) h.record(v * 1000);
+    auto snap = h.snapshot();
+    EXPECT_EQ(snap.count, 10000u);
+    EXPECT_EQ(snap.sum, 1000ull * 10000 * 10001 / 2);
+    for (double q : {0.5, 0.9, 0.99, 0.999, 1.0}) {
+        double exact = q * 10000 * 1000;
+        double got = static_cast<double>(snap.quantile(q));
+        EXPECT_GE(got, exact) << q;
+        EXPECT_LE(got, exact * (1 + 1.0 / 16)) << q;
+    }
+    EXPECT_EQ(Histogram().snapshot().quantile(0.5), 0u);
+}
+
+TEST(Metrics, SumsShardsAcrossThreads) {
+    metrics::Counter counter;
+    Histogram h;
+    constexpr int kThreads = 8;
+    constexpr int kPerThread = 10000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < kPerThread; ++i) {
+                counter.add();
+                h.record(100);
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    EXPECT_EQ(counter.value(), uint64_t{kThreads} * kPerThread);
+    EXPECT_EQ(h.snapshot().count, uint64_t{kThreads} * kPerThread);
+}
+
+TEST(Registry, ReturnsSameSeries) {
+    metrics::Registry registry;
+    auto& a = registry.counter("requests_total", "Requests.", {{"command", "ls"}});
+    auto& b = registry.counter("requests_total", "Requests.", {{"command", "ls"}});
+    auto& c = registry.counter("requests_total", "Requests.", {{"command", "get"}});
+    EXPECT_EQ(&a, &b);
+    EXPECT_NE(&a, &c);
+    EXPECT_EQ(&registry.histogram("latency_seconds", "Latency."), &registry.histogram("latency_seconds", "Latency."));
+}
+
+TEST(Registry, RendersPrometheusText) {
+    metrics::Registry registry;
+    registry.counter("requests_total", "Requests.", {{"command", "l\"s"}}).add(3);
+    registry.histogram("latency_seconds", "Latency.").record(2000000000);
+    int owner = 0;
+    registry.callback("queue_depth", "Queued.", metrics::Registry::Type::Gauge, {}, &owner,
+                      [] { return std::optional<double>(7); });
+    std::string text = registry.render();
+    EXPECT_NE(text.find("# HELP requests_total Requests.\n# TYPE requests_total counter\n"), std::string::npos);
+    EXPECT_NE(text.find("requests_total{command=\"l\\\"s\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE latency_seconds summary\n"), std::string::npos);
+    EXPECT_NE(text.find("latency_seconds{quantile=\"0.5\"} 2."), std::string::npos);
+    EXPECT_NE(text.find("latency_seconds_sum 2\n"), std::string::npos);
+    EXPECT_NE(text.find("latency_seconds_count 1\n"), std::string::npos);
+    EXPECT_NE(text.find("queue_depth 7\n"), std::string::npos);
+
+    registry.forget(&owner);
+    EXPECT_EQ(registry.render().find("queue_depth"), std::string::npos);
+}
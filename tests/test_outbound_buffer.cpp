@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "net/outbound_buffer.h"
+
+namespace {
+
+struct SocketPair {
+    int fds[2]{-1, -1};
+    SocketPair() {
+        ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds);
+        int small = 4096;
+        ::setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+        ::setsockopt(fds[1], SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+    }
+    ~SocketPair() { ::close(fds[0]); ::close(fds[1]); }
+};
+
+net::FrameRef frame_of(net::FramePool& pool, const std::string& body) {
+    net::FrameRef f = pool.acquire(body.size());
+    std::memcpy(f->body(), body.data(), body.size());
+    return f;
+}
+
+// Wire image of a frame as the peer sees it.
+std::string wire_of(const std::string& body) {
+    MessageHeader h;
+    h.length = static_cast<uint16_t>(body.size());
+    return std::string(reinterpret_cast<const char*>(&h), sizeof(h)) + body;
+}
+
+std::string drain(int fd) {
+    std::string got;
+    char buf[8192];
+    ssize_t n;
+    while ((n = ::read(fd, buf, sizeof(buf))) > 0) got.append(buf, n);
+    return got;
+}
+
+} // namespace
+
+TEST(OutboundBuffer, SmallAppendsDrainImmediately) {
+    SocketPair sp;
+    auto pool = net::FramePool::create();
+    net::OutboundBuffer out;
+    out.append(frame_of(*pool, "hello "));
+    out.append(frame_of(*pool, "world"));
+    EXPECT_EQ(out.pending_bytes(), 11u + 2 * sizeof(MessageHeader));
+    size_t written = 0;
+    EXPECT_EQ(out.flush(sp.fds[0], written), net::OutboundBuffer::FlushResult::Drained);
+    EXPECT_EQ(written, 11u + 2 * sizeof(MessageHeader));
+    EXPECT_TRUE(out.empty());
+    EXPECT_EQ(drain(sp.fds[1]), wire_of("hello ") + wire_of("world"));
+}
+
+TEST(OutboundBuffer, PartialWritesKeepOrder) {
+    SocketPair sp;
+    auto pool = net::FramePool::create();
+    net::OutboundBuffer out;
+    std::string expected;
+    for (int i = 0; i < 64; ++i) {
+        std::string chunk(10000 + i, static_cast<char>('a' + i % 26));
+        expected += wire_of(chunk);
+        out.append(frame_of(*pool, chunk));
+    }
+    std::string got;
+    size_t written = 0;
+    int rounds = 0;
+    while (true) {
+        auto r = out.flush(sp.fds[0], written);
+        ASSERT_NE(r, net::OutboundBuffer::FlushResult::Error);
+        got += drain(sp.fds[1]);
+        if (r == net::OutboundBuffer::FlushResult::Drained) break;
+        ++rounds;
+    }
+    got += drain(sp.fds[1]);
+    EXPECT_GT(rounds, 0);   // the socket really pushed back
+    EXPECT_EQ(written, expected.size());
+    EXPECT_EQ(got, expected);
+}
+
+TEST(OutboundBuffer, SpliceAppendsBehind) {
+    SocketPair sp;
+    auto pool = net::FramePool::create();
+    net::OutboundBuffer out, later;
+    out.append(frame_of(*pool, "first "));
+    later.append(frame_of(*pool, "second"));
+    out.splice(later);
+    EXPECT_TRUE(later.empty());
+    EXPECT_EQ(out.pending_bytes(), 12u + 2 * sizeof(MessageHeader));
+    size_t written = 0;
+    out.flush(sp.fds[0], written);
+    EXPECT_EQ(drain(sp.fds[1]), wire_of("first ") + wire_of("second"));
+}
+
+TEST(OutboundBuffer, ErrorWhenPeerClosed) {
+    SocketPair sp;
+    ::close(sp.fds[1]);
+    sp.fds[1] = -1;
+    auto pool = net::FramePool::create();
+    net::OutboundBuffer out;
+    out.append(frame_of(*pool, "x"));
+    size_t written = 0;
+    EXPECT_EQ(out.flush(sp.fds[0], written), net::OutboundBuffer::FlushResult::Error);
+    EXPECT_EQ(out.pending_bytes(), 1u + sizeof(MessageHeader));
+}
+
+TEST(OutboundBuffer, PrepareAndConsumeForSubmittedSends) {
+    auto pool = net::FramePool::create();
+    net::OutboundBuffer out;
+    out.append(frame_of(*pool, "first "));
+    out.append(frame_of(*pool, "second"));
+    const size_t first = wire_of("first ").size();
+    iovec iov[net::OutboundBuffer::kMaxIov];
+    net::FrameRef frames[net::OutboundBuffer::kMaxIov];
+    ASSERT_EQ(out.prepare(iov, frames, net::OutboundBuffer::kMaxIov), 2);
+    EXPECT_EQ(iov[0].iov_len, first);
+    // The references keep the frames alive even once the buffer lets go of them.
+    out.consume(first + 3);
+    out.clear();
+    EXPECT_EQ(std::string(static_cast<const char*>(iov[1].iov_base), iov[1].iov_len), wire_of("second"));
+    for (auto& f : frames) f.reset();
+    EXPECT_EQ(pool->stats().outstanding.load(), 0u);
+
+    out.append(frame_of(*pool, "third"));
+    out.append(frame_of(*pool, "fourth"));
+    out.consume(4);
+    ASSERT_EQ(out.prepare(iov, nullptr, 1), 1);
+    EXPECT_EQ(std::string(static_cast<const char*>(iov[0].iov_base), iov[0].iov_len), wire_of("third").substr(4));
+    EXPECT_EQ(out.pending_bytes(), wire_of("third").size() + wire_of("fourth").size() - 4);
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include "net/request_pipeline.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using net::RequestPipeline;
+
+TEST(RequestPipeline, DeliversInOrderWhenCompletedOutOfOrder) {
+    RequestPipeline pipeline(8);
+    std::vector<int> delivered;
+    uint64_t a = pipeline.begin(), b = pipeline.begin(), c = pipeline.begin();
+    EXPECT_EQ(pipeline.outstanding(), 3u);
+
+    EXPECT_EQ(pipeline.complete(c, [&] { delivered.push_back(3); }), 0u);
+    EXPECT_EQ(pipeline.complete(b, [&] { delivered.push_back(2); }), 0u);
+    EXPECT_TRUE(delivered.empty());
+    // completing the head releases everything behind it
+    EXPECT_EQ(pipeline.complete(a, [&] { delivered.push_back(1); }), 3u);
+    EXPECT_EQ(delivered, (std::vector<int>{1, 2, 3}));
+    EXPECT_EQ(pipeline.outstanding(), 0u);
+}
+
+TEST(RequestPipeline, EmptyDeliveryKeepsItsPlace) {
+    RequestPipeline pipeline(4);
+    std::vector<int> delivered;
+    uint64_t a = pipeline.begin(), b = pipeline.begin();
+    EXPECT_EQ(pipeline.complete(b, [&] { delivered.push_back(2); }), 0u);
+    EXPECT_EQ(pipeline.complete(a, {}), 2u);   // a request that produced no response
+    EXPECT_EQ(delivered, (std::vector<int>{2}));
+}
+
+TEST(RequestPipeline, FullAtDepthAndWrapsAround) {
+    RequestPipeline pipeline(4);
+    std::vector<uint64_t> delivered;
+    for (int round = 0; round < 10; ++round) {
+        std::vector<uint64_t> seqs;
+        while (!pipeline.full()) seqs.push_back(pipeline.begin());
+        ASSERT_EQ(seqs.size(), 4u);
+        std::reverse(seqs.begin(), seqs.end());
+        for (auto seq : seqs) pipeline.complete(seq, [&delivered, seq] { delivered.push_back(seq); });
+        EXPECT_EQ(pipeline.outstanding(), 0u);
+    }
+    ASSERT_EQ(delivered.size(), 40u);
+    for (uint64_t i = 0; i < delivered.size(); ++i) EXPECT_EQ(delivered[i], i);
+}
+
+TEST(RequestPipeline, ConcurrentCompletionsStayOrdered) {
+    RequestPipeline pipeline(64);
+    constexpr uint64_t kRequests = 20000;
+    std::mutex mu;
+    std::vector<uint64_t> delivered;
+    std::atomic<uint64_t> next_to_run{0};
+    std::vector<uint64_t> seqs(kRequests);
+    std::atomic<uint64_t> begun{0};
+
+    // One producer numbering requests (the reactor), workers completing them in any order.
+    std::vector<std::thread> workers;
+    for (int w = 0; w < 4; ++w) {
+        workers.emplace_back([&, w] {
+            std::mt19937 rng(w);
+            while (true) {
+                uint64_t i = next_to_run.load();
+                if (i >= kRequests) break;
+                if (i >= begun.load(std::memory_order_acquire)) { std::this_thread::yield(); continue; }
+                if (!next_to_run.compare_exchange_weak(i, i + 1)) continue;
+                if (rng() % 4 == 0) std::this_thread::yield();
+                pipeline.complete(seqs[i], [&, seq = seqs[i]] {
+                    std::lock_guard<std::mutex> lock(mu);
+                    delivered.push_back(seq);
+                });
+            }
+        });
+    }
+    for (uint64_t i = 0; i < kRequests; ++i) {
+        while (pipeline.full()) std::this_thread::yield();
+        seqs[i] = pipeline.begin();
+        begun.store(i + 1, std::memory_order_release);
+    }
+    for (auto& t : workers) t.join();
+
+    EXPECT_EQ(pipeline.outstanding(), 0u);
+    ASSERT_EQ(delivered.size(), kRequests);
+    for (uint64_t i = 0; i < kRequests; ++i) ASSERT_EQ(delivered[i], i);
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "net/response_queue.h"
+
+namespace {
+
+struct Delivered {
+    std::vector<std::pair<int, uint32_t>> resumes;
+    std::vector<std::size_t> frame_sizes;     // in delivery order
+    int frames = 0;
+    int sources = 0;
+};
+
+std::size_t drain_into(net::ResponseQueue& queue, Delivered& out) {
+    return queue.drain([&](int fd, uint32_t generation, net::FrameRef& frame, net::OutboundSource& source) {
+        if (!frame && !source) {
+            out.resumes.emplace_back(fd, generation);
+        } else if (frame) {
+            ++out.frames;
+            out.frame_sizes.push_back(frame->header().length);
+        } else {
+            ++out.sources;
+        }
+    });
+}
+
+net::FrameRef sized_frame(net::FramePool& pool, std::size_t length) {
+    auto frame = pool.acquire(length);
+    frame->header().length = static_cast<uint32_t>(length);
+    return frame;
+}
+
+} // namespace
+
+TEST(ResponseQueue, DeliversResumes) {
+    net::ResponseQueue queue(4);
+    ASSERT_TRUE(queue.submit_resume(7, 1));
+    Delivered out;
+    EXPECT_EQ(drain_into(queue, out), 1u);
+    EXPECT_EQ(out.resumes, (std::vector<std::pair<int, uint32_t>>{{7, 1}}));
+}
+
+TEST(ResponseQueue, ResumeIsNotDroppedWhenTheQueueIsFull) {
+    auto pool = net::FramePool::create();
+    net::ResponseQueue queue(2);
+    for (std::size_t i = 0; i < queue.capacity(); ++i) queue.submit(3, 1, pool->acquire(8));
+    // An edge-triggered connection with its input held back is only read again on this resume.
+    EXPECT_TRUE(queue.submit_resume(5, 2));
+    EXPECT_TRUE(queue.submit_resume(6, 4));
+    Delivered out;
+    EXPECT_EQ(drain_into(queue, out), queue.capacity() + 2);
+    EXPECT_EQ(out.frames, static_cast<int>(queue.capacity()));
+    EXPECT_EQ(out.resumes, (std::vector<std::pair<int, uint32_t>>{{5, 2}, {6, 4}}));
+
+    Delivered again;
+    EXPECT_EQ(drain_into(queue, again), 0u);
+}
+
+TEST(ResponseQueue, FramesAndSourcesOverflowInOrder) {
+    auto pool = net::FramePool::create();
+    net::ResponseQueue queue(4);
+    // Three times the ring: nothing may be lost, and a connection's replies keep their order.
+    for (std::size_t i = 1; i <= 3 * queue.capacity(); ++i) queue.submit(3, 1, sized_frame(*pool, i));
+    queue.submit_source(3, 1, [](net::OutboundBuffer&) { return false; });
+    queue.submit(3, 1, sized_frame(*pool, 100));
+    EXPECT_EQ(queue.overflowed(), 2 * queue.capacity() + 2);
+
+    Delivered out;
+    EXPECT_EQ(drain_into(queue, out), 3 * queue.capacity() + 2);
+    std::vector<std::size_t> expected;
+    for (std::size_t i = 1; i <= 3 * queue.capacity(); ++i) expected.push_back(i);
+    expected.push_back(100);
+    EXPECT_EQ(out.frame_sizes, expected);
+    EXPECT_EQ(out.sources, 1);
+    EXPECT_EQ(queue.overflowed(), 0u);
+
+    // Drained: back on the ring.
+    queue.submit(3, 1, sized_frame(*pool, 7));
+    EXPECT_EQ(queue.overflowed(), 0u);
+    Delivered again;
+    EXPECT_EQ(drain_into(queue, again), 1u);
+    EXPECT_EQ(again.frame_sizes, (std::vector<std::size_t>{7}));
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "concurrency/lf_thread_pool.h"
+#include "concurrency/task.h"
+
+using concurrency::LFThreadPool;
+using Task = LFThreadPool::Task;
+using Series = concurrency::SeriesTask<Task>;
+
+namespace {
+
+bool wait_for(const std::atomic<int>& value, int expected) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (value.load() != expected) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+} // namespace
+
+TEST(SeriesTask, RunsInPostOrderWithoutOverlap) {
+    constexpr int kSeries = 8;
+    constexpr int kTasks = 2000;
+    struct State {
+        std::vector<int> last = std::vector<int>(kSeries, -1);  // only touched by the series' own tasks
+        std::vector<std::atomic<int>> inside = std::vector<std::atomic<int>>(kSeries);
+        std::atomic<int> out_of_order{0};
+        std::atomic<int> overlapped{0};
+        std::atomic<int> ran{0};
+    } st;
+    LFThreadPool pool(1, 3, 1024, 1024);
+    std::vector<Series::Ptr> series;
+    for (int s = 0; s < kSeries; ++s) series.push_back(pool.make_series());
+    for (int i = 0; i < kTasks; ++i) {
+        for (int s = 0; s < kSeries; ++s) {
+            series[s]->post([&st, s, i] {
+                if (st.inside[s].fetch_add(1) != 0) ++st.overlapped;
+                if (st.last[s] != i - 1) ++st.out_of_order;
+                st.last[s] = i;
+                st.inside[s].fetch_sub(1);
+                ++st.ran;
+            });
+        }
+    }
+    ASSERT_TRUE(wait_for(st.ran, kSeries * kTasks));
+    EXPECT_EQ(st.out_of_order.load(), 0);
+    EXPECT_EQ(st.overlapped.load(), 0);
+}
+
+TEST(SeriesTask, KeepsOrderPerProducerWithManyProducers) {
+    LFThreadPool pool(0, 4, 1024, 1024);
+    auto series = pool.make_series();
+    constexpr int kProducers = 4;
+    constexpr int kTasks = 5000;
+    std::vector<int> last(kProducers, -1);
+    std::atomic<int> out_of_order{0};
+    std::atomic<int> ran{0};
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&, p] {
+            for (int i = 0; i < kTasks; ++i) {
+                series->post([&, p, i] {
+                    if (last[p] != i - 1) ++out_of_order;
+                    last[p] = i;
+                    ++ran;
+                });
+            }
+        });
+    }
+    for (auto& th : producers) th.join();
+    ASSERT_TRUE(wait_for(ran, kProducers * kTasks));
+    EXPECT_EQ(out_of_order.load(), 0);
+    EXPECT_EQ(series->pending(), 0u);
+}
+
+TEST(SeriesTask, WaitsForRetryWhenExecutorRefuses) {
+    bool accept = false;
+    std::vector<Task> submitted;
+    auto series = Series::create([&](Task t) {
+        if (!accept) return false;
+        submitted.push_back(std::move(t));
+        return true;
+    }, 2);
+    std::vector<int> order;
+    EXPECT_FALSE(series->post([&] {
+        // Posted from inside a task: queued behind it, not run recursively.
+        series->post([&] { order.push_back(3); });
+        series->post([&] { order.push_back(4); });
+        order.push_back(1);
+    }));
+    EXPECT_FALSE(series->post([&] { order.push_back(2); }));
+    EXPECT_TRUE(order.empty());     // nothing runs on the posting thread
+    EXPECT_TRUE(series->stalled());
+    EXPECT_FALSE(series->retry());
+    accept = true;
+    EXPECT_TRUE(series->retry());
+    EXPECT_FALSE(series->stalled());
+    ASSERT_EQ(submitted.size(), 1u);
+    // Refused at the batch boundary, the drain keeps going on its own thread.
+    accept = false;
+    auto drain = std::move(submitted[0]);
+    drain();
+    EXPECT_EQ(order, (std::vector<int>{1, 2, 3, 4}));
+    EXPECT_EQ(series->pending(), 0u);
+}
+
+TEST(SeriesTask, HandsLongRunsBackToTheExecutor) {
+    std::vector<Task> submitted;
+    auto series = Series::create([&](Task t) { submitted.push_back(std::move(t)); return true; }, 4);
+    int ran = 0;
+    for (int i = 0; i < 10; ++i) series->post([&] { ++ran; });
+    ASSERT_EQ(submitted.size(), 1u);
+    for (std::size_t i = 0; i < submitted.size(); ++i) {
+        auto drain = std::move(submitted[i]);
+        drain();
+    }
+    EXPECT_EQ(ran, 10);
+    EXPECT_EQ(submitted.size(), 3u);   // 4 + 4 + 2
+}
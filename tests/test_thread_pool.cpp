@@ -0,0 +1,276 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "concurrency/lf_thread_pool.h"
+
+using concurrency::LFThreadPool;
+using concurrency::TaskClass;
+
+namespace {
+
+// Polls until all workers are parked (or the timeout passes).
+bool wait_parked(const LFThreadPool& pool, uint64_t parks, std::chrono::milliseconds timeout = std::chrono::seconds(5)) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (pool.stats().parks.load() < parks) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+bool wait_for(const std::atomic<int>& value, int expected) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (value.load() != expected) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+template <typename Pred>
+bool wait_until(Pred pred, std::chrono::milliseconds timeout = std::chrono::seconds(10)) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// Decides every few milliseconds so the tests do not wait on the 100ms default.
+concurrency::PoolScalingConfig fast_scaling(std::size_t max_flexible) {
+    concurrency::PoolScalingConfig config;
+    config.max_flexible = max_flexible;
+    config.interval = std::chrono::milliseconds(2);
+    config.grow_backlog = 2;
+    config.grow_wait = std::chrono::milliseconds(1);
+    config.grow_after = 2;
+    config.shrink_after = 5;
+    return config;
+}
+
+} // namespace
+
+TEST(LFThreadPool, IdleWorkersPark) {
+    LFThreadPool pool(1, 3, 64, 64);
+    EXPECT_TRUE(wait_parked(pool, 4));
+}
+
+TEST(LFThreadPool, SubmitWakesParkedWorkers) {
+    LFThreadPool pool(1, 2, 64, 64);
+    ASSERT_TRUE(wait_parked(pool, 3));
+    std::atomic<int> ran{0};
+    for (int round = 1; round <= 50; ++round) {
+        ASSERT_TRUE(pool.submit([&] { ++ran; }));
+        ASSERT_TRUE(wait_for(ran, round)) << "round " << round;
+    }
+    EXPECT_GT(pool.stats().wakes.load(), 0u);
+}
+
+TEST(LFThreadPool, PinnedTaskWakesPinnedWorker) {
+    // Only a pinned worker may run it: waking a flexible one would leave it in the queue.
+    LFThreadPool pool(1, 2, 64, 64);
+    ASSERT_TRUE(wait_parked(pool, 3));
+    std::atomic<int> ran{0};
+    ASSERT_TRUE(pool.submit_pinned([&] { ++ran; }));
+    EXPECT_TRUE(wait_for(ran, 1));
+    EXPECT_EQ(pool.stats().executed_pinned.load(), 1u);
+}
+
+TEST(LFThreadPool, RunsEveryTaskFromManySubmitters) {
+    LFThreadPool pool(2, 2, 1024, 1024);
+    constexpr int kThreads = 4;
+    constexpr int kTasks = 5000;
+    std::atomic<int> ran{0};
+    std::vector<std::thread> submitters;
+    for (int t = 0; t < kThreads; ++t) {
+        submitters.emplace_back([&, t] {
+            for (int i = 0; i < kTasks; ++i) {
+                auto cls = (i + t) % 3 == 0 ? TaskClass::PinnedOnly : TaskClass::Flexible;
+                while (!pool.submit([&] { ++ran; }, cls)) std::this_thread::yield();
+                if (i % 500 == 0) std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        });
+    }
+    for (auto& th : submitters) th.join();
+    EXPECT_TRUE(wait_for(ran, kThreads * kTasks));
+}
+
+TEST(LFThreadPool, ShutdownWakesParkedWorkers) {
+    auto pool = std::make_unique<LFThreadPool>(2, 2, 64, 64);
+    ASSERT_TRUE(wait_parked(*pool, 4));
+    auto start = std::chrono::steady_clock::now();
+    pool.reset();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+}
+
+TEST(LFThreadPool, WorkerSubmitsGoToItsOwnDeque) {
+    LFThreadPool pool(1, 2, 64, 64);
+    std::atomic<int> ran{0};
+    constexpr int kChildren = 500;
+    ASSERT_TRUE(pool.submit([&] {
+        for (int i = 0; i < kChildren; ++i) {
+            while (!pool.submit([&] { ++ran; })) std::this_thread::yield();
+        }
+    }));
+    EXPECT_TRUE(wait_for(ran, kChildren));
+    EXPECT_EQ(pool.stats().local.load(), static_cast<uint64_t>(kChildren));
+}
+
+TEST(LFThreadPool, IdleWorkersStealFanOut) {
+    LFThreadPool pool(0, 4, 64, 64);
+    constexpr int kChildren = 8;
+    std::atomic<int> ran{0};
+    std::atomic<int> stolen{-1};
+    ASSERT_TRUE(pool.submit([&] {
+        for (int i = 0; i < kChildren; ++i) ASSERT_TRUE(pool.submit([&] { ++ran; }));
+        // Hold this worker: its children only run if somebody steals them.
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (ran.load() == 0 && std::chrono::steady_clock::now() < deadline) std::this_thread::yield();
+        stolen = ran.load() > 0;
+    }));
+    EXPECT_TRUE(wait_for(ran, kChildren));
+    EXPECT_TRUE(wait_for(stolen, 1));
+    EXPECT_GT(pool.stats().steals.load(), 0u);
+}
+
+TEST(LFThreadPool, StealingKeepsPinnedOnlyOnPinnedWorkers) {
+    // The parent holds one pinned worker until its children are done, so only the other
+    // pinned worker may steal them; two idle flexible workers must leave them alone.
+    LFThreadPool pool(2, 2, 256, 256);
+    constexpr int kChildren = 200;
+    std::atomic<int> ran{0};
+    std::mutex mutex;
+    std::set<std::thread::id> runners;
+    std::atomic<bool> finished{false};
+    ASSERT_TRUE(pool.submit_pinned([&] {
+        for (int i = 0; i < kChildren; ++i) {
+            ASSERT_TRUE(pool.submit_pinned([&] {
+                std::this_thread::sleep_for(std::chrono::microseconds(20));
+                std::lock_guard<std::mutex> lock(mutex);
+                runners.insert(std::this_thread::get_id());
+                ++ran;
+            }));
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (ran.load() < kChildren && std::chrono::steady_clock::now() < deadline) std::this_thread::yield();
+        finished = true;
+    }));
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!finished.load() && std::chrono::steady_clock::now() < deadline) std::this_thread::yield();
+    ASSERT_EQ(ran.load(), kChildren);
+    EXPECT_EQ(runners.size(), 1u);
+    EXPECT_EQ(pool.stats().local.load(), static_cast<uint64_t>(kChildren));
+    EXPECT_EQ(pool.stats().steals.load(), static_cast<uint64_t>(kChildren));
+}
+
+TEST(LFThreadPool, FlexibleWorkerSendsPinnedOnlyToInjectionQueue) {
+    LFThreadPool pool(1, 1, 64, 64);
+    std::atomic<int> ran{0};
+    ASSERT_TRUE(pool.submit([&] {
+        while (!pool.submit_pinned([&] { ++ran; })) std::this_thread::yield();
+    }));
+    EXPECT_TRUE(wait_for(ran, 1));
+    EXPECT_EQ(pool.stats().executed_pinned.load(), 1u);
+}
+
+TEST(LFThreadPool, ShutdownRunsTasksLeftInDeques) {
+    std::atomic<int> ran{0};
+    {
+        LFThreadPool pool(0, 1, 64, 64);
+        std::atomic<bool> queued{false};
+        ASSERT_TRUE(pool.submit([&] {
+            for (int i = 0; i < 10; ++i) ASSERT_TRUE(pool.submit([&] { ++ran; }));
+            queued = true;
+            // Stay busy until shutdown so the children are still in the deque.
+            while (!pool.stopped()) std::this_thread::yield();
+        }));
+        while (!queued) std::this_thread::yield();
+    }
+    EXPECT_EQ(ran.load(), 10);
+}
+
+TEST(LFThreadPool, FixedFlexibleTierDoesNotScale) {
+    LFThreadPool pool(1, 2, 64, 64);
+    std::atomic<int> ran{0};
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_TRUE(pool.submit([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            ++ran;
+        }));
+    }
+    EXPECT_TRUE(wait_for(ran, 20));
+    EXPECT_EQ(pool.flexible_worker_count(), 2u);
+    EXPECT_EQ(pool.max_flexible_worker_count(), 2u);
+    EXPECT_EQ(pool.stats().scale_ups.load(), 0u);
+}
+
+TEST(LFThreadPool, ElasticTierGrowsUnderBacklogAndShrinksWhenIdle) {
+    LFThreadPool pool(0, 1, 1024, 1024, {}, LFThreadPool::Scheduling::WorkStealing, {}, fast_scaling(6));
+    EXPECT_EQ(pool.flexible_worker_count(), 1u);
+    // Blocking tasks: one worker would take a second over them.
+    constexpr int kTasks = 200;
+    std::atomic<int> ran{0};
+    for (int i = 0; i < kTasks; ++i) {
+        ASSERT_TRUE(pool.submit([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            ++ran;
+        }));
+    }
+    EXPECT_TRUE(wait_until([&] { return pool.flexible_worker_count() == 6; }));
+    EXPECT_TRUE(wait_for(ran, kTasks));
+    EXPECT_EQ(pool.stats().scale_ups.load(), 5u);
+    EXPECT_GT(pool.stats().sampled_backlog.load() + pool.stats().sampled_wait_us.load(), 0u);
+
+    // Idle: back to the floor one worker at a time, never below it.
+    EXPECT_TRUE(wait_until([&] { return pool.flexible_worker_count() == 1; }));
+    EXPECT_EQ(pool.stats().scale_downs.load(), 5u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(pool.flexible_worker_count(), 1u);
+}
+
+TEST(LFThreadPool, ShortBurstsDoNotScaleWithoutEnoughBusySamples) {
+    auto config = fast_scaling(4);
+    config.grow_after = 1000;
+    LFThreadPool pool(0, 1, 1024, 1024, {}, LFThreadPool::Scheduling::WorkStealing, {}, config);
+    std::atomic<int> ran{0};
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_TRUE(pool.submit([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            ++ran;
+        }));
+    }
+    EXPECT_TRUE(wait_for(ran, 20));
+    EXPECT_EQ(pool.flexible_worker_count(), 1u);
+    EXPECT_EQ(pool.stats().scale_ups.load(), 0u);
+}
+
+TEST(LFThreadPool, ScalingChurnLosesNoTasks) {
+    auto config = fast_scaling(4);
+    config.grow_after = 1;
+    config.shrink_after = 1;
+    LFThreadPool pool(1, 1, 1024, 1024, {}, LFThreadPool::Scheduling::WorkStealing, {}, config);
+    constexpr int kRounds = 20;
+    constexpr int kTasks = 40;
+    std::atomic<int> ran{0};
+    for (int round = 0; round < kRounds; ++round) {
+        for (int i = 0; i < kTasks; ++i) {
+            // Half of them fan out from a worker, onto deques of workers that may retire next.
+            bool queued = i % 2 == 0
+                ? pool.submit([&] { std::this_thread::sleep_for(std::chrono::microseconds(300)); ++ran; })
+                : pool.submit([&] { while (!pool.submit([&] { ++ran; })) std::this_thread::yield(); });
+            ASSERT_TRUE(queued);
+        }
+        ASSERT_TRUE(wait_for(ran, (round + 1) * kTasks)) << "round " << round;
+        std::this_thread::sleep_for(std::chrono::milliseconds(15));
+    }
+    EXPECT_GT(pool.stats().scale_ups.load(), 0u);
+    EXPECT_GT(pool.stats().scale_downs.load(), 0u);
+    EXPECT_LE(pool.flexible_worker_count(), 4u);
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include "net/timer_wheel.h"
+#include <random>
+#include <vector>
+
+using namespace std::chrono_literals;
+using net::TimerWheel;
+
+namespace {
+// Drive the wheel with a synthetic clock, 1ms ticks.
+struct FakeClock {
+    TimerWheel::Clock::time_point start = TimerWheel::Clock::now();
+    TimerWheel::Clock::time_point at(std::chrono::milliseconds ms) const { return start + ms; }
+};
+}
+
+TEST(TimerWheel, FiresAtDeadlineNotBefore) {
+    FakeClock clock;
+    TimerWheel wheel(1ms, clock.start);
+    int fired = 0;
+    wheel.arm(5ms, [&]{ ++fired; });
+    EXPECT_EQ(wheel.advance(clock.at(4ms)), 0u);
+    EXPECT_EQ(fired, 0);
+    EXPECT_EQ(wheel.advance(clock.at(5ms)), 1u);
+    EXPECT_EQ(fired, 1);
+    EXPECT_EQ(wheel.size(), 0u);
+}
+
+TEST(TimerWheel, CancelAndStaleIds) {
+    FakeClock clock;
+    TimerWheel wheel(1ms, clock.start);
+    bool fired = false;
+    auto id = wheel.arm(10ms, [&]{ fired = true; });
+    EXPECT_TRUE(wheel.armed(id));
+    EXPECT_TRUE(wheel.cancel(id));
+    EXPECT_FALSE(wheel.cancel(id));
+    EXPECT_FALSE(wheel.cancel(0));
+    // The node is reused, but the old id must not cancel the new timer.
+    auto next = wheel.arm(10ms, []{});
+    EXPECT_NE(next, id);
+    EXPECT_FALSE(wheel.cancel(id));
+    EXPECT_TRUE(wheel.armed(next));
+    wheel.advance(clock.at(20ms));
+    EXPECT_FALSE(fired);
+    EXPECT_FALSE(wheel.armed(next));
+}
+
+TEST(TimerWheel, CascadesAcrossLevels) {
+    FakeClock clock;
+    TimerWheel wheel(1ms, clock.start);
+    std::vector<int64_t> delays = {1, 63, 64, 65, 4095, 4096, 4097, 262143, 262144, 300000,
+                                   1 << 24, (1 << 24) + 777};
+    int64_t now_ms = 0;
+    size_t fired = 0;
+    for (auto d : delays) {
+        wheel.arm(std::chrono::milliseconds(d), [&, d]{ ++fired; EXPECT_EQ(now_ms, d); });
+    }
+    for (now_ms = 1; now_ms <= (1 << 24) + 1000; ++now_ms) {
+        wheel.advance(clock.at(std::chrono::milliseconds(now_ms)));
+    }
+    EXPECT_EQ(fired, delays.size());
+    EXPECT_EQ(wheel.size(), 0u);
+}
+
+TEST(TimerWheel, LargeStepsNeverFireEarly) {
+    FakeClock clock;
+    TimerWheel wheel(1ms, clock.start);
+    int64_t now_ms = 0;
+    size_t fired = 0;
+    for (int64_t d = 1; d < 2000000; d = d * 3 + 1) {
+        wheel.arm(std::chrono::milliseconds(d), [&, d]{ ++fired; EXPECT_GE(now_ms, d); });
+    }
+    const size_t armed = wheel.size();
+    while (wheel.size() != 0) {
+        now_ms += 997;   // the loop woke up late: everything due by now fires in this call
+        wheel.advance(clock.at(std::chrono::milliseconds(now_ms)));
+    }
+    EXPECT_EQ(fired, armed);
+}
+
+TEST(TimerWheel, RandomDeadlinesFireInOrderAndOnTime) {
+    FakeClock clock;
+    TimerWheel wheel(1ms, clock.start);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> dist(1, 200000);
+    int64_t now_ms = 0;
+    int64_t last = 0;
+    size_t fired = 0, late = 0;
+    for (int i = 0; i < 20000; ++i) {
+        int64_t d = dist(rng);
+        wheel.arm(std::chrono::milliseconds(d), [&, d]{
+            ++fired;
+            if (now_ms != d) ++late;
+            EXPECT_GE(now_ms, last);
+            last = now_ms;
+        });
+    }
+    for (now_ms = 1; now_ms <= 200000; ++now_ms) {
+        wheel.advance(clock.at(std::chrono::milliseconds(now_ms)));
+    }
+    EXPECT_EQ(fired, 20000u);
+    EXPECT_EQ(late, 0u);
+}
+
+TEST(TimerWheel, CallbackMayRearmAndCancel) {
+    FakeClock clock;
+    TimerWheel wheel(1ms, clock.start);
+    int ticks = 0;
+    bool victim_fired = false;
+    auto victim = wheel.arm(3ms, [&]{ victim_fired = true; });
+    std::function<void()> periodic = [&]{
+        if (++ticks == 1) wheel.cancel(victim);
+        if (ticks < 5) wheel.arm(2ms, periodic);
+    };
+    wheel.arm(2ms, periodic);
+    for (int t = 1; t <= 20; ++t) wheel.advance(clock.at(std::chrono::milliseconds(t)));
+    EXPECT_EQ(ticks, 5);
+    EXPECT_FALSE(victim_fired);
+    EXPECT_EQ(wheel.size(), 0u);
+}
+
+TEST(TimerWheel, NextTimeout) {
+    FakeClock clock;
+    TimerWheel wheel(10ms, clock.start);
+    EXPECT_EQ(wheel.next_timeout_ms(clock.at(0ms), 1000), 1000);
+    wheel.arm(50ms, []{});
+    EXPECT_EQ(wheel.next_timeout_ms(clock.at(0ms), 1000), 50);
+    EXPECT_EQ(wheel.next_timeout_ms(clock.at(20ms), 1000), 30);
+    EXPECT_EQ(wheel.next_timeout_ms(clock.at(0ms), 10), 10);
+    EXPECT_EQ(wheel.next_timeout_ms(clock.at(70ms), 1000), 0);
+    wheel.advance(clock.at(70ms));
+    EXPECT_EQ(wheel.size(), 0u);
+
+    // A far timer only wakes the loop at the cascade that brings it closer.
+    wheel.arm(60s, []{});
+    int wait = wheel.next_timeout_ms(clock.at(70ms), 1000000);
+    EXPECT_GT(wait, 0);
+    EXPECT_LE(wait, 60000);
+}
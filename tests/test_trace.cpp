@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+
+#include "metrics/trace.h"
+
+namespace trace = metrics::trace;
+
+namespace {
+
+std::size_t count(const std::string& text, const std::string& needle) {
+    std::size_t n = 0;
+    for (auto pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) ++n;
+    return n;
+}
+
+class TraceTest : public ::testing::Test {
+protected:
+    void SetUp() override { trace::clear(); }
+    void TearDown() override {
+        trace::set_sample_every(0);
+        trace::clear();
+    }
+};
+
+} // namespace
+
+TEST_F(TraceTest, SamplesOneInN) {
+    EXPECT_EQ(trace::begin(), 0u);
+    trace::set_sample_every(4);
+    int sampled = 0;
+    for (int i = 0; i < 100; ++i) sampled += trace::begin() != 0;
+    EXPECT_EQ(sampled, 25);
+    trace::set_sample_every(1);
+    uint64_t a = trace::begin();
+    uint64_t b = trace::begin();
+    EXPECT_NE(a, 0u);
+    EXPECT_NE(a, b);
+}
+
+TEST_F(TraceTest, SpansNeedACurrentTrace) {
+    { trace::Span span("untraced", "test"); }
+    EXPECT_EQ(trace::dump_json().find("untraced"), std::string::npos);
+
+    {
+        trace::Scope scope(42);
+        EXPECT_EQ(trace::current(), 42u);
+        trace::Span outer("outer", "test");
+        {
+            trace::Scope nested(0);
+            trace::Span span("hidden", "test");
+        }
+        trace::Span inner("inner", "test");
+    }
+    EXPECT_EQ(trace::current(), 0u);
+    std::string json = trace::dump_json();
+    EXPECT_EQ(json.find("hidden"), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"outer\",\"cat\":\"test\",\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"inner\""), std::string::npos);
+    EXPECT_EQ(count(json, "\"args\":{\"trace\":42}"), 2u);
+}
+
+TEST_F(TraceTest, DumpsMicrosecondsWithNanoseconds) {
+    trace::record(7, "stage", "test", 1234567, 1236000);
+    std::string json = trace::dump_json();
+    EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0), 0u);
+    EXPECT_NE(json.find("\"ts\":1234.567,\"dur\":1.433,"), std::string::npos);
+}
+
+TEST_F(TraceTest, KeepsLatestEventsPerThread) {
+    std::thread([] {
+        for (std::size_t i = 0; i < trace::kBufferEvents + 10; ++i) {
+            trace::record(i + 1, i < 10 ? "old" : "new", "test", 0, 1);
+        }
+    }).join();
+    trace::record(1, "main", "test", 0, 1);
+    // The exited thread's spans are still there, minus the ones its ring overwrote.
+    std::string json = trace::dump_json();
+    EXPECT_EQ(count(json, "\"name\":\"old\""), 0u);
+    EXPECT_EQ(count(json, "\"name\":\"new\""), trace::kBufferEvents);
+    EXPECT_EQ(count(json, "\"name\":\"main\""), 1u);
+}
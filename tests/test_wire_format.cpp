@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include "net/frame_buffer.h"
+#include "protocol/wire_format.h"
+#include "utils/crc32c.h"
+
+using protocol::FrameHeader;
+using protocol::WireFormat;
+
+namespace {
+WireFormat v2(uint32_t caps = protocol::kCapLargeFrames, uint32_t max_frame = protocol::kMaxBodyV2) {
+    return protocol::negotiate(protocol::kProtocolV2, caps, max_frame);
+}
+}
+
+TEST(Crc32c, KnownVectors) {
+    EXPECT_EQ(utils::crc32c("123456789", 9), 0xe3069283u);
+    EXPECT_EQ(utils::crc32c("", 0), 0u);
+    std::string data(1000, 'x');
+    for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<char>(i * 7);
+    // continuing over pieces gives the same result as one pass
+    uint32_t whole = utils::crc32c(data.data(), data.size());
+    uint32_t split = utils::crc32c(data.data() + 13, data.size() - 13, utils::crc32c(data.data(), 13));
+    EXPECT_EQ(whole, split);
+}
+
+TEST(WireFormat, Negotiate) {
+    auto v1 = protocol::negotiate(1, protocol::kServerCapabilities, protocol::kMaxBodyV2);
+    EXPECT_FALSE(v1.v2());
+    EXPECT_EQ(v1.header_size(), sizeof(MessageHeader));
+    EXPECT_EQ(v1.chunk_size(), MAX_MESSAGE_SIZE - sizeof(MessageHeader));
+
+    auto large = v2(protocol::kCapLargeFrames | (1u << 30), 8u << 20);
+    EXPECT_TRUE(large.v2());
+    EXPECT_EQ(large.capabilities, protocol::kCapLargeFrames);   // unknown bits dropped
+    EXPECT_EQ(large.max_body, protocol::kMaxBodyV2);            // clamped to what the server has
+    EXPECT_EQ(large.header_size(), sizeof(MessageHeaderV2));
+    EXPECT_FALSE(large.crc());
+
+    auto small = v2(protocol::kCapCrc, 8u << 20);
+    EXPECT_EQ(small.max_body, protocol::kMaxBodyV1);           // no large frames without the bit
+    EXPECT_TRUE(small.crc());
+}
+
+TEST(WireFormat, HeaderRoundTrip) {
+    FrameHeader h;
+    h.length = 5;
+    h.type = 6;
+    h.request_id = 42;
+    const uint8_t body[] = "hello";
+    uint8_t out[protocol::kMaxHeaderSize];
+
+    WireFormat v1;
+    protocol::encode_header(h, v1, body, out);
+    auto back = protocol::decode_header(out, v1);
+    EXPECT_EQ(back.length, 5u);
+    EXPECT_EQ(back.type, 6);
+    EXPECT_EQ(back.request_id, 42);
+
+    auto large = v2();
+    h.length = 3 << 20;   // beyond 16 bits; no checksum, so the body is not read
+    protocol::encode_header(h, large, body, out);
+    back = protocol::decode_header(out, large);
+    EXPECT_EQ(back.length, 3u << 20);
+    EXPECT_EQ(back.request_id, 42);
+    EXPECT_FALSE(back.flags & protocol::kFrameCrc);
+
+    auto crc = v2(protocol::kCapCrc);
+    h.length = 5;
+    protocol::encode_header(h, crc, body, out);
+    back = protocol::decode_header(out, crc);
+    EXPECT_TRUE(back.flags & protocol::kFrameCrc);
+    EXPECT_EQ(back.crc, utils::crc32c(body, 5));
+}
+
+TEST(WireFormat, BodyChecksum) {
+    auto format = v2(protocol::kCapCrc);
+    std::string payload = "some body";
+    std::string wire = protocol::encode_frame(4, payload.data(), payload.size(), format);
+    ASSERT_EQ(wire.size(), sizeof(MessageHeaderV2) + payload.size());
+    auto bytes = reinterpret_cast<uint8_t*>(wire.data());
+    auto header = protocol::decode_header(bytes, format);
+    EXPECT_TRUE(protocol::verify_body(header, bytes + sizeof(MessageHeaderV2)));
+    bytes[sizeof(MessageHeaderV2) + 2] ^= 1;
+    EXPECT_FALSE(protocol::verify_body(header, bytes + sizeof(MessageHeaderV2)));
+}
+
+TEST(WireFormat, FrameSealsInItsFormat) {
+    auto pool = net::FramePool::create();
+    EXPECT_FALSE(pool->acquire(1u << 20));          // v1 frames stay below 64KB
+    auto format = v2();
+    auto frame = pool->acquire(1u << 20, format);
+    ASSERT_TRUE(frame);
+    EXPECT_EQ(frame->body_capacity(), 1u << 20);
+    frame->header().type = 6;
+    std::memset(frame->body(), 'b', 1u << 20);
+    frame->seal();
+    EXPECT_EQ(frame->wire_size(), sizeof(MessageHeaderV2) + (1u << 20));
+    EXPECT_EQ(frame->wire_data() + sizeof(MessageHeaderV2), frame->body());
+    auto header = protocol::decode_header(frame->wire_data(), format);
+    EXPECT_EQ(header.length, 1u << 20);
+    EXPECT_EQ(header.type, 6);
+
+    auto small = pool->acquire(3);
+    small->seal();
+    EXPECT_EQ(small->wire_size(), sizeof(MessageHeader) + 3);
+    EXPECT_EQ(protocol::decode_header(small->wire_data(), WireFormat{}).length, 3u);
+}
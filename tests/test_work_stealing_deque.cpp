@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "lockfreequeue/work_stealing_deque.hpp"
+
+using Deque = lf::WorkStealingDeque<uint64_t>;
+
+TEST(WorkStealingDeque, OwnerPopsLifoThievesStealFifo) {
+    Deque deque(8);
+    for (uint64_t i = 1; i <= 4; ++i) ASSERT_TRUE(deque.push(i));
+    uint64_t v = 0;
+    ASSERT_TRUE(deque.pop(v));
+    EXPECT_EQ(v, 4u);
+    ASSERT_TRUE(deque.steal(v));
+    EXPECT_EQ(v, 1u);
+    ASSERT_TRUE(deque.pop(v));
+    EXPECT_EQ(v, 3u);
+    ASSERT_TRUE(deque.steal(v));
+    EXPECT_EQ(v, 2u);
+    EXPECT_FALSE(deque.pop(v));
+    EXPECT_FALSE(deque.steal(v));
+    EXPECT_TRUE(deque.empty());
+}
+
+TEST(WorkStealingDeque, RejectsPushWhenFull) {
+    Deque deque(3);
+    EXPECT_EQ(deque.capacity(), 4u);
+    for (uint64_t i = 0; i < 4; ++i) ASSERT_TRUE(deque.push(i));
+    EXPECT_FALSE(deque.push(4));
+    uint64_t v = 0;
+    ASSERT_TRUE(deque.steal(v));
+    EXPECT_TRUE(deque.push(4));
+    EXPECT_EQ(deque.size(), 4u);
+}
+
+TEST(WorkStealingDeque, StealIfLeavesRefusedValues) {
+    Deque deque(8);
+    ASSERT_TRUE(deque.push(7));
+    ASSERT_TRUE(deque.push(8));
+    uint64_t v = 0;
+    EXPECT_FALSE(deque.steal_if(v, [](uint64_t x) { return x % 2 == 0; }));
+    EXPECT_EQ(deque.size(), 2u);
+    ASSERT_TRUE(deque.pop(v));
+    EXPECT_EQ(v, 8u);
+    ASSERT_TRUE(deque.pop(v));
+    EXPECT_EQ(v, 7u);
+}
+
+TEST(WorkStealingDeque, EveryValueTakenExactlyOnce) {
+    constexpr uint64_t kValues = 200000;
+    constexpr int kThieves = 3;
+    Deque deque(64);
+    std::vector<std::atomic<int>> taken(kValues);
+    std::atomic<bool> done{false};
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < kThieves; ++t) {
+        thieves.emplace_back([&] {
+            uint64_t v;
+            while (!done.load(std::memory_order_acquire) || !deque.empty()) {
+                if (deque.steal(v)) taken[v].fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    uint64_t v;
+    for (uint64_t i = 0; i < kValues; ++i) {
+        while (!deque.push(i)) {
+            if (deque.pop(v)) taken[v].fetch_add(1, std::memory_order_relaxed);
+        }
+        // The owner takes back every third value, racing the thieves for the last one.
+        if (i % 3 == 0 && deque.pop(v)) taken[v].fetch_add(1, std::memory_order_relaxed);
+    }
+    while (deque.pop(v)) taken[v].fetch_add(1, std::memory_order_relaxed);
+    done.store(true, std::memory_order_release);
+    for (auto& th : thieves) th.join();
+    for (uint64_t i = 0; i < kValues; ++i) ASSERT_EQ(taken[i].load(), 1) << "value " << i;
+}
@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+
+#include "concurrency/lf_thread_pool.h"
+
+// Idle cost and wake-up latency of the LFThreadPool workers, with the server's layout
+// (2 pinned + 4 flexible workers, no core pinning here).
+//
+// yield:       the previous idle loop: every worker try_pops and std::this_thread::yield()s.
+// park:        LFThreadPool: spin with backoff, then park on a futex until submit() wakes one.
+//
+// idle_cpu_pct is the process CPU time over an idle --idle-ms window (100 = one core).
+// Wake-up latency is from submit() to the task starting, after --gap-us of idleness each.
+// tasks_per_sec is a burst of --burst empty tasks from one submitter.
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    int idle_ms = 1000;
+    int wakes = 500;
+    int gap_us = 2000;
+    int burst = 200000;
+};
+
+static BenchConfig parse_args(int argc, char** argv) {
+    BenchConfig cfg;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        auto need = [&](int i){ if (i+1>=argc) { std::cerr << "Missing value after " << a << "\n"; std::exit(1);} };
+        if (a == "--idle-ms") { need(i); cfg.idle_ms = std::atoi(argv[++i]); }
+        else if (a == "--wakes") { need(i); cfg.wakes = std::atoi(argv[++i]); }
+        else if (a == "--gap-us") { need(i); cfg.gap_us = std::atoi(argv[++i]); }
+        else if (a == "--burst") { need(i); cfg.burst = std::atoi(argv[++i]); }
+        else if (a == "--help") {
+            std::cout << "Usage: thread_pool_bench [options]\n"
+                      << "  --idle-ms N            idle window for the CPU measurement (default 1000)\n"
+                      << "  --wakes N              wake-up samples (default 500)\n"
+                      << "  --gap-us N             idle time before each wake-up (default 2000)\n"
+                      << "  --burst N              tasks in the throughput burst (default 200000)\n"
+                      << "  --help                 show this help\n";
+            std::exit(0);
+        }
+    }
+    return cfg;
+}
+
+static uint64_t g_sink = 0;     // results feed main()'s exit code so nothing is optimised away
+
+using Task = concurrency::LFThreadPool::Task;
+
+// The pool's worker loop before parking, reduced to one queue.
+class YieldPool {
+public:
+    explicit YieldPool(std::size_t threads) : queue_(4096) {
+        for (std::size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this] {
+                while (!stop_.load(std::memory_order_relaxed)) {
+                    Task task;
+                    if (queue_.try_pop(task)) task();
+                    else std::this_thread::yield();
+                }
+            });
+        }
+    }
+    ~YieldPool() {
+        stop_ = true;
+        for (auto& th : workers_) th.join();
+    }
+    bool submit(Task t) { return queue_.try_push(std::move(t)); }
+
+private:
+    lf::ArrayMPMCQueue<Task> queue_;
+    std::vector<std::thread> workers_;
+    std::atomic<bool> stop_{false};
+};
+
+static double cpu_seconds() {
+    rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+template <typename Pool>
+static void run(const char* variant, Pool& pool, const BenchConfig& cfg) {
+    // Let the workers settle (park) before measuring.
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    double cpu0 = cpu_seconds();
+    auto t0 = Clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(cfg.idle_ms));
+    double wall = std::chrono::duration<double>(Clock::now() - t0).count();
+    double idle_cpu_pct = (cpu_seconds() - cpu0) / wall * 100;
+
+    std::vector<int64_t> latencies;
+    latencies.reserve(cfg.wakes);
+    for (int i = 0; i < cfg.wakes; ++i) {
+        std::this_thread::sleep_for(std::chrono::microseconds(cfg.gap_us));
+        std::atomic<int64_t> started{0};
+        int64_t submitted = now_ns();
+        while (!pool.submit([&started] { started.store(now_ns(), std::memory_order_release); })) {}
+        while (started.load(std::memory_order_acquire) == 0) std::this_thread::yield();
+        latencies.push_back(started.load() - submitted);
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto pct = [&](double q) { return latencies[std::min<std::size_t>(latencies.size() - 1, latencies.size() * q)] / 1000.0; };
+
+    std::atomic<int> done{0};
+    auto b0 = Clock::now();
+    for (int i = 0; i < cfg.burst; ++i) {
+        while (!pool.submit([&done] { done.fetch_add(1, std::memory_order_relaxed); })) std::this_thread::yield();
+    }
+    while (done.load() < cfg.burst) std::this_thread::yield();
+    double burst_s = std::chrono::duration<double>(Clock::now() - b0).count();
+    g_sink += done.load();
+
+    std::cout << "POOL BENCH RESULT"
+              << " variant=" << variant
+              << std::fixed << std::setprecision(1)
+              << " idle_cpu_pct=" << idle_cpu_pct
+              << " wake_p50_us=" << pct(0.5)
+              << " wake_p99_us=" << pct(0.99)
+              << " wake_max_us=" << latencies.back() / 1000.0
+              << std::setprecision(0)
+              << " tasks_per_sec=" << cfg.burst / burst_s
+              << "\n";
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg = parse_args(argc, argv);
+    {
+        YieldPool pool(6);
+        run("yield", pool, cfg);
+    }
+    {
+        concurrency::LFThreadPool pool(2, 4, 1024, 1024);
+        run("park", pool, cfg);
+        std::cout << "POOL BENCH STATS parks=" << pool.stats().parks.load() << " wakes=" << pool.stats().wakes.load() << "\n";
+    }
+    return g_sink == 0xdeadbeef;
+}
@@ -0,0 +1,188 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "net/timer_wheel.h"
+
+// Cost of keeping millions of connection timers in an IOReactor's TimerWheel.
+//   arm        arm N idle-style timers (1s .. 1h)
+//   rearm      cancel + arm, i.e. refreshing a timer on every request
+//   loop       per-iteration overhead of next_timeout_ms() + advance() with N timers pending,
+//              simulating a reactor that wakes every --step-us, against an empty wheel
+//   cancel     cancel all N
+// The same arm/rearm/cancel sequence on a std::multimap ordered timer set is the baseline.
+
+using Clock = std::chrono::steady_clock;
+using namespace std::chrono_literals;
+
+struct BenchConfig {
+    int64_t timers = 2000000;
+    int64_t iterations = 1000000;   // simulated reactor loop iterations
+    int64_t step_us = 100;          // simulated time between iterations
+    int64_t max_delay_ms = 3600 * 1000;
+    std::string mode = "all";
+};
+
+static BenchConfig parse_args(int argc, char** argv) {
+    BenchConfig cfg;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        auto need = [&](int i){ if (i+1>=argc) { std::cerr << "Missing value after " << a << "\n"; std::exit(1);} };
+        if (a == "--timers") { need(i); cfg.timers = std::atoll(argv[++i]); }
+        else if (a == "--iterations") { need(i); cfg.iterations = std::atoll(argv[++i]); }
+        else if (a == "--step-us") { need(i); cfg.step_us = std::atoll(argv[++i]); }
+        else if (a == "--max-delay-ms") { need(i); cfg.max_delay_ms = std::atoll(argv[++i]); }
+        else if (a == "--mode") { need(i); cfg.mode = argv[++i]; }
+        else if (a == "--help") {
+            std::cout << "Usage: timer_wheel_bench [options]\n"
+                      << "  --mode NAME            wheel | map | all (default all)\n"
+                      << "  --timers N             pending timers (default 2000000)\n"
+                      << "  --iterations N         simulated reactor loop iterations (default 1000000)\n"
+                      << "  --step-us N            simulated time per iteration (default 100)\n"
+                      << "  --max-delay-ms N       timers are armed 1s .. N ms ahead (default 3600000)\n"
+                      << "  --help                 show this help\n";
+            std::exit(0);
+        }
+    }
+    return cfg;
+}
+
+static long vm_hwm_kb() {
+    std::ifstream in("/proc/self/status");
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) return std::atol(line.c_str() + 6);
+    }
+    return -1;
+}
+
+static double ns_per(Clock::time_point t0, Clock::time_point t1, int64_t ops) {
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / static_cast<double>(ops);
+}
+
+static std::vector<int64_t> make_delays(const BenchConfig& cfg) {
+    std::mt19937_64 rng(7);
+    std::uniform_int_distribution<int64_t> dist(1000, std::max<int64_t>(1000, cfg.max_delay_ms));
+    std::vector<int64_t> delays(cfg.timers);
+    for (auto& d : delays) d = dist(rng);
+    return delays;
+}
+
+// Loop overhead with `wheel` as it is: wake every step_us of simulated time.
+static double loop_ns(net::TimerWheel& wheel, Clock::time_point start, const BenchConfig& cfg, uint64_t& fired, int64_t& sleep_ms) {
+    auto now = start;
+    sleep_ms = 0;
+    fired = 0;
+    auto t0 = Clock::now();
+    for (int64_t i = 0; i < cfg.iterations; ++i) {
+        sleep_ms += wheel.next_timeout_ms(now, 1000);
+        now += std::chrono::microseconds(cfg.step_us);
+        fired += wheel.advance(now);
+    }
+    return ns_per(t0, Clock::now(), cfg.iterations);
+}
+
+static void run_wheel(const BenchConfig& cfg, const std::vector<int64_t>& delays) {
+    auto start = Clock::now();
+    net::TimerWheel wheel(10ms, start);
+    uint64_t callbacks = 0;
+    std::vector<net::TimerWheel::TimerId> ids(cfg.timers);
+
+    auto t0 = Clock::now();
+    for (int64_t i = 0; i < cfg.timers; ++i) {
+        ids[i] = wheel.arm(std::chrono::milliseconds(delays[i]), [&callbacks]{ ++callbacks; });
+    }
+    auto t1 = Clock::now();
+    double arm = ns_per(t0, t1, cfg.timers);
+
+    t0 = Clock::now();
+    for (int64_t i = 0; i < cfg.timers; ++i) {
+        wheel.cancel(ids[i]);
+        ids[i] = wheel.arm(std::chrono::milliseconds(delays[cfg.timers - 1 - i]), [&callbacks]{ ++callbacks; });
+    }
+    t1 = Clock::now();
+    double rearm = ns_per(t0, t1, cfg.timers);
+
+    net::TimerWheel empty(10ms, start);
+    uint64_t fired_empty = 0, fired_full = 0;
+    int64_t sleep_empty = 0, sleep_full = 0;
+    double loop_empty = loop_ns(empty, start, cfg, fired_empty, sleep_empty);
+    double loop_full = loop_ns(wheel, start, cfg, fired_full, sleep_full);
+    size_t pending = wheel.size();
+
+    t0 = Clock::now();
+    size_t cancelled = 0;
+    for (auto id : ids) cancelled += wheel.cancel(id);
+    t1 = Clock::now();
+    double cancel = ns_per(t0, t1, static_cast<int64_t>(cancelled ? cancelled : 1));
+
+    std::cout << "TIMER WHEEL BENCH RESULT\n"
+              << " mode=wheel timers=" << cfg.timers
+              << std::fixed << std::setprecision(1)
+              << " arm_ns=" << arm
+              << " rearm_ns=" << rearm
+              << " cancel_ns=" << cancel
+              << " loop_ns_empty=" << loop_empty
+              << " loop_ns_full=" << loop_full
+              << " loop_overhead_ns=" << (loop_full - loop_empty)
+              << " simulated_sec=" << std::setprecision(1) << (cfg.iterations * cfg.step_us / 1e6)
+              << " fired=" << fired_full
+              << " pending=" << pending
+              << " VmHWM_MB=" << std::setprecision(1) << (vm_hwm_kb() / 1024.0)
+              << "\n";
+}
+
+static void run_map(const BenchConfig& cfg, const std::vector<int64_t>& delays) {
+    // Ordered multimap keyed by deadline, the usual "timer set" in hand-written reactors.
+    using Map = std::multimap<Clock::time_point, std::function<void()>>;
+    Map timers;
+    uint64_t callbacks = 0;
+    std::vector<Map::iterator> ids(cfg.timers);
+    auto now = Clock::now();
+
+    auto t0 = Clock::now();
+    for (int64_t i = 0; i < cfg.timers; ++i) {
+        ids[i] = timers.emplace(now + std::chrono::milliseconds(delays[i]), [&callbacks]{ ++callbacks; });
+    }
+    auto t1 = Clock::now();
+    double arm = ns_per(t0, t1, cfg.timers);
+
+    t0 = Clock::now();
+    for (int64_t i = 0; i < cfg.timers; ++i) {
+        timers.erase(ids[i]);
+        ids[i] = timers.emplace(now + std::chrono::milliseconds(delays[cfg.timers - 1 - i]), [&callbacks]{ ++callbacks; });
+    }
+    t1 = Clock::now();
+    double rearm = ns_per(t0, t1, cfg.timers);
+
+    t0 = Clock::now();
+    for (auto it : ids) timers.erase(it);
+    t1 = Clock::now();
+    double cancel = ns_per(t0, t1, cfg.timers);
+
+    std::cout << "TIMER WHEEL BENCH RESULT\n"
+              << " mode=map timers=" << cfg.timers
+              << std::fixed << std::setprecision(1)
+              << " arm_ns=" << arm
+              << " rearm_ns=" << rearm
+              << " cancel_ns=" << cancel
+              << " VmHWM_MB=" << (vm_hwm_kb() / 1024.0)
+              << "\n";
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg = parse_args(argc, argv);
+    auto delays = make_delays(cfg);
+    // The wheel runs first so its VmHWM is not inflated by the map's nodes.
+    if (cfg.mode == "all" || cfg.mode == "wheel") run_wheel(cfg, delays);
+    if (cfg.mode == "all" || cfg.mode == "map") run_map(cfg, delays);
+    return 0;
+}
@@ -0,0 +1,239 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "net/frame_buffer.h"
+#include "net/frame_decoder.h"
+#include "net/outbound_buffer.h"
+#include "protocol/wire_format.h"
+#include "types/enums.h"
+
+// GET and PUT streaming throughput over loopback TCP with today's 64KB protocol v1 frames
+// against 1MB protocol v2 frames (optionally with CRC-32C on every body).
+//
+// GET: the sender is the server's download path, pread()ing chunk_size() bodies from a file
+// into pooled frames (GETHandler does so on the disk executor) and flushing them through an
+// OutboundBuffer; the receiver decodes them with a FrameDecoder and discards the data.
+// PUT: the sender frames chunks of a file the same way; the receiver is the server's upload
+// path, FrameDecoder plus pwrite() of every PUT_DATA body into a scratch file.
+// Files live in --dir (default /tmp) and are mostly page cache, so this measures framing,
+// syscalls and copies rather than the disk.
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    uint64_t size_mb = 512;
+    int rounds = 3;
+    bool crc = false;
+    std::string dir = "/tmp";
+    std::string op = "all";     // get, put or all
+};
+
+static BenchConfig parse_args(int argc, char** argv) {
+    BenchConfig cfg;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        auto need = [&](int i){ if (i+1>=argc) { std::cerr << "Missing value after " << a << "\n"; std::exit(1);} };
+        if (a == "--size-mb") { need(i); cfg.size_mb = std::strtoull(argv[++i], nullptr, 10); }
+        else if (a == "--rounds") { need(i); cfg.rounds = std::atoi(argv[++i]); }
+        else if (a == "--crc") { cfg.crc = true; }
+        else if (a == "--dir") { need(i); cfg.dir = argv[++i]; }
+        else if (a == "--op") { need(i); cfg.op = argv[++i]; }
+        else if (a == "--help") {
+            std::cout << "Usage: transfer_bench [options]\n"
+                      << "  --op get|put|all       transfer direction (default all)\n"
+                      << "  --size-mb N            bytes per transfer in MB (default 512)\n"
+                      << "  --rounds N             transfers per configuration, best is reported (default 3)\n"
+                      << "  --crc                  also run v2 with CRC-32C on every frame\n"
+                      << "  --dir PATH             where the source and scratch files go (default /tmp)\n"
+                      << "  --help                 show this help\n";
+            std::exit(0);
+        }
+    }
+    return cfg;
+}
+
+static std::pair<int, int> tcp_pair() {
+    int lfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (::bind(lfd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(lfd, 1) != 0) {
+        std::cerr << "listen failed: " << strerror(errno) << "\n";
+        std::exit(1);
+    }
+    ::getsockname(lfd, reinterpret_cast<sockaddr*>(&addr), &len);
+    int a = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    ::connect(a, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    int b = ::accept4(lfd, nullptr, nullptr, SOCK_NONBLOCK);
+    ::close(lfd);
+    return {a, b};
+}
+
+// Producer side: frames of format.chunk_size() read from fd, the last one empty.
+static void send_file(int sock, int file, uint64_t size, MessageType type, const protocol::WireFormat& format,
+                      uint64_t& frames) {
+    auto pool = net::FramePool::create();
+    net::OutboundBuffer out;
+    uint64_t offset = 0;
+    bool eof = false;
+    const size_t chunk = format.chunk_size();
+    while (!eof || !out.empty()) {
+        while (!eof && out.pending_bytes() < net::OutboundBuffer::kLowWatermark) {
+            size_t want = static_cast<size_t>(std::min<uint64_t>(chunk, size - offset));
+            net::FrameRef frame = pool->acquire(chunk, format);
+            ssize_t rn = want ? ::pread(file, frame->body(), want, static_cast<off_t>(offset)) : 0;
+            if (rn < 0) rn = 0;
+            frame->header().type = static_cast<uint8_t>(type);
+            frame->header().length = static_cast<uint32_t>(rn);
+            out.append(std::move(frame));
+            offset += rn;
+            ++frames;
+            eof = (rn == 0);
+        }
+        size_t written = 0;
+        auto r = out.flush(sock, written);
+        if (r == net::OutboundBuffer::FlushResult::Error) {
+            std::cerr << "send failed\n";
+            std::exit(1);
+        }
+        if (r == net::OutboundBuffer::FlushResult::WouldBlock) {
+            pollfd p{sock, POLLOUT, 0};
+            ::poll(&p, 1, 100);
+        }
+    }
+}
+
+// Consumer side: decode until the empty frame; write bodies to `file` unless it is -1.
+static uint64_t receive_file(int sock, int file, const protocol::WireFormat& format) {
+    auto pool = net::FramePool::create();
+    net::FrameDecoder decoder;
+    decoder.set_format(format);
+    uint64_t received = 0;
+    bool done = false;
+    while (!done) {
+        size_t nread = 0;
+        auto status = decoder.read_frames(sock, *pool, [&] { return !done; }, [&](net::FrameRef frame) {
+            uint32_t len = frame->header().length;
+            if (len == 0) { done = true; return; }
+            if (file >= 0 && ::pwrite(file, frame->body(), len, static_cast<off_t>(received)) != static_cast<ssize_t>(len)) {
+                std::cerr << "pwrite failed\n";
+                std::exit(1);
+            }
+            received += len;
+        }, nread);
+        if (status == net::FrameDecoder::Status::Error || status == net::FrameDecoder::Status::Closed) {
+            std::cerr << "receive failed\n";
+            std::exit(1);
+        }
+        if (status == net::FrameDecoder::Status::Drained) {
+            pollfd p{sock, POLLIN, 0};
+            ::poll(&p, 1, 100);
+        }
+    }
+    return received;
+}
+
+struct RunResult {
+    double mb_per_sec;
+    uint64_t frames;
+};
+
+static RunResult run_once(const BenchConfig& cfg, bool put, const protocol::WireFormat& format,
+                          int source, const std::string& scratch) {
+    uint64_t size = cfg.size_mb << 20;
+    auto [sender, receiver] = tcp_pair();
+    int sink = -1;
+    if (put) sink = ::open(scratch.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    uint64_t frames = 0, received = 0;
+
+    auto t0 = Clock::now();
+    std::thread rx([&] { received = receive_file(receiver, sink, format); });
+    send_file(sender, source, size, put ? MessageType::PUT_DATA : MessageType::GET_DATA, format, frames);
+    rx.join();
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    if (received != size) {
+        std::cerr << "short transfer: " << received << " of " << size << "\n";
+        std::exit(1);
+    }
+    if (sink >= 0) ::close(sink);
+    ::close(sender);
+    ::close(receiver);
+    return {static_cast<double>(size) / (1 << 20) / secs, frames};
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg = parse_args(argc, argv);
+    std::string source_path = cfg.dir + "/transfer_bench.src";
+    std::string scratch_path = cfg.dir + "/transfer_bench.dst";
+
+    // Source file, written once and read again by every run (page cache).
+    int source = ::open(source_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (source < 0) {
+        std::cerr << "cannot create " << source_path << ": " << strerror(errno) << "\n";
+        return 1;
+    }
+    std::vector<char> block(1 << 20);
+    for (size_t i = 0; i < block.size(); ++i) block[i] = static_cast<char>(i * 31 + 7);
+    for (uint64_t i = 0; i < cfg.size_mb; ++i) {
+        if (::write(source, block.data(), block.size()) != static_cast<ssize_t>(block.size())) {
+            std::cerr << "write failed\n";
+            return 1;
+        }
+    }
+
+    struct Variant { const char* name; protocol::WireFormat format; };
+    std::vector<Variant> variants{
+        {"v1_64k", protocol::WireFormat{}},
+        {"v2_1m", protocol::negotiate(protocol::kProtocolV2, protocol::kCapLargeFrames, protocol::kMaxBodyV2)},
+    };
+    if (cfg.crc) {
+        variants.push_back({"v2_1m_crc", protocol::negotiate(protocol::kProtocolV2,
+                            protocol::kCapLargeFrames | protocol::kCapCrc, protocol::kMaxBodyV2)});
+    }
+
+    for (bool put : {false, true}) {
+        if (cfg.op != "all" && cfg.op != (put ? "put" : "get")) continue;
+        double base = 0;
+        for (const auto& v : variants) {
+            RunResult best{0, 0};
+            for (int r = 0; r < cfg.rounds; ++r) {
+                RunResult res = run_once(cfg, put, v.format, source, scratch_path);
+                if (res.mb_per_sec > best.mb_per_sec) best = res;
+            }
+            if (base == 0) base = best.mb_per_sec;
+            std::cout << "TRANSFER BENCH RESULT\n"
+                      << " op=" << (put ? "put" : "get")
+                      << " framing=" << v.name
+                      << " chunk=" << v.format.chunk_size()
+                      << " size_mb=" << cfg.size_mb
+                      << " frames=" << best.frames
+                      << std::fixed << std::setprecision(0)
+                      << " mb_per_sec=" << best.mb_per_sec
+                      << std::setprecision(2)
+                      << " speedup=" << (best.mb_per_sec / base)
+                      << "\n";
+        }
+    }
+
+    ::close(source);
+    ::unlink(source_path.c_str());
+    ::unlink(scratch_path.c_str());
+    return 0;
+}
@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "concurrency/lf_thread_pool.h"
+
+// LFThreadPool scheduling: the two shared injection queues alone vs per-worker deques with
+// stealing, at the server's pinned:flexible ratio (threads/3 pinned, no core pinning here).
+//
+// shared:      Scheduling::SharedQueues, every submit goes through the MPMC queues.
+// stealing:    Scheduling::WorkStealing, submits from a worker go to its own deque.
+//
+// fanout:      one external thread submits --roots tasks; each submits --children tasks of
+//              --child-ns of work from the worker. tasks_per_sec over roots + children.
+// mixed:       the reactor's view of an ls/put mix: --requests external submits, 90% "ls"
+//              (--ls-ns of work), 10% "put" that submits --put-chunks chunk writes of
+//              --chunk-ns each from the worker. Latency is submit to the last piece done.
+
+using Clock = std::chrono::steady_clock;
+using concurrency::LFThreadPool;
+
+struct BenchConfig {
+    std::vector<int> threads{2, 6, 16};
+    int roots = 2000;
+    int children = 32;
+    int child_ns = 1000;
+    int requests = 50000;
+    int ls_ns = 5000;
+    int put_chunks = 8;
+    int chunk_ns = 6000;
+};
+
+static std::vector<int> parse_list(const std::string& s) {
+    std::vector<int> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) out.push_back(std::atoi(item.c_str()));
+    return out;
+}
+
+static BenchConfig parse_args(int argc, char** argv) {
+    BenchConfig cfg;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        auto need = [&](int i){ if (i+1>=argc) { std::cerr << "Missing value after " << a << "\n"; std::exit(1);} };
+        if (a == "--threads") { need(i); cfg.threads = parse_list(argv[++i]); }
+        else if (a == "--roots") { need(i); cfg.roots = std::atoi(argv[++i]); }
+        else if (a == "--children") { need(i); cfg.children = std::atoi(argv[++i]); }
+        else if (a == "--child-ns") { need(i); cfg.child_ns = std::atoi(argv[++i]); }
+        else if (a == "--requests") { need(i); cfg.requests = std::atoi(argv[++i]); }
+        else if (a == "--ls-ns") { need(i); cfg.ls_ns = std::atoi(argv[++i]); }
+        else if (a == "--put-chunks") { need(i); cfg.put_chunks = std::atoi(argv[++i]); }
+        else if (a == "--chunk-ns") { need(i); cfg.chunk_ns = std::atoi(argv[++i]); }
+        else if (a == "--help") {
+            std::cout << "Usage: work_stealing_bench [options]\n"
+                      << "  --threads LIST         pool sizes, comma separated (default 2,6,16)\n"
+                      << "  --roots N              fan-out roots (default 2000)\n"
+                      << "  --children N           children per root (default 32)\n"
+                      << "  --child-ns N           work per child (default 1000)\n"
+                      << "  --requests N           mixed workload requests (default 50000)\n"
+                      << "  --ls-ns N              work per ls (default 5000)\n"
+                      << "  --put-chunks N         chunk tasks per put (default 8)\n"
+                      << "  --chunk-ns N           work per chunk (default 6000)\n"
+                      << "  --help                 show this help\n";
+            std::exit(0);
+        }
+    }
+    return cfg;
+}
+
+static uint64_t g_sink = 0;     // results feed main()'s exit code so nothing is optimised away
+
+static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+static void burn(int ns) {
+    int64_t until = now_ns() + ns;
+    while (now_ns() < until) {}
+}
+
+static std::unique_ptr<LFThreadPool> make_pool(int threads, LFThreadPool::Scheduling scheduling) {
+    std::size_t pinned = threads / 3;
+    return std::make_unique<LFThreadPool>(pinned, threads - pinned, 4096, 4096, std::vector<int>{}, scheduling);
+}
+
+template <typename Fn>
+static void submit_retry(LFThreadPool& pool, Fn fn) {
+    while (!pool.submit(fn)) std::this_thread::yield();
+}
+
+// From a worker: retrying could wait forever on a queue only the workers drain.
+template <typename Fn>
+static void submit_or_run(LFThreadPool& pool, Fn fn) {
+    if (!pool.submit(fn)) fn();
+}
+
+static void run_fanout(const char* variant, int threads, LFThreadPool::Scheduling scheduling, const BenchConfig& cfg) {
+    auto pool = make_pool(threads, scheduling);
+    std::atomic<int64_t> done{0};
+    const int64_t total = static_cast<int64_t>(cfg.roots) * (cfg.children + 1);
+    auto t0 = Clock::now();
+    for (int r = 0; r < cfg.roots; ++r) {
+        submit_retry(*pool, [&pool, &done, &cfg] {
+            for (int c = 0; c < cfg.children; ++c) {
+                submit_or_run(*pool, [&done, &cfg] {
+                    burn(cfg.child_ns);
+                    done.fetch_add(1, std::memory_order_relaxed);
+                });
+            }
+            done.fetch_add(1, std::memory_order_relaxed);
+        });
+    }
+    while (done.load() < total) std::this_thread::yield();
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+    g_sink += done.load();
+
+    std::cout << "STEAL BENCH RESULT"
+              << " workload=fanout"
+              << " variant=" << variant
+              << " threads=" << threads
+              << std::fixed << std::setprecision(0)
+              << " tasks_per_sec=" << total / secs
+              << " steals=" << pool->stats().steals.load()
+              << " local=" << pool->stats().local.load()
+              << "\n";
+}
+
+struct Request {
+    int64_t submitted = 0;
+    std::atomic<int> pieces{0};
+    int64_t finished = 0;
+};
+
+static void run_mixed(const char* variant, int threads, LFThreadPool::Scheduling scheduling, const BenchConfig& cfg) {
+    auto pool = make_pool(threads, scheduling);
+    std::vector<Request> requests(cfg.requests);
+    std::atomic<int> completed{0};
+    auto finish = [&completed](Request& req) {
+        if (req.pieces.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            req.finished = now_ns();
+            completed.fetch_add(1, std::memory_order_release);
+        }
+    };
+    auto t0 = Clock::now();
+    for (int i = 0; i < cfg.requests; ++i) {
+        Request& req = requests[i];
+        bool put = i % 10 == 9;
+        req.pieces.store(put ? cfg.put_chunks : 1, std::memory_order_relaxed);
+        req.submitted = now_ns();
+        if (!put) {
+            submit_retry(*pool, [&req, &cfg, &finish] {
+                burn(cfg.ls_ns);
+                finish(req);
+            });
+        } else {
+            submit_retry(*pool, [&pool, &req, &cfg, &finish] {
+                for (int c = 0; c < cfg.put_chunks; ++c) {
+                    submit_or_run(*pool, [&req, &cfg, &finish] {
+                        burn(cfg.chunk_ns);
+                        finish(req);
+                    });
+                }
+            });
+        }
+    }
+    while (completed.load(std::memory_order_acquire) < cfg.requests) std::this_thread::yield();
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    std::vector<int64_t> ls, put;
+    for (int i = 0; i < cfg.requests; ++i) {
+        (i % 10 == 9 ? put : ls).push_back(requests[i].finished - requests[i].submitted);
+    }
+    std::sort(ls.begin(), ls.end());
+    std::sort(put.begin(), put.end());
+    auto pct = [](const std::vector<int64_t>& v, double q) {
+        return v.empty() ? 0.0 : v[std::min<std::size_t>(v.size() - 1, v.size() * q)] / 1000.0;
+    };
+    g_sink += completed.load();
+
+    std::cout << "STEAL BENCH RESULT"
+              << " workload=mixed"
+              << " variant=" << variant
+              << " threads=" << threads
+              << std::fixed << std::setprecision(0)
+              << " requests_per_sec=" << cfg.requests / secs
+              << std::setprecision(1)
+              << " ls_p50_us=" << pct(ls, 0.5)
+              << " ls_p99_us=" << pct(ls, 0.99)
+              << " put_p50_us=" << pct(put, 0.5)
+              << " put_p99_us=" << pct(put, 0.99)
+              << " steals=" << pool->stats().steals.load()
+              << "\n";
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg = parse_args(argc, argv);
+    for (int threads : cfg.threads) {
+        run_fanout("shared", threads, LFThreadPool::Scheduling::SharedQueues, cfg);
+        run_fanout("stealing", threads, LFThreadPool::Scheduling::WorkStealing, cfg);
+    }
+    for (int threads : cfg.threads) {
+        run_mixed("shared", threads, LFThreadPool::Scheduling::SharedQueues, cfg);
+        run_mixed("stealing", threads, LFThreadPool::Scheduling::WorkStealing, cfg);
+    }
+    return g_sink == 0xdeadbeef;
+}